@@ -0,0 +1,583 @@
+/*
+ * Stratus ATC - Mock XPLM for the Offline Benchmark
+ *
+ * See mock_xplm.h. Everything the plugin and the commander link against
+ * must be defined here; a missing function shows up as a link (or load)
+ * error of stratus_bench, not as a silent gap in the numbers.
+ */
+
+#include "mock_xplm.h"
+
+#include "XPLMDataAccess.h"
+#include "XPLMNavigation.h"
+#include "XPLMPlanes.h"
+#include "XPLMProcessing.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MOCK_MAX_REFS 256
+#define MOCK_MAX_COMMANDS 16
+#define MOCK_ARRAY_LEN 8
+#define MOCK_NAME_LEN 128
+#define MOCK_DEFAULT_INTERVAL 0.1f
+#define MOCK_PI 3.14159265358979323846
+
+/* value(t) = base + rate * t + amp * sin(2 pi t / period) */
+typedef struct MockScript {
+  const char *name;
+  XPLMDataTypeID types;
+  double base;
+  double rate;
+  double amp;
+  double period;
+  const char *text; /* xplmType_Data */
+} MockScript;
+
+/* A gently weaving cruise near Seattle at ~120 kt */
+static const MockScript kScript[] = {
+    {"sim/flightmodel/position/latitude", xplmType_Double, 47.45, 0.0003, 0, 0,
+     NULL},
+    {"sim/flightmodel/position/longitude", xplmType_Double, -122.31, 0.0004, 0,
+     0, NULL},
+    {"sim/flightmodel/position/elevation", xplmType_Double, 1500.0, 0, 30.0,
+     120.0, NULL},
+    {"sim/flightmodel/position/y_agl", xplmType_Float, 1400.0, 0, 30.0, 120.0,
+     NULL},
+    {"sim/flightmodel/position/mag_psi", xplmType_Float, 45.0, 0, 20.0, 240.0,
+     NULL},
+    {"sim/flightmodel/position/true_psi", xplmType_Float, 60.0, 0, 20.0, 240.0,
+     NULL},
+    {"sim/flightmodel/position/phi", xplmType_Float, 0.0, 0, 15.0, 240.0, NULL},
+    {"sim/flightmodel/position/theta", xplmType_Float, 2.0, 0, 1.0, 60.0, NULL},
+    {"sim/flightmodel/position/groundspeed", xplmType_Float, 62.0, 0, 1.0, 30.0,
+     NULL},
+    {"sim/flightmodel/position/indicated_airspeed", xplmType_Float, 110.0, 0,
+     2.0, 30.0, NULL},
+    {"sim/flightmodel/position/true_airspeed", xplmType_Float, 63.0, 0, 1.0,
+     30.0, NULL},
+    {"sim/flightmodel/position/vh_ind_fpm", xplmType_Float, 0.0, 0, 600.0,
+     120.0, NULL},
+    {"sim/flightmodel/failures/onground_any", xplmType_Int, 0, 0, 0, 0, NULL},
+    {"sim/time/paused", xplmType_Int, 0, 0, 0, 0, NULL},
+    {"sim/time/total_flight_time_sec", xplmType_Float, 0, 1.0, 0, 0, NULL},
+
+    /* TCAS targets: slot 0 (the user) and seven others, all of them at
+     * the same place since array elements share one script */
+    {"sim/cockpit2/tcas/indicators/tcas_num_acf", xplmType_Int, 8, 0, 0, 0,
+     NULL},
+    {"sim/cockpit2/tcas/targets/position/lat", xplmType_FloatArray, 47.5,
+     0.0002, 0, 0, NULL},
+    {"sim/cockpit2/tcas/targets/position/lon", xplmType_FloatArray, -122.3,
+     0, 0, 0, NULL},
+    {"sim/cockpit2/tcas/targets/position/ele", xplmType_FloatArray, 900.0, 0,
+     0, 0, NULL},
+    {"sim/cockpit2/tcas/targets/position/psi", xplmType_FloatArray, 10.0, 0,
+     0, 0, NULL},
+    {"sim/cockpit2/tcas/targets/position/vx", xplmType_FloatArray, 10.0, 0, 0,
+     0, NULL},
+    {"sim/cockpit2/tcas/targets/position/vy", xplmType_FloatArray, -3.0, 0, 0,
+     0, NULL},
+    {"sim/cockpit2/tcas/targets/position/vz", xplmType_FloatArray, -70.0, 0,
+     0, 0, NULL},
+    {"sim/cockpit2/tcas/targets/modeS_id", xplmType_IntArray, 11160567, 0, 0,
+     0, NULL},
+    {"sim/aircraft/engine/acf_num_engines", xplmType_Int, 1, 0, 0, 0, NULL},
+    {"sim/flightmodel/engine/ENGN_running", xplmType_IntArray, 1, 0, 0, 0,
+     NULL},
+    {"sim/cockpit2/radios/actuators/com1_frequency_hz_833", xplmType_Int,
+     118300, 0, 0, 0, NULL},
+    {"sim/cockpit2/radios/actuators/com1_standby_frequency_hz_833",
+     xplmType_Int, 119900, 0, 0, 0, NULL},
+    {"sim/cockpit2/radios/actuators/com2_frequency_hz_833", xplmType_Int,
+     121900, 0, 0, 0, NULL},
+    {"sim/cockpit2/radios/actuators/com2_standby_frequency_hz_833",
+     xplmType_Int, 120950, 0, 0, 0, NULL},
+    {"sim/cockpit2/radios/actuators/nav1_frequency_hz", xplmType_Int, 11680, 0,
+     0, 0, NULL},
+    {"sim/cockpit2/radios/actuators/nav2_frequency_hz", xplmType_Int, 11300, 0,
+     0, 0, NULL},
+    {"sim/cockpit/radios/transponder_code", xplmType_Int, 4521, 0, 0, 0, NULL},
+    {"sim/cockpit/radios/transponder_mode", xplmType_Int, 2, 0, 0, 0, NULL},
+    {"sim/cockpit/autopilot/altitude", xplmType_Float, 5000.0, 0, 0, 0, NULL},
+    {"sim/cockpit/autopilot/heading_mag", xplmType_Float, 45.0, 0, 0, 0, NULL},
+    {"sim/cockpit/autopilot/vertical_velocity", xplmType_Float, 500.0, 0, 0, 0,
+     NULL},
+    {"sim/aircraft/view/acf_ICAO", xplmType_Data, 0, 0, 0, 0, "C172"},
+    {"sim/aircraft/view/acf_tailnum", xplmType_Data, 0, 0, 0, 0, "N172SP"},
+};
+
+typedef struct MockRef {
+  char name[MOCK_NAME_LEN];
+  XPLMDataTypeID types;
+  const MockScript *script; /* NULL: reads 0 until set */
+  int has_value;            /* XPLMSetData* was called */
+  double value;
+
+  /* XPLMRegisterDataAccessor */
+  int accessor;
+  XPLMGetDatai_f read_int;
+  XPLMGetDataf_f read_float;
+  XPLMGetDatad_f read_double;
+  XPLMGetDatavi_f read_int_array;
+  XPLMGetDatavf_f read_float_array;
+  XPLMGetDatab_f read_data;
+  void *refcon;
+} MockRef;
+
+typedef struct MockCommand {
+  char name[MOCK_NAME_LEN];
+  XPLMCommandCallback_f handler;
+  void *refcon;
+} MockCommand;
+
+static MockRef g_refs[MOCK_MAX_REFS];
+static int g_ref_count = 0;
+
+static MockCommand g_commands[MOCK_MAX_COMMANDS];
+static int g_command_count = 0;
+
+static XPLMCreateFlightLoop_t g_loop;
+static int g_loop_created = 0;
+static float g_loop_interval = MOCK_DEFAULT_INTERVAL;
+static int g_cycle = 0;
+
+static double g_sim_time = 0.0;
+
+void MockXplm_Reset(void) {
+  memset(g_refs, 0, sizeof(g_refs));
+  g_ref_count = 0;
+  memset(g_commands, 0, sizeof(g_commands));
+  g_command_count = 0;
+  g_loop_created = 0;
+  g_loop_interval = MOCK_DEFAULT_INTERVAL;
+  g_cycle = 0;
+  g_sim_time = 0.0;
+}
+
+double MockXplm_SimTime(void) { return g_sim_time; }
+
+/* ============================================================================
+ * DataRefs
+ * ============================================================================
+ */
+
+static const MockScript *FindScript(const char *name) {
+  for (size_t i = 0; i < sizeof(kScript) / sizeof(kScript[0]); i++) {
+    if (strcmp(kScript[i].name, name) == 0)
+      return &kScript[i];
+  }
+  return NULL;
+}
+
+static MockRef *FindRef(const char *name) {
+  for (int i = 0; i < g_ref_count; i++) {
+    if (strcmp(g_refs[i].name, name) == 0)
+      return &g_refs[i];
+  }
+  return NULL;
+}
+
+static MockRef *AddRef(const char *name) {
+  if (g_ref_count >= MOCK_MAX_REFS || strlen(name) >= MOCK_NAME_LEN)
+    return NULL;
+  MockRef *ref = &g_refs[g_ref_count++];
+  memset(ref, 0, sizeof(*ref));
+  strcpy(ref->name, name);
+  return ref;
+}
+
+static double ScriptValue(const MockRef *ref) {
+  if (ref->has_value)
+    return ref->value;
+  const MockScript *s = ref->script;
+  if (!s)
+    return 0.0;
+  double v = s->base + s->rate * g_sim_time;
+  if (s->period > 0.0)
+    v += s->amp * sin(2.0 * MOCK_PI * g_sim_time / s->period);
+  return v;
+}
+
+XPLMDataRef XPLMFindDataRef(const char *inDataRefName) {
+  MockRef *ref = FindRef(inDataRefName);
+  if (ref)
+    return ref;
+  ref = AddRef(inDataRefName);
+  if (!ref)
+    return NULL;
+  ref->script = FindScript(inDataRefName);
+  ref->types = ref->script ? ref->script->types
+                           : xplmType_Int | xplmType_Float | xplmType_Double;
+  return ref;
+}
+
+int XPLMCanWriteDataRef(XPLMDataRef inDataRef) {
+  return inDataRef && !((MockRef *)inDataRef)->accessor;
+}
+
+int XPLMIsDataRefGood(XPLMDataRef inDataRef) { return inDataRef != NULL; }
+
+XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef) {
+  return inDataRef ? ((MockRef *)inDataRef)->types : xplmType_Unknown;
+}
+
+int XPLMGetDatai(XPLMDataRef inDataRef) {
+  MockRef *ref = inDataRef;
+  if (!ref)
+    return 0;
+  if (ref->accessor)
+    return ref->read_int ? ref->read_int(ref->refcon) : 0;
+  return (int)ScriptValue(ref);
+}
+
+float XPLMGetDataf(XPLMDataRef inDataRef) {
+  MockRef *ref = inDataRef;
+  if (!ref)
+    return 0.0f;
+  if (ref->accessor)
+    return ref->read_float ? ref->read_float(ref->refcon) : 0.0f;
+  return (float)ScriptValue(ref);
+}
+
+double XPLMGetDatad(XPLMDataRef inDataRef) {
+  MockRef *ref = inDataRef;
+  if (!ref)
+    return 0.0;
+  if (ref->accessor)
+    return ref->read_double ? ref->read_double(ref->refcon) : 0.0;
+  return ScriptValue(ref);
+}
+
+static void SetValue(XPLMDataRef inDataRef, double value) {
+  MockRef *ref = inDataRef;
+  if (!ref || ref->accessor)
+    return;
+  ref->has_value = 1;
+  ref->value = value;
+}
+
+void XPLMSetDatai(XPLMDataRef inDataRef, int inValue) {
+  SetValue(inDataRef, inValue);
+}
+
+void XPLMSetDataf(XPLMDataRef inDataRef, float inValue) {
+  SetValue(inDataRef, inValue);
+}
+
+void XPLMSetDatad(XPLMDataRef inDataRef, double inValue) {
+  SetValue(inDataRef, inValue);
+}
+
+/* Arrays hold MOCK_ARRAY_LEN copies of the scalar value */
+static int ArrayRange(int inOffset, int inMax) {
+  if (inOffset >= MOCK_ARRAY_LEN)
+    return 0;
+  int n = MOCK_ARRAY_LEN - inOffset;
+  return n < inMax ? n : inMax;
+}
+
+int XPLMGetDatavi(XPLMDataRef inDataRef, int *outValues, int inOffset,
+                  int inMax) {
+  MockRef *ref = inDataRef;
+  if (!ref)
+    return 0;
+  if (ref->accessor)
+    return ref->read_int_array ? ref->read_int_array(ref->refcon, outValues,
+                                                     inOffset, inMax)
+                               : 0;
+  if (!outValues)
+    return MOCK_ARRAY_LEN;
+  int n = ArrayRange(inOffset, inMax);
+  for (int i = 0; i < n; i++)
+    outValues[i] = (int)ScriptValue(ref);
+  return n;
+}
+
+int XPLMGetDatavf(XPLMDataRef inDataRef, float *outValues, int inOffset,
+                  int inMax) {
+  MockRef *ref = inDataRef;
+  if (!ref)
+    return 0;
+  if (ref->accessor)
+    return ref->read_float_array ? ref->read_float_array(ref->refcon, outValues,
+                                                         inOffset, inMax)
+                                 : 0;
+  if (!outValues)
+    return MOCK_ARRAY_LEN;
+  int n = ArrayRange(inOffset, inMax);
+  for (int i = 0; i < n; i++)
+    outValues[i] = (float)ScriptValue(ref);
+  return n;
+}
+
+void XPLMSetDatavi(XPLMDataRef inDataRef, int *inValues, int inoffset,
+                   int inCount) {
+  if (inValues && inCount > 0 && inoffset == 0)
+    SetValue(inDataRef, inValues[0]);
+}
+
+void XPLMSetDatavf(XPLMDataRef inDataRef, float *inValues, int inoffset,
+                   int inCount) {
+  if (inValues && inCount > 0 && inoffset == 0)
+    SetValue(inDataRef, inValues[0]);
+}
+
+int XPLMGetDatab(XPLMDataRef inDataRef, void *outValue, int inOffset,
+                 int inMaxBytes) {
+  MockRef *ref = inDataRef;
+  if (!ref)
+    return 0;
+  if (ref->accessor)
+    return ref->read_data ? ref->read_data(ref->refcon, outValue, inOffset,
+                                           inMaxBytes)
+                          : 0;
+  const char *text = ref->script ? ref->script->text : NULL;
+  int len = text ? (int)strlen(text) + 1 : 0;
+  if (!outValue)
+    return len;
+  if (inOffset >= len)
+    return 0;
+  int n = len - inOffset < inMaxBytes ? len - inOffset : inMaxBytes;
+  memcpy(outValue, text + inOffset, (size_t)n);
+  return n;
+}
+
+void XPLMSetDatab(XPLMDataRef inDataRef, void *inValue, int inOffset,
+                  int inLength) {
+  /* Strings are script-only */
+  (void)inDataRef;
+  (void)inValue;
+  (void)inOffset;
+  (void)inLength;
+}
+
+XPLMDataRef XPLMRegisterDataAccessor(
+    const char *inDataName, XPLMDataTypeID inDataType, int inIsWritable,
+    XPLMGetDatai_f inReadInt, XPLMSetDatai_f inWriteInt,
+    XPLMGetDataf_f inReadFloat, XPLMSetDataf_f inWriteFloat,
+    XPLMGetDatad_f inReadDouble, XPLMSetDatad_f inWriteDouble,
+    XPLMGetDatavi_f inReadIntArray, XPLMSetDatavi_f inWriteIntArray,
+    XPLMGetDatavf_f inReadFloatArray, XPLMSetDatavf_f inWriteFloatArray,
+    XPLMGetDatab_f inReadData, XPLMSetDatab_f inWriteData, void *inReadRefcon,
+    void *inWriteRefcon) {
+  /* Writes through accessors are not exercised by the benchmark */
+  (void)inIsWritable;
+  (void)inWriteInt;
+  (void)inWriteFloat;
+  (void)inWriteDouble;
+  (void)inWriteIntArray;
+  (void)inWriteFloatArray;
+  (void)inWriteData;
+  (void)inWriteRefcon;
+
+  MockRef *ref = FindRef(inDataName);
+  if (!ref)
+    ref = AddRef(inDataName);
+  if (!ref)
+    return NULL;
+  ref->types = inDataType;
+  ref->accessor = 1;
+  ref->read_int = inReadInt;
+  ref->read_float = inReadFloat;
+  ref->read_double = inReadDouble;
+  ref->read_int_array = inReadIntArray;
+  ref->read_float_array = inReadFloatArray;
+  ref->read_data = inReadData;
+  ref->refcon = inReadRefcon;
+  return ref;
+}
+
+void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef) {
+  MockRef *ref = inDataRef;
+  if (!ref || !ref->accessor)
+    return;
+  /* The slot stays resolvable, like a DataRef whose owner went away */
+  char name[MOCK_NAME_LEN];
+  strcpy(name, ref->name);
+  memset(ref, 0, sizeof(*ref));
+  strcpy(ref->name, name);
+}
+
+/* ============================================================================
+ * Flight loops
+ * ============================================================================
+ */
+
+XPLMFlightLoopID XPLMCreateFlightLoop(XPLMCreateFlightLoop_t *inParams) {
+  /* The plugin creates exactly one */
+  g_loop = *inParams;
+  g_loop_created = 1;
+  return &g_loop;
+}
+
+void XPLMDestroyFlightLoop(XPLMFlightLoopID inFlightLoopID) {
+  (void)inFlightLoopID;
+  g_loop_created = 0;
+}
+
+void XPLMScheduleFlightLoop(XPLMFlightLoopID inFlightLoopID, float inInterval,
+                            int inRelativeToNow) {
+  (void)inFlightLoopID;
+  (void)inRelativeToNow;
+  if (inInterval > 0.0f)
+    g_loop_interval = inInterval;
+}
+
+float XPLMGetElapsedTime(void) { return (float)g_sim_time; }
+
+int XPLMGetCycleNumber(void) { return g_cycle; }
+
+int MockXplm_RunFlightLoop(void) {
+  if (!g_loop_created)
+    return 0;
+  float elapsed = g_loop_interval;
+  float next = g_loop.callbackFunc(elapsed, elapsed, ++g_cycle, g_loop.refcon);
+  /* Negative = that many frames; the mock sim runs at 60 fps */
+  if (next > 0.0f)
+    g_loop_interval = next;
+  else if (next < 0.0f)
+    g_loop_interval = -next / 60.0f;
+  g_sim_time += g_loop_interval;
+  return 1;
+}
+
+/* ============================================================================
+ * Commands
+ * ============================================================================
+ */
+
+static MockCommand *CommandOf(const char *name) {
+  for (int i = 0; i < g_command_count; i++) {
+    if (strcmp(g_commands[i].name, name) == 0)
+      return &g_commands[i];
+  }
+  return NULL;
+}
+
+XPLMCommandRef XPLMFindCommand(const char *inName) { return CommandOf(inName); }
+
+XPLMCommandRef XPLMCreateCommand(const char *inName,
+                                 const char *inDescription) {
+  (void)inDescription;
+  MockCommand *cmd = CommandOf(inName);
+  if (cmd)
+    return cmd;
+  if (g_command_count >= MOCK_MAX_COMMANDS || strlen(inName) >= MOCK_NAME_LEN)
+    return NULL;
+  cmd = &g_commands[g_command_count++];
+  memset(cmd, 0, sizeof(*cmd));
+  strcpy(cmd->name, inName);
+  return cmd;
+}
+
+void XPLMRegisterCommandHandler(XPLMCommandRef inComand,
+                                XPLMCommandCallback_f inHandler, int inBefore,
+                                void *inRefcon) {
+  (void)inBefore;
+  MockCommand *cmd = inComand;
+  if (!cmd)
+    return;
+  cmd->handler = inHandler;
+  cmd->refcon = inRefcon;
+}
+
+void XPLMUnregisterCommandHandler(XPLMCommandRef inComand,
+                                  XPLMCommandCallback_f inHandler,
+                                  int inBefore, void *inRefcon) {
+  (void)inBefore;
+  (void)inRefcon;
+  MockCommand *cmd = inComand;
+  if (cmd && cmd->handler == inHandler)
+    cmd->handler = NULL;
+}
+
+static void Dispatch(MockCommand *cmd, XPLMCommandPhase phase) {
+  if (cmd && cmd->handler)
+    cmd->handler(cmd, phase, cmd->refcon);
+}
+
+void XPLMCommandBegin(XPLMCommandRef inCommand) {
+  Dispatch(inCommand, xplm_CommandBegin);
+}
+
+void XPLMCommandEnd(XPLMCommandRef inCommand) {
+  Dispatch(inCommand, xplm_CommandEnd);
+}
+
+void XPLMCommandOnce(XPLMCommandRef inCommand) {
+  Dispatch(inCommand, xplm_CommandBegin);
+  Dispatch(inCommand, xplm_CommandEnd);
+}
+
+void MockXplm_Command(const char *name, XPLMCommandPhase phase) {
+  Dispatch(CommandOf(name), phase);
+}
+
+/* ============================================================================
+ * Utilities, navigation, planes
+ * ============================================================================
+ */
+
+void XPLMDebugString(const char *inString) { (void)inString; }
+
+void XPLMGetSystemPath(char *outSystemPath) {
+  strcpy(outSystemPath, "/mock/X-Plane 12/");
+}
+
+/* One airport, always nearest */
+XPLMNavRef XPLMFindNavAid(const char *inNameFragment, const char *inIDFragment,
+                          float *inLat, float *inLon, int *inFrequency,
+                          XPLMNavType inType) {
+  (void)inNameFragment;
+  (void)inIDFragment;
+  (void)inLat;
+  (void)inLon;
+  (void)inFrequency;
+  return (inType & xplm_Nav_Airport) ? 0 : XPLM_NAV_NOT_FOUND;
+}
+
+void XPLMGetNavAidInfo(XPLMNavRef inRef, XPLMNavType *outType,
+                       float *outLatitude, float *outLongitude,
+                       float *outHeight, int *outFrequency, float *outHeading,
+                       char *outID, char *outName, char *outReg) {
+  (void)inRef;
+  if (outType)
+    *outType = xplm_Nav_Airport;
+  if (outLatitude)
+    *outLatitude = 47.449f;
+  if (outLongitude)
+    *outLongitude = -122.309f;
+  if (outHeight)
+    *outHeight = 132.0f;
+  if (outFrequency)
+    *outFrequency = 0;
+  if (outHeading)
+    *outHeading = 0.0f;
+  if (outID)
+    strcpy(outID, "KSEA");
+  if (outName)
+    strcpy(outName, "Seattle Tacoma Intl");
+  if (outReg)
+    *outReg = 0;
+}
+
+void XPLMGetNthAircraftModel(int inIndex, char *outFileName, char *outPath) {
+  (void)inIndex;
+  if (outFileName)
+    strcpy(outFileName, "Cessna_172SP.acf");
+  if (outPath)
+    strcpy(outPath, "/mock/X-Plane 12/Aircraft/Laminar Research/Cessna 172 "
+                    "SP/Cessna_172SP.acf");
+}
+
+void XPLMCountAircraft(int *outTotalAircraft, int *outActiveAircraft,
+                       XPLMPluginID *outController) {
+  if (outTotalAircraft)
+    *outTotalAircraft = 1;
+  if (outActiveAircraft)
+    *outActiveAircraft = 1;
+  if (outController)
+    *outController = XPLM_NO_PLUGIN_ID;
+}
@@ -0,0 +1,37 @@
+/*
+ * Stratus ATC - Mock XPLM for the Offline Benchmark
+ *
+ * A stand-in for the parts of the X-Plane SDK the plugin (and the Rust
+ * commander) call, so stratus_plugin.c can run outside the sim:
+ *
+ *   - DataRefs: any name resolves. A short script gives the telemetry
+ *     DataRefs a plausible cruise (position, altitude and heading move with
+ *     sim time); everything else reads as a constant derived from its name.
+ *     XPLMSetData* values stick; registered accessors are called through.
+ *   - Flight loops: the one created by the plugin is driven explicitly with
+ *     MockXplm_RunFlightLoop(), which also advances sim time by the interval
+ *     the callback asked for. Nothing runs on its own.
+ *   - Commands: handlers are stored and fired by MockXplm_Command().
+ *
+ * Single-threaded like the real sim thread; nothing here is locked.
+ */
+
+#ifndef STRATUS_MOCK_XPLM_H
+#define STRATUS_MOCK_XPLM_H
+
+#include "XPLMUtilities.h"
+
+/* Forget every DataRef, flight loop and command; sim time back to 0 */
+void MockXplm_Reset(void);
+
+/* Sim seconds since MockXplm_Reset(); drives the scripted DataRefs */
+double MockXplm_SimTime(void);
+
+/* Call the plugin's flight loop once and advance sim time by the interval
+ * it returns. Returns 0 if no flight loop has been created. */
+int MockXplm_RunFlightLoop(void);
+
+/* Send `phase` to the handlers of the command called `name` */
+void MockXplm_Command(const char *name, XPLMCommandPhase phase);
+
+#endif /* STRATUS_MOCK_XPLM_H */
@@ -0,0 +1,573 @@
+/*
+ * Stratus ATC - Offline Plugin Benchmark
+ *
+ * Runs stratus_plugin.c against the mock XPLM (mock_xplm.h) for a fixed
+ * number of flight-loop ticks in each telemetry mode, and reports per tick:
+ *
+ *   ns/tick        mean wall time of the flight-loop callback
+ *   p99_us         99th percentile, from the plugin's own histogram
+ *   allocs/tick    malloc/calloc/realloc calls, all threads
+ *   syscalls/tick  system calls made by the bench (sim) thread, counted
+ *                  under ptrace in a second, untimed run
+ *   bytes/tick     bytes passed to write(2) and friends (/proc/self/io);
+ *                  shared-memory stores are not I/O and do not count
+ *
+ * A tick is one flight-loop callback. The plugin's scheduler (stratus_sched.h)
+ * calls back for every due task, so most ticks only apply commands and one
+ * in a few captures and publishes a frame.
+ *
+ * By default the I/O thread is stopped before the ticks run, so the plugin
+ * writes inline (its fallback path): every tick's full cost lands on the
+ * bench thread and the counts are deterministic. --threaded keeps the I/O
+ * thread as in the sim; ns/tick and syscalls/tick then cover only the sim
+ * thread, and the rest depends on how many frames the I/O thread coalesced.
+ *
+ * Each mode runs in its own forked process with its own data directory
+ * (HOME points into a temporary directory), so plugin state never leaks
+ * between modes. Linux only: allocation counting relies on glibc's
+ * __libc_* entry points.
+ *
+ * Before the modes run, settings text is parsed under a comma-decimal
+ * locale (de_DE.UTF-8, skipped where it is not installed), as happens when
+ * another plugin sets the process locale; a misparse fails the run.
+ *
+ * Usage: stratus_bench [--ticks N] [--mode NAME] [--threaded] [--no-syscalls]
+ *
+ * Output is one whitespace-separated line per mode; '#' lines are comments.
+ * scripts/check_regression.sh compares it against a baseline.
+ */
+
+#define _GNU_SOURCE /* nftw, and glibc's malloc entry points */
+
+#include "mock_xplm.h"
+
+#include "XPLMPlugin.h"
+
+#include "stratus_airports.h"
+#include "stratus_config.h"
+#include "stratus_perf.h"
+#include "stratus_profile.h"
+#include "stratus_thread.h"
+
+#include <errno.h>
+#include <ftw.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Plugin entry points (stratus_plugin.c, compiled into this binary) */
+PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc);
+PLUGIN_API void XPluginStop(void);
+PLUGIN_API int XPluginEnable(void);
+PLUGIN_API void XPluginDisable(void);
+
+#define DEFAULT_TICKS 10000
+#define WARMUP_TICKS 100
+#define BENCH_PATH_LEN 512
+
+/* Settings shared by every mode: keep the log and the perf dump quiet, and
+ * traffic export to its own mode */
+#define COMMON_CONFIG "log_level = warn\nperf_dump_s = 0\ntraffic_rate_hz = 0\n"
+
+typedef struct BenchMode {
+  const char *name;
+  const char *config; /* stratus_plugin.cfg */
+} BenchMode;
+
+static const BenchMode kModes[] = {
+    {"json", "transport = json\nformat = json\n"},
+    {"binary", "transport = json\nformat = binary\n"},
+    {"shm", "transport = shm\n"},
+    {"delta", "transport = json\nformat = json\npublish = delta\n"},
+    {"record", "transport = shm\nrecord = on\n"},
+    {"server", "transport = shm\nserver = on\n"},
+    {"udp", "transport = shm\nudp = 127.0.0.1:9\n"},
+    {"traffic", "transport = shm\ntraffic_rate_hz = 10\n"},
+    {"inproc", "transport = shm\nin_process = on\n"},
+};
+#define MODE_COUNT (sizeof(kModes) / sizeof(kModes[0]))
+
+typedef struct BenchOptions {
+  long ticks;
+  const char *only_mode; /* NULL = all */
+  int threaded;
+  int count_syscalls;
+} BenchOptions;
+
+typedef struct BenchResult {
+  int ok;
+  double ns_per_tick;
+  double p99_us;
+  uint64_t allocs;
+  uint64_t bytes;
+  int64_t syscalls; /* -1 = not measured */
+} BenchResult;
+
+static char g_root[BENCH_PATH_LEN]; /* Temporary directory for all modes */
+
+/* ============================================================================
+ * Allocation counting
+ * ============================================================================
+ */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+static _Atomic uint64_t g_allocs = 0;
+
+static void CountAlloc(void) {
+  atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+}
+
+/* These replace glibc's for the whole process, libraries included; free()
+ * is left alone since the memory still comes from glibc's heap */
+void *malloc(size_t size) {
+  CountAlloc();
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+  CountAlloc();
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  CountAlloc();
+  return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  CountAlloc();
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  CountAlloc();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+  CountAlloc();
+  void *p = __libc_memalign(alignment, size);
+  if (!p)
+    return ENOMEM;
+  *out = p;
+  return 0;
+}
+
+/* ============================================================================
+ * One mode, in a child process
+ * ============================================================================
+ */
+
+/* Bytes written through write(2)-family calls by the whole process */
+static uint64_t BytesWritten(void) {
+  FILE *f = fopen("/proc/self/io", "r");
+  if (!f)
+    return 0;
+  char line[128];
+  unsigned long long wchar = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "wchar: %llu", &wchar) == 1)
+      break;
+  }
+  fclose(f);
+  return wchar;
+}
+
+/* Write an airport index around the mock position (47.45 N, 122.31 W):
+ * BENCH_AIRPORTS_PER_TILE airports with one runway each in every tile of a
+ * 9 x 9 degree block, so each search reads as much as over a busy region */
+#define BENCH_AIRPORT_SPAN 9
+#define BENCH_AIRPORTS_PER_TILE 8
+#define BENCH_AIRPORT_COUNT                                                    \
+  (BENCH_AIRPORT_SPAN * BENCH_AIRPORT_SPAN * BENCH_AIRPORTS_PER_TILE)
+static int WriteAirportIndex(const char *path) {
+  static uint32_t tiles[STRATUS_AIRPORT_TILES + 1];
+  static StratusAirport airports[BENCH_AIRPORT_COUNT];
+  static StratusRunway runways[BENCH_AIRPORT_COUNT];
+  const int row0 = 47 + 90 - BENCH_AIRPORT_SPAN / 2;
+  const int col0 = -123 + 180 - BENCH_AIRPORT_SPAN / 2;
+
+  /* Tile by tile in file order, row-major from the south-west */
+  uint32_t n = 0;
+  for (int t = 0; t < STRATUS_AIRPORT_TILES; t++) {
+    tiles[t] = n;
+    int row = t / 360, col = t % 360;
+    if (row < row0 || row >= row0 + BENCH_AIRPORT_SPAN || col < col0 ||
+        col >= col0 + BENCH_AIRPORT_SPAN)
+      continue;
+    for (int k = 0; k < BENCH_AIRPORTS_PER_TILE; k++, n++) {
+      double lat = row - 90 + (k + 0.5) / BENCH_AIRPORTS_PER_TILE;
+      double lon = col - 180 + ((k * 3) % 8 + 0.5) / 8.0;
+      StratusAirport *a = &airports[n];
+      a->lat_e7 = (int32_t)(lat * 1e7);
+      a->lon_e7 = (int32_t)(lon * 1e7);
+      snprintf(a->ident, sizeof(a->ident), "B%04u", (unsigned)n);
+      a->elevation_ft = 400;
+      a->runway_count = 1;
+      a->first_runway = n;
+
+      /* 16/34, 9000 ft */
+      StratusRunway *r = &runways[n];
+      r->le_lat_e7 = (int32_t)((lat + 0.0125) * 1e7);
+      r->le_lon_e7 = a->lon_e7;
+      r->he_lat_e7 = (int32_t)((lat - 0.0125) * 1e7);
+      r->he_lon_e7 = a->lon_e7;
+      memcpy(r->le_ident, "16", 3);
+      memcpy(r->he_ident, "34", 3);
+      r->length_ft = 9000;
+      r->width_ft = 150;
+    }
+  }
+  tiles[STRATUS_AIRPORT_TILES] = n;
+
+  StratusAirportsHeader h = {.magic = STRATUS_AIRPORTS_MAGIC,
+                             .version = STRATUS_AIRPORTS_VERSION,
+                             .header_size = sizeof(StratusAirportsHeader),
+                             .airport_size = sizeof(StratusAirport),
+                             .runway_size = sizeof(StratusRunway),
+                             .airport_count = n,
+                             .runway_count = n};
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return 0;
+  int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+           fwrite(tiles, sizeof(tiles), 1, f) == 1 &&
+           fwrite(airports, sizeof(airports), 1, f) == 1 &&
+           fwrite(runways, sizeof(runways), 1, f) == 1;
+  return fclose(f) == 0 && ok;
+}
+
+/* Create HOME/.local/share/StratusATC with the mode's config and the
+ * airport index in it */
+static int PrepareHome(const BenchMode *mode, char *home, size_t size) {
+  static const char *const kParts[] = {"", "/.local", "/.local/share",
+                                       "/.local/share/StratusATC"};
+  char path[BENCH_PATH_LEN + 96];
+
+  snprintf(home, size, "%s/%s", g_root, mode->name);
+  for (size_t i = 0; i < sizeof(kParts) / sizeof(kParts[0]); i++) {
+    snprintf(path, sizeof(path), "%s%s", home, kParts[i]);
+    if (mkdir(path, 0755) != 0 && errno != EEXIST)
+      return 0;
+  }
+
+  snprintf(path, sizeof(path), "%s/.local/share/StratusATC/stratus_plugin.cfg",
+           home);
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return 0;
+  fprintf(f, "%s%s", COMMON_CONFIG, mode->config);
+  fclose(f);
+
+  snprintf(path, sizeof(path), "%s/.local/share/StratusATC/%s", home,
+           STRATUS_AIRPORTS_FILE);
+  return WriteAirportIndex(path);
+}
+
+/* Run the plugin through XPluginStart ... XPluginStop. `traced` marks the
+ * measured ticks with SIGUSR1 for the syscall counter (CountSyscalls). */
+static void RunMode(const BenchMode *mode, const BenchOptions *opt, int traced,
+                    BenchResult *out) {
+  memset(out, 0, sizeof(*out));
+  out->syscalls = -1;
+
+  char home[BENCH_PATH_LEN + 32];
+  if (!PrepareHome(mode, home, sizeof(home)))
+    return;
+  setenv("HOME", home, 1);
+  /* The config file decides the mode, not the caller's environment */
+  unsetenv("STRATUS_TELEMETRY_TRANSPORT");
+  unsetenv("STRATUS_TELEMETRY_FORMAT");
+
+  MockXplm_Reset();
+  char name[256], sig[256], desc[256];
+  if (!XPluginStart(name, sig, desc))
+    return;
+  XPluginEnable();
+  if (!opt->threaded)
+    XPluginDisable(); /* Stops the I/O thread; the flight loop still runs */
+
+  for (int i = 0; i < WARMUP_TICKS; i++)
+    MockXplm_RunFlightLoop();
+
+  uint64_t bytes0 = BytesWritten();
+  uint64_t allocs0 = atomic_load(&g_allocs);
+  if (traced)
+    raise(SIGUSR1);
+  uint64_t t0 = StratusMonotonicNs();
+
+  for (long i = 0; i < opt->ticks; i++)
+    MockXplm_RunFlightLoop();
+
+  uint64_t t1 = StratusMonotonicNs();
+  if (traced)
+    raise(SIGUSR1);
+  if (opt->threaded)
+    XPluginDisable(); /* Join the I/O thread so its writes are counted */
+  uint64_t allocs1 = atomic_load(&g_allocs);
+  uint64_t bytes1 = BytesWritten();
+
+  StratusPerfStats stats;
+  StratusPerf_Stats(STRATUS_PERF_FLIGHT_LOOP, &stats);
+  XPluginStop();
+
+  out->ok = 1;
+  out->ns_per_tick = (double)(t1 - t0) / (double)opt->ticks;
+  out->p99_us = stats.p99_us;
+  out->allocs = allocs1 - allocs0;
+  out->bytes = bytes1 - bytes0;
+}
+
+/* Timed run: the child reports back through a pipe */
+static int TimeMode(const BenchMode *mode, const BenchOptions *opt,
+                    BenchResult *out) {
+  int fds[2];
+  if (pipe(fds) != 0)
+    return 0;
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    BenchResult result;
+    RunMode(mode, opt, 0, &result);
+    ssize_t n = write(fds[1], &result, sizeof(result));
+    _exit(n == (ssize_t)sizeof(result) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  ssize_t n = read(fds[0], out, sizeof(*out));
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  return n == (ssize_t)sizeof(*out) && out->ok;
+}
+
+/* Untimed run under ptrace, counting syscall entries of the child's main
+ * thread between its two SIGUSR1 markers. Threads it creates are not
+ * traced. Returns -1 if tracing is not possible here. */
+static int64_t CountSyscalls(const BenchMode *mode, const BenchOptions *opt) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0)
+    return -1;
+  if (pid == 0) {
+    if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0)
+      _exit(1);
+    raise(SIGSTOP);
+    BenchResult result;
+    RunMode(mode, opt, 1, &result);
+    _exit(result.ok ? 0 : 1);
+  }
+
+  int status;
+  if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) {
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    return -1;
+  }
+  ptrace(PTRACE_SETOPTIONS, pid, NULL,
+         (void *)(intptr_t)(PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL));
+
+  int64_t count = -1;
+  int counting = 0;
+  int in_syscall = 0;
+  int deliver = 0;
+  for (;;) {
+    if (ptrace(PTRACE_SYSCALL, pid, NULL, (void *)(intptr_t)deliver) != 0)
+      break;
+    deliver = 0;
+    if (waitpid(pid, &status, 0) != pid || WIFEXITED(status) ||
+        WIFSIGNALED(status))
+      break;
+    if (!WIFSTOPPED(status))
+      continue;
+
+    int sig = WSTOPSIG(status);
+    if (sig == (SIGTRAP | 0x80)) {
+      in_syscall = !in_syscall;
+      if (in_syscall && counting)
+        count++;
+    } else if (sig == SIGUSR1) {
+      if (!counting) {
+        counting = 1;
+        count = 0;
+      } else {
+        counting = 0;
+        count--; /* The kill() that raised this marker */
+      }
+    } else {
+      deliver = sig;
+    }
+  }
+  waitpid(pid, &status, WNOHANG);
+  return counting ? -1 : count;
+}
+
+/* ============================================================================
+ * Driver
+ * ============================================================================
+ */
+
+static int RemoveEntry(const char *path, const struct stat *st, int flag,
+                       struct FTW *ftw) {
+  (void)st;
+  (void)flag;
+  (void)ftw;
+  remove(path);
+  return 0;
+}
+
+/* Another plugin may switch the process to a comma-decimal locale; profiles
+ * and stratus_plugin.cfg must still parse as written. Returns 0 on a
+ * mismatch. */
+static int CheckLocaleParsing(void) {
+  if (!setlocale(LC_NUMERIC, "de_DE.UTF-8")) {
+    printf("# locale check skipped: de_DE.UTF-8 not installed\n");
+    return 1;
+  }
+
+  char dir[BENCH_PATH_LEN + 32];
+  char path[BENCH_PATH_LEN + 64];
+  snprintf(dir, sizeof(dir), "%s/locale", g_root);
+  int ok = mkdir(dir, 0755) == 0;
+
+  snprintf(path, sizeof(path), "%s/locale.cfg", dir);
+  FILE *f = ok ? fopen(path, "w") : NULL;
+  if (f) {
+    fprintf(f, "autopilot.altitude_ft = vendor/ap_alt_m 3.28084\n");
+    fclose(f);
+    StratusProfile p;
+    ok = StratusProfile_Load(&p, dir, "locale.acf", "", NULL) &&
+         p.count == 1 && p.entries[0].scale == 3.28084f;
+  } else {
+    ok = 0;
+  }
+
+  snprintf(path, sizeof(path), "%s/stratus_plugin.cfg", dir);
+  f = ok ? fopen(path, "w") : NULL;
+  if (f) {
+    fprintf(f, "rate_hz = 12.5\ndeadband_position_deg = 0.00001\n");
+    fclose(f);
+    StratusConfig cfg;
+    StratusConfig_Defaults(&cfg);
+    ok = StratusConfig_Load(&cfg, path, NULL) && cfg.rate_hz == 12.5f &&
+         cfg.deadband_position_deg == 0.00001f;
+  } else {
+    ok = 0;
+  }
+
+  setlocale(LC_NUMERIC, "C");
+  if (!ok)
+    fprintf(stderr, "stratus_bench: settings misparsed under de_DE.UTF-8\n");
+  return ok;
+}
+
+static void Usage(const char *argv0) {
+  fprintf(stderr,
+          "Usage: %s [--ticks N] [--mode NAME] [--threaded] [--no-syscalls]\n"
+          "Modes:",
+          argv0);
+  for (size_t i = 0; i < MODE_COUNT; i++)
+    fprintf(stderr, " %s", kModes[i].name);
+  fprintf(stderr, "\n");
+}
+
+static int ParseArgs(int argc, char **argv, BenchOptions *opt) {
+  opt->ticks = DEFAULT_TICKS;
+  opt->only_mode = NULL;
+  opt->threaded = 0;
+  opt->count_syscalls = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+      opt->ticks = strtol(argv[++i], NULL, 10);
+      if (opt->ticks <= 0)
+        return 0;
+    } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      opt->only_mode = argv[++i];
+    } else if (strcmp(argv[i], "--threaded") == 0) {
+      opt->threaded = 1;
+    } else if (strcmp(argv[i], "--no-syscalls") == 0) {
+      opt->count_syscalls = 0;
+    } else {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  BenchOptions opt;
+  if (!ParseArgs(argc, argv, &opt)) {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  if (opt.only_mode) {
+    size_t i = 0;
+    while (i < MODE_COUNT && strcmp(opt.only_mode, kModes[i].name) != 0)
+      i++;
+    if (i == MODE_COUNT) {
+      fprintf(stderr, "stratus_bench: unknown mode '%s'\n", opt.only_mode);
+      return 2;
+    }
+  }
+
+  const char *tmp = getenv("TMPDIR");
+  snprintf(g_root, sizeof(g_root), "%s/stratus_bench.XXXXXX",
+           tmp && *tmp ? tmp : "/tmp");
+  if (!mkdtemp(g_root)) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  printf("# stratus_bench: %ld ticks per mode, I/O %s\n", opt.ticks,
+         opt.threaded ? "thread" : "inline");
+  int failed = !CheckLocaleParsing();
+  printf("# %-8s %10s %8s %12s %14s %11s\n", "mode", "ns/tick", "p99_us",
+         "allocs/tick", "syscalls/tick", "bytes/tick");
+
+  for (size_t i = 0; i < MODE_COUNT; i++) {
+    const BenchMode *mode = &kModes[i];
+    if (opt.only_mode && strcmp(opt.only_mode, mode->name) != 0)
+      continue;
+
+    BenchResult r;
+    if (!TimeMode(mode, &opt, &r)) {
+      fprintf(stderr, "stratus_bench: mode %s failed\n", mode->name);
+      failed = 1;
+      continue;
+    }
+    if (opt.count_syscalls)
+      r.syscalls = CountSyscalls(mode, &opt);
+
+    double ticks = (double)opt.ticks;
+    printf("%-10s %10.1f %8.1f %12.2f ", mode->name, r.ns_per_tick, r.p99_us,
+           (double)r.allocs / ticks);
+    if (r.syscalls >= 0)
+      printf("%14.2f", (double)r.syscalls / ticks);
+    else
+      printf("%14s", "-");
+    printf(" %11.1f\n", (double)r.bytes / ticks);
+  }
+
+  nftw(g_root, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+  return failed;
+}
@@ -0,0 +1,214 @@
+/*
+ * Stratus ATC - Airport Index
+ *
+ * See stratus_airports.h.
+ */
+
+#include "stratus_airports.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NM_PER_DEG 60.0
+#define DEG_TO_RAD 0.017453292519943295
+#define TILE_ROWS 180
+#define TILE_COLS 360
+
+/* The file as read; the pointers below point into it */
+static uint8_t *g_data = NULL;
+static const uint32_t *g_tiles = NULL;
+static const StratusAirport *g_airports = NULL;
+static const StratusRunway *g_runways = NULL;
+static uint32_t g_airport_count = 0;
+static uint32_t g_runway_count = 0;
+
+static int Valid(const uint8_t *data, size_t size) {
+  StratusAirportsHeader h;
+  if (size < sizeof(h))
+    return 0;
+  memcpy(&h, data, sizeof(h));
+  if (h.magic != STRATUS_AIRPORTS_MAGIC ||
+      h.version != STRATUS_AIRPORTS_VERSION ||
+      h.header_size != sizeof(h) || h.airport_size != sizeof(StratusAirport) ||
+      h.runway_size != sizeof(StratusRunway))
+    return 0;
+  size_t expected = sizeof(h) + (STRATUS_AIRPORT_TILES + 1) * sizeof(uint32_t) +
+                    (size_t)h.airport_count * sizeof(StratusAirport) +
+                    (size_t)h.runway_count * sizeof(StratusRunway);
+  if (size != expected)
+    return 0;
+
+  const uint32_t *tiles = (const uint32_t *)(data + sizeof(h));
+  if (tiles[0] != 0 || tiles[STRATUS_AIRPORT_TILES] != h.airport_count)
+    return 0;
+  for (size_t i = 0; i < STRATUS_AIRPORT_TILES; i++) {
+    if (tiles[i] > tiles[i + 1])
+      return 0;
+  }
+  const StratusAirport *airports =
+      (const StratusAirport *)(tiles + STRATUS_AIRPORT_TILES + 1);
+  for (uint32_t i = 0; i < h.airport_count; i++) {
+    if ((uint64_t)airports[i].first_runway + airports[i].runway_count >
+        h.runway_count)
+      return 0;
+  }
+  return 1;
+}
+
+int StratusAirports_Load(const char *path) {
+  StratusAirports_Unload();
+
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return 0;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    size = ftell(f);
+  uint8_t *data = size > 0 ? malloc((size_t)size) : NULL;
+  int ok = data && fseek(f, 0, SEEK_SET) == 0 &&
+           fread(data, 1, (size_t)size, f) == (size_t)size &&
+           Valid(data, (size_t)size);
+  fclose(f);
+  if (!ok) {
+    free(data);
+    return 0;
+  }
+
+  StratusAirportsHeader h;
+  memcpy(&h, data, sizeof(h));
+  g_data = data;
+  g_tiles = (const uint32_t *)(data + sizeof(h));
+  g_airports = (const StratusAirport *)(g_tiles + STRATUS_AIRPORT_TILES + 1);
+  g_runways = (const StratusRunway *)(g_airports + h.airport_count);
+  g_airport_count = h.airport_count;
+  g_runway_count = h.runway_count;
+  return 1;
+}
+
+void StratusAirports_Unload(void) {
+  free(g_data);
+  g_data = NULL;
+  g_tiles = NULL;
+  g_airports = NULL;
+  g_runways = NULL;
+  g_airport_count = 0;
+  g_runway_count = 0;
+}
+
+uint32_t StratusAirports_Count(void) { return g_airport_count; }
+
+/* Degrees into [-180, 180) */
+static double WrapDeg(double d) {
+  d = fmod(d + 180.0, 360.0);
+  return (d < 0.0 ? d + 360.0 : d) - 180.0;
+}
+
+/* Shortest longitude distance from `lon` to columns [west, west + width) */
+static double LonGap(double lon, double west, double width) {
+  double into = fmod(lon - west, 360.0);
+  if (into < 0.0)
+    into += 360.0;
+  if (into < width)
+    return 0.0;
+  double past = into - width;
+  double before = 360.0 - into;
+  return past < before ? past : before;
+}
+
+/* cos() of the latitude closest to a pole in rows [row, row + rows) and
+ * at `lat`, the smallest east-west scale anywhere in between */
+static double MinCos(int row, int rows, double lat) {
+  double south = fabs(row - 90.0);
+  double north = fabs(row + rows - 90.0);
+  double m = fabs(lat);
+  if (south > m)
+    m = south;
+  if (north > m)
+    m = north;
+  return m >= 90.0 ? 0.0 : cos(m * DEG_TO_RAD);
+}
+
+const StratusAirport *StratusAirports_Nearest(double lat, double lon,
+                                              double range_nm,
+                                              double *dist_nm) {
+  if (!g_airports || !(range_nm > 0.0))
+    return NULL;
+
+  double y = lat + 90.0;
+  double x = WrapDeg(lon) + 180.0;
+  int row0 = (int)floor(y);
+  int col0 = (int)floor(x);
+  if (row0 > TILE_ROWS - 1)
+    row0 = TILE_ROWS - 1;
+  if (row0 < 0)
+    row0 = 0;
+  if (col0 > TILE_COLS - 1)
+    col0 = TILE_COLS - 1;
+
+  double scale = cos(lat * DEG_TO_RAD) * NM_PER_DEG; /* nm per degree east */
+  double best2 = range_nm * range_nm;
+  const StratusAirport *best = NULL;
+
+  for (int k = 0; k < TILE_ROWS; k++) {
+    /* Nothing in ring k is closer than the edge of rings 0 .. k-1 */
+    if (k > 0) {
+      int box_row = row0 - (k - 1), box_rows = 2 * k - 1;
+      double lat_gap = fmin(y - box_row, box_row + box_rows - y);
+      double bound = lat_gap * NM_PER_DEG;
+      if (box_rows < TILE_COLS) {
+        double lon_gap = fmin(x - (col0 - (k - 1)), col0 + k - x);
+        double lon_nm =
+            lon_gap * MinCos(box_row, box_rows, lat) * NM_PER_DEG;
+        if (lon_nm < bound)
+          bound = lon_nm;
+      }
+      if (bound * bound >= best2)
+        break;
+    }
+
+    for (int dr = -k; dr <= k; dr++) {
+      int row = row0 + dr;
+      if (row < 0 || row >= TILE_ROWS)
+        continue;
+      int edge_row = dr == -k || dr == k;
+      double lat_gap = fmax(0.0, fmax(row - y, y - (row + 1)));
+      double row_cos = MinCos(row, 1, lat) * NM_PER_DEG;
+      for (int dc = -k; dc <= k; dc++) {
+        if (!edge_row && dc != -k && dc != k)
+          continue; /* Inside the ring: an earlier ring's tile */
+        if (2 * k + 1 > TILE_COLS && (dc < -(TILE_COLS / 2 - 1) ||
+                                      dc > TILE_COLS / 2))
+          continue; /* Wrapped around: every column once */
+        int col = ((col0 + dc) % TILE_COLS + TILE_COLS) % TILE_COLS;
+
+        /* Skip tiles whose nearest corner is already too far */
+        double gx = LonGap(x, col, 1.0) * row_cos;
+        double gy = lat_gap * NM_PER_DEG;
+        if (gx * gx + gy * gy >= best2)
+          continue;
+
+        size_t tile = (size_t)row * TILE_COLS + (size_t)col;
+        for (uint32_t i = g_tiles[tile]; i < g_tiles[tile + 1]; i++) {
+          const StratusAirport *a = &g_airports[i];
+          double ex = WrapDeg(a->lon_e7 * 1e-7 - lon) * scale;
+          double ny = (a->lat_e7 * 1e-7 - lat) * NM_PER_DEG;
+          double d2 = ex * ex + ny * ny;
+          if (d2 < best2) {
+            best2 = d2;
+            best = a;
+          }
+        }
+      }
+    }
+  }
+
+  if (best && dist_nm)
+    *dist_nm = sqrt(best2);
+  return best;
+}
+
+const StratusRunway *StratusAirports_Runways(const StratusAirport *a) {
+  return g_runways + a->first_runway;
+}
@@ -0,0 +1,103 @@
+/*
+ * Stratus ATC - Airport Index
+ *
+ * Airports and runways for the derived state (stratus_derived.h), from a
+ * precomputed file in the data directory, `stratus_airports.bin`, that
+ * scripts/build_airport_index.py builds from the OurAirports CSVs. The
+ * plugin reads it once at startup; after that, lookups are arithmetic on
+ * the loaded arrays: no allocation, no I/O.
+ *
+ * Airports are sorted into 1 x 1 degree tiles (latitude rows from the south
+ * pole, longitude columns from 180 W). A table of tile start offsets gives
+ * each tile's airports as one contiguous run, so a nearest-airport query
+ * reads the aircraft's tile and only as many rings of tiles around it as
+ * can still hold something closer. Each airport's runways are a contiguous
+ * run of the runway array.
+ *
+ * Layout (little-endian):
+ *   [StratusAirportsHeader, 32 bytes]
+ *   [uint32_t tile_start[STRATUS_AIRPORT_TILES + 1]]  (into airports)
+ *   [StratusAirport x airport_count]  (by tile)
+ *   [StratusRunway x runway_count]    (by airport)
+ *
+ * Distances use a flat-earth approximation around the aircraft, well under
+ * 1% off within the ranges the derived state asks for.
+ */
+
+#ifndef STRATUS_AIRPORTS_H
+#define STRATUS_AIRPORTS_H
+
+#include "stratus_frame.h"
+
+#include <stdint.h>
+
+#define STRATUS_AIRPORTS_FILE "stratus_airports.bin"
+#define STRATUS_AIRPORTS_MAGIC 0x50415453u /* "STAP" */
+#define STRATUS_AIRPORTS_VERSION 1
+#define STRATUS_AIRPORT_TILES (180 * 360)
+
+typedef struct StratusAirportsHeader {
+  uint32_t magic;        /* STRATUS_AIRPORTS_MAGIC */
+  uint16_t version;      /* STRATUS_AIRPORTS_VERSION */
+  uint16_t header_size;  /* sizeof(StratusAirportsHeader) */
+  uint16_t airport_size; /* sizeof(StratusAirport) */
+  uint16_t runway_size;  /* sizeof(StratusRunway) */
+  uint32_t airport_count;
+  uint32_t runway_count;
+  uint8_t _reserved[12];
+} StratusAirportsHeader;
+
+typedef struct StratusAirport {
+  int32_t lat_e7; /* Reference point, degrees * 1e7 */
+  int32_t lon_e7;
+  char ident[STRATUS_AIRPORT_ID_LEN]; /* NUL-padded; idents fit in 7 */
+  int16_t elevation_ft;
+  uint8_t type; /* StratusAirportType */
+  uint8_t runway_count;
+  uint32_t first_runway;
+} StratusAirport;
+
+/* Runways with both threshold positions; ends as OurAirports names them */
+typedef struct StratusRunway {
+  int32_t le_lat_e7; /* Low end threshold */
+  int32_t le_lon_e7;
+  int32_t he_lat_e7; /* High end threshold */
+  int32_t he_lon_e7;
+  char le_ident[STRATUS_RUNWAY_ID_LEN]; /* "09L"; NUL-padded */
+  char he_ident[STRATUS_RUNWAY_ID_LEN];
+  uint16_t length_ft;
+  uint16_t width_ft; /* 0 if unknown */
+} StratusRunway;
+
+_Static_assert(sizeof(StratusAirportsHeader) == 32,
+               "StratusAirportsHeader layout changed");
+_Static_assert(sizeof(StratusAirport) == 24, "StratusAirport layout changed");
+_Static_assert(sizeof(StratusRunway) == 28, "StratusRunway layout changed");
+
+typedef enum {
+  STRATUS_AIRPORT_SMALL,
+  STRATUS_AIRPORT_MEDIUM,
+  STRATUS_AIRPORT_LARGE,
+  STRATUS_AIRPORT_SEAPLANE
+} StratusAirportType;
+
+/* Read the index at `path`, replacing any loaded one. Returns 1 on success;
+ * on failure (missing, truncated, other version) no index is loaded. */
+int StratusAirports_Load(const char *path);
+
+/* Free the loaded index */
+void StratusAirports_Unload(void);
+
+/* Airports in the loaded index, 0 without one */
+uint32_t StratusAirports_Count(void);
+
+/* Nearest airport within `range_nm` of the position, with its distance in
+ * `*dist_nm`; NULL if there is none or no index */
+const StratusAirport *StratusAirports_Nearest(double lat, double lon,
+                                              double range_nm,
+                                              double *dist_nm);
+
+/* Runways of `a`, `a->runway_count` of them */
+const StratusRunway *StratusAirports_Runways(const StratusAirport *a);
+
+#endif /* STRATUS_AIRPORTS_H */
@@ -0,0 +1,198 @@
+/*
+ * Stratus ATC - ATC State DataRefs and Commands
+ *
+ * See stratus_atc.h.
+ */
+
+#include "stratus_atc.h"
+
+#include "XPLMDataAccess.h"
+#include "XPLMUtilities.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static StratusCommander *g_commander = NULL;
+static StratusAtcState g_state; /* Last copy from the commander */
+static int g_ptt_active = 0;
+
+/* ============================================================================
+ * DataRefs
+ * ============================================================================
+ */
+
+typedef enum {
+  FIELD_SQUAWK,
+  FIELD_FREQUENCY,
+  FIELD_ALTITUDE,
+  FIELD_HEADING,
+  FIELD_CLEARANCE,
+  FIELD_CLEARANCE_SEQ,
+  FIELD_PTT,
+  FIELD_LAST_OP,
+  FIELD_LAST_RESULT,
+  FIELD_COMMANDS_APPLIED,
+  FIELD_COUNT_
+} AtcField;
+
+static const char *const kFieldNames[FIELD_COUNT_] = {
+    "stratus/atc/squawk",
+    "stratus/atc/frequency",
+    "stratus/atc/altitude_ft",
+    "stratus/atc/heading_deg",
+    "stratus/atc/clearance",
+    "stratus/atc/clearance_seq",
+    "stratus/atc/ptt",
+    "stratus/atc/last_command_op",
+    "stratus/atc/last_command_result",
+    "stratus/atc/commands_applied"};
+
+static XPLMDataRef g_datarefs[FIELD_COUNT_];
+
+static double FieldValue(void *refcon) {
+  switch ((AtcField)(intptr_t)refcon) {
+  case FIELD_SQUAWK:
+    return g_state.squawk;
+  case FIELD_FREQUENCY:
+    return g_state.frequency;
+  case FIELD_ALTITUDE:
+    return g_state.altitude_ft;
+  case FIELD_HEADING:
+    return g_state.heading_deg;
+  case FIELD_CLEARANCE_SEQ:
+    return g_state.clearance_seq;
+  case FIELD_PTT:
+    return g_ptt_active;
+  case FIELD_LAST_OP:
+    return g_state.last_op;
+  case FIELD_LAST_RESULT:
+    return g_state.last_result;
+  case FIELD_COMMANDS_APPLIED:
+    return g_state.commands_applied;
+  default:
+    return 0.0;
+  }
+}
+
+static int GetFieldInt(void *refcon) { return (int)FieldValue(refcon); }
+static float GetFieldFloat(void *refcon) { return (float)FieldValue(refcon); }
+
+/* The clearance text with its NUL, as a byte array */
+static int GetClearance(void *refcon, void *out, int offset, int max_len) {
+  (void)refcon;
+  int len = (int)strlen(g_state.clearance) + 1;
+  if (!out)
+    return len;
+  if (offset < 0 || offset >= len || max_len <= 0)
+    return 0;
+  int n = len - offset < max_len ? len - offset : max_len;
+  memcpy(out, g_state.clearance + offset, (size_t)n);
+  return n;
+}
+
+static void RegisterDataRefs(void) {
+  for (int i = 0; i < FIELD_COUNT_; i++) {
+    if (g_datarefs[i])
+      continue;
+    void *refcon = (void *)(intptr_t)i;
+    if (i == FIELD_CLEARANCE)
+      g_datarefs[i] = XPLMRegisterDataAccessor(
+          kFieldNames[i], xplmType_Data, 0, NULL, NULL, NULL, NULL, NULL,
+          NULL, NULL, NULL, NULL, NULL, GetClearance, NULL, refcon, NULL);
+    else if (i == FIELD_ALTITUDE || i == FIELD_HEADING)
+      g_datarefs[i] = XPLMRegisterDataAccessor(
+          kFieldNames[i], xplmType_Float, 0, NULL, NULL, GetFieldFloat, NULL,
+          NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, refcon, NULL);
+    else
+      g_datarefs[i] = XPLMRegisterDataAccessor(
+          kFieldNames[i], xplmType_Int, 0, GetFieldInt, NULL, NULL, NULL,
+          NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, refcon, NULL);
+  }
+}
+
+/* ============================================================================
+ * Commands
+ * ============================================================================
+ */
+
+typedef struct AtcCommand {
+  const char *name;
+  const char *description;
+  StratusComplyAction action;
+  XPLMCommandRef ref;
+} AtcCommand;
+
+static AtcCommand g_commands[] = {
+    {"stratus/atc/squawk_assigned",
+     "Stratus ATC - Set the transponder to the assigned squawk",
+     STRATUS_COMPLY_SQUAWK, NULL},
+    {"stratus/atc/tune_frequency",
+     "Stratus ATC - Tune COM1 standby to the next ATC frequency",
+     STRATUS_COMPLY_FREQUENCY, NULL},
+    {"stratus/atc/set_altitude",
+     "Stratus ATC - Set the autopilot altitude to the assigned altitude",
+     STRATUS_COMPLY_ALTITUDE, NULL},
+    {"stratus/atc/set_heading",
+     "Stratus ATC - Set the autopilot heading to the assigned heading",
+     STRATUS_COMPLY_HEADING, NULL}};
+
+#define ATC_COMMAND_COUNT (int)(sizeof(g_commands) / sizeof(g_commands[0]))
+
+static int ComplyHandler(XPLMCommandRef command, XPLMCommandPhase phase,
+                         void *refcon) {
+  (void)command;
+  if (phase != xplm_CommandBegin || !g_commander)
+    return 0;
+  const AtcCommand *c = (const AtcCommand *)refcon;
+  stratus_commander_comply(g_commander, (uint32_t)c->action);
+  StratusAtc_Update(); /* Publish the outcome before the next flight loop */
+  return 0;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================
+ */
+
+void StratusAtc_Register(StratusCommander *commander) {
+  g_commander = commander;
+  memset(&g_state, 0, sizeof(g_state));
+  g_state.squawk = STRATUS_ATC_NONE;
+  g_state.frequency = STRATUS_ATC_NONE;
+  g_state.altitude_ft = STRATUS_ATC_NONE;
+  g_state.heading_deg = STRATUS_ATC_NONE;
+  StratusAtc_Update();
+
+  RegisterDataRefs();
+  for (int i = 0; i < ATC_COMMAND_COUNT; i++) {
+    AtcCommand *c = &g_commands[i];
+    if (c->ref)
+      continue;
+    c->ref = XPLMCreateCommand(c->name, c->description);
+    XPLMRegisterCommandHandler(c->ref, ComplyHandler, 1, c);
+  }
+}
+
+void StratusAtc_Update(void) {
+  if (g_commander)
+    stratus_commander_atc_state(g_commander, &g_state);
+}
+
+void StratusAtc_SetPtt(int active) { g_ptt_active = active; }
+
+void StratusAtc_Unregister(void) {
+  for (int i = 0; i < ATC_COMMAND_COUNT; i++) {
+    AtcCommand *c = &g_commands[i];
+    if (c->ref) {
+      XPLMUnregisterCommandHandler(c->ref, ComplyHandler, 1, c);
+      c->ref = NULL;
+    }
+  }
+  for (int i = 0; i < FIELD_COUNT_; i++) {
+    if (g_datarefs[i]) {
+      XPLMUnregisterDataAccessor(g_datarefs[i]);
+      g_datarefs[i] = NULL;
+    }
+  }
+  g_commander = NULL;
+}
@@ -0,0 +1,54 @@
+/*
+ * Stratus ATC - ATC State DataRefs and Commands
+ *
+ * What ATC has assigned (sent by the client with SET_ATC and kept by the
+ * commander, see stratus_commander.h) is published as read-only DataRefs,
+ * so other plugins, cockpit panels and instrument software read it at sim
+ * speed instead of polling files:
+ *
+ *   stratus/atc/squawk              int    Assigned code, -1 if none
+ *   stratus/atc/frequency           int    Next frequency (SET_RADIO units)
+ *   stratus/atc/altitude_ft         float  Assigned altitude, -1 if none
+ *   stratus/atc/heading_deg         float  Assigned heading (magnetic)
+ *   stratus/atc/clearance           data   Last clearance, NUL-terminated
+ *   stratus/atc/clearance_seq       int    Bumped when the clearance changes
+ *   stratus/atc/ptt                 int    1 while stratus/ptt is held
+ *   stratus/atc/last_command_op     int    OP_* of the last command applied
+ *   stratus/atc/last_command_result int    Its ACK_* result, 0 = applied
+ *   stratus/atc/commands_applied    int    Since plugin start
+ *
+ * Commands for hardware buttons write the assignment through the commander
+ * directly, with no command-file round trip, and are acked on the command
+ * ring like client commands:
+ *
+ *   stratus/atc/squawk_assigned     Transponder to the assigned code
+ *   stratus/atc/tune_frequency      Next frequency into COM1 standby
+ *   stratus/atc/set_altitude        Autopilot altitude to the assigned one
+ *   stratus/atc/set_heading         Autopilot heading to the assigned one
+ *
+ * Sim thread only.
+ */
+
+#ifndef STRATUS_ATC_H
+#define STRATUS_ATC_H
+
+#include "stratus_commander.h"
+
+/* Register the DataRefs and commands. The plugin calls this from
+ * XPluginStart with no commander, so the DataRefs exist from the start, and
+ * again from its deferred init (first flight-loop tick) once the commander
+ * exists. DataRefs read as "nothing assigned" without one. */
+void StratusAtc_Register(StratusCommander *commander);
+
+/* Refresh the published state from the commander. Call each flight loop
+ * after stratus_commander_apply(); a no-op unless something changed. */
+void StratusAtc_Update(void);
+
+/* PTT state for stratus/atc/ptt (from the stratus/ptt handler) */
+void StratusAtc_SetPtt(int active);
+
+/* Remove the DataRefs and commands. Call from XPluginStop before the
+ * commander is destroyed. */
+void StratusAtc_Unregister(void);
+
+#endif /* STRATUS_ATC_H */
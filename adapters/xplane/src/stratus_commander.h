@@ -0,0 +1,107 @@
+/*
+ * Stratus ATC - Rust Commander FFI (stratus-rs/stratus-commander)
+ *
+ * The commander owns the client command file and the writable DataRefs used
+ * to apply commands. One handle is created by the plugin's deferred init, on
+ * the first flight-loop tick, and kept for the life of the plugin:
+ *
+ *   stratus_commander_create()  - sim thread, resolves DataRefs once
+ *   stratus_commander_poll()    - I/O thread, reads/parses new commands
+ *   stratus_commander_submit()  - I/O thread, queues command lines that
+ *                                 arrived another way (UDP stream)
+ *   stratus_commander_apply()   - sim thread, drains the /stratus_commands
+ *                                 shared-memory ring and queued file
+ *                                 commands, then writes the latest per
+ *                                 target, most urgent first; acks each in
+ *                                 the ring
+ *   stratus_commander_set_budget_us() - sim thread, caps the time one apply
+ *                                 spends writing; the rest waits a call
+ *   stratus_commander_rate_hz() - sim thread, client-requested telemetry rate
+ *   stratus_commander_atc_state() - sim thread, copies out the ATC state
+ *                                 (SET_ATC plus the last command's outcome)
+ *   stratus_commander_comply() - sim thread, writes an ATC assignment for a
+ *                                 stratus/atc/ command (see stratus_atc.h)
+ *   stratus_commander_map()     - sim thread, points a written field at an
+ *                                 aircraft profile's DataRef (and command)
+ *   stratus_commander_reset_map() - sim thread, back to the stock DataRefs
+ *   stratus_commander_destroy() - XPluginStop, after the I/O thread is gone
+ *
+ * Not tied to a handle: stratus_push_telemetry() (sim thread) publishes a
+ * captured frame to Rust consumers in the same process, which read it
+ * lock-free from stratus_commander::TELEMETRY (snapshot.rs).
+ */
+
+#ifndef STRATUS_COMMANDER_H
+#define STRATUS_COMMANDER_H
+
+#include "stratus_frame.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct StratusCommander StratusCommander;
+
+#define STRATUS_ATC_CLEARANCE_LEN 256
+#define STRATUS_ATC_NONE (-1) /* Any assignment field when none is set */
+
+/* Mirrors AtcState in stratus-commander/src/atc.rs */
+typedef struct StratusAtcState {
+  uint64_t seq; /* Bumped on every change; 0 = never filled */
+  int32_t squawk;
+  int32_t frequency; /* Next frequency to contact, SET_RADIO units */
+  float altitude_ft;
+  float heading_deg;      /* Magnetic */
+  uint32_t clearance_seq; /* Bumped when the clearance text changes */
+  uint32_t last_op;       /* Ring OP_* code of the last command applied */
+  int32_t last_result;    /* Its ACK_* result, 0 = applied */
+  uint32_t commands_applied;
+  char clearance[STRATUS_ATC_CLEARANCE_LEN]; /* NUL-terminated UTF-8 */
+} StratusAtcState;
+
+_Static_assert(sizeof(StratusAtcState) == 296,
+               "StratusAtcState layout changed");
+
+/* Actions for stratus_commander_comply() */
+typedef enum {
+  STRATUS_COMPLY_SQUAWK = 1,    /* Transponder to the assigned code */
+  STRATUS_COMPLY_FREQUENCY = 2, /* Next frequency into COM1 standby */
+  STRATUS_COMPLY_ALTITUDE = 3,  /* Autopilot altitude to the assigned one */
+  STRATUS_COMPLY_HEADING = 4    /* Autopilot heading to the assigned one */
+} StratusComplyAction;
+
+StratusCommander *stratus_commander_create(const char *command_path,
+                                           const char *status_path);
+int stratus_commander_poll(StratusCommander *handle);
+/* Queue `len` bytes of command-file lines; returns the number queued */
+int stratus_commander_submit(StratusCommander *handle, const char *text,
+                             size_t len);
+int stratus_commander_apply(StratusCommander *handle);
+/* 0 = no limit; at least one command is written per apply */
+void stratus_commander_set_budget_us(StratusCommander *handle,
+                                     uint32_t budget_us);
+/* Telemetry rate a client asked for with SET_RATE, 0 = plugin's choice */
+float stratus_commander_rate_hz(StratusCommander *handle);
+/* Copy the ATC state into `out` unless out->seq is current; returns 1 if it
+ * copied, 0 if unchanged, -1 on invalid arguments */
+int stratus_commander_atc_state(StratusCommander *handle,
+                                StratusAtcState *out);
+/* Carry out an assignment; returns the ACK_* result (acked on the ring too),
+ * -1 on invalid handle */
+int stratus_commander_comply(StratusCommander *handle, uint32_t action);
+/* `field` is "<section>.<key>" (stratus_profile.h); `dataref` NULL = stock,
+ * `scale` 0 = 1, `command` NULL = none. Returns 1 mapped, 0 if the commander
+ * never writes `field`, -1 if the DataRef or command was not found. */
+int stratus_commander_map(StratusCommander *handle, const char *field,
+                          const char *dataref, float scale,
+                          const char *command);
+void stratus_commander_reset_map(StratusCommander *handle);
+void stratus_commander_destroy(StratusCommander *handle);
+
+/* Copies `frame` into the in-process snapshot; never blocks */
+void stratus_push_telemetry(const StratusFrame *frame);
+
+/* Legacy one-shot entry point: read + apply, no state kept */
+int process_stratus_commands(const char *command_path,
+                             const char *status_path);
+
+#endif /* STRATUS_COMMANDER_H */
@@ -0,0 +1,224 @@
+/*
+ * Stratus ATC - Plugin Configuration
+ *
+ * See stratus_config.h.
+ */
+
+#include "stratus_config.h"
+
+#include "stratus_json.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+void StratusConfig_Defaults(StratusConfig *cfg) {
+  memset(cfg, 0, sizeof(*cfg));
+  strcpy(cfg->transport, "both");
+  strcpy(cfg->format, "json");
+  strcpy(cfg->in_process, "off");
+  cfg->rate_hz = 10.0f;
+  cfg->idle_rate_hz = 1.0f;
+  cfg->approach_rate_hz = 25.0f;
+  cfg->max_rate_hz = 50.0f;
+  cfg->approach_agl_ft = 3000.0f;
+  cfg->command_poll_ms = 100;
+  cfg->command_rate_hz = 30.0f;
+  cfg->command_budget_us = 200;
+  cfg->radio_rate_hz = 2.0f;
+  cfg->event_rate_hz = 30.0f;
+  strcpy(cfg->publish, "full");
+  cfg->keyframe_interval_s = 5.0f;
+  cfg->deadband_position_deg = 0.00001f;
+  cfg->deadband_altitude_ft = 10.0f;
+  cfg->deadband_angle_deg = 0.5f;
+  cfg->deadband_speed = 0.5f;
+  cfg->deadband_vs_fpm = 50.0f;
+  strcpy(cfg->log_level, "info");
+  cfg->log_max_kb = 1024;
+  cfg->log_keep = 3;
+  cfg->perf_budget_us = 1000;
+  cfg->perf_dump_s = 60;
+  strcpy(cfg->record, "off");
+  strcpy(cfg->server, "off");
+  strcpy(cfg->udp, "off");
+  cfg->traffic_rate_hz = 1.0f;
+  cfg->airport_range_nm = 50.0f;
+}
+
+static char *Trim(char *s) {
+  while (isspace((unsigned char)*s))
+    s++;
+  char *end = s + strlen(s);
+  while (end > s && isspace((unsigned char)end[-1]))
+    *--end = '\0';
+  return s;
+}
+
+static int ParseFloat(const char *value, float min, float max, float *out) {
+  double parsed;
+  if (!StratusJson_ParseDouble(value, &parsed))
+    return 0;
+  float v = (float)parsed;
+  if (v < min || v > max)
+    return 0;
+  *out = v;
+  return 1;
+}
+
+static int ParseText(const char *value, char *out, size_t size) {
+  if (strlen(value) >= size)
+    return 0;
+  strcpy(out, value);
+  return 1;
+}
+
+static int ParseString(const char *value, char *out) {
+  return ParseText(value, out, STRATUS_CONFIG_VALUE_LEN);
+}
+
+static int Apply(StratusConfig *cfg, const char *key, const char *value) {
+  if (strcmp(key, "transport") == 0)
+    return ParseString(value, cfg->transport);
+  if (strcmp(key, "format") == 0)
+    return ParseString(value, cfg->format);
+  if (strcmp(key, "in_process") == 0)
+    return ParseString(value, cfg->in_process);
+  if (strcmp(key, "rate_hz") == 0)
+    return ParseFloat(value, 0.1f, 100.0f, &cfg->rate_hz);
+  if (strcmp(key, "idle_rate_hz") == 0)
+    return ParseFloat(value, 0.1f, 100.0f, &cfg->idle_rate_hz);
+  if (strcmp(key, "approach_rate_hz") == 0)
+    return ParseFloat(value, 0.1f, 100.0f, &cfg->approach_rate_hz);
+  if (strcmp(key, "max_rate_hz") == 0)
+    return ParseFloat(value, 0.1f, 100.0f, &cfg->max_rate_hz);
+  if (strcmp(key, "approach_agl_ft") == 0)
+    return ParseFloat(value, 0.0f, 50000.0f, &cfg->approach_agl_ft);
+  if (strcmp(key, "command_poll_ms") == 0) {
+    float ms;
+    if (!ParseFloat(value, 10.0f, 10000.0f, &ms))
+      return 0;
+    cfg->command_poll_ms = (unsigned)ms;
+    return 1;
+  }
+  if (strcmp(key, "command_rate_hz") == 0)
+    return ParseFloat(value, 1.0f, 100.0f, &cfg->command_rate_hz);
+  if (strcmp(key, "command_budget_us") == 0) {
+    float us;
+    if (!ParseFloat(value, 0.0f, 100000.0f, &us))
+      return 0;
+    cfg->command_budget_us = (unsigned)us;
+    return 1;
+  }
+  if (strcmp(key, "radio_rate_hz") == 0)
+    return ParseFloat(value, 0.0f, 100.0f, &cfg->radio_rate_hz);
+  if (strcmp(key, "event_rate_hz") == 0)
+    return ParseFloat(value, 0.0f, 100.0f, &cfg->event_rate_hz);
+  if (strcmp(key, "publish") == 0)
+    return ParseString(value, cfg->publish);
+  if (strcmp(key, "keyframe_interval_s") == 0)
+    return ParseFloat(value, 0.0f, 3600.0f, &cfg->keyframe_interval_s);
+  if (strcmp(key, "deadband_position_deg") == 0)
+    return ParseFloat(value, 0.0f, 1.0f, &cfg->deadband_position_deg);
+  if (strcmp(key, "deadband_altitude_ft") == 0)
+    return ParseFloat(value, 0.0f, 1000.0f, &cfg->deadband_altitude_ft);
+  if (strcmp(key, "deadband_angle_deg") == 0)
+    return ParseFloat(value, 0.0f, 45.0f, &cfg->deadband_angle_deg);
+  if (strcmp(key, "deadband_speed") == 0)
+    return ParseFloat(value, 0.0f, 100.0f, &cfg->deadband_speed);
+  if (strcmp(key, "deadband_vs_fpm") == 0)
+    return ParseFloat(value, 0.0f, 5000.0f, &cfg->deadband_vs_fpm);
+  if (strcmp(key, "log_level") == 0)
+    return ParseString(value, cfg->log_level);
+  if (strcmp(key, "log_max_kb") == 0) {
+    float kb;
+    if (!ParseFloat(value, 0.0f, 1048576.0f, &kb))
+      return 0;
+    cfg->log_max_kb = (unsigned)kb;
+    return 1;
+  }
+  if (strcmp(key, "log_keep") == 0) {
+    float keep;
+    if (!ParseFloat(value, 0.0f, 9.0f, &keep))
+      return 0;
+    cfg->log_keep = (int)keep;
+    return 1;
+  }
+  if (strcmp(key, "perf_budget_us") == 0) {
+    float us;
+    if (!ParseFloat(value, 1.0f, 1000000.0f, &us))
+      return 0;
+    cfg->perf_budget_us = (unsigned)us;
+    return 1;
+  }
+  if (strcmp(key, "perf_dump_s") == 0) {
+    float secs;
+    if (!ParseFloat(value, 0.0f, 86400.0f, &secs))
+      return 0;
+    cfg->perf_dump_s = (unsigned)secs;
+    return 1;
+  }
+  if (strcmp(key, "record") == 0)
+    return ParseString(value, cfg->record);
+  if (strcmp(key, "server") == 0)
+    return ParseString(value, cfg->server);
+  if (strcmp(key, "udp") == 0)
+    return ParseText(value, cfg->udp, sizeof(cfg->udp));
+  if (strcmp(key, "traffic_rate_hz") == 0)
+    return ParseFloat(value, 0.0f, 10.0f, &cfg->traffic_rate_hz);
+  if (strcmp(key, "airport_range_nm") == 0)
+    return ParseFloat(value, 0.0f, 500.0f, &cfg->airport_range_nm);
+  return -1;
+}
+
+int StratusConfig_Load(StratusConfig *cfg, const char *path,
+                       void (*warn)(const char *msg)) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return 0;
+
+  char line[256];
+  char msg[320];
+  int lineno = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = '\0';
+    char *text = Trim(line);
+    if (*text == '\0')
+      continue;
+
+    char *eq = strchr(text, '=');
+    if (!eq) {
+      if (warn) {
+        snprintf(msg, sizeof(msg), "%s:%d: expected key = value", path,
+                 lineno);
+        warn(msg);
+      }
+      continue;
+    }
+    *eq = '\0';
+    char *key = Trim(text);
+    char *value = Trim(eq + 1);
+
+    int ok = Apply(cfg, key, value);
+    if (ok < 0 && warn) {
+      snprintf(msg, sizeof(msg), "%s:%d: unknown key '%s'", path, lineno, key);
+      warn(msg);
+    } else if (ok == 0 && warn) {
+      snprintf(msg, sizeof(msg), "%s:%d: bad value for '%s': '%s'", path,
+               lineno, key, value);
+      warn(msg);
+    }
+  }
+
+  fclose(f);
+
+  /* Keep the rate bands ordered so the controller never inverts them */
+  if (cfg->max_rate_hz < cfg->rate_hz)
+    cfg->max_rate_hz = cfg->rate_hz;
+  if (cfg->max_rate_hz < cfg->approach_rate_hz)
+    cfg->max_rate_hz = cfg->approach_rate_hz;
+  return 1;
+}
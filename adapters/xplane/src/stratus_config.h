@@ -0,0 +1,127 @@
+/*
+ * Stratus ATC - Plugin Configuration
+ *
+ * Settings are read once at XPluginStart from `stratus_plugin.cfg` in the
+ * data directory. The file is optional; a missing file or key keeps the
+ * default. Format is one `key = value` per line, `#` starts a comment:
+ *
+ *   # Telemetry transport: json | shm | both
+ *   transport = both
+ *   # Telemetry file format: json | binary | both
+ *   format = json
+ *   # Also hand each frame to Rust consumers inside the plugin's process
+ *   # (stratus_push_telemetry): off | on
+ *   in_process = off
+ *   # Telemetry rates (Hz)
+ *   rate_hz = 10
+ *   idle_rate_hz = 1
+ *   approach_rate_hz = 25
+ *   max_rate_hz = 50
+ *   # Below this height AGL, descending, counts as approach
+ *   approach_agl_ft = 3000
+ *   # Command file poll interval, and how often parsed commands are applied
+ *   command_poll_ms = 100
+ *   command_rate_hz = 30
+ *   # Time one run may spend writing commands; the rest of a burst waits
+ *   # for the next run, most urgent first (0 = no limit)
+ *   command_budget_us = 200
+ *   # Radios, transponder, autopilot and engines: read at this rate and
+ *   # after each applied command, not with every frame (0 = every frame)
+ *   radio_rate_hz = 2
+ *   # Check for touchdown, pause, radio and transponder changes this often
+ *   # and publish at once when one happens (stratus_events.h; 0 = only
+ *   # with each frame)
+ *   event_rate_hz = 30
+ *   # Telemetry file publishing: full (every tick) | delta
+ *   publish = full
+ *   # Delta mode: full keyframe at least this often, deltas in between
+ *   keyframe_interval_s = 5
+ *   # Delta mode dead-bands: smaller changes are not published
+ *   deadband_position_deg = 0.00001
+ *   deadband_altitude_ft = 10
+ *   deadband_angle_deg = 0.5
+ *   deadband_speed = 0.5
+ *   deadband_vs_fpm = 50
+ *   # Plugin log: minimum level (debug | info | warn | error | off),
+ *   # rotate stratus_atc.log at this size (0 = never), keep this many old logs
+ *   log_level = info
+ *   log_max_kb = 1024
+ *   log_keep = 3
+ *   # Flight-loop budget for the stratus/perf over_budget counters, and how
+ *   # often to append timing stats to stratus_perf.jsonl (0 = never)
+ *   perf_budget_us = 1000
+ *   perf_dump_s = 60
+ *   # Flight data recorder: off | on (every captured frame to recordings/)
+ *   record = off
+ *   # Local telemetry server: off | on (stratus_telemetry.sock subscribers)
+ *   server = off
+ *   # UDP stream to a remote receiver: off | <host>:<port> (commands come
+ *   # back over the same socket)
+ *   udp = off
+ *   # Other aircraft (AI, multiplayer) to stratus_traffic.json (0 = off)
+ *   traffic_rate_hz = 1
+ *   # Derived state: nearest airport search radius (stratus_airports.bin)
+ *   airport_range_nm = 50
+ *
+ * Environment variables (STRATUS_TELEMETRY_TRANSPORT, ...) still override
+ * the file, which keeps one-off experiments out of the config.
+ */
+
+#ifndef STRATUS_CONFIG_H
+#define STRATUS_CONFIG_H
+
+#define STRATUS_CONFIG_FILE "stratus_plugin.cfg"
+#define STRATUS_CONFIG_VALUE_LEN 32
+#define STRATUS_CONFIG_ADDRESS_LEN 256 /* Host names run longer than keywords */
+
+typedef struct StratusConfig {
+  char transport[STRATUS_CONFIG_VALUE_LEN];
+  char format[STRATUS_CONFIG_VALUE_LEN];
+  char in_process[STRATUS_CONFIG_VALUE_LEN];
+
+  float rate_hz;          /* Normal flight */
+  float idle_rate_hz;     /* Paused, or parked on the ground */
+  float approach_rate_hz; /* Low and descending */
+  float max_rate_hz;      /* Ceiling for client SET_RATE requests */
+  float approach_agl_ft;
+
+  unsigned command_poll_ms;
+  float command_rate_hz;
+  unsigned command_budget_us;
+  float radio_rate_hz;
+  float event_rate_hz;
+
+  char publish[STRATUS_CONFIG_VALUE_LEN];
+  float keyframe_interval_s;
+  float deadband_position_deg; /* Latitude/longitude */
+  float deadband_altitude_ft;  /* MSL and AGL, and other feet */
+  float deadband_angle_deg;    /* Heading, pitch, roll */
+  float deadband_speed;        /* Ground speed, IAS, TAS, in their own units */
+  float deadband_vs_fpm;
+
+  char log_level[STRATUS_CONFIG_VALUE_LEN];
+  unsigned log_max_kb;
+  int log_keep;
+
+  unsigned perf_budget_us;
+  unsigned perf_dump_s;
+
+  char record[STRATUS_CONFIG_VALUE_LEN];
+  char server[STRATUS_CONFIG_VALUE_LEN];
+  char udp[STRATUS_CONFIG_ADDRESS_LEN];
+
+  float traffic_rate_hz;
+
+  float airport_range_nm;
+} StratusConfig;
+
+/* Fill `cfg` with built-in defaults */
+void StratusConfig_Defaults(StratusConfig *cfg);
+
+/* Overlay settings from `path` onto `cfg`. Returns 1 if the file was read,
+ * 0 if it does not exist. Unknown keys and bad values are reported through
+ * `warn` (may be NULL) and otherwise ignored. */
+int StratusConfig_Load(StratusConfig *cfg, const char *path,
+                       void (*warn)(const char *msg));
+
+#endif /* STRATUS_CONFIG_H */
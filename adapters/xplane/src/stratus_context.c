@@ -0,0 +1,98 @@
+/*
+ * Stratus ATC - Simulation Context
+ *
+ * See stratus_context.h.
+ */
+
+#include "stratus_context.h"
+#include "stratus_json.h"
+
+#include "XPLMDataAccess.h"
+#include "XPLMNavigation.h"
+#include "XPLMPlanes.h"
+
+#include <string.h>
+#include <time.h>
+
+static XPLMDataRef dr_icao = NULL;
+static XPLMDataRef dr_tailnum = NULL;
+static XPLMDataRef dr_lat = NULL;
+static XPLMDataRef dr_lon = NULL;
+
+static uint64_t g_seq = 0;
+
+void StratusContext_Init(void) {
+  dr_icao = XPLMFindDataRef("sim/aircraft/view/acf_ICAO");
+  dr_tailnum = XPLMFindDataRef("sim/aircraft/view/acf_tailnum");
+  dr_lat = XPLMFindDataRef("sim/flightmodel/position/latitude");
+  dr_lon = XPLMFindDataRef("sim/flightmodel/position/longitude");
+}
+
+/* Byte-array DataRef into a NUL-terminated string */
+static void ReadString(XPLMDataRef dr, char *out, int size) {
+  memset(out, 0, (size_t)size);
+  if (dr)
+    XPLMGetDatab(dr, out, 0, size - 1);
+}
+
+void StratusContext_Capture(StratusContext *ctx, StratusContextEvent event) {
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->seq = ++g_seq;
+  ctx->timestamp = (int64_t)time(NULL);
+  ctx->event = event;
+
+  XPLMGetNthAircraftModel(0, ctx->acf_file, ctx->acf_path);
+  ReadString(dr_icao, ctx->icao, sizeof(ctx->icao));
+  ReadString(dr_tailnum, ctx->tailnum, sizeof(ctx->tailnum));
+
+  if (dr_lat && dr_lon) {
+    float lat = (float)XPLMGetDatad(dr_lat);
+    float lon = (float)XPLMGetDatad(dr_lon);
+    XPLMNavRef apt = XPLMFindNavAid(NULL, NULL, &lat, &lon, NULL,
+                                    xplm_Nav_Airport);
+    if (apt != XPLM_NAV_NOT_FOUND) {
+      XPLMGetNavAidInfo(apt, NULL, NULL, NULL, NULL, NULL, NULL,
+                        ctx->airport_id, ctx->airport_name, NULL);
+    }
+  }
+}
+
+static const char *EventName(StratusContextEvent event) {
+  switch (event) {
+  case STRATUS_CONTEXT_PLANE_LOADED:
+    return "plane_loaded";
+  case STRATUS_CONTEXT_AIRPORT_LOADED:
+    return "airport_loaded";
+  case STRATUS_CONTEXT_SCENERY_LOADED:
+    return "scenery_loaded";
+  case STRATUS_CONTEXT_STARTUP:
+    break;
+  }
+  return "startup";
+}
+
+size_t StratusContext_WriteJSON(char *out, size_t cap,
+                                const StratusContext *ctx) {
+  StratusJsonBuf b;
+  StratusJson_Init(&b, out, cap);
+  StratusJson_Raw(&b, "{\n  \"seq\": ");
+  StratusJson_Uint(&b, ctx->seq);
+  StratusJson_Raw(&b, ",\n  \"timestamp\": ");
+  StratusJson_Int(&b, ctx->timestamp);
+  StratusJson_Raw(&b, ",\n  \"event\": ");
+  StratusJson_String(&b, EventName(ctx->event));
+  StratusJson_Raw(&b, ",\n  \"aircraft\": {\n    \"file\": ");
+  StratusJson_String(&b, ctx->acf_file);
+  StratusJson_Raw(&b, ",\n    \"path\": ");
+  StratusJson_String(&b, ctx->acf_path);
+  StratusJson_Raw(&b, ",\n    \"icao\": ");
+  StratusJson_String(&b, ctx->icao);
+  StratusJson_Raw(&b, ",\n    \"tailnum\": ");
+  StratusJson_String(&b, ctx->tailnum);
+  StratusJson_Raw(&b, "\n  },\n  \"location\": {\n    \"airport_id\": ");
+  StratusJson_String(&b, ctx->airport_id);
+  StratusJson_Raw(&b, ",\n    \"airport_name\": ");
+  StratusJson_String(&b, ctx->airport_name);
+  StratusJson_Raw(&b, "\n  }\n}\n");
+  return StratusJson_Finish(&b);
+}
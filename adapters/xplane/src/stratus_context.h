@@ -0,0 +1,60 @@
+/*
+ * Stratus ATC - Simulation Context
+ *
+ * Slow-changing facts about the session: which aircraft is loaded and where
+ * it is. They are captured only when X-Plane reports a change
+ * (XPLM_MSG_PLANE_LOADED, XPLM_MSG_AIRPORT_LOADED, XPLM_MSG_SCENERY_LOADED)
+ * and at enable, then written to `stratus_context.json` as a separate
+ * low-rate event. Each event bumps `seq`, which clients use as a cheap
+ * invalidation signal (re-warm the model, rebuild prompts).
+ *
+ * The telemetry frame keeps only the cached .acf file name, so the flight
+ * loop no longer queries the aircraft model every tick.
+ */
+
+#ifndef STRATUS_CONTEXT_H
+#define STRATUS_CONTEXT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+  STRATUS_CONTEXT_STARTUP,
+  STRATUS_CONTEXT_PLANE_LOADED,
+  STRATUS_CONTEXT_AIRPORT_LOADED,
+  STRATUS_CONTEXT_SCENERY_LOADED
+} StratusContextEvent;
+
+typedef struct StratusContext {
+  uint64_t seq;
+  int64_t timestamp; /* Unix time, seconds */
+  StratusContextEvent event;
+
+  /* User aircraft */
+  char acf_file[256];
+  char acf_path[512];
+  char icao[40];    /* sim/aircraft/view/acf_ICAO */
+  char tailnum[40]; /* sim/aircraft/view/acf_tailnum */
+
+  /* Airport nearest the aircraft when the event fired */
+  char airport_id[32];
+  char airport_name[256];
+} StratusContext;
+
+/* Resolve the DataRefs used by StratusContext_Capture. Call from the
+ * plugin's deferred init (first flight-loop tick). */
+void StratusContext_Init(void);
+
+/* Fill `ctx` from the sim for `event`, assigning the next sequence number.
+ * Sim thread only (SDK calls); meant for message handlers, not every tick. */
+void StratusContext_Capture(StratusContext *ctx, StratusContextEvent event);
+
+/* Room for a context record with every string fully escaped */
+#define STRATUS_CONTEXT_JSON_MAX 8192
+
+/* Write `ctx` as a JSON object into `out`. Returns the length, or 0 if `cap`
+ * is too small. Any thread. */
+size_t StratusContext_WriteJSON(char *out, size_t cap,
+                                const StratusContext *ctx);
+
+#endif /* STRATUS_CONTEXT_H */
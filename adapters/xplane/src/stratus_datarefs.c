@@ -0,0 +1,392 @@
+/*
+ * Stratus ATC - DataRef Registry
+ *
+ * See stratus_datarefs.h.
+ */
+
+#include "stratus_datarefs.h"
+#include "stratus_thread.h"
+
+#include "XPLMDataAccess.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FIELD(dataref, section, key, type, member, precision, deadband)        \
+  {dataref,                                                                    \
+   section,                                                                    \
+   key,                                                                        \
+   type,                                                                       \
+   offsetof(StratusFrame, member),                                             \
+   sizeof(((StratusFrame *)0)->member),                                        \
+   1,                                                                          \
+   0.0f,                                                                       \
+   precision,                                                                  \
+   deadband}
+
+#define ARRAY_FIELD(dataref, section, key, type, member, deadband)             \
+  {dataref,                                                                    \
+   section,                                                                    \
+   key,                                                                        \
+   type,                                                                       \
+   offsetof(StratusFrame, member),                                             \
+   sizeof(((StratusFrame *)0)->member),                                        \
+   (int)(sizeof(((StratusFrame *)0)->member) /                                 \
+         sizeof(((StratusFrame *)0)->member[0])),                              \
+   0.0f,                                                                       \
+   0,                                                                          \
+   deadband}
+
+const StratusField g_stratus_fields[] = {
+    FIELD(NULL, NULL, "aircraft", STRATUS_FIELD_STR, aircraft, 0,
+          STRATUS_DEADBAND_EXACT),
+
+    /* Position */
+    FIELD("sim/flightmodel/position/latitude", "position", "latitude",
+          STRATUS_FIELD_F64, latitude, 8, STRATUS_DEADBAND_POSITION),
+    FIELD("sim/flightmodel/position/longitude", "position", "longitude",
+          STRATUS_FIELD_F64, longitude, 8, STRATUS_DEADBAND_POSITION),
+    FIELD("sim/flightmodel/position/elevation", "position", "altitude_msl_m",
+          STRATUS_FIELD_F64, altitude_msl_m, 2, STRATUS_DEADBAND_ALTITUDE),
+    FIELD("sim/flightmodel/position/y_agl", "position", "altitude_agl_m",
+          STRATUS_FIELD_F64, altitude_agl_m, 2, STRATUS_DEADBAND_ALTITUDE),
+
+    /* Orientation */
+    FIELD("sim/flightmodel/position/mag_psi", "orientation", "heading_mag",
+          STRATUS_FIELD_F32, heading_mag, 2, STRATUS_DEADBAND_ANGLE),
+    FIELD("sim/flightmodel/position/true_psi", "orientation", "heading_true",
+          STRATUS_FIELD_F32, heading_true, 2, STRATUS_DEADBAND_ANGLE),
+    FIELD("sim/flightmodel/position/theta", "orientation", "pitch",
+          STRATUS_FIELD_F32, pitch, 2, STRATUS_DEADBAND_ANGLE),
+    FIELD("sim/flightmodel/position/phi", "orientation", "roll",
+          STRATUS_FIELD_F32, roll, 2, STRATUS_DEADBAND_ANGLE),
+
+    /* Speed */
+    FIELD("sim/flightmodel/position/groundspeed", "speed", "ground_speed_mps",
+          STRATUS_FIELD_F32, ground_speed_mps, 2, STRATUS_DEADBAND_SPEED),
+    FIELD("sim/flightmodel/position/indicated_airspeed", "speed", "ias_kts",
+          STRATUS_FIELD_F32, ias_kts, 2, STRATUS_DEADBAND_SPEED),
+    FIELD("sim/flightmodel/position/true_airspeed", "speed", "tas_mps",
+          STRATUS_FIELD_F32, tas_mps, 2, STRATUS_DEADBAND_SPEED),
+    FIELD("sim/flightmodel/position/vh_ind_fpm", "speed",
+          "vertical_speed_fpm", STRATUS_FIELD_F32, vertical_speed_fpm, 2,
+          STRATUS_DEADBAND_VS),
+
+    /* Radios (Hz, 8.33 kHz-capable DataRefs) */
+    FIELD("sim/cockpit2/radios/actuators/com1_frequency_hz_833", "radios",
+          "com1_hz", STRATUS_FIELD_I32, com1_hz, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit2/radios/actuators/com1_standby_frequency_hz_833",
+          "radios", "com1_standby_hz", STRATUS_FIELD_I32, com1_standby_hz, 0,
+          STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit2/radios/actuators/com2_frequency_hz_833", "radios",
+          "com2_hz", STRATUS_FIELD_I32, com2_hz, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit2/radios/actuators/com2_standby_frequency_hz_833",
+          "radios", "com2_standby_hz", STRATUS_FIELD_I32, com2_standby_hz, 0,
+          STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit2/radios/actuators/nav1_frequency_hz", "radios",
+          "nav1_hz", STRATUS_FIELD_I32, nav1_hz, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit2/radios/actuators/nav2_frequency_hz", "radios",
+          "nav2_hz", STRATUS_FIELD_I32, nav2_hz, 0, STRATUS_DEADBAND_EXACT),
+
+    /* Transponder */
+    FIELD("sim/cockpit/radios/transponder_code", "transponder", "code",
+          STRATUS_FIELD_I32, xpdr_code, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit/radios/transponder_mode", "transponder", "mode",
+          STRATUS_FIELD_I32, xpdr_mode, 0, STRATUS_DEADBAND_EXACT),
+
+    /* Autopilot targets */
+    FIELD("sim/cockpit/autopilot/altitude", "autopilot", "altitude_ft",
+          STRATUS_FIELD_F32, ap_altitude_ft, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit/autopilot/heading_mag", "autopilot", "heading",
+          STRATUS_FIELD_F32, ap_heading, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/cockpit/autopilot/vertical_velocity", "autopilot", "vs_fpm",
+          STRATUS_FIELD_F32, ap_vs_fpm, 0, STRATUS_DEADBAND_EXACT),
+
+    /* State */
+    FIELD("sim/flightmodel/failures/onground_any", "state", "on_ground",
+          STRATUS_FIELD_BOOL, on_ground, 0, STRATUS_DEADBAND_EXACT),
+    FIELD("sim/time/paused", "state", "paused", STRATUS_FIELD_BOOL, paused, 0,
+          STRATUS_DEADBAND_EXACT),
+
+    /* Engines */
+    FIELD("sim/aircraft/engine/acf_num_engines", "engines", "count",
+          STRATUS_FIELD_I32, engine_count, 0, STRATUS_DEADBAND_EXACT),
+    ARRAY_FIELD("sim/flightmodel/engine/ENGN_running", "engines", "running",
+                STRATUS_FIELD_I32_ARRAY, engine_running,
+                STRATUS_DEADBAND_EXACT),
+
+    /* Derived state (stratus_derived.h), no DataRefs */
+    FIELD(NULL, "derived", "phase", STRATUS_FIELD_I32, phase, 0,
+          STRATUS_DEADBAND_EXACT),
+    FIELD(NULL, "derived", "ground_speed_kts", STRATUS_FIELD_F32,
+          ground_speed_kts, 1, STRATUS_DEADBAND_SPEED),
+    FIELD(NULL, "derived", "tas_kts", STRATUS_FIELD_F32, tas_kts, 1,
+          STRATUS_DEADBAND_SPEED),
+    FIELD(NULL, "derived", "altitude_msl_ft", STRATUS_FIELD_F32,
+          altitude_msl_ft, 0, STRATUS_DEADBAND_FEET),
+    FIELD(NULL, "derived", "altitude_agl_ft", STRATUS_FIELD_F32,
+          altitude_agl_ft, 0, STRATUS_DEADBAND_FEET),
+    FIELD(NULL, "derived", "airport", STRATUS_FIELD_STR, airport, 0,
+          STRATUS_DEADBAND_EXACT),
+    FIELD(NULL, "derived", "airport_dist_nm", STRATUS_FIELD_F32,
+          airport_dist_nm, 2, STRATUS_DEADBAND_NM),
+    FIELD(NULL, "derived", "airport_bearing_deg", STRATUS_FIELD_F32,
+          airport_bearing_deg, 1, STRATUS_DEADBAND_ANGLE),
+    FIELD(NULL, "derived", "airport_elevation_ft", STRATUS_FIELD_F32,
+          airport_elevation_ft, 0, STRATUS_DEADBAND_EXACT),
+    FIELD(NULL, "derived", "runway", STRATUS_FIELD_STR, runway, 0,
+          STRATUS_DEADBAND_EXACT),
+    FIELD(NULL, "derived", "runway_dist_ft", STRATUS_FIELD_F32,
+          runway_dist_ft, 0, STRATUS_DEADBAND_FEET),
+    FIELD(NULL, "derived", "runway_length_ft", STRATUS_FIELD_I32,
+          runway_length_ft, 0, STRATUS_DEADBAND_EXACT),
+    FIELD(NULL, "derived", "on_runway", STRATUS_FIELD_BOOL, on_runway, 0,
+          STRATUS_DEADBAND_EXACT),
+};
+
+const size_t g_stratus_field_count =
+    sizeof(g_stratus_fields) / sizeof(g_stratus_fields[0]);
+
+#define FIELD_COUNT (sizeof(g_stratus_fields) / sizeof(g_stratus_fields[0]))
+
+/* Resolved handles, the names and scales they come from (the row's, or an
+ * aircraft profile's) and read groups, parallel to g_stratus_fields */
+static XPLMDataRef g_handles[FIELD_COUNT];
+static const char *g_names[FIELD_COUNT];
+static char g_profile_names[FIELD_COUNT][STRATUS_PROFILE_NAME_LEN];
+static float g_scales[FIELD_COUNT];
+static XPLMDataTypeID g_types[FIELD_COUNT];
+static unsigned char g_groups[FIELD_COUNT];
+
+/* Sections read at the slow rate; everything else is STRATUS_READ_FAST */
+static const char *const kSlowSections[] = {"radios", "transponder",
+                                            "autopilot", "engines"};
+
+static unsigned GroupOf(const StratusField *f) {
+  if (!f->section)
+    return STRATUS_READ_FAST;
+  for (size_t i = 0; i < sizeof(kSlowSections) / sizeof(kSlowSections[0]);
+       i++) {
+    if (strcmp(f->section, kSlowSections[i]) == 0)
+      return STRATUS_READ_SLOW;
+  }
+  return STRATUS_READ_FAST;
+}
+
+/* Rows the event probe reads between frames (stratus_events.h); they stay
+ * in their section's group too */
+static const char *const kEventFields[] = {"state.on_ground", "state.paused",
+                                           "radios.com1_hz", "radios.com2_hz",
+                                           "transponder.code",
+                                           "transponder.mode"};
+
+static unsigned EventGroupOf(const StratusField *f) {
+  if (!f->section)
+    return 0;
+  size_t len = strlen(f->section);
+  for (size_t i = 0; i < sizeof(kEventFields) / sizeof(kEventFields[0]); i++) {
+    const char *name = kEventFields[i];
+    if (strncmp(name, f->section, len) == 0 && name[len] == '.' &&
+        strcmp(name + len + 1, f->key) == 0)
+      return STRATUS_READ_EVENTS;
+  }
+  return 0;
+}
+
+static XPLMDataRef g_sim_time;
+
+/* Rows whose DataRef has not been found yet, one bit per row */
+#define MISSING_WORDS ((FIELD_COUNT + 31) / 32)
+static uint32_t g_missing[MISSING_WORDS];
+static int g_missing_count = 0;
+static int g_pending = 0;        /* Something left to look up */
+static uint64_t g_retry_ns = 0;  /* Next lookup at or after this time */
+static uint64_t g_backoff_ns = 0;
+
+#define RETRY_FIRST_NS 1000000000ull /* Then doubling, up to: */
+#define RETRY_MAX_NS 60000000000ull
+
+static void SetMissing(size_t i) { g_missing[i / 32] |= 1u << (i % 32); }
+static void ClearMissing(size_t i) { g_missing[i / 32] &= ~(1u << (i % 32)); }
+static int IsMissing(size_t i) { return (g_missing[i / 32] >> (i % 32)) & 1u; }
+
+void StratusDataRefs_Init(void) {
+  g_sim_time = NULL;
+  memset(g_missing, 0, sizeof(g_missing));
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    const StratusField *f = &g_stratus_fields[i];
+    g_handles[i] = NULL;
+    g_types[i] = 0;
+    g_names[i] = f->dataref;
+    g_scales[i] = f->scale;
+    g_groups[i] = (unsigned char)(GroupOf(f) | EventGroupOf(f));
+    if (f->dataref)
+      SetMissing(i);
+  }
+  g_pending = 1;
+  g_retry_ns = 0;
+  g_backoff_ns = RETRY_FIRST_NS;
+}
+
+int StratusDataRefs_Resolve(void) {
+  int missing = 0;
+  if (!g_sim_time)
+    g_sim_time = XPLMFindDataRef("sim/time/total_flight_time_sec");
+  if (!g_sim_time)
+    missing++;
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if (!IsMissing(i))
+      continue;
+    g_handles[i] = XPLMFindDataRef(g_names[i]);
+    if (!g_handles[i]) {
+      missing++;
+      continue;
+    }
+    g_types[i] = XPLMGetDataRefTypes(g_handles[i]);
+    ClearMissing(i);
+  }
+
+  g_missing_count = missing;
+  g_pending = missing > 0;
+  g_retry_ns = StratusMonotonicNs() + g_backoff_ns;
+  g_backoff_ns = g_backoff_ns * 2 < RETRY_MAX_NS ? g_backoff_ns * 2
+                                                 : RETRY_MAX_NS;
+  return missing;
+}
+
+void StratusDataRefs_Refresh(void) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if (g_handles[i] && !XPLMIsDataRefGood(g_handles[i])) {
+      g_handles[i] = NULL;
+      g_types[i] = 0;
+      SetMissing(i);
+    }
+  }
+  g_pending = 1;
+  g_retry_ns = 0;
+  g_backoff_ns = RETRY_FIRST_NS;
+}
+
+int StratusDataRefs_Missing(void) { return g_missing_count; }
+
+int StratusDataRefs_FieldIndex(const char *field) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    const StratusField *f = &g_stratus_fields[i];
+    if (!f->dataref || !f->section)
+      continue;
+    size_t len = strlen(f->section);
+    if (strncmp(field, f->section, len) == 0 && field[len] == '.' &&
+        strcmp(field + len + 1, f->key) == 0)
+      return (int)i;
+  }
+  return -1;
+}
+
+int StratusDataRefs_UseProfile(const StratusProfile *p) {
+  const char *names[FIELD_COUNT];
+  float scales[FIELD_COUNT];
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    names[i] = g_stratus_fields[i].dataref;
+    scales[i] = g_stratus_fields[i].scale;
+  }
+
+  int used = 0;
+  for (int e = 0; p && e < p->count; e++) {
+    const StratusProfileEntry *entry = &p->entries[e];
+    int i = StratusDataRefs_FieldIndex(entry->field);
+    if (i < 0 || entry->dataref[0] == '\0')
+      continue;
+    names[i] = entry->dataref;
+    scales[i] = entry->scale;
+    used++;
+  }
+
+  /* Rows that moved are looked up again on the next read */
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    g_scales[i] = scales[i];
+    if (names[i] == g_names[i] ||
+        (names[i] && g_names[i] && strcmp(names[i], g_names[i]) == 0))
+      continue;
+    if (names[i] == g_stratus_fields[i].dataref) {
+      g_names[i] = names[i];
+    } else {
+      snprintf(g_profile_names[i], sizeof(g_profile_names[i]), "%s", names[i]);
+      g_names[i] = g_profile_names[i];
+    }
+    g_handles[i] = NULL;
+    g_types[i] = 0;
+    SetMissing(i);
+  }
+  g_pending = 1;
+  g_retry_ns = 0;
+  g_backoff_ns = RETRY_FIRST_NS;
+  return used;
+}
+
+/* Scalar read in the DataRef's own type, widest first */
+static double ReadNumber(XPLMDataRef h, XPLMDataTypeID types) {
+  if (types & xplmType_Double)
+    return XPLMGetDatad(h);
+  if (types & xplmType_Float)
+    return XPLMGetDataf(h);
+  if (types & xplmType_Int)
+    return XPLMGetDatai(h);
+  return 0.0;
+}
+
+void StratusDataRefs_Read(StratusFrame *fr, unsigned groups) {
+  char *base = (char *)fr;
+
+  /* First use, and retries while anything is missing */
+  if (g_pending && StratusMonotonicNs() >= g_retry_ns)
+    StratusDataRefs_Resolve();
+
+  if (g_sim_time && (groups & STRATUS_READ_FAST))
+    fr->sim_time_s = XPLMGetDataf(g_sim_time);
+
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    const StratusField *f = &g_stratus_fields[i];
+    XPLMDataRef h = g_handles[i];
+    if (!h || !(g_groups[i] & groups))
+      continue;
+
+    char *dst = base + f->offset;
+    if (f->type == STRATUS_FIELD_I32_ARRAY) {
+      XPLMGetDatavi(h, (int *)dst, 0, f->count);
+      continue;
+    }
+    if (f->type == STRATUS_FIELD_F32_ARRAY) {
+      XPLMGetDatavf(h, (float *)dst, 0, f->count);
+      continue;
+    }
+
+    double v = ReadNumber(h, g_types[i]);
+    if (g_scales[i] != 0.0f)
+      v *= g_scales[i];
+
+    switch (f->type) {
+    case STRATUS_FIELD_F64:
+      memcpy(dst, &v, sizeof(v));
+      break;
+    case STRATUS_FIELD_F32: {
+      float fv = (float)v;
+      memcpy(dst, &fv, sizeof(fv));
+      break;
+    }
+    case STRATUS_FIELD_I32: {
+      /* Rounded, not truncated: 121.8999 MHz * 1000 is 121900, as the
+       * commander rounds what it writes */
+      int32_t iv = (int32_t)lround(v);
+      memcpy(dst, &iv, sizeof(iv));
+      break;
+    }
+    case STRATUS_FIELD_BOOL:
+      *(uint8_t *)dst = v != 0.0;
+      break;
+    default:
+      break;
+    }
+  }
+}
@@ -0,0 +1,124 @@
+/*
+ * Stratus ATC - DataRef Registry
+ *
+ * One table describes every exported telemetry field: the DataRef it comes
+ * from, where it lives in StratusFrame, its JSON section/key and how it is
+ * published. The capture loop, the JSON writer and delta publishing all walk
+ * this table, so adding a field means adding one row (plus the StratusFrame
+ * member and its Rust mirror).
+ *
+ * DataRef value types are queried once, when the DataRef is found, so a row
+ * does not say how to read the DataRef, only what type the frame field is.
+ * Array fields are read with a single XPLMGetDatavi/XPLMGetDatavf range call.
+ *
+ * The sim clock (StratusFrame.sim_time_s) is read here too but is not a
+ * row: like `timestamp` it is record metadata, written with every record
+ * and never a reason on its own to publish a delta.
+ *
+ * Rows fall in two read groups by section: the flight state that moves
+ * every frame (position, orientation, speed, state) and the cockpit settings
+ * that change a few times a flight (radios, transponder, autopilot,
+ * engines), which the plugin reads at a lower rate into the same frame.
+ *
+ * A handful of rows whose changes are events (touchdown, pause, radios,
+ * transponder) also belong to STRATUS_READ_EVENTS, which the plugin reads
+ * on its own, more often than frames are captured.
+ *
+ * An aircraft profile (stratus_profile.h) can point rows at the aircraft's
+ * own DataRefs, with a scale; the row keeps its section, key and type.
+ *
+ * The "derived" rows have no DataRef: the plugin computes them from the
+ * other rows after each read (stratus_derived.h). They are published like
+ * any other field, so a phase change alone publishes a delta.
+ */
+
+#ifndef STRATUS_DATAREFS_H
+#define STRATUS_DATAREFS_H
+
+#include "stratus_frame.h"
+#include "stratus_profile.h"
+
+#include <stddef.h>
+
+typedef enum {
+  STRATUS_FIELD_F64,
+  STRATUS_FIELD_F32,
+  STRATUS_FIELD_I32,
+  STRATUS_FIELD_BOOL, /* uint8_t, 0/1 */
+  STRATUS_FIELD_STR,  /* NUL-terminated char array */
+  STRATUS_FIELD_I32_ARRAY,
+  STRATUS_FIELD_F32_ARRAY
+} StratusFieldType;
+
+/* Dead-band class used by delta publishing (stratus_delta.h) */
+typedef enum {
+  STRATUS_DEADBAND_EXACT, /* Any change is published */
+  STRATUS_DEADBAND_POSITION,
+  STRATUS_DEADBAND_ALTITUDE,
+  STRATUS_DEADBAND_ANGLE,
+  STRATUS_DEADBAND_SPEED,
+  STRATUS_DEADBAND_VS,
+  STRATUS_DEADBAND_FEET, /* The altitude dead-band, for fields in feet */
+  STRATUS_DEADBAND_NM,   /* The position dead-band, in nautical miles */
+  STRATUS_DEADBAND_COUNT
+} StratusDeadband;
+
+typedef struct StratusField {
+  const char *dataref; /* NULL: filled by the plugin itself */
+  const char *section; /* JSON object the field lives in; NULL = top level */
+  const char *key;     /* JSON key */
+  StratusFieldType type;
+  size_t offset; /* Into StratusFrame */
+  size_t size;   /* Bytes in StratusFrame */
+  int count;     /* Elements, for array fields */
+  float scale;   /* Applied to numeric DataRef values; 0 = 1 */
+  int precision; /* JSON decimals for floating-point fields */
+  StratusDeadband deadband;
+} StratusField;
+
+/* All fields, in JSON output order; fields of one section are contiguous */
+extern const StratusField g_stratus_fields[];
+extern const size_t g_stratus_field_count;
+
+/* Mark every DataRef unresolved. No lookups happen here: the plugin's
+ * deferred init (first flight-loop tick) resolves them, or else the first
+ * read. Call from XPluginStart. */
+void StratusDataRefs_Init(void);
+
+/* Look up the DataRefs (and their types) not found so far. Returns the
+ * number still missing; their fields keep their last value (0 at first).
+ * While any are missing, StratusDataRefs_Read calls this again on a
+ * backoff, 1 s doubling to 60 s, so DataRefs that an aircraft or another
+ * plugin registers late are picked up. Sim thread only. */
+int StratusDataRefs_Resolve(void);
+
+/* Drop handles whose owner has gone away and retry everything missing on
+ * the next read, backoff reset. Call on XPLM_MSG_PLANE_LOADED, when
+ * aircraft plugins register their DataRefs. */
+void StratusDataRefs_Refresh(void);
+
+/* DataRefs missing at the last lookup */
+int StratusDataRefs_Missing(void);
+
+/* Row of `field` (<section>.<key>, as in the JSON), -1 if there is none */
+int StratusDataRefs_FieldIndex(const char *field);
+
+/* Read the rows `p` maps from its DataRefs, with its scales, and every
+ * other row from its own; NULL restores the stock DataRefs. Changed rows
+ * are looked up again on the next read; names are copied. Returns the
+ * number of entries that named a row. */
+int StratusDataRefs_UseProfile(const StratusProfile *p);
+
+/* Read groups for StratusDataRefs_Read */
+#define STRATUS_READ_FAST 0x1 /* Flight state, and the sim clock */
+#define STRATUS_READ_SLOW 0x2 /* Cockpit settings */
+#define STRATUS_READ_ALL (STRATUS_READ_FAST | STRATUS_READ_SLOW)
+/* Just the few rows whose transitions are events (stratus_events.h), from
+ * either group, for the event probe between frames */
+#define STRATUS_READ_EVENTS 0x4
+
+/* Read the resolved DataRefs of `groups` into `fr`, leaving the other
+ * fields as they were. Sim thread only. */
+void StratusDataRefs_Read(StratusFrame *fr, unsigned groups);
+
+#endif /* STRATUS_DATAREFS_H */
@@ -0,0 +1,261 @@
+/*
+ * Stratus ATC - Delta Telemetry Publishing
+ *
+ * See stratus_delta.h. Runs on the I/O thread.
+ */
+
+#include "stratus_delta.h"
+#include "stratus_events.h"
+#include "stratus_json.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define FEET_TO_METERS 0.3048
+#define NM_PER_DEG 60.0 /* Of latitude */
+
+static const void *FieldPtr(const StratusField *f, const StratusFrame *fr) {
+  return (const char *)fr + f->offset;
+}
+
+/* Numeric value of a scalar field, or of element `i` of an array field */
+static double FieldNumber(const StratusField *f, const StratusFrame *fr,
+                          int i) {
+  const char *p = FieldPtr(f, fr);
+  switch (f->type) {
+  case STRATUS_FIELD_F64: {
+    double v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  case STRATUS_FIELD_F32:
+  case STRATUS_FIELD_F32_ARRAY: {
+    float v;
+    memcpy(&v, p + (size_t)i * sizeof(v), sizeof(v));
+    return v;
+  }
+  case STRATUS_FIELD_I32:
+  case STRATUS_FIELD_I32_ARRAY: {
+    int32_t v;
+    memcpy(&v, p + (size_t)i * sizeof(v), sizeof(v));
+    return v;
+  }
+  case STRATUS_FIELD_BOOL:
+    return *(const uint8_t *)p;
+  case STRATUS_FIELD_STR:
+    break;
+  }
+  return 0.0;
+}
+
+/* True if the field moved beyond its dead-band between `a` and `b` */
+static int FieldDiffers(const StratusDelta *d, const StratusField *f,
+                        const StratusFrame *a, const StratusFrame *b) {
+  if (f->type == STRATUS_FIELD_STR || f->deadband == STRATUS_DEADBAND_EXACT)
+    return memcmp(FieldPtr(f, a), FieldPtr(f, b), f->size) != 0;
+
+  for (int i = 0; i < f->count; i++) {
+    if (fabs(FieldNumber(f, a, i) - FieldNumber(f, b, i)) >
+        d->deadband[f->deadband])
+      return 1;
+  }
+  return 0;
+}
+
+void StratusDelta_Init(StratusDelta *d, const StratusConfig *cfg) {
+  memset(d, 0, sizeof(*d));
+  d->deadband[STRATUS_DEADBAND_EXACT] = 0.0;
+  d->deadband[STRATUS_DEADBAND_POSITION] = cfg->deadband_position_deg;
+  d->deadband[STRATUS_DEADBAND_ALTITUDE] =
+      cfg->deadband_altitude_ft * FEET_TO_METERS;
+  d->deadband[STRATUS_DEADBAND_ANGLE] = cfg->deadband_angle_deg;
+  d->deadband[STRATUS_DEADBAND_SPEED] = cfg->deadband_speed;
+  d->deadband[STRATUS_DEADBAND_VS] = cfg->deadband_vs_fpm;
+  d->deadband[STRATUS_DEADBAND_FEET] = cfg->deadband_altitude_ft;
+  d->deadband[STRATUS_DEADBAND_NM] = cfg->deadband_position_deg * NM_PER_DEG;
+  d->keyframe_interval_s = cfg->keyframe_interval_s;
+}
+
+StratusPublishKind StratusDelta_Next(StratusDelta *d, const StratusFrame *fr) {
+  if (!d->have_keyframe || fr->events ||
+      (double)(fr->monotonic_ns - d->keyframe_ns) * 1e-9 >=
+          d->keyframe_interval_s) {
+    d->keyframe = *fr;
+    d->reader = *fr;
+    d->keyframe_seq = ++d->seq;
+    d->keyframe_ns = fr->monotonic_ns;
+    d->have_keyframe = 1;
+    return fr->events ? STRATUS_PUBLISH_EVENT : STRATUS_PUBLISH_KEYFRAME;
+  }
+
+  int changed = 0;
+  for (size_t i = 0; i < g_stratus_field_count && !changed; i++)
+    changed = FieldDiffers(d, &g_stratus_fields[i], &d->reader, fr);
+  if (!changed)
+    return STRATUS_PUBLISH_NONE;
+
+  /* The delta carries every field that differs from the keyframe; the rest
+   * fall back to their keyframe values on the reader's side */
+  d->reader = d->keyframe;
+  d->reader.timestamp = fr->timestamp;
+  d->reader.frame_seq = fr->frame_seq;
+  d->reader.monotonic_ns = fr->monotonic_ns;
+  d->reader.sim_time_s = fr->sim_time_s;
+  d->reader.event_seq = fr->event_seq;
+  for (size_t i = 0; i < g_stratus_field_count; i++) {
+    const StratusField *f = &g_stratus_fields[i];
+    if (FieldDiffers(d, f, &d->keyframe, fr))
+      memcpy((char *)&d->reader + f->offset, FieldPtr(f, fr), f->size);
+  }
+  d->seq++;
+  return STRATUS_PUBLISH_DELTA;
+}
+
+static int SameSection(const char *a, const char *b) {
+  return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static void WriteNumber(StratusJsonBuf *b, const StratusField *field,
+                        const StratusFrame *fr, int i) {
+  switch (field->type) {
+  case STRATUS_FIELD_F64:
+  case STRATUS_FIELD_F32:
+  case STRATUS_FIELD_F32_ARRAY:
+    StratusJson_Fixed(b, FieldNumber(field, fr, i), field->precision);
+    break;
+  default:
+    StratusJson_Int(b, (int64_t)FieldNumber(field, fr, i));
+    break;
+  }
+}
+
+static void WriteValue(StratusJsonBuf *b, const StratusField *field,
+                       const StratusFrame *fr) {
+  switch (field->type) {
+  case STRATUS_FIELD_BOOL:
+    StratusJson_Bool(b, FieldNumber(field, fr, 0) != 0.0);
+    break;
+  case STRATUS_FIELD_STR:
+    StratusJson_String(b, (const char *)FieldPtr(field, fr));
+    break;
+  case STRATUS_FIELD_I32_ARRAY:
+  case STRATUS_FIELD_F32_ARRAY:
+    StratusJson_Char(b, '[');
+    for (int i = 0; i < field->count; i++) {
+      if (i)
+        StratusJson_Raw(b, ", ");
+      WriteNumber(b, field, fr, i);
+    }
+    StratusJson_Char(b, ']');
+    break;
+  default:
+    WriteNumber(b, field, fr, 0);
+    break;
+  }
+}
+
+/* Bit i of `fields` selects g_stratus_fields[i]; fields past bit 63 are
+ * always written */
+static int FieldSelected(uint64_t fields, size_t i) {
+  return i >= 64 || (fields >> i) & 1u;
+}
+
+static void WriteEvents(StratusJsonBuf *b, uint32_t events) {
+  StratusJson_Raw(b, ",\n  \"events\": [");
+  int first = 1;
+  for (int i = 0; i < STRATUS_EVENT_COUNT; i++) {
+    if (!(events & (1u << i)))
+      continue;
+    if (!first)
+      StratusJson_Raw(b, ", ");
+    StratusJson_String(b, StratusEvents_Name(i));
+    first = 0;
+  }
+  StratusJson_Char(b, ']');
+}
+
+static void WriteRecord(StratusJsonBuf *b, const StratusDelta *d,
+                        const StratusFrame *fr, StratusPublishKind kind,
+                        uint64_t fields) {
+  StratusJson_Raw(b, "{\n  \"timestamp\": ");
+  StratusJson_Int(b, fr->timestamp);
+  StratusJson_Raw(b, ",\n  \"frame_seq\": ");
+  StratusJson_Uint(b, fr->frame_seq);
+  StratusJson_Raw(b, ",\n  \"monotonic_ns\": ");
+  StratusJson_Uint(b, fr->monotonic_ns);
+  StratusJson_Raw(b, ",\n  \"sim_time_s\": ");
+  StratusJson_Fixed(b, fr->sim_time_s, 3);
+  StratusJson_Raw(b, ",\n  \"event_seq\": ");
+  StratusJson_Uint(b, fr->event_seq);
+  if (kind == STRATUS_PUBLISH_EVENT) {
+    StratusJson_Raw(b, ",\n  \"type\": \"event\"");
+    WriteEvents(b, fr->events);
+  } else if (kind == STRATUS_PUBLISH_KEYFRAME) {
+    StratusJson_Raw(b, ",\n  \"type\": \"keyframe\"");
+  } else if (kind == STRATUS_PUBLISH_DELTA) {
+    StratusJson_Raw(b, ",\n  \"type\": \"delta\"");
+  }
+  if (kind != STRATUS_PUBLISH_FULL && d && d->have_keyframe) {
+    StratusJson_Raw(b, ",\n  \"seq\": ");
+    StratusJson_Uint(b, d->seq);
+    StratusJson_Raw(b, ",\n  \"keyframe_seq\": ");
+    StratusJson_Uint(b, d->keyframe_seq);
+  }
+  if (kind != STRATUS_PUBLISH_DELTA)
+    StratusJson_Raw(b, ",\n  \"simulator\": \"X-Plane\"");
+
+  /* Sections and keys come from the registry and never need escaping */
+  const char *open_section = NULL;
+  int first_in_section = 1;
+  for (size_t i = 0; i < g_stratus_field_count; i++) {
+    const StratusField *field = &g_stratus_fields[i];
+    if (!FieldSelected(fields, i))
+      continue;
+    if (kind == STRATUS_PUBLISH_DELTA &&
+        !FieldDiffers(d, field, &d->keyframe, fr))
+      continue;
+
+    if (!SameSection(field->section, open_section)) {
+      if (open_section)
+        StratusJson_Raw(b, "\n  }");
+      if (field->section) {
+        StratusJson_Raw(b, ",\n  \"");
+        StratusJson_Raw(b, field->section);
+        StratusJson_Raw(b, "\": {");
+      }
+      open_section = field->section;
+      first_in_section = 1;
+    }
+
+    if (field->section)
+      StratusJson_Raw(b, first_in_section ? "\n    \"" : ",\n    \"");
+    else
+      StratusJson_Raw(b, ",\n  \"");
+    StratusJson_Raw(b, field->key);
+    StratusJson_Raw(b, "\": ");
+    WriteValue(b, field, fr);
+    first_in_section = 0;
+  }
+  if (open_section)
+    StratusJson_Raw(b, "\n  }");
+  StratusJson_Raw(b, "\n}\n");
+}
+
+size_t StratusDelta_WriteJSON(char *out, size_t cap, const StratusDelta *d,
+                              const StratusFrame *fr, StratusPublishKind kind) {
+  StratusJsonBuf b;
+  StratusJson_Init(&b, out, cap);
+  WriteRecord(&b, d, fr, kind, UINT64_MAX);
+  return StratusJson_Finish(&b);
+}
+
+size_t StratusDelta_WriteJSONFields(char *out, size_t cap,
+                                    const StratusFrame *fr, uint64_t fields) {
+  StratusJsonBuf b;
+  StratusJson_Init(&b, out, cap);
+  WriteRecord(&b, NULL, fr,
+              fr->events ? STRATUS_PUBLISH_EVENT : STRATUS_PUBLISH_FULL,
+              fields);
+  return StratusJson_Finish(&b);
+}
@@ -0,0 +1,86 @@
+/*
+ * Stratus ATC - Delta Telemetry Publishing
+ *
+ * Most telemetry fields (radios, transponder, autopilot targets, aircraft)
+ * change a handful of times per flight, and a parked aircraft changes not at
+ * all. In delta mode the plugin writes:
+ *
+ *   - a full keyframe every `keyframe_interval_s`, tagged
+ *       "type": "keyframe", "seq": N, "keyframe_seq": N
+ *   - in between, only when some field moved beyond its dead-band, a delta
+ *       "type": "delta", "seq": M, "keyframe_seq": N
+ *     holding every field that differs from keyframe N by more than its
+ *     dead-band.
+ *   - nothing at all while no field moves beyond its dead-band.
+ *
+ * A frame with events (stratus_events.h) is always written in full, in
+ * either mode, as
+ *     "type": "event", "events": ["touchdown", ...]
+ * and in delta mode it is also the new keyframe, with seq == keyframe_seq.
+ * Every record carries the frame's "event_seq".
+ *
+ * Deltas are relative to the keyframe, not to the previous delta, so a reader
+ * that misses records (the file is overwritten in place) only needs the most
+ * recent keyframe plus the most recent delta. The reader's view of every
+ * field stays within its dead-band of the sim.
+ *
+ * Fields and their dead-band classes come from the DataRef registry
+ * (stratus_datarefs.h), which also drives the JSON writer. A "full" record
+ * is the format the plugin has always written, without type/seq keys.
+ */
+
+#ifndef STRATUS_DELTA_H
+#define STRATUS_DELTA_H
+
+#include "stratus_config.h"
+#include "stratus_datarefs.h"
+#include "stratus_frame.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  STRATUS_PUBLISH_NONE,     /* Nothing changed, skip the write */
+  STRATUS_PUBLISH_FULL,     /* Plain snapshot (delta mode off) */
+  STRATUS_PUBLISH_KEYFRAME, /* Snapshot that later deltas refer to */
+  STRATUS_PUBLISH_DELTA,    /* Changed fields only */
+  STRATUS_PUBLISH_EVENT     /* Snapshot of a frame with events */
+} StratusPublishKind;
+
+typedef struct StratusDelta {
+  double deadband[STRATUS_DEADBAND_COUNT]; /* In each field's own unit */
+  double keyframe_interval_s;
+
+  StratusFrame keyframe; /* Last keyframe written */
+  StratusFrame reader;   /* What a reader holds: keyframe + last delta */
+  uint64_t seq;
+  uint64_t keyframe_seq;
+  uint64_t keyframe_ns; /* monotonic_ns of the last keyframe */
+  int have_keyframe;
+} StratusDelta;
+
+/* Set dead-bands and keyframe interval from the config and reset state */
+void StratusDelta_Init(StratusDelta *d, const StratusConfig *cfg);
+
+/* Decide what to publish for `fr` and advance the state accordingly. Call
+ * once per frame, then pass the result to StratusDelta_WriteJSON. A frame
+ * with events is STRATUS_PUBLISH_EVENT, and the keyframe from then on. */
+StratusPublishKind StratusDelta_Next(StratusDelta *d, const StratusFrame *fr);
+
+/* Largest record either writer produces, with room to spare */
+#define STRATUS_DELTA_JSON_MAX 4096
+
+/* Write `fr` as a JSON record of the given kind into `out`. `d` may be NULL
+ * for STRATUS_PUBLISH_FULL, and for STRATUS_PUBLISH_EVENT outside delta
+ * mode. Returns the length, or 0 if `cap` is too small. */
+size_t StratusDelta_WriteJSON(char *out, size_t cap, const StratusDelta *d,
+                              const StratusFrame *fr, StratusPublishKind kind);
+
+/* Write `fr` as a full record holding only the selected fields: bit i of
+ * `fields` selects g_stratus_fields[i]; an event record if `fr` has events.
+ * Used for telemetry server subscriptions (stratus_server.h). Returns as
+ * StratusDelta_WriteJSON. */
+size_t StratusDelta_WriteJSONFields(char *out, size_t cap,
+                                    const StratusFrame *fr, uint64_t fields);
+
+#endif /* STRATUS_DELTA_H */
@@ -0,0 +1,211 @@
+/*
+ * Stratus ATC - Derived Flight State
+ *
+ * See stratus_derived.h. Runs on the sim thread.
+ */
+
+#include "stratus_derived.h"
+
+#include <math.h>
+#include <string.h>
+
+#define MPS_TO_KTS 1.9438445
+#define METERS_TO_FEET 3.28084
+#define FEET_PER_NM 6076.115
+#define NM_PER_DEG 60.0
+#define DEG_TO_RAD 0.017453292519943295
+#define RAD_TO_DEG 57.29577951308232
+
+/* Phase thresholds, as in flight_phase.py; on the ground by ground speed */
+#define PARKED_KTS 3.0
+#define TAXI_MAX_KTS 40.0
+#define CLIMB_FPM 300.0
+#define DESCENT_FPM -300.0
+#define PATTERN_AGL_FT 2000.0
+#define DEPARTURE_MSL_FT 10000.0
+
+#define DEFAULT_RUNWAY_WIDTH_FT 100.0
+#define CONFIRM_NS ((uint64_t)(STRATUS_PHASE_CONFIRM_S * 1e9))
+#define SEARCH_NS ((uint64_t)(STRATUS_DERIVED_SEARCH_S * 1e9))
+
+static const char *const kPhaseNames[STRATUS_PHASE_COUNT] = {
+    "UNKNOWN",   "PARKED",  "TAXI_OUT", "TAKEOFF",  "DEPARTURE",
+    "CRUISE",    "DESCENT", "APPROACH", "LANDING",  "TAXI_IN"};
+
+void StratusDerived_Init(StratusDerived *d, double airport_range_nm) {
+  memset(d, 0, sizeof(*d));
+  d->range_nm = airport_range_nm;
+}
+
+const char *StratusDerived_PhaseName(int phase) {
+  if (phase < 0 || phase >= STRATUS_PHASE_COUNT)
+    return kPhaseNames[STRATUS_PHASE_UNKNOWN];
+  return kPhaseNames[phase];
+}
+
+static int EnginesRunning(const StratusFrame *fr) {
+  int n = fr->engine_count < STRATUS_MAX_ENGINES ? fr->engine_count
+                                                 : STRATUS_MAX_ENGINES;
+  for (int i = 0; i < n; i++) {
+    if (fr->engine_running[i])
+      return 1;
+  }
+  return 0;
+}
+
+static StratusPhase Detect(const StratusDerived *d, const StratusFrame *fr) {
+  if (fr->on_ground) {
+    if (fr->ground_speed_kts < PARKED_KTS) {
+      /* After a flight, stopped with the engines off ends it */
+      if (d->airborne && EnginesRunning(fr))
+        return STRATUS_PHASE_TAXI_IN;
+      return STRATUS_PHASE_PARKED;
+    }
+    if (fr->ground_speed_kts < TAXI_MAX_KTS)
+      return d->airborne ? STRATUS_PHASE_TAXI_IN : STRATUS_PHASE_TAXI_OUT;
+    return d->airborne ? STRATUS_PHASE_LANDING : STRATUS_PHASE_TAKEOFF;
+  }
+
+  if (fr->vertical_speed_fpm > CLIMB_FPM)
+    return fr->altitude_msl_ft < DEPARTURE_MSL_FT ? STRATUS_PHASE_DEPARTURE
+                                                  : STRATUS_PHASE_CRUISE;
+  /* Descending or level: low means in the pattern or on approach */
+  if (fr->altitude_agl_ft < PATTERN_AGL_FT)
+    return STRATUS_PHASE_APPROACH;
+  return fr->vertical_speed_fpm < DESCENT_FPM ? STRATUS_PHASE_DESCENT
+                                              : STRATUS_PHASE_CRUISE;
+}
+
+/* Advance the phase state machine; returns 1 if the phase changed */
+static int UpdatePhase(StratusDerived *d, const StratusFrame *fr) {
+  if (fr->paused) {
+    d->pending = d->phase; /* The confirmation clock starts over after */
+    return 0;
+  }
+  if (!fr->on_ground)
+    d->airborne = 1;
+
+  StratusPhase now = Detect(d, fr);
+  if (now == d->phase) {
+    d->pending = now;
+    return 0;
+  }
+  if (d->phase != STRATUS_PHASE_UNKNOWN) {
+    if (now != d->pending) {
+      d->pending = now;
+      d->pending_since_ns = fr->monotonic_ns;
+      return 0;
+    }
+    if (fr->monotonic_ns - d->pending_since_ns < CONFIRM_NS)
+      return 0;
+  }
+  d->phase = now; /* The first detection needs no confirmation */
+  d->pending = now;
+  if (now == STRATUS_PHASE_PARKED)
+    d->airborne = 0;
+  return 1;
+}
+
+/* Degrees into [-180, 180) */
+static double WrapDeg(double deg) {
+  deg = fmod(deg + 180.0, 360.0);
+  return (deg < 0.0 ? deg + 360.0 : deg) - 180.0;
+}
+
+/* Nearest runway of `a` to the aircraft at the origin; `east` is nm per
+ * degree of longitude there */
+static void UpdateRunway(const StratusAirport *a, StratusFrame *fr,
+                         double east) {
+  const StratusRunway *runways = StratusAirports_Runways(a);
+  const StratusRunway *best = NULL;
+  double best_ft = 0.0, best_heading = 0.0;
+  for (int i = 0; i < a->runway_count; i++) {
+    const StratusRunway *r = &runways[i];
+    double x1 = WrapDeg(r->le_lon_e7 * 1e-7 - fr->longitude) * east;
+    double y1 = (r->le_lat_e7 * 1e-7 - fr->latitude) * NM_PER_DEG;
+    double vx = WrapDeg((r->he_lon_e7 - r->le_lon_e7) * 1e-7) * east;
+    double vy = (r->he_lat_e7 - r->le_lat_e7) * 1e-7 * NM_PER_DEG;
+
+    /* Closest point of the threshold-to-threshold segment */
+    double len2 = vx * vx + vy * vy;
+    double t = len2 > 0.0 ? -(x1 * vx + y1 * vy) / len2 : 0.0;
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t;
+    double ft = hypot(x1 + t * vx, y1 + t * vy) * FEET_PER_NM;
+    if (!best || ft < best_ft) {
+      best = r;
+      best_ft = ft;
+      best_heading = atan2(vx, vy) * RAD_TO_DEG; /* Low end to high end */
+    }
+  }
+
+  if (!best) {
+    memset(fr->runway, 0, sizeof(fr->runway));
+    fr->runway_dist_ft = 0.0f;
+    fr->runway_length_ft = 0;
+    fr->on_runway = 0;
+    return;
+  }
+  /* Lined up from the low end towards the high end: the low end's number */
+  int from_low = fabs(WrapDeg(fr->heading_true - best_heading)) <= 90.0;
+  memcpy(fr->runway, from_low ? best->le_ident : best->he_ident,
+         sizeof(fr->runway));
+  fr->runway[sizeof(fr->runway) - 1] = '\0';
+  fr->runway_dist_ft = (float)best_ft;
+  fr->runway_length_ft = best->length_ft;
+  double half_width =
+      (best->width_ft ? best->width_ft : DEFAULT_RUNWAY_WIDTH_FT) / 2.0;
+  fr->on_runway = fr->on_ground && best_ft <= half_width;
+}
+
+static void UpdateAirport(StratusDerived *d, StratusFrame *fr) {
+  if (fr->monotonic_ns >= d->next_search_ns) {
+    d->airport = StratusAirports_Nearest(fr->latitude, fr->longitude,
+                                         d->range_nm, NULL);
+    d->next_search_ns = fr->monotonic_ns + SEARCH_NS;
+  }
+
+  const StratusAirport *a = d->airport;
+  if (!a) {
+    memset(fr->airport, 0, sizeof(fr->airport));
+    fr->airport_dist_nm = 0.0f;
+    fr->airport_bearing_deg = 0.0f;
+    fr->airport_elevation_ft = 0.0f;
+    memset(fr->runway, 0, sizeof(fr->runway));
+    fr->runway_dist_ft = 0.0f;
+    fr->runway_length_ft = 0;
+    fr->on_runway = 0;
+    return;
+  }
+
+  double east = cos(fr->latitude * DEG_TO_RAD) * NM_PER_DEG;
+  double x = WrapDeg(a->lon_e7 * 1e-7 - fr->longitude) * east;
+  double y = (a->lat_e7 * 1e-7 - fr->latitude) * NM_PER_DEG;
+  double bearing = atan2(x, y) * RAD_TO_DEG;
+  memcpy(fr->airport, a->ident, sizeof(fr->airport));
+  fr->airport[sizeof(fr->airport) - 1] = '\0';
+  fr->airport_dist_nm = (float)hypot(x, y);
+  fr->airport_bearing_deg = (float)(bearing < 0.0 ? bearing + 360.0 : bearing);
+  fr->airport_elevation_ft = a->elevation_ft;
+  UpdateRunway(a, fr, east);
+}
+
+int StratusDerived_Update(StratusDerived *d, StratusFrame *fr) {
+  fr->ground_speed_kts = (float)(fr->ground_speed_mps * MPS_TO_KTS);
+  fr->tas_kts = (float)(fr->tas_mps * MPS_TO_KTS);
+  fr->altitude_msl_ft = (float)(fr->altitude_msl_m * METERS_TO_FEET);
+  fr->altitude_agl_ft = (float)(fr->altitude_agl_m * METERS_TO_FEET);
+
+  /* The sim clock going back is a new flight (or a restarted sim) */
+  if (fr->sim_time_s < d->sim_time_s) {
+    d->phase = STRATUS_PHASE_UNKNOWN;
+    d->pending = STRATUS_PHASE_UNKNOWN;
+    d->airborne = 0;
+    d->next_search_ns = 0;
+  }
+  d->sim_time_s = fr->sim_time_s;
+
+  int changed = UpdatePhase(d, fr);
+  fr->phase = (int32_t)d->phase;
+  UpdateAirport(d, fr);
+  return changed;
+}
@@ -0,0 +1,73 @@
+/*
+ * Stratus ATC - Derived Flight State
+ *
+ * Facts every client would otherwise work out from the raw frame, computed
+ * once per captured frame on the sim thread and published in the frame's
+ * derived block (StratusFrame v4) and the "derived" JSON section:
+ *
+ *   - flight phase, from the same rules as the old Python client's
+ *     flight_phase.py: on the ground by ground speed (so wind over a parked
+ *     aircraft is not taxiing) and whether it has flown yet, in the air by
+ *     vertical speed, altitude and height above ground. A new phase has to
+ *     hold for STRATUS_PHASE_CONFIRM_S before it is published, and the
+ *     phase holds while the sim is paused.
+ *   - ground speed and TAS in knots, altitudes in feet
+ *   - nearest airport within `airport_range_nm`, with distance, bearing and
+ *     elevation, from the airport index (stratus_airports.h)
+ *   - that airport's nearest runway: the end the aircraft is heading for,
+ *     its distance from the centerline, its length, and whether the
+ *     aircraft is on it
+ *
+ * The nearest-airport search runs every STRATUS_DERIVED_SEARCH_S; distance,
+ * bearing and runway are recomputed for every frame. Without an index the
+ * airport fields stay empty and the rest is still filled in.
+ */
+
+#ifndef STRATUS_DERIVED_H
+#define STRATUS_DERIVED_H
+
+#include "stratus_airports.h"
+#include "stratus_frame.h"
+
+#include <stdint.h>
+
+typedef enum {
+  STRATUS_PHASE_UNKNOWN,
+  STRATUS_PHASE_PARKED,
+  STRATUS_PHASE_TAXI_OUT,
+  STRATUS_PHASE_TAKEOFF,
+  STRATUS_PHASE_DEPARTURE,
+  STRATUS_PHASE_CRUISE,
+  STRATUS_PHASE_DESCENT,
+  STRATUS_PHASE_APPROACH,
+  STRATUS_PHASE_LANDING,
+  STRATUS_PHASE_TAXI_IN,
+  STRATUS_PHASE_COUNT
+} StratusPhase;
+
+#define STRATUS_PHASE_CONFIRM_S 3.0
+#define STRATUS_DERIVED_SEARCH_S 1.0
+
+typedef struct StratusDerived {
+  double range_nm;
+  StratusPhase phase;
+  StratusPhase pending;       /* Detected, waiting to be confirmed */
+  uint64_t pending_since_ns;  /* monotonic_ns it was first detected */
+  int airborne;               /* Flown since the last PARKED */
+  double sim_time_s;          /* Of the last frame; going back = new flight */
+  const StratusAirport *airport;
+  uint64_t next_search_ns;
+} StratusDerived;
+
+/* Reset for a new session, with the nearest-airport search radius. Call
+ * again after loading a different airport index. */
+void StratusDerived_Init(StratusDerived *d, double airport_range_nm);
+
+/* Fill the derived block of `fr` from its raw fields. Returns 1 if the
+ * published phase changed. */
+int StratusDerived_Update(StratusDerived *d, StratusFrame *fr);
+
+/* "PARKED", "TAXI_OUT", ...; "UNKNOWN" for anything out of range */
+const char *StratusDerived_PhaseName(int phase);
+
+#endif /* STRATUS_DERIVED_H */
@@ -0,0 +1,51 @@
+/*
+ * Stratus ATC - Telemetry Events
+ *
+ * See stratus_events.h.
+ */
+
+#include "stratus_events.h"
+
+#include <string.h>
+
+static const char *const kEventNames[STRATUS_EVENT_COUNT] = {
+    "touchdown", "liftoff", "pause",     "unpause", "com1",
+    "com2",      "squawk",  "xpdr_mode", "phase"};
+
+void StratusEvents_Init(StratusEvents *e) { memset(e, 0, sizeof(*e)); }
+
+uint32_t StratusEvents_Detect(StratusEvents *e, const StratusFrame *fr) {
+  uint32_t events = 0;
+  if (e->primed) {
+    if (fr->on_ground != e->on_ground)
+      events |= fr->on_ground ? STRATUS_EVENT_TOUCHDOWN : STRATUS_EVENT_LIFTOFF;
+    if (fr->paused != e->paused)
+      events |= fr->paused ? STRATUS_EVENT_PAUSE : STRATUS_EVENT_UNPAUSE;
+    if (fr->com1_hz != e->com1_hz)
+      events |= STRATUS_EVENT_COM1;
+    if (fr->com2_hz != e->com2_hz)
+      events |= STRATUS_EVENT_COM2;
+    if (fr->xpdr_code != e->xpdr_code)
+      events |= STRATUS_EVENT_SQUAWK;
+    if (fr->xpdr_mode != e->xpdr_mode)
+      events |= STRATUS_EVENT_XPDR_MODE;
+    if (fr->phase != e->phase)
+      events |= STRATUS_EVENT_PHASE;
+  }
+
+  e->primed = 1;
+  e->on_ground = fr->on_ground;
+  e->paused = fr->paused;
+  e->com1_hz = fr->com1_hz;
+  e->com2_hz = fr->com2_hz;
+  e->xpdr_code = fr->xpdr_code;
+  e->xpdr_mode = fr->xpdr_mode;
+  e->phase = fr->phase;
+  return events;
+}
+
+const char *StratusEvents_Name(int bit) {
+  if (bit < 0 || bit >= STRATUS_EVENT_COUNT)
+    return NULL;
+  return kEventNames[bit];
+}
@@ -0,0 +1,64 @@
+/*
+ * Stratus ATC - Telemetry Events
+ *
+ * Some transitions matter to ATC the moment they happen: touchdown and
+ * liftoff, the sim pausing or resuming, a COM frequency or transponder
+ * change, a new flight phase. At the telemetry rate (1 Hz when parked, and
+ * up to a period late at any rate) a client would see them late, so the
+ * plugin looks for them between frames and publishes one at once:
+ *
+ *   - an event probe task reads just the rows in STRATUS_READ_EVENTS
+ *     (stratus_datarefs.h) at `event_rate_hz` and, on a change, makes the
+ *     telemetry task due on the same flight-loop callback
+ *   - every captured frame is checked too, for the derived flight phase
+ *     and for anything the probe did not run in time to see
+ *
+ * The frame that follows carries the transitions in StratusFrame.events and
+ * is published in full everywhere: a "type": "event" record in the telemetry
+ * file (stratus_delta.h), sent to every server subscriber whatever its rate,
+ * and never coalesced away on the I/O thread.
+ *
+ * The first frame only sets the baseline. Sim thread only; no SDK calls.
+ */
+
+#ifndef STRATUS_EVENTS_H
+#define STRATUS_EVENTS_H
+
+#include "stratus_frame.h"
+
+#include <stdint.h>
+
+#define STRATUS_EVENT_TOUCHDOWN 0x001u /* on_ground 0 -> 1 */
+#define STRATUS_EVENT_LIFTOFF 0x002u   /* on_ground 1 -> 0 */
+#define STRATUS_EVENT_PAUSE 0x004u
+#define STRATUS_EVENT_UNPAUSE 0x008u
+#define STRATUS_EVENT_COM1 0x010u /* Active frequency, e.g. a swap */
+#define STRATUS_EVENT_COM2 0x020u
+#define STRATUS_EVENT_SQUAWK 0x040u /* Transponder code */
+#define STRATUS_EVENT_XPDR_MODE 0x080u
+#define STRATUS_EVENT_PHASE 0x100u /* Derived flight phase */
+#define STRATUS_EVENT_COUNT 9
+
+typedef struct StratusEvents {
+  int primed; /* Seen a frame to compare against */
+  uint8_t on_ground;
+  uint8_t paused;
+  int32_t com1_hz;
+  int32_t com2_hz;
+  int32_t xpdr_code;
+  int32_t xpdr_mode;
+  int32_t phase;
+} StratusEvents;
+
+/* Forget the baseline; the next frame sets it */
+void StratusEvents_Init(StratusEvents *e);
+
+/* STRATUS_EVENT_* bits for what changed in `fr` since the last call, which
+ * becomes the new baseline */
+uint32_t StratusEvents_Detect(StratusEvents *e, const StratusFrame *fr);
+
+/* "touchdown", "liftoff", "pause", "unpause", "com1", "com2", "squawk",
+ * "xpdr_mode", "phase" for bit i; NULL past the last one */
+const char *StratusEvents_Name(int bit);
+
+#endif /* STRATUS_EVENTS_H */
@@ -0,0 +1,26 @@
+/*
+ * Stratus ATC - Telemetry Frame Serialization
+ *
+ * See stratus_frame.h. The encoded form is the in-memory layout verbatim,
+ * so encoding is two memcpys and decoding on the Rust side is a bounds check
+ * plus an unaligned read.
+ */
+
+#include "stratus_frame.h"
+
+#include <string.h>
+
+size_t StratusFrame_Encode(const StratusFrame *frame, uint8_t *out,
+                           size_t cap) {
+  if (cap < STRATUS_FRAME_ENCODED_SIZE)
+    return 0;
+
+  StratusFrameHeader hdr = {.magic = STRATUS_FRAME_MAGIC,
+                            .version = STRATUS_FRAME_VERSION,
+                            .header_size = sizeof(StratusFrameHeader),
+                            .frame_size = sizeof(StratusFrame),
+                            .flags = 0};
+  memcpy(out, &hdr, sizeof(hdr));
+  memcpy(out + sizeof(hdr), frame, sizeof(*frame));
+  return STRATUS_FRAME_ENCODED_SIZE;
+}
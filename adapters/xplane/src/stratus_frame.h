@@ -0,0 +1,135 @@
+/*
+ * Stratus ATC - Telemetry Frame Layout
+ *
+ * Fixed-layout snapshot of the DataRefs the plugin exports each tick.
+ * This struct is shared byte-for-byte with the Rust client
+ * (stratus-core/src/frame.rs, `TelemetryFrame`) and the in-process
+ * consumer (stratus-commander/src/frame.rs, `Frame`), so any change here
+ * must bump STRATUS_FRAME_VERSION and be mirrored in both.
+ *
+ * The same bytes are used by the shared-memory ring (stratus_shm.h) and,
+ * prefixed with a StratusFrameHeader, by the binary telemetry file
+ * (stratus_telemetry.bin). All multi-byte values are little-endian, the
+ * native order of every platform X-Plane runs on.
+ *
+ * All fields are naturally aligned and explicitly padded; there is no
+ * compiler-inserted padding on any supported platform.
+ */
+
+#ifndef STRATUS_FRAME_H
+#define STRATUS_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STRATUS_FRAME_VERSION 5
+#define STRATUS_FRAME_MAGIC 0x46525453u /* "STRF" little-endian */
+#define STRATUS_AIRCRAFT_NAME_LEN 64
+#define STRATUS_MAX_ENGINES 8
+#define STRATUS_AIRPORT_ID_LEN 8
+#define STRATUS_RUNWAY_ID_LEN 4
+
+typedef struct StratusFrame {
+  int64_t timestamp; /* Unix time, seconds */
+
+  /* Position */
+  double latitude;
+  double longitude;
+  double altitude_msl_m;
+  double altitude_agl_m;
+
+  /* Orientation (degrees) */
+  float heading_mag;
+  float heading_true;
+  float pitch;
+  float roll;
+
+  /* Speed */
+  float ground_speed_mps;
+  float ias_kts;
+  float tas_mps;
+  float vertical_speed_fpm;
+
+  /* Radios (Hz, 8.33 kHz-capable DataRefs) */
+  int32_t com1_hz;
+  int32_t com1_standby_hz;
+  int32_t com2_hz;
+  int32_t com2_standby_hz;
+  int32_t nav1_hz;
+  int32_t nav2_hz;
+
+  /* Transponder */
+  int32_t xpdr_code;
+  int32_t xpdr_mode;
+
+  /* Autopilot targets */
+  float ap_altitude_ft;
+  float ap_heading;
+  float ap_vs_fpm;
+
+  /* State flags (0/1) */
+  uint8_t on_ground;
+  uint8_t paused;
+  uint8_t _pad0[2];
+
+  /* Aircraft .acf file name, NUL-terminated, truncated if longer */
+  char aircraft[STRATUS_AIRCRAFT_NAME_LEN];
+
+  /* Engines (v2): running flags for the first engine_count engines */
+  int32_t engine_count;
+  int32_t engine_running[STRATUS_MAX_ENGINES];
+  uint8_t _pad1[4];
+
+  /* Capture timing (v3). `timestamp` only resolves whole seconds; these let
+   * a client order frames, spot dropped ones and compute rates. */
+  uint64_t frame_seq;    /* 1 for the first frame after plugin start */
+  uint64_t monotonic_ns; /* Plugin monotonic clock at capture */
+  double sim_time_s;     /* sim/time/total_flight_time_sec at capture */
+
+  /* Derived state (v4), computed by the plugin from the fields above and
+   * its airport index (stratus_derived.h) so clients need not */
+  int32_t phase; /* StratusPhase */
+  float ground_speed_kts;
+  float tas_kts;
+  float altitude_msl_ft;
+  float altitude_agl_ft;
+  char airport[STRATUS_AIRPORT_ID_LEN]; /* Nearest airport, "" if none */
+  float airport_dist_nm;
+  float airport_bearing_deg; /* True, from the aircraft */
+  float airport_elevation_ft;
+  char runway[STRATUS_RUNWAY_ID_LEN]; /* Its nearest runway, by heading end */
+  float runway_dist_ft;               /* From that runway's centerline */
+  int32_t runway_length_ft;
+  uint8_t on_runway; /* On the ground within the runway's width */
+  uint8_t _pad2[3];
+
+  /* Events (v5): transitions since the previous frame, STRATUS_EVENT_* bits
+   * (stratus_events.h), 0 in most frames. event_seq counts the frames that
+   * had any, so a reader that skipped frames can tell it missed one. */
+  uint32_t events;
+  uint32_t event_seq;
+} StratusFrame;
+
+_Static_assert(sizeof(StratusFrame) == 312, "StratusFrame layout changed");
+
+/* Header in front of a serialized frame, so readers can reject a file written
+ * by a different plugin version instead of misreading it */
+typedef struct StratusFrameHeader {
+  uint32_t magic;       /* STRATUS_FRAME_MAGIC */
+  uint16_t version;     /* STRATUS_FRAME_VERSION */
+  uint16_t header_size; /* sizeof(StratusFrameHeader) */
+  uint32_t frame_size;  /* sizeof(StratusFrame) */
+  uint32_t flags;       /* Reserved, 0 */
+} StratusFrameHeader;
+
+_Static_assert(sizeof(StratusFrameHeader) == 16,
+               "StratusFrameHeader layout changed");
+
+#define STRATUS_FRAME_ENCODED_SIZE                                             \
+  (sizeof(StratusFrameHeader) + sizeof(StratusFrame))
+
+/* Serialize header + frame into `out`. Returns the number of bytes written,
+ * or 0 if `cap` is smaller than STRATUS_FRAME_ENCODED_SIZE. */
+size_t StratusFrame_Encode(const StratusFrame *frame, uint8_t *out, size_t cap);
+
+#endif /* STRATUS_FRAME_H */
@@ -0,0 +1,216 @@
+/*
+ * Stratus ATC - Background I/O Thread
+ *
+ * See stratus_io.h. The queue is a classic power-of-two SPSC ring: the
+ * producer owns `head`, the consumer owns `tail`, and each side only reads
+ * the other's index with acquire ordering.
+ */
+
+#include "stratus_io.h"
+#include "stratus_thread.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#define IO_QUEUE_LEN 32 /* Power of two */
+#define IO_QUEUE_MASK (IO_QUEUE_LEN - 1)
+
+typedef enum {
+  IO_MSG_FRAME,
+  IO_MSG_PTT,
+  IO_MSG_CONTEXT,
+  IO_MSG_TRAFFIC
+} IoMsgType;
+
+typedef struct IoMsg {
+  IoMsgType type;
+  union {
+    StratusFrame frame;
+    StratusPttEvent ptt;
+    StratusContext context;
+    StratusTraffic traffic;
+  } u;
+} IoMsg;
+
+static IoMsg g_queue[IO_QUEUE_LEN];
+static _Atomic uint32_t g_head = 0; /* Next slot to write (producer) */
+static _Atomic uint32_t g_tail = 0; /* Next slot to read (consumer) */
+static _Atomic uint64_t g_dropped = 0;
+static _Atomic int g_running = 0;
+
+static StratusIoCallbacks g_callbacks;
+static unsigned g_poll_interval_ms = 100;
+
+static StratusThread g_thread;
+static StratusWake g_wake;
+
+/* ============================================================================
+ * Queue
+ * ============================================================================
+ */
+
+static IoMsg *QueueReserve(void) {
+  uint32_t head = atomic_load_explicit(&g_head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&g_tail, memory_order_acquire);
+  if (head - tail >= IO_QUEUE_LEN) {
+    atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+    return NULL;
+  }
+  return &g_queue[head & IO_QUEUE_MASK];
+}
+
+static void QueueCommit(void) {
+  atomic_fetch_add_explicit(&g_head, 1, memory_order_release);
+  StratusWake_Post(&g_wake);
+}
+
+int StratusIo_PushFrame(const StratusFrame *frame) {
+  if (!atomic_load_explicit(&g_running, memory_order_relaxed))
+    return 0;
+  IoMsg *msg = QueueReserve();
+  if (!msg)
+    return 0;
+  msg->type = IO_MSG_FRAME;
+  memcpy(&msg->u.frame, frame, sizeof(*frame));
+  QueueCommit();
+  return 1;
+}
+
+int StratusIo_PushPtt(const StratusPttEvent *ev) {
+  if (!atomic_load_explicit(&g_running, memory_order_relaxed))
+    return 0;
+  IoMsg *msg = QueueReserve();
+  if (!msg)
+    return 0;
+  msg->type = IO_MSG_PTT;
+  memcpy(&msg->u.ptt, ev, sizeof(*ev));
+  QueueCommit();
+  return 1;
+}
+
+int StratusIo_PushContext(const StratusContext *ctx) {
+  if (!atomic_load_explicit(&g_running, memory_order_relaxed))
+    return 0;
+  IoMsg *msg = QueueReserve();
+  if (!msg)
+    return 0;
+  msg->type = IO_MSG_CONTEXT;
+  memcpy(&msg->u.context, ctx, sizeof(*ctx));
+  QueueCommit();
+  return 1;
+}
+
+int StratusIo_PushTraffic(const StratusTraffic *traffic) {
+  if (!atomic_load_explicit(&g_running, memory_order_relaxed))
+    return 0;
+  IoMsg *msg = QueueReserve();
+  if (!msg)
+    return 0;
+  msg->type = IO_MSG_TRAFFIC;
+  memcpy(&msg->u.traffic, traffic, sizeof(*traffic));
+  QueueCommit();
+  return 1;
+}
+
+uint64_t StratusIo_Dropped(void) {
+  return atomic_load_explicit(&g_dropped, memory_order_relaxed);
+}
+
+int StratusIo_IsRunning(void) {
+  return atomic_load_explicit(&g_running, memory_order_relaxed);
+}
+
+/* ============================================================================
+ * I/O thread
+ * ============================================================================
+ */
+
+/* Drain the queue. Frames are coalesced so a slow disk only ever writes the
+ * newest one, carrying the events of every frame it replaced; PTT
+ * transitions, context events and traffic snapshots are delivered in
+ * order. */
+static void DrainQueue(void) {
+  static StratusFrame latest;
+  int have_frame = 0;
+  uint32_t events = 0;
+
+  uint32_t tail = atomic_load_explicit(&g_tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&g_head, memory_order_acquire);
+
+  while (tail != head) {
+    const IoMsg *msg = &g_queue[tail & IO_QUEUE_MASK];
+    if (msg->type == IO_MSG_FRAME) {
+      memcpy(&latest, &msg->u.frame, sizeof(latest));
+      events |= latest.events;
+      have_frame = 1;
+    } else if (msg->type == IO_MSG_PTT && g_callbacks.on_ptt) {
+      g_callbacks.on_ptt(&msg->u.ptt);
+    } else if (msg->type == IO_MSG_CONTEXT && g_callbacks.on_context) {
+      g_callbacks.on_context(&msg->u.context);
+    } else if (msg->type == IO_MSG_TRAFFIC && g_callbacks.on_traffic) {
+      g_callbacks.on_traffic(&msg->u.traffic);
+    }
+    tail++;
+    atomic_store_explicit(&g_tail, tail, memory_order_release);
+  }
+
+  if (have_frame && g_callbacks.on_frame) {
+    latest.events = events;
+    g_callbacks.on_frame(&latest);
+  }
+}
+
+static void IoThreadMain(void *arg) {
+  (void)arg;
+  uint64_t next_idle = StratusMonotonicMs();
+
+  while (atomic_load_explicit(&g_running, memory_order_acquire)) {
+    uint64_t now = StratusMonotonicMs();
+    if (now < next_idle)
+      StratusWake_Wait(&g_wake, (unsigned)(next_idle - now));
+
+    DrainQueue();
+
+    now = StratusMonotonicMs();
+    if (now >= next_idle) {
+      if (g_callbacks.on_idle)
+        g_callbacks.on_idle();
+      next_idle = now + g_poll_interval_ms;
+    }
+  }
+
+  /* Flush whatever the sim thread queued before stopping */
+  DrainQueue();
+}
+
+int StratusIo_Start(const StratusIoCallbacks *callbacks,
+                    unsigned poll_interval_ms) {
+  if (atomic_load(&g_running))
+    return 1;
+
+  g_callbacks = *callbacks;
+  g_poll_interval_ms = poll_interval_ms ? poll_interval_ms : 100;
+  atomic_store(&g_head, 0);
+  atomic_store(&g_tail, 0);
+
+  if (!StratusWake_Init(&g_wake))
+    return 0;
+
+  atomic_store(&g_running, 1);
+  if (!StratusThread_Start(&g_thread, IoThreadMain, NULL)) {
+    atomic_store(&g_running, 0);
+    StratusWake_Destroy(&g_wake);
+    return 0;
+  }
+  return 1;
+}
+
+void StratusIo_Stop(void) {
+  if (!atomic_load(&g_running))
+    return;
+
+  atomic_store(&g_running, 0);
+  StratusWake_Post(&g_wake);
+  StratusThread_Join(&g_thread);
+  StratusWake_Destroy(&g_wake);
+}
@@ -0,0 +1,63 @@
+/*
+ * Stratus ATC - Background I/O Thread
+ *
+ * Keeps blocking file I/O off the X-Plane sim thread. The flight loop and
+ * command handlers push small fixed-size messages into a lock-free
+ * single-producer/single-consumer queue; a dedicated thread drains it and
+ * runs the (blocking) callbacks supplied by the plugin. The same thread runs
+ * an idle callback every poll interval for work that is not driven by the
+ * sim, such as reading the client command file.
+ *
+ * Producer side (sim thread) never blocks and never allocates: a push is a
+ * memcpy, two atomic operations and a semaphore post.
+ */
+
+#ifndef STRATUS_IO_H
+#define STRATUS_IO_H
+
+#include "stratus_context.h"
+#include "stratus_frame.h"
+#include "stratus_ptt.h"
+#include "stratus_traffic.h"
+
+#include <stdint.h>
+
+typedef struct StratusIoCallbacks {
+  /* Newest telemetry frame; older queued frames are skipped */
+  void (*on_frame)(const StratusFrame *frame);
+  /* PTT state change, in the order they happened */
+  void (*on_ptt)(const StratusPttEvent *ev);
+  /* Context event (aircraft/airport/scenery loaded), never coalesced */
+  void (*on_context)(const StratusContext *ctx);
+  /* Traffic snapshot (low rate), in order */
+  void (*on_traffic)(const StratusTraffic *traffic);
+  /* Called at least once per poll interval */
+  void (*on_idle)(void);
+} StratusIoCallbacks;
+
+/* Start the I/O thread. Returns 1 on success, 0 if no thread could be made. */
+int StratusIo_Start(const StratusIoCallbacks *callbacks,
+                    unsigned poll_interval_ms);
+
+/* Drain outstanding messages, then stop and join the I/O thread. */
+void StratusIo_Stop(void);
+
+/* 1 while the I/O thread is running */
+int StratusIo_IsRunning(void);
+
+/* Queue a telemetry frame. Returns 0 if the queue is full (frame dropped). */
+int StratusIo_PushFrame(const StratusFrame *frame);
+
+/* Queue a PTT state change. Returns 0 if the queue is full. */
+int StratusIo_PushPtt(const StratusPttEvent *ev);
+
+/* Queue a context event. Returns 0 if the queue is full. */
+int StratusIo_PushContext(const StratusContext *ctx);
+
+/* Queue a traffic snapshot. Returns 0 if the queue is full. */
+int StratusIo_PushTraffic(const StratusTraffic *traffic);
+
+/* Messages dropped because the queue was full since start */
+uint64_t StratusIo_Dropped(void);
+
+#endif /* STRATUS_IO_H */
@@ -0,0 +1,228 @@
+/*
+ * Stratus ATC - JSON Output Helpers
+ *
+ * See stratus_json.h.
+ */
+
+#define _GNU_SOURCE /* strtod_l on glibc */
+
+#include "stratus_json.h"
+
+#include <locale.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if APL
+#include <xlocale.h>
+#endif
+
+#if IBM
+typedef _locale_t CLocale;
+#define NewCLocale() _create_locale(LC_NUMERIC, "C")
+#define FreeCLocale(l) _free_locale(l)
+#define StrtodL(s, end, l) _strtod_l(s, end, l)
+#else
+typedef locale_t CLocale;
+#define NewCLocale() newlocale(LC_NUMERIC_MASK, "C", (locale_t)0)
+#define FreeCLocale(l) freelocale(l)
+#define StrtodL(s, end, l) strtod_l(s, end, l)
+#endif
+
+static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4,
+                                1e5, 1e6, 1e7, 1e8, 1e9};
+static const char kHex[] = "0123456789abcdef";
+
+void StratusJson_Init(StratusJsonBuf *b, char *data, size_t cap) {
+  b->data = data;
+  b->cap = cap;
+  b->len = 0;
+  b->overflow = 0;
+}
+
+size_t StratusJson_Finish(StratusJsonBuf *b) {
+  if (b->overflow)
+    return 0;
+  if (b->len < b->cap)
+    b->data[b->len] = '\0';
+  return b->len;
+}
+
+static void Append(StratusJsonBuf *b, const char *s, size_t n) {
+  if (n > b->cap - b->len) {
+    b->overflow = 1;
+    return;
+  }
+  memcpy(b->data + b->len, s, n);
+  b->len += n;
+}
+
+void StratusJson_Raw(StratusJsonBuf *b, const char *s) {
+  Append(b, s, strlen(s));
+}
+
+void StratusJson_Char(StratusJsonBuf *b, char c) {
+  if (b->len == b->cap) {
+    b->overflow = 1;
+    return;
+  }
+  b->data[b->len++] = c;
+}
+
+void StratusJson_String(StratusJsonBuf *b, const char *s) {
+  StratusJson_Char(b, '"');
+  const unsigned char *p = (const unsigned char *)s;
+  while (*p) {
+    /* Copy the longest run that needs no escaping in one go */
+    const unsigned char *run = p;
+    while (*p >= 0x20 && *p != '"' && *p != '\\')
+      p++;
+    Append(b, (const char *)run, (size_t)(p - run));
+    if (!*p)
+      break;
+
+    char esc[6] = {'\\', 0, 0, 0, 0, 0};
+    size_t n = 2;
+    switch (*p) {
+    case '"':
+      esc[1] = '"';
+      break;
+    case '\\':
+      esc[1] = '\\';
+      break;
+    case '\n':
+      esc[1] = 'n';
+      break;
+    case '\r':
+      esc[1] = 'r';
+      break;
+    case '\t':
+      esc[1] = 't';
+      break;
+    default:
+      esc[1] = 'u';
+      esc[2] = '0';
+      esc[3] = '0';
+      esc[4] = kHex[*p >> 4];
+      esc[5] = kHex[*p & 0xF];
+      n = 6;
+      break;
+    }
+    Append(b, esc, n);
+    p++;
+  }
+  StratusJson_Char(b, '"');
+}
+
+void StratusJson_Uint(StratusJsonBuf *b, uint64_t v) {
+  char digits[20];
+  size_t n = 0;
+  do {
+    digits[sizeof(digits) - ++n] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  Append(b, digits + sizeof(digits) - n, n);
+}
+
+void StratusJson_Int(StratusJsonBuf *b, int64_t v) {
+  if (v < 0) {
+    StratusJson_Char(b, '-');
+    StratusJson_Uint(b, (uint64_t)0 - (uint64_t)v);
+  } else {
+    StratusJson_Uint(b, (uint64_t)v);
+  }
+}
+
+/* `frac` as exactly `precision` digits, leading zeros included */
+static void AppendFraction(StratusJsonBuf *b, uint64_t frac, int precision) {
+  char digits[9];
+  for (int i = precision - 1; i >= 0; i--) {
+    digits[i] = (char)('0' + frac % 10);
+    frac /= 10;
+  }
+  StratusJson_Char(b, '.');
+  Append(b, digits, (size_t)precision);
+}
+
+void StratusJson_Fixed(StratusJsonBuf *b, double v, int precision) {
+  if (isnan(v) || isinf(v)) {
+    StratusJson_Raw(b, "null");
+    return;
+  }
+  if (precision < 0)
+    precision = 0;
+  if (precision > 9)
+    precision = 9;
+
+  /* Whole part and fraction are both exact; only the scaling rounds */
+  double mag = fabs(v);
+  double whole = floor(mag);
+  double scale = kPow10[precision];
+  double x = (mag - whole) * scale;
+  double digits = floor(x);
+  double rem = x - digits;
+  uint64_t frac = (uint64_t)digits;
+
+  if (rem > 0.5 + 1e-6) {
+    frac++;
+  } else if (rem >= 0.5 - 1e-6) {
+    /* Too close to a tie to trust the rounded product. The fused residual
+     * is rounded once, so its sign is right. Ties go to even, like printf. */
+    double residual = fma(mag - whole, scale, -(digits + 0.5));
+    int odd = precision ? (int)(frac & 1u) : fmod(whole, 2.0) != 0.0;
+    if (residual > 0.0 || (residual == 0.0 && odd))
+      frac++;
+  }
+  if (frac >= (uint64_t)scale) {
+    frac -= (uint64_t)scale;
+    whole += 1.0;
+  }
+
+  if (signbit(v))
+    StratusJson_Char(b, '-');
+  if (whole < 18446744073709551616.0) { /* 2^64 */
+    StratusJson_Uint(b, (uint64_t)whole);
+  } else {
+    /* Beyond any telemetry value. "%.0f" prints no radix character, so
+     * it is locale-independent too. */
+    char big[320];
+    snprintf(big, sizeof(big), "%.0f", whole);
+    StratusJson_Raw(b, big);
+  }
+  if (precision)
+    AppendFraction(b, frac, precision);
+}
+
+void StratusJson_Bool(StratusJsonBuf *b, int v) {
+  StratusJson_Raw(b, v ? "true" : "false");
+}
+
+/* Created on first use and kept for the life of the process */
+static _Atomic(CLocale) g_c_locale;
+
+static CLocale CNumericLocale(void) {
+  CLocale loc = atomic_load_explicit(&g_c_locale, memory_order_acquire);
+  if (loc)
+    return loc;
+  CLocale fresh = NewCLocale();
+  if (!fresh)
+    return NULL;
+  if (atomic_compare_exchange_strong_explicit(&g_c_locale, &loc, fresh,
+                                              memory_order_acq_rel,
+                                              memory_order_acquire))
+    return fresh;
+  FreeCLocale(fresh); /* Another thread got there first */
+  return loc;
+}
+
+int StratusJson_ParseDouble(const char *s, double *out) {
+  CLocale loc = CNumericLocale();
+  char *end;
+  /* Without a C locale object, plain strtod is right in most processes */
+  double v = loc ? StrtodL(s, &end, loc) : strtod(s, &end);
+  if (end == s || *end != '\0')
+    return 0;
+  *out = v;
+  return 1;
+}
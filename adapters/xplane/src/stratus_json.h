@@ -0,0 +1,60 @@
+/*
+ * Stratus ATC - JSON Output Helpers
+ *
+ * Shared by the telemetry, context and server writers. Output goes into a
+ * caller-supplied buffer, so a record costs no allocation and no stdio, and
+ * the finished bytes can be handed to one write() or send(). Numbers are
+ * formatted here rather than by printf: the decimal separator is always '.',
+ * whatever locale another plugin has set for the process. The one reader,
+ * StratusJson_ParseDouble, gives settings text the same guarantee.
+ *
+ * Writers never fail individually; running out of room latches `overflow`
+ * and StratusJson_Finish reports it once at the end.
+ */
+
+#ifndef STRATUS_JSON_H
+#define STRATUS_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct StratusJsonBuf {
+  char *data;
+  size_t cap;
+  size_t len;
+  int overflow; /* Set once the output did not fit */
+} StratusJsonBuf;
+
+/* Start writing into `data` (`cap` bytes) */
+void StratusJson_Init(StratusJsonBuf *b, char *data, size_t cap);
+
+/* Length written, or 0 if it overflowed. The output is NUL-terminated when
+ * there is room, but the terminator is not counted. */
+size_t StratusJson_Finish(StratusJsonBuf *b);
+
+/* Append `s` verbatim (punctuation, keys known not to need escaping) */
+void StratusJson_Raw(StratusJsonBuf *b, const char *s);
+
+void StratusJson_Char(StratusJsonBuf *b, char c);
+
+/* Write `s` as a JSON string literal, quotes included. Quotes, backslashes
+ * and control characters are escaped; other bytes (UTF-8) pass through. */
+void StratusJson_String(StratusJsonBuf *b, const char *s);
+
+void StratusJson_Int(StratusJsonBuf *b, int64_t v);
+
+void StratusJson_Uint(StratusJsonBuf *b, uint64_t v);
+
+/* `v` with exactly `precision` (0-9) decimals, rounded to nearest with ties
+ * to even: the same digits as printf("%.*f") in the C locale. NaN and
+ * infinities, which JSON cannot represent, are written as null. */
+void StratusJson_Fixed(StratusJsonBuf *b, double v, int precision);
+
+void StratusJson_Bool(StratusJsonBuf *b, int v);
+
+/* Parse all of `s` as strtod() does in the C locale, so the separator is
+ * '.' whatever the process locale. Returns 1 and sets `*out` if the whole
+ * string is a number, 0 otherwise. */
+int StratusJson_ParseDouble(const char *s, double *out);
+
+#endif /* STRATUS_JSON_H */
@@ -0,0 +1,338 @@
+/*
+ * Stratus ATC - Asynchronous Plugin Log
+ *
+ * See stratus_log.h. The ring is a bounded multi-producer queue in the
+ * style of Vyukov's: every slot carries a sequence number that says
+ * whether it is free for position `pos` (seq == pos) or holds the message
+ * for it (seq == pos + 1). Producers claim positions with a CAS on the
+ * enqueue index; the single consumer is whoever holds the drain flag,
+ * normally the writer thread.
+ */
+
+#include "stratus_log.h"
+#include "stratus_thread.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_RING_LEN 256 /* Power of two */
+#define LOG_RING_MASK (LOG_RING_LEN - 1)
+#define LOG_MSG_LEN 240
+#define LOG_FLUSH_MS 100 /* Writer wakes at least this often */
+#define LOG_PATH_LEN 1024
+
+typedef struct LogSlot {
+  _Atomic uint32_t seq;
+  uint8_t level;
+  int64_t unix_ms;
+  char text[LOG_MSG_LEN];
+} LogSlot;
+
+_Atomic int g_stratus_log_level = STRATUS_LOG_INFO;
+
+static LogSlot g_ring[LOG_RING_LEN];
+static _Atomic uint32_t g_enqueue = 0;
+static _Atomic uint32_t g_dequeue = 0; /* Written by the drain flag holder */
+static _Atomic uint64_t g_dropped = 0; /* Ring full */
+static atomic_flag g_drain_lock = ATOMIC_FLAG_INIT;
+
+static _Atomic int g_open = 0;
+static _Atomic int g_running = 0; /* Writer thread alive */
+static StratusThread g_thread;
+static StratusWake g_wake;
+
+/* Owned by the drain flag holder once the log is open */
+static FILE *g_fp = NULL;
+static char g_path[LOG_PATH_LEN];
+static uint64_t g_bytes = 0;
+static _Atomic uint64_t g_max_bytes = 1024u * 1024u;
+static _Atomic int g_keep = 3;
+
+static const char *const kLevelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+static int64_t WallClockMs(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void LocalTime(time_t t, struct tm *out) {
+#if IBM
+  localtime_s(out, &t);
+#else
+  localtime_r(&t, out);
+#endif
+}
+
+/* ============================================================================
+ * Ring
+ * ============================================================================
+ */
+
+static LogSlot *RingReserve(uint32_t *pos_out) {
+  uint32_t pos = atomic_load_explicit(&g_enqueue, memory_order_relaxed);
+  for (;;) {
+    LogSlot *slot = &g_ring[pos & LOG_RING_MASK];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&g_enqueue, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        *pos_out = pos;
+        return slot;
+      }
+    } else if (diff < 0) {
+      return NULL; /* Full: the writer has not caught up with this slot */
+    } else {
+      pos = atomic_load_explicit(&g_enqueue, memory_order_relaxed);
+    }
+  }
+}
+
+static void RingCommit(LogSlot *slot, uint32_t pos) {
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+static uint32_t RingBacklog(void) {
+  return atomic_load_explicit(&g_enqueue, memory_order_relaxed) -
+         atomic_load_explicit(&g_dequeue, memory_order_relaxed);
+}
+
+/* ============================================================================
+ * Writer side
+ * ============================================================================
+ */
+
+static void WriteLine(int level, int64_t unix_ms, const char *text) {
+  if (!g_fp)
+    return;
+  struct tm tm_info;
+  LocalTime((time_t)(unix_ms / 1000), &tm_info);
+  char time_str[16];
+  strftime(time_str, sizeof(time_str), "%H:%M:%S", &tm_info);
+
+  int n = fprintf(g_fp, "[%s.%03d] [%s] %s\n", time_str,
+                  (int)(unix_ms % 1000), kLevelNames[level], text);
+  if (n > 0)
+    g_bytes += (uint64_t)n;
+}
+
+static void WriteBanner(const char *what) {
+  if (!g_fp)
+    return;
+  time_t now = time(NULL);
+  struct tm tm_info;
+  LocalTime(now, &tm_info);
+  char time_str[64];
+  strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+  int n = fprintf(g_fp, "=== %s: %s ===\n", what, time_str);
+  if (n > 0)
+    g_bytes += (uint64_t)n;
+  fflush(g_fp);
+}
+
+static void Rotate(void) {
+  int keep = atomic_load_explicit(&g_keep, memory_order_relaxed);
+  char from[LOG_PATH_LEN + 16], to[LOG_PATH_LEN + 16];
+
+  fclose(g_fp);
+  if (keep > 0) {
+    snprintf(to, sizeof(to), "%s.%d", g_path, keep);
+    remove(to);
+    for (int i = keep - 1; i >= 1; i--) {
+      snprintf(from, sizeof(from), "%s.%d", g_path, i);
+      snprintf(to, sizeof(to), "%s.%d", g_path, i + 1);
+      rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", g_path);
+    rename(g_path, to);
+  }
+  g_fp = fopen(g_path, keep > 0 ? "a" : "w");
+  g_bytes = 0;
+  WriteBanner("Log Rotated");
+}
+
+/* Write out everything committed so far. Only one thread drains at a time;
+ * a caller that finds the flag taken leaves the work to its holder. */
+static void Drain(void) {
+  if (atomic_flag_test_and_set_explicit(&g_drain_lock, memory_order_acquire))
+    return;
+
+  int wrote = 0;
+  uint64_t dropped =
+      atomic_exchange_explicit(&g_dropped, 0, memory_order_relaxed);
+  if (dropped) {
+    char text[64];
+    snprintf(text, sizeof(text), "%llu log messages dropped (queue full)",
+             (unsigned long long)dropped);
+    WriteLine(STRATUS_LOG_WARN, WallClockMs(), text);
+    wrote = 1;
+  }
+
+  uint32_t pos = atomic_load_explicit(&g_dequeue, memory_order_relaxed);
+  for (;;) {
+    LogSlot *slot = &g_ring[pos & LOG_RING_MASK];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if ((int32_t)(seq - (pos + 1)) < 0)
+      break; /* Not committed yet */
+    WriteLine(slot->level, slot->unix_ms, slot->text);
+    atomic_store_explicit(&slot->seq, pos + LOG_RING_LEN,
+                          memory_order_release);
+    pos++;
+    atomic_store_explicit(&g_dequeue, pos, memory_order_relaxed);
+    wrote = 1;
+  }
+
+  if (wrote && g_fp) {
+    fflush(g_fp);
+    uint64_t max_bytes =
+        atomic_load_explicit(&g_max_bytes, memory_order_relaxed);
+    if (max_bytes && g_bytes >= max_bytes)
+      Rotate();
+  }
+
+  atomic_flag_clear_explicit(&g_drain_lock, memory_order_release);
+}
+
+static void WriterMain(void *arg) {
+  (void)arg;
+  while (atomic_load_explicit(&g_running, memory_order_acquire)) {
+    StratusWake_Wait(&g_wake, LOG_FLUSH_MS);
+    Drain();
+  }
+  Drain();
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================
+ */
+
+int StratusLog_Open(const char *path) {
+  if (atomic_load(&g_open))
+    return 1;
+  if (strlen(path) >= sizeof(g_path))
+    return 0;
+
+  g_fp = fopen(path, "a");
+  if (!g_fp)
+    return 0;
+  strcpy(g_path, path);
+  fseek(g_fp, 0, SEEK_END);
+  long size = ftell(g_fp);
+  g_bytes = size > 0 ? (uint64_t)size : 0;
+
+  fputc('\n', g_fp);
+  WriteBanner("StratusATC Session Started");
+
+  for (uint32_t i = 0; i < LOG_RING_LEN; i++)
+    atomic_store_explicit(&g_ring[i].seq, i, memory_order_relaxed);
+  atomic_store(&g_enqueue, 0);
+  atomic_store(&g_dequeue, 0);
+  atomic_store(&g_dropped, 0);
+  atomic_store(&g_open, 1);
+
+  if (StratusWake_Init(&g_wake)) {
+    atomic_store(&g_running, 1);
+    if (!StratusThread_Start(&g_thread, WriterMain, NULL)) {
+      atomic_store(&g_running, 0);
+      StratusWake_Destroy(&g_wake);
+    }
+  }
+  return 1;
+}
+
+void StratusLog_Configure(StratusLogLevel min_level, size_t max_bytes,
+                          int keep) {
+  atomic_store(&g_stratus_log_level, (int)min_level);
+  atomic_store(&g_max_bytes, (uint64_t)max_bytes);
+  atomic_store(&g_keep, keep < 0 ? 0 : keep);
+}
+
+void StratusLog_Close(void) {
+  if (!atomic_exchange(&g_open, 0))
+    return;
+
+  if (atomic_load(&g_running)) {
+    atomic_store(&g_running, 0);
+    StratusWake_Post(&g_wake);
+    StratusThread_Join(&g_thread);
+    StratusWake_Destroy(&g_wake);
+  }
+  Drain();
+
+  WriteBanner("Session Ended");
+  if (g_fp) {
+    fclose(g_fp);
+    g_fp = NULL;
+  }
+}
+
+int StratusLog_ParseLevel(const char *name) {
+  static const char *const names[] = {"debug", "info", "warn", "error",
+                                      "off"};
+  for (int i = 0; i <= STRATUS_LOG_OFF; i++) {
+    if (strcmp(name, names[i]) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/* Count a message against its call site. Returns 0 if it must be dropped;
+ * the first message of a new window learns how many the last one dropped. */
+static int RateLimit(StratusLogSite *site, uint32_t *suppressed) {
+  uint64_t now = StratusMonotonicMs() + 1; /* 0 = site never used */
+  uint64_t start =
+      atomic_load_explicit(&site->window_start_ms, memory_order_relaxed);
+  if (start == 0 || now - start >= STRATUS_LOG_WINDOW_MS) {
+    if (atomic_compare_exchange_strong(&site->window_start_ms, &start, now)) {
+      *suppressed = atomic_exchange(&site->suppressed, 0);
+      atomic_store(&site->count, 0);
+    }
+  }
+  if (atomic_fetch_add(&site->count, 1) >= STRATUS_LOG_BURST) {
+    atomic_fetch_add(&site->suppressed, 1);
+    return 0;
+  }
+  return 1;
+}
+
+void StratusLog_Write(StratusLogSite *site, StratusLogLevel level,
+                      const char *fmt, ...) {
+  if (!atomic_load_explicit(&g_open, memory_order_relaxed) ||
+      level >= STRATUS_LOG_OFF)
+    return;
+
+  uint32_t suppressed = 0;
+  if (!RateLimit(site, &suppressed))
+    return;
+
+  uint32_t pos;
+  LogSlot *slot = RingReserve(&pos);
+  if (!slot) {
+    atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  slot->level = (uint8_t)level;
+  slot->unix_ms = WallClockMs();
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(slot->text, sizeof(slot->text), fmt, args);
+  va_end(args);
+  if (suppressed && n >= 0 && (size_t)n < sizeof(slot->text)) {
+    snprintf(slot->text + n, sizeof(slot->text) - (size_t)n,
+             " (%u similar messages suppressed)", (unsigned)suppressed);
+  }
+  RingCommit(slot, pos);
+
+  /* Warnings and a filling ring are worth a wakeup; the rest can wait for
+   * the writer's next periodic flush */
+  if (!atomic_load_explicit(&g_running, memory_order_relaxed))
+    Drain();
+  else if (level >= STRATUS_LOG_WARN || RingBacklog() >= LOG_RING_LEN / 2)
+    StratusWake_Post(&g_wake);
+}
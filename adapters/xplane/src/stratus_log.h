@@ -0,0 +1,96 @@
+/*
+ * Stratus ATC - Asynchronous Plugin Log
+ *
+ * Logging from the sim thread must not touch the disk. A log call formats
+ * the message into a slot of a lock-free multi-producer ring (one vsnprintf,
+ * no stdio, no locks) and returns; a writer thread adds the wall-clock time,
+ * appends batches to `stratus_atc.log`, flushes once per batch and rotates
+ * the file when it grows past its size limit.
+ *
+ * Filtering happens twice:
+ *   - at compile time, calls below STRATUS_LOG_COMPILED_LEVEL are removed
+ *     (e.g. -DSTRATUS_LOG_COMPILED_LEVEL=STRATUS_LOG_INFO drops LOG_DEBUG);
+ *   - at run time, calls below the configured level (`log_level`) cost one
+ *     relaxed atomic load.
+ *
+ * Every call site is rate-limited on its own: at most STRATUS_LOG_BURST
+ * messages per STRATUS_LOG_WINDOW_MS, after which it stays quiet until the
+ * window ends and then reports how many messages it suppressed. A failing
+ * fopen() in a 25 Hz loop costs a few lines per window, not a full disk.
+ */
+
+#ifndef STRATUS_LOG_H
+#define STRATUS_LOG_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  STRATUS_LOG_DEBUG,
+  STRATUS_LOG_INFO,
+  STRATUS_LOG_WARN,
+  STRATUS_LOG_ERROR,
+  STRATUS_LOG_OFF
+} StratusLogLevel;
+
+#ifndef STRATUS_LOG_COMPILED_LEVEL
+#define STRATUS_LOG_COMPILED_LEVEL STRATUS_LOG_DEBUG
+#endif
+
+#define STRATUS_LOG_BURST 10
+#define STRATUS_LOG_WINDOW_MS 10000u
+
+/* Rate-limit state, one per call site (see STRATUS_LOG) */
+typedef struct StratusLogSite {
+  _Atomic uint64_t window_start_ms;
+  _Atomic uint32_t count;      /* Messages in the current window */
+  _Atomic uint32_t suppressed; /* Dropped in the current window */
+} StratusLogSite;
+
+extern _Atomic int g_stratus_log_level;
+
+#if defined(__GNUC__)
+#define STRATUS_LOG_PRINTF(fmt_index)                                          \
+  __attribute__((format(printf, fmt_index, fmt_index + 1)))
+#else
+#define STRATUS_LOG_PRINTF(fmt_index)
+#endif
+
+#define STRATUS_LOG(level, ...)                                                \
+  do {                                                                         \
+    if ((level) >= STRATUS_LOG_COMPILED_LEVEL &&                               \
+        (level) >= atomic_load_explicit(&g_stratus_log_level,                  \
+                                        memory_order_relaxed)) {               \
+      static StratusLogSite stratus_log_site_;                                 \
+      StratusLog_Write(&stratus_log_site_, (level), __VA_ARGS__);              \
+    }                                                                          \
+  } while (0)
+
+#define LOG_DEBUG(...) STRATUS_LOG(STRATUS_LOG_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) STRATUS_LOG(STRATUS_LOG_INFO, __VA_ARGS__)
+#define LOG_WARN(...) STRATUS_LOG(STRATUS_LOG_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) STRATUS_LOG(STRATUS_LOG_ERROR, __VA_ARGS__)
+
+/* Open (append to) the log file, write the session header and start the
+ * writer thread. Returns 1 on success; without a file, log calls are no-ops.
+ * If no thread can be started, messages are written by the caller instead. */
+int StratusLog_Open(const char *path);
+
+/* Runtime minimum level and rotation: once the file reaches `max_bytes`
+ * (0 = never), it becomes `<path>.1`, older ones shift up to `<path>.<keep>`
+ * and a new file is started. `keep` = 0 just truncates. */
+void StratusLog_Configure(StratusLogLevel min_level, size_t max_bytes,
+                          int keep);
+
+/* Write everything still queued, the session footer, and close the file. */
+void StratusLog_Close(void);
+
+/* Level for a name ("debug", "info", "warn", "error", "off"), or -1 */
+int StratusLog_ParseLevel(const char *name);
+
+/* Use the LOG_* macros rather than calling this directly */
+void StratusLog_Write(StratusLogSite *site, StratusLogLevel level,
+                      const char *fmt, ...) STRATUS_LOG_PRINTF(3);
+
+#endif /* STRATUS_LOG_H */
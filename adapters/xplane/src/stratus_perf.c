@@ -0,0 +1,285 @@
+/*
+ * Stratus ATC - Plugin Timing Histograms
+ *
+ * See stratus_perf.h. Bucket layout: values below 32 ns get a bucket each;
+ * above that, the top five significant bits pick one of 16 sub-buckets
+ * inside the value's power of two.
+ */
+
+#include "stratus_perf.h"
+
+#include "stratus_json.h"
+#include "XPLMDataAccess.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SUB_BUCKETS 16
+#define LINEAR_LIMIT (2 * SUB_BUCKETS) /* Values below this are exact */
+#define MAX_MSB 35                     /* Clamp at 2^36 ns, ~68 s */
+#define BUCKET_COUNT (LINEAR_LIMIT + (MAX_MSB - 4) * SUB_BUCKETS)
+
+typedef struct PerfHistogram {
+  _Atomic uint32_t buckets[BUCKET_COUNT];
+  _Atomic uint64_t over_budget;
+  _Atomic uint64_t max_ns;
+  _Atomic uint64_t budget_ns;
+} PerfHistogram;
+
+static PerfHistogram g_hist[STRATUS_PERF_STAGE_COUNT];
+
+static const char *const kStageNames[STRATUS_PERF_STAGE_COUNT] = {
+    "flight_loop",     "capture",         "apply_commands",
+    "ptt",             "write_telemetry", "read_commands",
+    "serve_telemetry", "stream_udp",      "capture_traffic"};
+
+static int HighestBit(uint64_t v) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(v);
+#else
+  int msb = 0;
+  while (v >>= 1)
+    msb++;
+  return msb;
+#endif
+}
+
+static int BucketOf(uint64_t ns) {
+  if (ns < LINEAR_LIMIT)
+    return (int)ns;
+  int msb = HighestBit(ns);
+  if (msb > MAX_MSB)
+    return BUCKET_COUNT - 1;
+  int top = (int)(ns >> (msb - 4)); /* 16..31 */
+  return LINEAR_LIMIT + (msb - 5) * SUB_BUCKETS + (top - SUB_BUCKETS);
+}
+
+/* Largest value that lands in `bucket` */
+static uint64_t BucketUpper(int bucket) {
+  if (bucket < LINEAR_LIMIT)
+    return (uint64_t)bucket;
+  int msb = (bucket - LINEAR_LIMIT) / SUB_BUCKETS + 5;
+  uint64_t top =
+      SUB_BUCKETS + (uint64_t)((bucket - LINEAR_LIMIT) % SUB_BUCKETS);
+  return ((top + 1) << (msb - 4)) - 1;
+}
+
+void StratusPerf_Record(StratusPerfStage stage, uint64_t ns) {
+  PerfHistogram *h = &g_hist[stage];
+  atomic_fetch_add_explicit(&h->buckets[BucketOf(ns)], 1,
+                            memory_order_relaxed);
+
+  uint64_t budget = atomic_load_explicit(&h->budget_ns, memory_order_relaxed);
+  if (budget && ns > budget)
+    atomic_fetch_add_explicit(&h->over_budget, 1, memory_order_relaxed);
+
+  uint64_t max = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+  while (ns > max && !atomic_compare_exchange_weak_explicit(
+                         &h->max_ns, &max, ns, memory_order_relaxed,
+                         memory_order_relaxed)) {
+  }
+}
+
+void StratusPerf_SetBudget(StratusPerfStage stage, uint64_t ns) {
+  atomic_store(&g_hist[stage].budget_ns, ns);
+}
+
+const char *StratusPerf_StageName(StratusPerfStage stage) {
+  return kStageNames[stage];
+}
+
+/* Value at quantile `q` of `buckets` (holding `count` samples), in us */
+static double Quantile(const uint32_t *buckets, uint64_t count, double q) {
+  if (!count)
+    return 0.0;
+  uint64_t rank = (uint64_t)(q * (double)count + 0.5);
+  if (rank < 1)
+    rank = 1;
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKET_COUNT; i++) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return (double)BucketUpper(i) / 1000.0;
+  }
+  return (double)BucketUpper(BUCKET_COUNT - 1) / 1000.0;
+}
+
+static double Min(double a, double b) { return a < b ? a : b; }
+
+static void Snapshot(StratusPerfStage stage, uint32_t *buckets) {
+  for (int i = 0; i < BUCKET_COUNT; i++)
+    buckets[i] = atomic_load_explicit(&g_hist[stage].buckets[i],
+                                      memory_order_relaxed);
+}
+
+void StratusPerf_Stats(StratusPerfStage stage, StratusPerfStats *out) {
+  const PerfHistogram *h = &g_hist[stage];
+  uint32_t buckets[BUCKET_COUNT];
+  Snapshot(stage, buckets);
+
+  uint64_t count = 0;
+  for (int i = 0; i < BUCKET_COUNT; i++)
+    count += buckets[i];
+
+  /* Buckets report their upper edge; the exact max caps the percentiles */
+  out->count = count;
+  out->over_budget =
+      atomic_load_explicit(&h->over_budget, memory_order_relaxed);
+  out->max_us =
+      (double)atomic_load_explicit(&h->max_ns, memory_order_relaxed) / 1000.0;
+  out->p50_us = Min(Quantile(buckets, count, 0.50), out->max_us);
+  out->p99_us = Min(Quantile(buckets, count, 0.99), out->max_us);
+}
+
+/* ============================================================================
+ * DataRefs
+ * ============================================================================
+ */
+
+typedef enum {
+  METRIC_COUNT,
+  METRIC_P50,
+  METRIC_P99,
+  METRIC_MAX,
+  METRIC_OVER_BUDGET,
+  METRIC_COUNT_
+} PerfMetric;
+
+static const char *const kMetricNames[METRIC_COUNT_] = {
+    "count", "p50_us", "p99_us", "max_us", "over_budget"};
+
+static XPLMDataRef g_datarefs[STRATUS_PERF_STAGE_COUNT * METRIC_COUNT_];
+
+static double MetricValue(void *refcon) {
+  int id = (int)(intptr_t)refcon;
+  StratusPerfStats stats;
+  StratusPerf_Stats((StratusPerfStage)(id / METRIC_COUNT_), &stats);
+  switch ((PerfMetric)(id % METRIC_COUNT_)) {
+  case METRIC_COUNT:
+    return (double)stats.count;
+  case METRIC_P50:
+    return stats.p50_us;
+  case METRIC_P99:
+    return stats.p99_us;
+  case METRIC_MAX:
+    return stats.max_us;
+  case METRIC_OVER_BUDGET:
+    return (double)stats.over_budget;
+  default:
+    return 0.0;
+  }
+}
+
+static int GetMetricInt(void *refcon) { return (int)MetricValue(refcon); }
+static float GetMetricFloat(void *refcon) { return (float)MetricValue(refcon); }
+
+void StratusPerf_RegisterDataRefs(void) {
+  char name[96];
+  for (int s = 0; s < STRATUS_PERF_STAGE_COUNT; s++) {
+    for (int m = 0; m < METRIC_COUNT_; m++) {
+      int id = s * METRIC_COUNT_ + m;
+      if (g_datarefs[id])
+        continue;
+      snprintf(name, sizeof(name), "stratus/perf/%s/%s", kStageNames[s],
+               kMetricNames[m]);
+      g_datarefs[id] = XPLMRegisterDataAccessor(
+          name, xplmType_Int | xplmType_Float, 0, GetMetricInt, NULL,
+          GetMetricFloat, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+          (void *)(intptr_t)id, NULL);
+    }
+  }
+}
+
+void StratusPerf_UnregisterDataRefs(void) {
+  for (int i = 0; i < STRATUS_PERF_STAGE_COUNT * METRIC_COUNT_; i++) {
+    if (g_datarefs[i]) {
+      XPLMUnregisterDataAccessor(g_datarefs[i]);
+      g_datarefs[i] = NULL;
+    }
+  }
+}
+
+/* ============================================================================
+ * Periodic dump
+ * ============================================================================
+ */
+
+/* Dumper-side state: counters as of the previous dump */
+static uint32_t g_last_buckets[STRATUS_PERF_STAGE_COUNT][BUCKET_COUNT];
+static uint64_t g_last_over[STRATUS_PERF_STAGE_COUNT];
+static time_t g_last_dump = 0;
+
+int StratusPerf_Dump(const char *path) {
+  time_t now = time(NULL);
+  /* Built with the JSON helpers so the decimals never follow the locale */
+  char line[4096];
+  StratusJsonBuf b;
+  StratusJson_Init(&b, line, sizeof line);
+  StratusJson_Raw(&b, "{\"timestamp\": ");
+  StratusJson_Int(&b, (int64_t)now);
+  StratusJson_Raw(&b, ", \"interval_s\": ");
+  StratusJson_Int(&b, (int64_t)(g_last_dump ? now - g_last_dump : 0));
+  StratusJson_Raw(&b, ", \"stages\": {");
+  for (int s = 0; s < STRATUS_PERF_STAGE_COUNT; s++) {
+    const PerfHistogram *h = &g_hist[s];
+    uint32_t buckets[BUCKET_COUNT];
+    Snapshot((StratusPerfStage)s, buckets);
+
+    uint64_t count = 0;
+    int highest = -1;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+      uint32_t cur = buckets[i];
+      buckets[i] = cur - g_last_buckets[s][i];
+      g_last_buckets[s][i] = cur;
+      count += buckets[i];
+      if (buckets[i])
+        highest = i;
+    }
+    uint64_t over = atomic_load_explicit(&h->over_budget, memory_order_relaxed);
+    uint64_t over_delta = over - g_last_over[s];
+    g_last_over[s] = over;
+
+    /* The interval max is only known to bucket precision; never report
+     * more than the exact all-time max */
+    double max_us = 0.0;
+    if (highest >= 0) {
+      uint64_t max_ns = BucketUpper(highest);
+      uint64_t all_time =
+          atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+      max_us = (double)(max_ns < all_time ? max_ns : all_time) / 1000.0;
+    }
+    uint64_t budget_ns =
+        atomic_load_explicit(&h->budget_ns, memory_order_relaxed);
+
+    if (s)
+      StratusJson_Raw(&b, ", ");
+    StratusJson_String(&b, kStageNames[s]);
+    StratusJson_Raw(&b, ": {\"count\": ");
+    StratusJson_Uint(&b, count);
+    StratusJson_Raw(&b, ", \"p50_us\": ");
+    StratusJson_Fixed(&b, Min(Quantile(buckets, count, 0.50), max_us), 1);
+    StratusJson_Raw(&b, ", \"p99_us\": ");
+    StratusJson_Fixed(&b, Min(Quantile(buckets, count, 0.99), max_us), 1);
+    StratusJson_Raw(&b, ", \"max_us\": ");
+    StratusJson_Fixed(&b, max_us, 1);
+    StratusJson_Raw(&b, ", \"over_budget\": ");
+    StratusJson_Uint(&b, over_delta);
+    StratusJson_Raw(&b, ", \"budget_us\": ");
+    StratusJson_Uint(&b, budget_ns / 1000u);
+    StratusJson_Char(&b, '}');
+  }
+  StratusJson_Raw(&b, "}}\n");
+  size_t len = StratusJson_Finish(&b);
+  if (!len)
+    return 0;
+
+  FILE *f = fopen(path, "a");
+  if (!f)
+    return 0;
+  fwrite(line, 1, len, f);
+  fclose(f);
+  g_last_dump = now;
+  return 1;
+}
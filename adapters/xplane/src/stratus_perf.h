@@ -0,0 +1,68 @@
+/*
+ * Stratus ATC - Plugin Timing Histograms
+ *
+ * Each instrumented stage records its duration into a fixed-bucket,
+ * log-linear histogram (HDR-style: 16 linear sub-buckets per power of two,
+ * so any reported value is within ~6% of the true one, from 1 ns to ~68 s).
+ * Recording is two atomic adds and, rarely, a CAS for the maximum; it is
+ * safe from any thread.
+ *
+ * The histograms are exposed two ways:
+ *   - read-only DataRefs, cumulative since plugin start:
+ *       stratus/perf/<stage>/count, p50_us, p99_us, max_us, over_budget
+ *   - StratusPerf_Dump(), which appends one JSON line per call to
+ *     stratus_perf.jsonl with the stats for the interval since the last
+ *     dump (next to latency.jsonl, which covers the voice pipeline).
+ *
+ * A stage with a budget counts every sample over it in `over_budget`.
+ */
+
+#ifndef STRATUS_PERF_H
+#define STRATUS_PERF_H
+
+#include <stdint.h>
+
+#define STRATUS_PERF_FILE "stratus_perf.jsonl"
+
+typedef enum {
+  STRATUS_PERF_FLIGHT_LOOP,     /* Whole FlightLoopCallback (sim thread) */
+  STRATUS_PERF_CAPTURE,         /* DataRef reads into the frame */
+  STRATUS_PERF_APPLY_COMMANDS,  /* stratus_commander_apply (sim thread) */
+  STRATUS_PERF_PTT,             /* PTTCommandHandler (sim thread) */
+  STRATUS_PERF_WRITE_TELEMETRY, /* Telemetry file write (I/O thread) */
+  STRATUS_PERF_READ_COMMANDS,   /* Command file poll (I/O thread) */
+  STRATUS_PERF_SERVE_TELEMETRY, /* Telemetry server fan-out (I/O thread) */
+  STRATUS_PERF_STREAM_UDP,      /* UDP frame send (I/O thread) */
+  STRATUS_PERF_CAPTURE_TRAFFIC, /* Traffic snapshot reads (sim thread) */
+  STRATUS_PERF_STAGE_COUNT
+} StratusPerfStage;
+
+typedef struct StratusPerfStats {
+  uint64_t count;
+  uint64_t over_budget;
+  double p50_us;
+  double p99_us;
+  double max_us;
+} StratusPerfStats;
+
+/* Record one sample of `ns` nanoseconds for `stage` */
+void StratusPerf_Record(StratusPerfStage stage, uint64_t ns);
+
+/* Samples longer than `ns` count as over budget (0 = no budget) */
+void StratusPerf_SetBudget(StratusPerfStage stage, uint64_t ns);
+
+/* Cumulative stats since plugin start */
+void StratusPerf_Stats(StratusPerfStage stage, StratusPerfStats *out);
+
+/* Short name used in DataRefs and the dump ("flight_loop", ...) */
+const char *StratusPerf_StageName(StratusPerfStage stage);
+
+/* Publish / withdraw the stratus/perf/... DataRefs */
+void StratusPerf_RegisterDataRefs(void);
+void StratusPerf_UnregisterDataRefs(void);
+
+/* Append the stats since the previous dump to `path` as one JSON line.
+ * Call from a single thread (the I/O thread). Returns 1 on success. */
+int StratusPerf_Dump(const char *path);
+
+#endif /* STRATUS_PERF_H */
@@ -2,7 +2,8 @@
  * Stratus ATC - X-Plane Adapter Plugin
  *
  * This plugin reads X-Plane DataRefs and writes them to a JSON file
- * for consumption by the Stratus ATC native client (Linux/Mac).
+ * and/or a shared-memory frame ring for consumption by the Stratus ATC
+ * native client (Linux/Mac).
  *
  * It also reads commands from the client (via JSONL file) and applies
  * them back to the simulator.
@@ -17,7 +18,30 @@
 #include "XPLMProcessing.h"
 #include "XPLMUtilities.h"
 
-#include <stdarg.h>
+#include "stratus_airports.h"
+#include "stratus_atc.h"
+#include "stratus_commander.h"
+#include "stratus_config.h"
+#include "stratus_context.h"
+#include "stratus_datarefs.h"
+#include "stratus_delta.h"
+#include "stratus_derived.h"
+#include "stratus_events.h"
+#include "stratus_frame.h"
+#include "stratus_io.h"
+#include "stratus_log.h"
+#include "stratus_perf.h"
+#include "stratus_profile.h"
+#include "stratus_ptt.h"
+#include "stratus_recorder.h"
+#include "stratus_sched.h"
+#include "stratus_server.h"
+#include "stratus_shm.h"
+#include "stratus_thread.h"
+#include "stratus_traffic.h"
+#include "stratus_udp.h"
+
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,6 +53,7 @@
 #include <windows.h>
 #define PATH_SEP "\\"
 #else
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
 #define PATH_SEP "/"
@@ -42,162 +67,173 @@
 
 /* File paths (set at init) */
 static char g_data_dir[512] = {0};
-static char g_input_file[1024] = {0};  /* We write here (telemetry) */
-static char g_output_file[1024] = {0}; /* We read here (commands from client) */
-static char g_status_file[1024] = {0}; /* Status updates from commander */
-static char g_log_file[1024] = {0};    /* Our own log file */
-
-/* Rust FFI - process_stratus_commands(cmd_path, status_path) */
-extern int process_stratus_commands(const char* command_path, const char* status_path);
-
-/* DataRef handles */
-static XPLMDataRef dr_lat = NULL;
-static XPLMDataRef dr_lon = NULL;
-static XPLMDataRef dr_alt_msl = NULL;  /* Altitude MSL in meters */
-static XPLMDataRef dr_alt_agl = NULL;  /* Altitude AGL in meters */
-static XPLMDataRef dr_hdg_mag = NULL;  /* Magnetic heading */
-static XPLMDataRef dr_hdg_true = NULL; /* True heading */
-static XPLMDataRef dr_pitch = NULL;
-static XPLMDataRef dr_roll = NULL;
-static XPLMDataRef dr_gnd_speed = NULL; /* Ground speed m/s */
-static XPLMDataRef dr_ias = NULL;       /* Indicated airspeed ktas */
-static XPLMDataRef dr_tas = NULL;       /* True airspeed m/s */
-static XPLMDataRef dr_vs = NULL;        /* Vertical speed fpm */
-static XPLMDataRef dr_on_ground = NULL; /* On ground flag */
-static XPLMDataRef dr_paused = NULL;    /* Sim paused */
-
-/* COM/NAV Radios */
-static XPLMDataRef dr_com1_freq = NULL;
-static XPLMDataRef dr_com1_stdby = NULL;
-static XPLMDataRef dr_com2_freq = NULL;
-static XPLMDataRef dr_com2_stdby = NULL;
-static XPLMDataRef dr_nav1_freq = NULL;
-static XPLMDataRef dr_nav2_freq = NULL;
-
-/* Transponder */
-static XPLMDataRef dr_xpdr_code = NULL;
-static XPLMDataRef dr_xpdr_mode = NULL;
-
-/* Autopilot */
-static XPLMDataRef dr_ap_alt = NULL;
-static XPLMDataRef dr_ap_hdg = NULL;
-static XPLMDataRef dr_ap_vs = NULL;
+static char g_input_file[1024] = {0};    /* We write here (telemetry) */
+static char g_binary_file[1024] = {0};   /* Binary frames (stratus_frame.h) */
+static char g_output_file[1024] = {0};   /* We read here (client commands) */
+static char g_status_file[1024] = {0};   /* Status updates from commander */
+static char g_log_file[1024] = {0};      /* Our own log file */
+static char g_config_file[1024] = {0};   /* Settings (stratus_config.h) */
+static char g_context_file[1024] = {0};  /* Aircraft/location context */
+static char g_perf_file[1024] = {0};     /* Timing stats (stratus_perf.h) */
+static char g_server_socket[1024] = {0}; /* Telemetry server socket */
+static char g_traffic_file[1024] = {0};  /* Traffic (stratus_traffic.h) */
+
+/* Settings loaded at XPluginStart */
+static StratusConfig g_config;
+
+/* Telemetry transport (STRATUS_TELEMETRY_TRANSPORT=json|shm|both) */
+#define TRANSPORT_JSON 0x1 /* stratus_telemetry.json, rewritten each tick */
+#define TRANSPORT_SHM 0x2  /* Shared-memory frame ring (stratus_shm.h) */
+static int g_transport = TRANSPORT_JSON | TRANSPORT_SHM;
+
+/* Telemetry file format (STRATUS_TELEMETRY_FORMAT=json|binary|both) */
+#define FORMAT_JSON 0x1   /* Human-readable, stratus_telemetry.json */
+#define FORMAT_BINARY 0x2 /* Packed frame, stratus_telemetry.bin */
+static int g_format = FORMAT_JSON;
+
+/* Delta publishing (`publish = delta`); state is owned by the I/O thread */
+static int g_publish_delta = 0;
+static StratusDelta g_delta;
+
+/* `in_process = on`: frames also go to stratus_push_telemetry */
+static int g_in_process = 0;
+
+/* Last captured telemetry frame, and frames captured so far */
+static StratusFrame g_frame;
+static uint64_t g_frame_seq = 0;
+
+/* Latest context event; its .acf name is copied into every frame */
+static StratusContext g_context;
+
+/* Aircraft DataRef profile (stratus_profile.h), chosen with each context */
+static StratusProfile g_profile;
+
+/* Flight phase and nearest airport state (stratus_derived.h) */
+static StratusDerived g_derived;
+
+/* Event edge detection (stratus_events.h), and what the probe saw since the
+ * last frame */
+static StratusEvents g_events;
+static uint32_t g_events_pending = 0;
+
+/* Traffic snapshot, captured every 1 / traffic_rate_hz (see CaptureTraffic) */
+static StratusTraffic g_traffic;
+static int g_traffic_empty_written = 0;
+
+/* Sim-thread tasks, run from the flight loop (see InitScheduler) */
+#define RADIOS_BUDGET_NS 50000u   /* About 15 DataRef reads */
+#define TRAFFIC_BUDGET_NS 250000u /* 19 planes' worth of per-plane DataRefs */
+static StratusSched g_sched;
+static int g_task_radios = -1;
+static int g_task_telemetry = -1;
+
+/* Rust command engine (stratus_commander.h), created once in XPluginStart */
+static StratusCommander *g_commander = NULL;
+
+/* Adaptive telemetry rate (see SelectTelemetryRate) */
+#define MIN_RATE_HZ 0.1f
+#define PARKED_SPEED_MPS 0.5f  /* Slower than this on the ground = parked */
+#define APPROACH_VS_FPM -200.0f /* Descending faster than this = approach */
+#define METERS_TO_FEET 3.28084f
+static float g_rate_hz = 0.0f; /* Telemetry task's current rate */
 
 /* PTT Command - user can bind this in X-Plane Settings > Keyboard/Joystick */
 static XPLMCommandRef g_ptt_command = NULL;
 static int g_ptt_active = 0;  /* 1 = PTT pressed, 0 = released */
 static char g_ptt_file[1024] = {0};  /* File to signal PTT state */
+static char g_ptt_socket[1024] = {0}; /* Voice process socket (stratus_ptt.h) */
 
 /* Flight loop callback ID */
 static XPLMFlightLoopID g_flight_loop_id = NULL;
 
-/* Logging */
-static FILE *g_log_fp = NULL;
-
-/* ============================================================================
- * Logging - writes to our own log file, NOT X-Plane's Log.txt
- * ============================================================================
- */
-
-static void LogOpen(void) {
-  if (g_log_fp)
-    return;
-  g_log_fp = fopen(g_log_file, "a");
-  if (g_log_fp) {
-    /* Write header on new session */
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char time_str[64];
-    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-    fprintf(g_log_fp, "\n=== StratusATC Session Started: %s ===\n",
-            time_str);
-    fflush(g_log_fp);
-  }
-}
-
-static void LogClose(void) {
-  if (g_log_fp) {
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char time_str[64];
-    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-    fprintf(g_log_fp, "=== Session Ended: %s ===\n", time_str);
-    fclose(g_log_fp);
-    g_log_fp = NULL;
-  }
-}
-
-static void Log(const char *level, const char *fmt, ...) {
-  if (!g_log_fp)
-    return;
-
-  /* Timestamp */
-  time_t now = time(NULL);
-  struct tm *tm_info = localtime(&now);
-  char time_str[64];
-  strftime(time_str, sizeof(time_str), "%H:%M:%S", tm_info);
-
-  fprintf(g_log_fp, "[%s] [%s] ", time_str, level);
-
-  va_list args;
-  va_start(args, fmt);
-  vfprintf(g_log_fp, fmt, args);
-  va_end(args);
-
-  fprintf(g_log_fp, "\n");
-  fflush(g_log_fp);
-}
-
-#define LOG_INFO(...) Log("INFO", __VA_ARGS__)
-#define LOG_WARN(...) Log("WARN", __VA_ARGS__)
-#define LOG_ERROR(...) Log("ERROR", __VA_ARGS__)
-#define LOG_DEBUG(...) Log("DEBUG", __VA_ARGS__)
+/* XPluginStart only registers; the rest waits for the first tick */
+static int g_initialized = 0; /* InitDeferred has run */
+static int g_enabled = 0;
 
 /* Forward declarations */
 static float FlightLoopCallback(float inElapsedSinceLastCall,
                                 float inElapsedTimeSinceLastFlightLoop,
                                 int inCounter, void *inRefcon);
+static void InitDeferred(void);
 static void InitDataRefs(void);
+static void StartIo(void);
 static void InitFilePaths(void);
-static void WriteTelemetryJSON(void);
+static void LoadConfig(void);
+static void InitTransport(void);
+static void InitPerf(void);
+static void InitRecorder(void);
+static void InitServer(void);
+static void InitUdp(void);
+static void InitTraffic(void);
+static void InitDerived(void);
+static void InitScheduler(void);
+static void ApplyCommands(void);
+static void CaptureRadios(void);
+static void ProbeEvents(void);
+static void PublishTelemetry(void);
+static void CaptureTelemetry(StratusFrame *fr, uint64_t now_ns);
+static float SelectTelemetryRate(const StratusFrame *fr);
+static void CaptureTraffic(void);
+static void IoFrame(const StratusFrame *fr);
+static void WriteTelemetryFiles(const StratusFrame *fr);
+static void WriteTelemetryJSON(const StratusFrame *fr, StratusPublishKind kind);
+static void WriteTelemetryBinary(const StratusFrame *fr);
 static void ReadCommandsJSONL(void);
+static void ReadCommandsUdp(void);
+static void IoIdle(void);
+static void WritePttState(const StratusPttEvent *ev);
+static void PublishContext(StratusContextEvent event);
+static void SelectProfile(const StratusContext *ctx);
+static void WriteContextJSON(const StratusContext *ctx);
+static void WriteTrafficJSON(const StratusTraffic *traffic);
 static int PTTCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void *inRefcon);
 
 /* ============================================================================
- * PTT Command Handler - writes state to file for stratus-voice to monitor
+ * PTT Command Handler - the transition goes straight to the voice socket, and
+ * the state file is rewritten on the I/O thread for older clients
  * ============================================================================
  */
 static int PTTCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void *inRefcon) {
     (void)inCommand;
     (void)inRefcon;
-    
-    if (inPhase == xplm_CommandBegin) {
-        /* PTT pressed */
-        g_ptt_active = 1;
+
+    if (inPhase != xplm_CommandBegin && inPhase != xplm_CommandEnd)
+        return 0;
+    uint64_t t0 = StratusMonotonicNs();
+
+    /* Signal first: everything below only adds latency */
+    int active = inPhase == xplm_CommandBegin;
+    StratusPttEvent ev;
+    StratusPtt_Send(active, &ev);
+    g_ptt_active = active;
+    StratusAtc_SetPtt(active);
+
+    if (!StratusIo_PushPtt(&ev))
+        WritePttState(&ev);
+
+    if (active)
         LOG_INFO("PTT Pressed (user can now speak)");
-        
-        /* Write state to file */
-        FILE *fp = fopen(g_ptt_file, "w");
-        if (fp) {
-            fprintf(fp, "{\"ptt\": true, \"timestamp\": %ld}\n", (long)time(NULL));
-            fclose(fp);
-        }
-    } else if (inPhase == xplm_CommandEnd) {
-        /* PTT released */
-        g_ptt_active = 0;
+    else
         LOG_INFO("PTT Released (processing speech)");
-        
-        /* Write state to file */
-        FILE *fp = fopen(g_ptt_file, "w");
-        if (fp) {
-            fprintf(fp, "{\"ptt\": false, \"timestamp\": %ld}\n", (long)time(NULL));
-            fclose(fp);
-        }
-    }
-    
+
+    StratusPerf_Record(STRATUS_PERF_PTT, StratusMonotonicNs() - t0);
     return 0;  /* Don't consume the command - allow other handlers */
 }
 
+/* Runs on the I/O thread (or inline if it is not running) */
+static void WritePttState(const StratusPttEvent *ev) {
+    FILE *fp = fopen(g_ptt_file, "w");
+    if (fp) {
+        fprintf(fp,
+                "{\"ptt\": %s, \"timestamp\": %lld, \"seq\": %u, "
+                "\"monotonic_ns\": %llu}\n",
+                ev->active ? "true" : "false",
+                (long long)(ev->unix_ns / 1000000000), (unsigned)ev->seq,
+                (unsigned long long)ev->monotonic_ns);
+        fclose(fp);
+    }
+}
+
 /* ============================================================================
  * Required Plugin Callbacks
  * ============================================================================
@@ -211,13 +247,22 @@ PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc) {
   /* Initialize file paths first (needed for log file) */
   InitFilePaths();
 
-  /* Open our log file */
-  LogOpen();
+  /* Open our log file (writes happen on the log thread) */
+  StratusLog_Open(g_log_file);
 
   LOG_INFO("Plugin starting (version %s)", PLUGIN_VERSION);
   LOG_INFO("Data directory: %s", g_data_dir);
 
-  InitDataRefs();
+  /* Only what other plugins may look for from their own XPluginStart:
+   * our DataRefs and commands. Lookups, sockets, shared memory and the
+   * command engine wait for the first flight-loop tick (InitDeferred), so
+   * they add nothing to sim load time. */
+  LoadConfig();
+  StratusDataRefs_Init();
+  InitPerf();
+  InitScheduler();
+  StratusAtc_Register(NULL); /* The commander is attached in InitDeferred */
+  LOG_INFO("ATC state DataRefs and commands under stratus/atc/");
 
   /* Create and register the PTT command */
   g_ptt_command = XPLMCreateCommand("stratus/ptt", 
@@ -225,7 +270,7 @@ PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc) {
   XPLMRegisterCommandHandler(g_ptt_command, PTTCommandHandler, 1, NULL);
   LOG_INFO("Registered PTT command: stratus/ptt (bind in Settings > Keyboard)");
 
-  /* Register the flight loop callback at ~1Hz */
+  /* Register the flight loop callback (woken for the next due task) */
   XPLMCreateFlightLoop_t fl_params = {
       .structSize = sizeof(XPLMCreateFlightLoop_t),
       .phase = xplm_FlightLoop_Phase_AfterFlightModel,
@@ -242,32 +287,145 @@ PLUGIN_API void XPluginStop(void) {
     XPLMDestroyFlightLoop(g_flight_loop_id);
     g_flight_loop_id = NULL;
   }
+  StratusShm_Close();
+  if (StratusServer_IsOpen()) {
+    if (StratusServer_Dropped())
+      LOG_INFO("Telemetry server skipped %llu frames for slow subscribers",
+               (unsigned long long)StratusServer_Dropped());
+    StratusServer_Close();
+  }
+  if (StratusUdp_IsOpen()) {
+    LOG_INFO("UDP stream sent %llu frames, %llu refused",
+             (unsigned long long)StratusUdp_Sent(),
+             (unsigned long long)StratusUdp_Dropped());
+    StratusUdp_Close();
+  }
+  uint64_t dropped = StratusRecorder_Close();
+  if (dropped)
+    LOG_WARN("Recorder dropped %llu frames (disk behind)",
+             (unsigned long long)dropped);
+  for (int i = 0; i < g_sched.count; i++) {
+    const StratusSchedTask *t = &g_sched.tasks[i];
+    if (t->deferrals || t->overruns)
+      LOG_INFO("Task %s: %llu runs, %llu deferred, %llu over budget", t->name,
+               (unsigned long long)t->runs, (unsigned long long)t->deferrals,
+               (unsigned long long)t->overruns);
+  }
+  StratusPerf_UnregisterDataRefs();
+  StratusAtc_Unregister();
+  StratusPtt_Close();
+  stratus_commander_destroy(g_commander);
+  g_commander = NULL;
+  StratusAirports_Unload();
+  g_initialized = 0;
   LOG_INFO("Plugin stopped");
-  LogClose();
+  StratusLog_Close();
 }
 
 PLUGIN_API int XPluginEnable(void) {
-  /* Schedule flight loop to run every 1 second */
+  g_enabled = 1;
+  if (g_initialized)
+    StartIo(); /* Otherwise InitDeferred starts it */
+
+  /* Start at the configured rate; the telemetry task adapts from there */
   if (g_flight_loop_id) {
-    XPLMScheduleFlightLoop(g_flight_loop_id, 0.1f, 1);
+    g_rate_hz = g_config.rate_hz;
+    StratusSched_SetPeriod(&g_sched, g_task_telemetry, 1.0f / g_rate_hz);
+    XPLMScheduleFlightLoop(g_flight_loop_id, 1.0f / g_rate_hz, 1);
   }
   LOG_INFO("Plugin enabled - telemetry streaming started");
   return 1;
 }
 
 PLUGIN_API void XPluginDisable(void) {
+  g_enabled = 0;
   if (g_flight_loop_id) {
     XPLMScheduleFlightLoop(g_flight_loop_id, 0, 0);
   }
+  StratusIo_Stop();
   LOG_INFO("Plugin disabled - telemetry streaming stopped");
 }
 
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFromWho, int inMessage,
                                       void *inParam) {
-  /* Handle messages from X-Plane or other plugins if needed */
-  (void)inFromWho;
-  (void)inMessage;
-  (void)inParam;
+  if (inFromWho != XPLM_PLUGIN_XPLANE)
+    return;
+
+  switch (inMessage) {
+  case XPLM_MSG_PLANE_LOADED:
+    /* inParam is the plane index; 0 is the user's aircraft. Its plugins
+     * have registered their DataRefs by now. */
+    if ((intptr_t)inParam == 0 && g_initialized) {
+      int before = StratusDataRefs_Missing();
+      PublishContext(STRATUS_CONTEXT_PLANE_LOADED); /* Picks its profile */
+      StratusDataRefs_Refresh();
+      int missing = StratusDataRefs_Resolve();
+      if (missing != before)
+        LOG_INFO("Aircraft loaded: %d DataRefs missing (was %d)", missing,
+                 before);
+    }
+    break;
+  case XPLM_MSG_AIRPORT_LOADED:
+    PublishContext(STRATUS_CONTEXT_AIRPORT_LOADED);
+    break;
+  case XPLM_MSG_SCENERY_LOADED:
+    PublishContext(STRATUS_CONTEXT_SCENERY_LOADED);
+    break;
+  default:
+    break;
+  }
+}
+
+/* Capture aircraft/location on the sim thread and hand the write to the I/O
+ * thread. Only runs on load events, never per tick; loads before the first
+ * tick are covered by its startup event. */
+static void PublishContext(StratusContextEvent event) {
+  if (!g_initialized)
+    return;
+  StratusContext_Capture(&g_context, event);
+  LOG_INFO("Context #%llu: aircraft %s (%s), nearest airport %s",
+           (unsigned long long)g_context.seq, g_context.acf_file,
+           g_context.icao, g_context.airport_id);
+  if (event == STRATUS_CONTEXT_STARTUP || event == STRATUS_CONTEXT_PLANE_LOADED)
+    SelectProfile(&g_context);
+
+  if (!StratusIo_PushContext(&g_context))
+    WriteContextJSON(&g_context);
+}
+
+static void ProfileWarn(const char *msg) { LOG_WARN("Profile: %s", msg); }
+
+/* Compile the aircraft's profile into the registry's read table and the
+ * commander's write table; without one, both go back to the stock DataRefs */
+static void SelectProfile(const StratusContext *ctx) {
+  char dir[1024];
+  snprintf(dir, sizeof(dir), "%s" PATH_SEP STRATUS_PROFILE_DIR, g_data_dir);
+  int found = StratusProfile_Load(&g_profile, dir, ctx->acf_file, ctx->icao,
+                                  ProfileWarn);
+  StratusDataRefs_UseProfile(found ? &g_profile : NULL);
+  stratus_commander_reset_map(g_commander);
+  if (!found)
+    return;
+
+  for (int i = 0; i < g_profile.count; i++) {
+    const StratusProfileEntry *e = &g_profile.entries[i];
+    if (!e->dataref[0] && !e->write[0] && !e->command[0])
+      continue; /* Only bad lines, already reported */
+    int read = e->dataref[0] && StratusDataRefs_FieldIndex(e->field) >= 0;
+    const char *dataref = e->write[0]     ? e->write
+                          : e->dataref[0] ? e->dataref
+                                          : NULL;
+    float scale = e->write[0] ? e->write_scale : e->scale;
+    int mapped = stratus_commander_map(g_commander, e->field, dataref, scale,
+                                       e->command[0] ? e->command : NULL);
+    if (mapped < 0)
+      LOG_WARN("Profile %s: %s: DataRef or command not found for writes",
+               g_profile.name, e->field);
+    else if (!read && !mapped)
+      LOG_WARN("Profile %s: %s is not a telemetry field or command target",
+               g_profile.name, e->field);
+  }
+  LOG_INFO("Aircraft profile %s: %d fields", g_profile.name, g_profile.count);
 }
 
 /* ============================================================================
@@ -328,180 +486,576 @@ static void InitFilePaths(void) {
 
   snprintf(g_input_file, sizeof(g_input_file),
            "%s" PATH_SEP "stratus_telemetry.json", g_data_dir);
+  snprintf(g_binary_file, sizeof(g_binary_file),
+           "%s" PATH_SEP "stratus_telemetry.bin", g_data_dir);
   snprintf(g_output_file, sizeof(g_output_file),
            "%s" PATH_SEP "stratus_commands.jsonl", g_data_dir);
   snprintf(g_status_file, sizeof(g_status_file),
            "%s" PATH_SEP "stratus_status.jsonl", g_data_dir);
   snprintf(g_ptt_file, sizeof(g_ptt_file),
            "%s" PATH_SEP "stratus_ptt.json", g_data_dir);
+  snprintf(g_ptt_socket, sizeof(g_ptt_socket),
+           "%s" PATH_SEP STRATUS_PTT_SOCKET, g_data_dir);
   snprintf(g_log_file, sizeof(g_log_file),
            "%s" PATH_SEP "stratus_atc.log", g_data_dir);
+  snprintf(g_perf_file, sizeof(g_perf_file),
+           "%s" PATH_SEP STRATUS_PERF_FILE, g_data_dir);
+  snprintf(g_context_file, sizeof(g_context_file),
+           "%s" PATH_SEP "stratus_context.json", g_data_dir);
+  snprintf(g_config_file, sizeof(g_config_file),
+           "%s" PATH_SEP STRATUS_CONFIG_FILE, g_data_dir);
+  snprintf(g_server_socket, sizeof(g_server_socket),
+           "%s" PATH_SEP STRATUS_SERVER_SOCKET, g_data_dir);
+  snprintf(g_traffic_file, sizeof(g_traffic_file),
+           "%s" PATH_SEP "stratus_traffic.json", g_data_dir);
 }
 
-static void InitDataRefs(void) {
-  /* Position */
-  dr_lat = XPLMFindDataRef("sim/flightmodel/position/latitude");
-  dr_lon = XPLMFindDataRef("sim/flightmodel/position/longitude");
-  dr_alt_msl = XPLMFindDataRef("sim/flightmodel/position/elevation");
-  dr_alt_agl = XPLMFindDataRef("sim/flightmodel/position/y_agl");
-
-  /* Orientation */
-  dr_hdg_mag = XPLMFindDataRef("sim/flightmodel/position/mag_psi");
-  dr_hdg_true = XPLMFindDataRef("sim/flightmodel/position/true_psi");
-  dr_pitch = XPLMFindDataRef("sim/flightmodel/position/theta");
-  dr_roll = XPLMFindDataRef("sim/flightmodel/position/phi");
-
-  /* Speed */
-  dr_gnd_speed = XPLMFindDataRef("sim/flightmodel/position/groundspeed");
-  dr_ias = XPLMFindDataRef("sim/flightmodel/position/indicated_airspeed");
-  dr_tas = XPLMFindDataRef("sim/flightmodel/position/true_airspeed");
-  dr_vs = XPLMFindDataRef("sim/flightmodel/position/vh_ind_fpm");
-
-  /* State */
-  dr_on_ground = XPLMFindDataRef("sim/flightmodel/failures/onground_any");
-  dr_paused = XPLMFindDataRef("sim/time/paused");
-
-  /* Radios (Hz values, divide by 10000 for MHz display) */
-  dr_com1_freq =
-      XPLMFindDataRef("sim/cockpit2/radios/actuators/com1_frequency_hz_833");
-  dr_com1_stdby = XPLMFindDataRef(
-      "sim/cockpit2/radios/actuators/com1_standby_frequency_hz_833");
-  dr_com2_freq =
-      XPLMFindDataRef("sim/cockpit2/radios/actuators/com2_frequency_hz_833");
-  dr_com2_stdby = XPLMFindDataRef(
-      "sim/cockpit2/radios/actuators/com2_standby_frequency_hz_833");
-  dr_nav1_freq =
-      XPLMFindDataRef("sim/cockpit2/radios/actuators/nav1_frequency_hz");
-  dr_nav2_freq =
-      XPLMFindDataRef("sim/cockpit2/radios/actuators/nav2_frequency_hz");
-
-  /* Transponder */
-  dr_xpdr_code = XPLMFindDataRef("sim/cockpit/radios/transponder_code");
-  dr_xpdr_mode = XPLMFindDataRef("sim/cockpit/radios/transponder_mode");
-
-  /* Autopilot */
-  dr_ap_alt = XPLMFindDataRef("sim/cockpit/autopilot/altitude");
-  dr_ap_hdg = XPLMFindDataRef("sim/cockpit/autopilot/heading_mag");
-  dr_ap_vs = XPLMFindDataRef("sim/cockpit/autopilot/vertical_velocity");
+static void ConfigWarn(const char *msg) { LOG_WARN("Config: %s", msg); }
+
+static void LoadConfig(void) {
+  StratusConfig_Defaults(&g_config);
+  if (StratusConfig_Load(&g_config, g_config_file, ConfigWarn))
+    LOG_INFO("Loaded settings from %s", g_config_file);
+
+  int level = StratusLog_ParseLevel(g_config.log_level);
+  if (level < 0) {
+    LOG_WARN("Unknown log level '%s', using info", g_config.log_level);
+    level = STRATUS_LOG_INFO;
+  }
+  StratusLog_Configure((StratusLogLevel)level,
+                       (size_t)g_config.log_max_kb * 1024u,
+                       g_config.log_keep);
+
+  LOG_INFO("Telemetry rate: %.1f Hz (idle %.1f Hz, approach %.1f Hz, "
+           "max %.1f Hz)",
+           g_config.rate_hz, g_config.idle_rate_hz, g_config.approach_rate_hz,
+           g_config.max_rate_hz);
+}
 
+/* Everything XPluginStart leaves for the first flight-loop tick, when the
+ * sim has finished loading */
+static void InitDeferred(void) {
+  uint64_t t0 = StratusMonotonicNs();
+  g_initialized = 1;
+
+  InitDataRefs();
+  StratusContext_Init();
+  InitTraffic();
+  InitDerived();
+  InitTransport();
+  InitRecorder();
+  InitServer();
+  InitUdp();
+
+  g_commander = stratus_commander_create(g_output_file, g_status_file);
+  if (g_commander) {
+    stratus_commander_set_budget_us(g_commander, g_config.command_budget_us);
+    StratusAtc_Register(g_commander);
+  } else {
+    LOG_ERROR("Failed to create command engine");
+  }
+
+  if (StratusPtt_Open(g_ptt_socket))
+    LOG_INFO("PTT signals go to %s", g_ptt_socket);
+  else
+    LOG_WARN("PTT socket unavailable - PTT is signalled via %s only",
+             g_ptt_file);
+
+  if (g_enabled)
+    StartIo();
+  LOG_INFO("Deferred init took %.1f ms",
+           (double)(StratusMonotonicNs() - t0) / 1e6);
+}
+
+static void InitDataRefs(void) {
+  int missing = StratusDataRefs_Resolve();
+  if (missing)
+    LOG_WARN("%d of %d DataRefs not found yet (retried in the background)",
+             missing, (int)g_stratus_field_count);
   LOG_INFO("DataRefs initialized");
 }
 
+/* File writes and command polling happen on the I/O thread */
+static void StartIo(void) {
+  StratusIoCallbacks io_callbacks = {.on_frame = IoFrame,
+                                     .on_ptt = WritePttState,
+                                     .on_context = WriteContextJSON,
+                                     .on_traffic = WriteTrafficJSON,
+                                     .on_idle = IoIdle};
+  if (StratusIo_Start(&io_callbacks, g_config.command_poll_ms)) {
+    LOG_INFO("I/O thread started");
+  } else {
+    LOG_WARN("I/O thread unavailable - file I/O stays on the sim thread");
+  }
+
+  PublishContext(STRATUS_CONTEXT_STARTUP);
+}
+
+/* Sim-thread stages share the per-frame budget; I/O thread stages have none */
+static void InitPerf(void) {
+  uint64_t budget_ns = (uint64_t)g_config.perf_budget_us * 1000u;
+  StratusPerf_SetBudget(STRATUS_PERF_FLIGHT_LOOP, budget_ns);
+  StratusPerf_SetBudget(STRATUS_PERF_PTT, budget_ns);
+  StratusPerf_RegisterDataRefs();
+  LOG_INFO("Timing DataRefs under stratus/perf/ (budget %u us)",
+           g_config.perf_budget_us);
+}
+
+static void InitRecorder(void) {
+  if (strcmp(g_config.record, "on") == 0) {
+    if (StratusRecorder_Open(g_data_dir))
+      LOG_INFO("Recording session to %s", StratusRecorder_Path());
+    else
+      LOG_WARN("Flight data recorder unavailable");
+  } else if (strcmp(g_config.record, "off") != 0) {
+    LOG_WARN("Unknown record setting '%s', using off", g_config.record);
+  }
+}
+
+static void InitServer(void) {
+  if (strcmp(g_config.server, "on") == 0) {
+    if (StratusServer_Open(g_server_socket))
+      LOG_INFO("Telemetry server listening on %s", g_server_socket);
+    else
+      LOG_WARN("Telemetry server unavailable on %s", g_server_socket);
+  } else if (strcmp(g_config.server, "off") != 0) {
+    LOG_WARN("Unknown server setting '%s', using off", g_config.server);
+  }
+}
+
+static void InitUdp(void) {
+  if (strcmp(g_config.udp, "off") == 0)
+    return;
+  if (StratusUdp_Open(g_config.udp))
+    LOG_INFO("Streaming telemetry over UDP to %s", g_config.udp);
+  else
+    LOG_WARN("UDP stream target '%s' unusable (expected host:port)",
+             g_config.udp);
+}
+
+static void InitTraffic(void) {
+  static const char *const kSources[] = {"none", "TCAS targets",
+                                         "multiplayer planes"};
+  StratusTrafficSource source = StratusTraffic_Init();
+  if (g_config.traffic_rate_hz <= 0.0f)
+    return;
+  if (source == STRATUS_TRAFFIC_NONE)
+    LOG_WARN("No traffic DataRefs found; stratus_traffic.json stays empty");
+  else
+    LOG_INFO("Traffic export: %s at %.1f Hz", kSources[source],
+             g_config.traffic_rate_hz);
+}
+
+static void InitDerived(void) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s" PATH_SEP STRATUS_AIRPORTS_FILE,
+           g_data_dir);
+  if (StratusAirports_Load(path))
+    LOG_INFO("Airport index: %u airports, searched within %.0f nm",
+             (unsigned)StratusAirports_Count(), g_config.airport_range_nm);
+  else
+    LOG_WARN("No airport index at %s (run scripts/build_airport_index.py); "
+             "derived airport fields stay empty",
+             path);
+  StratusDerived_Init(&g_derived, g_config.airport_range_nm);
+  StratusEvents_Init(&g_events);
+}
+
+/* Commands run first so a frame captured on the same tick already shows
+ * them; radios and traffic are phased into the gaps between telemetry
+ * frames. The event probe runs just before telemetry, so a frame it asks
+ * for goes out on the same tick. */
+static void InitScheduler(void) {
+  float frame_s = 1.0f / g_config.rate_hz;
+  StratusSched_Init(&g_sched, (uint64_t)g_config.perf_budget_us * 1000u);
+  StratusSched_Add(&g_sched, "commands", ApplyCommands,
+                   1.0f / g_config.command_rate_hz, 0.0f, 0);
+  if (g_config.radio_rate_hz > 0.0f)
+    g_task_radios =
+        StratusSched_Add(&g_sched, "radios", CaptureRadios,
+                         1.0f / g_config.radio_rate_hz, frame_s / 3.0f,
+                         RADIOS_BUDGET_NS);
+  if (g_config.event_rate_hz > 0.0f)
+    StratusSched_Add(&g_sched, "events", ProbeEvents,
+                     1.0f / g_config.event_rate_hz, 0.0f, 0);
+  g_task_telemetry = StratusSched_Add(&g_sched, "telemetry", PublishTelemetry,
+                                      frame_s, 0.0f, 0);
+  if (g_config.traffic_rate_hz > 0.0f)
+    StratusSched_Add(&g_sched, "traffic", CaptureTraffic,
+                     1.0f / g_config.traffic_rate_hz, 2.0f * frame_s / 3.0f,
+                     TRAFFIC_BUDGET_NS);
+  LOG_INFO("Tasks: commands %.0f Hz, radios %.1f Hz, events %.0f Hz, "
+           "telemetry %.1f Hz, traffic %.1f Hz",
+           g_config.command_rate_hz, g_config.radio_rate_hz,
+           g_config.event_rate_hz, g_config.rate_hz, g_config.traffic_rate_hz);
+}
+
+static void InitTransport(void) {
+  /* Environment overrides the config file */
+  const char *mode = getenv("STRATUS_TELEMETRY_TRANSPORT");
+  if (!mode)
+    mode = g_config.transport;
+  if (strcmp(mode, "json") == 0)
+    g_transport = TRANSPORT_JSON;
+  else if (strcmp(mode, "shm") == 0)
+    g_transport = TRANSPORT_SHM;
+  else if (strcmp(mode, "both") == 0)
+    g_transport = TRANSPORT_JSON | TRANSPORT_SHM;
+  else
+    LOG_WARN("Unknown telemetry transport '%s', using both", mode);
+
+  if (g_transport & TRANSPORT_SHM) {
+    if (StratusShm_Open()) {
+      LOG_INFO("Shared-memory telemetry ring: %s (%d slots)", STRATUS_SHM_NAME,
+               STRATUS_SHM_SLOTS);
+    } else {
+      LOG_WARN("Shared-memory telemetry unavailable, falling back to JSON");
+      g_transport = TRANSPORT_JSON;
+    }
+  }
+
+  LOG_INFO("Telemetry transport: %s%s%s",
+           (g_transport & TRANSPORT_JSON) ? "json" : "",
+           (g_transport == (TRANSPORT_JSON | TRANSPORT_SHM)) ? "+" : "",
+           (g_transport & TRANSPORT_SHM) ? "shm" : "");
+
+  const char *format = getenv("STRATUS_TELEMETRY_FORMAT");
+  if (!format)
+    format = g_config.format;
+  if (strcmp(format, "json") == 0)
+    g_format = FORMAT_JSON;
+  else if (strcmp(format, "binary") == 0)
+    g_format = FORMAT_BINARY;
+  else if (strcmp(format, "both") == 0)
+    g_format = FORMAT_JSON | FORMAT_BINARY;
+  else
+    LOG_WARN("Unknown telemetry format '%s', using json", format);
+
+  if (g_transport & TRANSPORT_JSON) {
+    LOG_INFO("Telemetry file format: %s%s%s",
+             (g_format & FORMAT_JSON) ? "json" : "",
+             (g_format == (FORMAT_JSON | FORMAT_BINARY)) ? "+" : "",
+             (g_format & FORMAT_BINARY) ? "binary" : "");
+  }
+
+  if (strcmp(g_config.in_process, "on") == 0) {
+    g_in_process = 1;
+    LOG_INFO("Telemetry also published to in-process consumers");
+  } else if (strcmp(g_config.in_process, "off") != 0) {
+    LOG_WARN("Unknown in_process setting '%s', using off",
+             g_config.in_process);
+  }
+
+  if (strcmp(g_config.publish, "delta") == 0) {
+    g_publish_delta = 1;
+    StratusDelta_Init(&g_delta, &g_config);
+    LOG_INFO("Telemetry publishing: delta (keyframe every %.0f s)",
+             g_config.keyframe_interval_s);
+  } else if (strcmp(g_config.publish, "full") != 0) {
+    LOG_WARN("Unknown telemetry publish mode '%s', using full",
+             g_config.publish);
+  }
+}
+
 static float FlightLoopCallback(float inElapsedSinceLastCall,
                                 float inElapsedTimeSinceLastFlightLoop,
                                 int inCounter, void *inRefcon) {
-  (void)inElapsedSinceLastCall;
   (void)inElapsedTimeSinceLastFlightLoop;
   (void)inCounter;
   (void)inRefcon;
+  if (!g_initialized)
+    InitDeferred(); /* Outside the timed region: a one-off */
 
-  WriteTelemetryJSON();
-  ReadCommandsJSONL();
+  uint64_t t0 = StratusMonotonicNs();
+  float next = StratusSched_Run(&g_sched, inElapsedSinceLastCall);
+  StratusPerf_Record(STRATUS_PERF_FLIGHT_LOOP, StratusMonotonicNs() - t0);
+  return next;
+}
+
+/* Apply whatever the I/O thread parsed since the last run */
+static void ApplyCommands(void) {
+  if (!StratusIo_IsRunning()) {
+    ReadCommandsJSONL();
+    ReadCommandsUdp();
+  }
+
+  uint64_t t0 = StratusMonotonicNs();
+  int applied = stratus_commander_apply(g_commander);
+  StratusAtc_Update();
+  StratusPerf_Record(STRATUS_PERF_APPLY_COMMANDS, StratusMonotonicNs() - t0);
+
+  /* A tuned radio or set transponder shows in the next frame, not at the
+   * next slow read */
+  if (applied > 0)
+    StratusSched_Kick(&g_sched, g_task_radios);
+}
+
+/* Cockpit settings into the frame the telemetry task publishes next */
+static void CaptureRadios(void) {
+  uint64_t t0 = StratusMonotonicNs();
+  StratusDataRefs_Read(&g_frame, STRATUS_READ_SLOW);
+  StratusPerf_Record(STRATUS_PERF_CAPTURE, StratusMonotonicNs() - t0);
+}
+
+/* Between frames, just the rows whose transitions are events: one of them
+ * brings the next frame forward to this tick */
+static void ProbeEvents(void) {
+  if (!g_frame_seq)
+    return; /* The first frame sets the baseline */
+  uint64_t t0 = StratusMonotonicNs();
+  StratusDataRefs_Read(&g_frame, STRATUS_READ_EVENTS);
+  uint32_t events = StratusEvents_Detect(&g_events, &g_frame);
+  StratusPerf_Record(STRATUS_PERF_CAPTURE, StratusMonotonicNs() - t0);
+  if (!events)
+    return;
+  g_events_pending |= events;
+  StratusSched_Kick(&g_sched, g_task_telemetry);
+}
+
+static void PublishTelemetry(void) {
+  uint64_t t0 = StratusMonotonicNs();
+  CaptureTelemetry(&g_frame, t0);
+  StratusPerf_Record(STRATUS_PERF_CAPTURE, StratusMonotonicNs() - t0);
+
+  /* What the probe saw, and whatever only a full capture shows */
+  g_frame.events = g_events_pending | StratusEvents_Detect(&g_events, &g_frame);
+  g_events_pending = 0;
+  if (g_frame.events) {
+    g_frame.event_seq++;
+    LOG_DEBUG("Event frame %llu: 0x%03x",
+              (unsigned long long)g_frame.frame_seq, (unsigned)g_frame.events);
+  }
+
+  StratusRecorder_Append(&g_frame, t0);
+
+  if (g_transport & TRANSPORT_SHM)
+    StratusShm_Publish(&g_frame);
+  if (g_in_process)
+    stratus_push_telemetry(&g_frame); /* A copy; no serialization */
+
+  if (StratusIo_IsRunning()) {
+    /* Serialization, file writes and socket sends happen on the I/O thread;
+     * a full queue just means it is behind, and the next frame supersedes
+     * this one */
+    if ((g_transport & TRANSPORT_JSON) || StratusServer_IsOpen() ||
+        StratusUdp_IsOpen())
+      StratusIo_PushFrame(&g_frame);
+  } else {
+    IoFrame(&g_frame);
+    StratusRecorder_Service();
+    StratusServer_Service();
+  }
+
+  float hz = SelectTelemetryRate(&g_frame);
+  if (hz != g_rate_hz) {
+    LOG_INFO("Telemetry rate %.1f Hz -> %.1f Hz", g_rate_hz, hz);
+    g_rate_hz = hz;
+    StratusSched_SetPeriod(&g_sched, g_task_telemetry, 1.0f / hz);
+  }
+}
+
+/* Pick the rate for the next tick. A client SET_RATE request wins (clamped
+ * to max_rate_hz); otherwise slow down while nothing moves and speed up on
+ * approach, where position and vertical speed change fastest. */
+static float SelectTelemetryRate(const StratusFrame *fr) {
+  float requested = stratus_commander_rate_hz(g_commander);
+  if (requested > 0.0f) {
+    if (requested < MIN_RATE_HZ)
+      return MIN_RATE_HZ;
+    return requested < g_config.max_rate_hz ? requested : g_config.max_rate_hz;
+  }
+
+  if (fr->paused)
+    return g_config.idle_rate_hz;
+  if (fr->on_ground && fr->ground_speed_mps < PARKED_SPEED_MPS)
+    return g_config.idle_rate_hz;
+  if (!fr->on_ground &&
+      fr->altitude_agl_m * METERS_TO_FEET < g_config.approach_agl_ft &&
+      fr->vertical_speed_fpm < APPROACH_VS_FPM)
+    return g_config.approach_rate_hz;
+  return g_config.rate_hz;
+}
 
-  return 0.1f; /* Call again in 0.1 seconds (10Hz) */
+/* Low-rate traffic snapshot, written on the I/O thread. An empty sky is
+ * written once rather than on every snapshot. */
+static void CaptureTraffic(void) {
+  uint64_t t0 = StratusMonotonicNs();
+  StratusTraffic_Capture(&g_traffic, t0);
+  StratusPerf_Record(STRATUS_PERF_CAPTURE_TRAFFIC, StratusMonotonicNs() - t0);
+
+  if (g_traffic.count == 0 && g_traffic_empty_written)
+    return;
+  g_traffic_empty_written = g_traffic.count == 0;
+  /* A full queue drops the snapshot; the next one supersedes it */
+  if (StratusIo_IsRunning())
+    StratusIo_PushTraffic(&g_traffic);
+  else
+    WriteTrafficJSON(&g_traffic);
 }
 
-static void WriteTelemetryJSON(void) {
-  /* Write to temp file first, then rename (atomic) */
+/* Flight state into `fr`; the cockpit settings in it are CaptureRadios' */
+static void CaptureTelemetry(StratusFrame *fr, uint64_t now_ns) {
+  fr->timestamp = (int64_t)time(NULL);
+  fr->frame_seq = ++g_frame_seq;
+  fr->monotonic_ns = now_ns;
+
+  /* One pass over the registry; with no radios task, or for the first
+   * frame (the events baseline), every field */
+  StratusDataRefs_Read(fr, g_task_radios < 0 || fr->frame_seq == 1
+                               ? STRATUS_READ_ALL
+                               : STRATUS_READ_FAST);
+
+  /* Aircraft is cached from the last context event (PublishContext); a
+   * longer file name is cut to the frame's field */
+  snprintf(fr->aircraft, sizeof(fr->aircraft), "%.*s",
+           (int)sizeof(fr->aircraft) - 1, g_context.acf_file);
+
+  if (StratusDerived_Update(&g_derived, fr))
+    LOG_INFO("Flight phase: %s", StratusDerived_PhaseName(fr->phase));
+}
+
+/* Runs on the I/O thread (or inline if it is not running) */
+static void IoFrame(const StratusFrame *fr) {
+  if (g_transport & TRANSPORT_JSON)
+    WriteTelemetryFiles(fr);
+
+  if (StratusServer_IsOpen()) {
+    uint64_t t0 = StratusMonotonicNs();
+    StratusServer_Publish(fr, t0);
+    StratusPerf_Record(STRATUS_PERF_SERVE_TELEMETRY,
+                       StratusMonotonicNs() - t0);
+  }
+
+  if (StratusUdp_IsOpen()) {
+    uint64_t t0 = StratusMonotonicNs();
+    StratusUdp_Publish(fr, t0);
+    StratusPerf_Record(STRATUS_PERF_STREAM_UDP, StratusMonotonicNs() - t0);
+  }
+}
+
+static void WriteTelemetryFiles(const StratusFrame *fr) {
+  StratusPublishKind kind =
+      fr->events ? STRATUS_PUBLISH_EVENT : STRATUS_PUBLISH_FULL;
+  if (g_publish_delta) {
+    /* Nothing moved beyond its dead-band: no write, no client wake-up */
+    kind = StratusDelta_Next(&g_delta, fr);
+    if (kind == STRATUS_PUBLISH_NONE)
+      return;
+  }
+
+  uint64_t t0 = StratusMonotonicNs();
+  if (g_format & FORMAT_JSON)
+    WriteTelemetryJSON(fr, kind);
+  if (g_format & FORMAT_BINARY)
+    WriteTelemetryBinary(fr);
+  StratusPerf_Record(STRATUS_PERF_WRITE_TELEMETRY, StratusMonotonicNs() - t0);
+}
+
+/* Replace `path` with `len` bytes of `data`: one write to a temp file, then
+ * an atomic rename, so readers never see a partial file. No stdio, so no
+ * allocation per call. */
+static int WriteFileAtomic(const char *path, const void *data, size_t len) {
   char tmp_file[1024];
-  snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", g_input_file);
+  snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", path);
 
-  FILE *f = fopen(tmp_file, "w");
+#if IBM
+  FILE *f = fopen(tmp_file, "wb");
   if (!f) {
     LOG_ERROR("Failed to open temp file for writing: %s", tmp_file);
+    return 0;
+  }
+  size_t written = fwrite(data, 1, len, f);
+  fclose(f);
+  int ok = written == len;
+#else
+  int fd = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open temp file for writing: %s", tmp_file);
+    return 0;
+  }
+  ssize_t written = write(fd, data, len);
+  close(fd);
+  int ok = written == (ssize_t)len;
+#endif
+
+  if (!ok) {
+    LOG_ERROR("Short write to %s", tmp_file);
+    remove(tmp_file);
+    return 0;
+  }
+  rename(tmp_file, path);
+  return 1;
+}
+
+static void WriteTelemetryJSON(const StratusFrame *fr,
+                               StratusPublishKind kind) {
+  static char buf[STRATUS_DELTA_JSON_MAX];
+  size_t len = StratusDelta_WriteJSON(buf, sizeof(buf), &g_delta, fr, kind);
+  if (!len) {
+    LOG_ERROR("Telemetry record exceeds %d bytes", STRATUS_DELTA_JSON_MAX);
     return;
   }
+  WriteFileAtomic(g_input_file, buf, len);
+}
 
-  /* Get current timestamp */
-  time_t now = time(NULL);
-
-  /* Read all DataRefs */
-  double lat = dr_lat ? XPLMGetDatad(dr_lat) : 0.0;
-  double lon = dr_lon ? XPLMGetDatad(dr_lon) : 0.0;
-  double alt_msl = dr_alt_msl ? XPLMGetDatad(dr_alt_msl) : 0.0;
-  float alt_agl = dr_alt_agl ? XPLMGetDataf(dr_alt_agl) : 0.0f;
-  float hdg_mag = dr_hdg_mag ? XPLMGetDataf(dr_hdg_mag) : 0.0f;
-  float hdg_true = dr_hdg_true ? XPLMGetDataf(dr_hdg_true) : 0.0f;
-  float pitch = dr_pitch ? XPLMGetDataf(dr_pitch) : 0.0f;
-  float roll = dr_roll ? XPLMGetDataf(dr_roll) : 0.0f;
-  float gnd_spd = dr_gnd_speed ? XPLMGetDataf(dr_gnd_speed) : 0.0f;
-  float ias = dr_ias ? XPLMGetDataf(dr_ias) : 0.0f;
-  float tas = dr_tas ? XPLMGetDataf(dr_tas) : 0.0f;
-  float vs = dr_vs ? XPLMGetDataf(dr_vs) : 0.0f;
-  int on_gnd = dr_on_ground ? XPLMGetDatai(dr_on_ground) : 0;
-  int paused = dr_paused ? XPLMGetDatai(dr_paused) : 0;
-
-  int com1 = dr_com1_freq ? XPLMGetDatai(dr_com1_freq) : 0;
-  int com1_sb = dr_com1_stdby ? XPLMGetDatai(dr_com1_stdby) : 0;
-  int com2 = dr_com2_freq ? XPLMGetDatai(dr_com2_freq) : 0;
-  int com2_sb = dr_com2_stdby ? XPLMGetDatai(dr_com2_stdby) : 0;
-  int nav1 = dr_nav1_freq ? XPLMGetDatai(dr_nav1_freq) : 0;
-  int nav2 = dr_nav2_freq ? XPLMGetDatai(dr_nav2_freq) : 0;
-  int xpdr = dr_xpdr_code ? XPLMGetDatai(dr_xpdr_code) : 0;
-  int xpdr_mode = dr_xpdr_mode ? XPLMGetDatai(dr_xpdr_mode) : 0;
-
-  float ap_alt = dr_ap_alt ? XPLMGetDataf(dr_ap_alt) : 0.0f;
-  float ap_hdg = dr_ap_hdg ? XPLMGetDataf(dr_ap_hdg) : 0.0f;
-  float ap_vs = dr_ap_vs ? XPLMGetDataf(dr_ap_vs) : 0.0f;
-
-  /* Get aircraft info */
-  char acf_path[512] = {0};
-  char acf_file[256] = {0};
-  XPLMGetNthAircraftModel(0, acf_file, acf_path);
-
-  /* Write JSON (manual formatting to avoid external deps) */
-  fprintf(f, "{\n");
-  fprintf(f, "  \"timestamp\": %ld,\n", (long)now);
-  fprintf(f, "  \"simulator\": \"X-Plane\",\n");
-  fprintf(f, "  \"aircraft\": \"%s\",\n", acf_file);
-  fprintf(f, "  \"position\": {\n");
-  fprintf(f, "    \"latitude\": %.8f,\n", lat);
-  fprintf(f, "    \"longitude\": %.8f,\n", lon);
-  fprintf(f, "    \"altitude_msl_m\": %.2f,\n", alt_msl);
-  fprintf(f, "    \"altitude_agl_m\": %.2f\n", alt_agl);
-  fprintf(f, "  },\n");
-  fprintf(f, "  \"orientation\": {\n");
-  fprintf(f, "    \"heading_mag\": %.2f,\n", hdg_mag);
-  fprintf(f, "    \"heading_true\": %.2f,\n", hdg_true);
-  fprintf(f, "    \"pitch\": %.2f,\n", pitch);
-  fprintf(f, "    \"roll\": %.2f\n", roll);
-  fprintf(f, "  },\n");
-  fprintf(f, "  \"speed\": {\n");
-  fprintf(f, "    \"ground_speed_mps\": %.2f,\n", gnd_spd);
-  fprintf(f, "    \"ias_kts\": %.2f,\n", ias);
-  fprintf(f, "    \"tas_mps\": %.2f,\n", tas);
-  fprintf(f, "    \"vertical_speed_fpm\": %.2f\n", vs);
-  fprintf(f, "  },\n");
-  fprintf(f, "  \"radios\": {\n");
-  fprintf(f, "    \"com1_hz\": %d,\n", com1);
-  fprintf(f, "    \"com1_standby_hz\": %d,\n", com1_sb);
-  fprintf(f, "    \"com2_hz\": %d,\n", com2);
-  fprintf(f, "    \"com2_standby_hz\": %d,\n", com2_sb);
-  fprintf(f, "    \"nav1_hz\": %d,\n", nav1);
-  fprintf(f, "    \"nav2_hz\": %d\n", nav2);
-  fprintf(f, "  },\n");
-  fprintf(f, "  \"transponder\": {\n");
-  fprintf(f, "    \"code\": %d,\n", xpdr);
-  fprintf(f, "    \"mode\": %d\n", xpdr_mode);
-  fprintf(f, "  },\n");
-  fprintf(f, "  \"autopilot\": {\n");
-  fprintf(f, "    \"altitude_ft\": %.0f,\n", ap_alt);
-  fprintf(f, "    \"heading\": %.0f,\n", ap_hdg);
-  fprintf(f, "    \"vs_fpm\": %.0f\n", ap_vs);
-  fprintf(f, "  },\n");
-  fprintf(f, "  \"state\": {\n");
-  fprintf(f, "    \"on_ground\": %s,\n", on_gnd ? "true" : "false");
-  fprintf(f, "    \"paused\": %s\n", paused ? "true" : "false");
-  fprintf(f, "  }\n");
-  fprintf(f, "}\n");
+/* Runs on the I/O thread (or inline if it is not running) */
+static void WriteContextJSON(const StratusContext *ctx) {
+  static char buf[STRATUS_CONTEXT_JSON_MAX];
+  size_t len = StratusContext_WriteJSON(buf, sizeof(buf), ctx);
+  if (!len) {
+    LOG_ERROR("Context record exceeds %d bytes", STRATUS_CONTEXT_JSON_MAX);
+    return;
+  }
+  WriteFileAtomic(g_context_file, buf, len);
+}
 
-  fclose(f);
+/* Runs on the I/O thread (or inline if it is not running) */
+static void WriteTrafficJSON(const StratusTraffic *traffic) {
+  static char buf[STRATUS_TRAFFIC_JSON_MAX];
+  size_t len = StratusTraffic_WriteJSON(buf, sizeof(buf), traffic);
+  if (!len) {
+    LOG_ERROR("Traffic record exceeds %d bytes", STRATUS_TRAFFIC_JSON_MAX);
+    return;
+  }
+  WriteFileAtomic(g_traffic_file, buf, len);
+}
 
-  /* Atomic rename */
-  rename(tmp_file, g_input_file);
+static void WriteTelemetryBinary(const StratusFrame *fr) {
+  uint8_t buf[STRATUS_FRAME_ENCODED_SIZE];
+  size_t len = StratusFrame_Encode(fr, buf, sizeof(buf));
+  WriteFileAtomic(g_binary_file, buf, len);
 }
 
+/* Runs on the I/O thread: parse only; the flight loop writes the DataRefs */
 static void ReadCommandsJSONL(void) {
-  /* Call the Rust CommandParser logic */
-  process_stratus_commands(g_output_file, g_status_file);
+  /* Cheap when nothing is pending: one fstat on the already-open file */
+  uint64_t t0 = StratusMonotonicNs();
+  stratus_commander_poll(g_commander);
+  StratusPerf_Record(STRATUS_PERF_READ_COMMANDS, StratusMonotonicNs() - t0);
+}
+
+/* Runs on the I/O thread: queue command datagrams from the UDP receiver */
+static void ReadCommandsUdp(void) {
+  static char text[STRATUS_UDP_DATAGRAM_MAX];
+  size_t len;
+  while ((len = StratusUdp_Receive(text, sizeof(text))) > 0)
+    stratus_commander_submit(g_commander, text, len);
+}
+
+/* Runs on the I/O thread every poll interval */
+static void IoIdle(void) {
+  static uint64_t next_dump_ms = 0;
+
+  ReadCommandsJSONL();
+  ReadCommandsUdp();
+  StratusRecorder_Service();
+  StratusServer_Service();
+
+  if (g_config.perf_dump_s > 0) {
+    uint64_t now = StratusMonotonicMs();
+    if (next_dump_ms && now >= next_dump_ms)
+      StratusPerf_Dump(g_perf_file);
+    if (!next_dump_ms || now >= next_dump_ms)
+      next_dump_ms = now + (uint64_t)g_config.perf_dump_s * 1000u;
+  }
 }
@@ -0,0 +1,159 @@
+/*
+ * Stratus ATC - Aircraft DataRef Profiles
+ *
+ * See stratus_profile.h.
+ */
+
+#include "stratus_profile.h"
+
+#include "stratus_json.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if IBM
+#define PATH_SEP "\\"
+#else
+#define PATH_SEP "/"
+#endif
+
+static char *Trim(char *s) {
+  while (isspace((unsigned char)*s))
+    s++;
+  char *end = s + strlen(s);
+  while (end > s && isspace((unsigned char)end[-1]))
+    *--end = '\0';
+  return s;
+}
+
+static StratusProfileEntry *EntryFor(StratusProfile *p, const char *field) {
+  for (int i = 0; i < p->count; i++) {
+    if (strcmp(p->entries[i].field, field) == 0)
+      return &p->entries[i];
+  }
+  if (p->count >= STRATUS_PROFILE_MAX)
+    return NULL;
+  StratusProfileEntry *e = &p->entries[p->count++];
+  memset(e, 0, sizeof(*e));
+  strcpy(e->field, field);
+  return e;
+}
+
+/* "<name> [scale]" */
+static int ParseRef(char *value, char *name, float *scale) {
+  char *space = value;
+  while (*space && !isspace((unsigned char)*space))
+    space++;
+  char *rest = "";
+  if (*space) {
+    *space = '\0';
+    rest = Trim(space + 1);
+  }
+  if (strlen(value) >= STRATUS_PROFILE_NAME_LEN)
+    return 0;
+  *scale = 0.0f;
+  if (*rest) {
+    double v;
+    if (!StratusJson_ParseDouble(rest, &v) || (float)v == 0.0f)
+      return 0;
+    *scale = (float)v;
+  }
+  strcpy(name, value);
+  return 1;
+}
+
+/* 1 = applied, 0 = bad value, -1 = bad key */
+static int Apply(StratusProfile *p, char *key, char *value) {
+  char *suffix = strrchr(key, '.');
+  int is_write = suffix && strcmp(suffix, ".write") == 0;
+  int is_command = suffix && strcmp(suffix, ".command") == 0;
+  if (is_write || is_command)
+    *suffix = '\0';
+  if (!strchr(key, '.') || strlen(key) >= STRATUS_PROFILE_FIELD_LEN ||
+      *value == '\0')
+    return -1;
+
+  StratusProfileEntry *e = EntryFor(p, key);
+  if (!e)
+    return -1;
+  if (is_command) {
+    if (strlen(value) >= STRATUS_PROFILE_NAME_LEN)
+      return 0;
+    strcpy(e->command, value);
+    return 1;
+  }
+  if (is_write)
+    return ParseRef(value, e->write, &e->write_scale);
+  return ParseRef(value, e->dataref, &e->scale);
+}
+
+static int LoadFile(StratusProfile *p, const char *path, const char *name,
+                    void (*warn)(const char *msg)) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return 0;
+
+  snprintf(p->name, sizeof(p->name), "%s", name);
+  char line[512];
+  char msg[1200]; /* Path plus message */
+  int lineno = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = '\0';
+    char *text = Trim(line);
+    if (*text == '\0')
+      continue;
+
+    char *eq = strchr(text, '=');
+    int ok = -1;
+    if (eq) {
+      *eq = '\0';
+      ok = Apply(p, Trim(text), Trim(eq + 1));
+    }
+    if (ok < 0 && warn) {
+      snprintf(msg, sizeof(msg),
+               "%s:%d: expected <section>.<key>[.write|.command] = <name>",
+               path, lineno);
+      warn(msg);
+    } else if (ok == 0 && warn) {
+      snprintf(msg, sizeof(msg), "%s:%d: bad DataRef or scale", path,
+               lineno);
+      warn(msg);
+    }
+  }
+
+  fclose(f);
+  return 1;
+}
+
+int StratusProfile_Load(StratusProfile *p, const char *dir,
+                        const char *acf_file, const char *icao,
+                        void (*warn)(const char *msg)) {
+  memset(p, 0, sizeof(*p));
+
+  /* The .acf name tells variants of one type apart, so it is tried first */
+  char stem[256];
+  snprintf(stem, sizeof(stem), "%s", acf_file ? acf_file : "");
+  char *dot = strrchr(stem, '.');
+  if (dot && strcmp(dot, ".acf") == 0)
+    *dot = '\0';
+
+  const char *names[] = {stem, icao ? icao : ""};
+  char path[1024];
+  char file[sizeof(p->name)];
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    /* No path separators from sim-supplied names */
+    if (names[i][0] == '\0' || strpbrk(names[i], "/\\"))
+      continue;
+    if (snprintf(file, sizeof(file), "%s.cfg", names[i]) >= (int)sizeof(file))
+      continue;
+    snprintf(path, sizeof(path), "%s" PATH_SEP "%s", dir, file);
+    if (LoadFile(p, path, file, warn))
+      return 1;
+  }
+  return 0;
+}
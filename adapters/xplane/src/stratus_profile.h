@@ -0,0 +1,61 @@
+/*
+ * Stratus ATC - Aircraft DataRef Profiles
+ *
+ * Study-level add-ons often keep their radios and autopilot in custom
+ * DataRefs and ignore writes to the stock ones. A profile maps logical
+ * telemetry fields, named `<section>.<key>` as in the telemetry JSON, to the
+ * aircraft's own DataRefs. It is chosen when an aircraft loads, from
+ * `profiles/` in the data directory: `<acf file name without .acf>.cfg`
+ * first, then `<ICAO type>.cfg`. Same syntax as stratus_plugin.cfg:
+ *
+ *   # Zibo Mod 737-800 (b738.acf)
+ *   autopilot.altitude_ft = laminar/B738/autopilot/mcp_alt_dial
+ *   autopilot.heading = laminar/B738/autopilot/mcp_hdg_dial
+ *   # Optional scale: telemetry value = DataRef value * scale
+ *   radios.com1_hz = vendor/radios/com1_mhz 1000000
+ *   # Written somewhere else than it is read (same scale rules)
+ *   transponder.code.write = vendor/xpdr/code_set
+ *   # Fired once after each write to the field
+ *   radios.com1_standby_hz.command = vendor/radios/com1_sync
+ *
+ * Fields not listed keep the stock DataRefs. A field can only be mapped to
+ * a numeric DataRef of the same shape (scalar or array) as its row.
+ *
+ * Loading is the only place names are matched: the registry
+ * (stratus_datarefs.h) and the commander (stratus_commander.h) compile a
+ * profile into handles indexed by field, so reads and writes stay array
+ * lookups.
+ */
+
+#ifndef STRATUS_PROFILE_H
+#define STRATUS_PROFILE_H
+
+#define STRATUS_PROFILE_DIR "profiles"
+#define STRATUS_PROFILE_MAX 32 /* Entries per profile */
+#define STRATUS_PROFILE_FIELD_LEN 48
+#define STRATUS_PROFILE_NAME_LEN 128 /* DataRef and command names */
+
+typedef struct StratusProfileEntry {
+  char field[STRATUS_PROFILE_FIELD_LEN]; /* <section>.<key> */
+  char dataref[STRATUS_PROFILE_NAME_LEN]; /* Read (and written); "" = stock */
+  float scale;                            /* 0 = 1 */
+  char write[STRATUS_PROFILE_NAME_LEN]; /* Written instead; "" = `dataref` */
+  float write_scale;
+  char command[STRATUS_PROFILE_NAME_LEN]; /* After each write; "" = none */
+} StratusProfileEntry;
+
+typedef struct StratusProfile {
+  char name[64]; /* File name, "" when no profile is loaded */
+  int count;
+  StratusProfileEntry entries[STRATUS_PROFILE_MAX];
+} StratusProfile;
+
+/* Load the profile for an aircraft from `dir`. `acf_file` is the .acf file
+ * name, `icao` its ICAO type; either may be empty. Returns 1 if a profile
+ * was found, 0 if not (`p` is then empty). `warn` (may be NULL) gets syntax
+ * errors, which skip the line. */
+int StratusProfile_Load(StratusProfile *p, const char *dir,
+                        const char *acf_file, const char *icao,
+                        void (*warn)(const char *msg));
+
+#endif /* STRATUS_PROFILE_H */
@@ -0,0 +1,104 @@
+/*
+ * Stratus ATC - Push-to-Talk Signal Socket
+ *
+ * See stratus_ptt.h.
+ */
+
+#include "stratus_ptt.h"
+
+#include <string.h>
+#include <time.h>
+
+#if !IBM
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static uint32_t g_seq = 0;
+
+#if IBM
+
+#include <windows.h>
+
+/* Windows: no datagram socket; stratus_ptt.json is the only PTT channel */
+int StratusPtt_Open(const char *socket_path) {
+  (void)socket_path;
+  return 0;
+}
+
+void StratusPtt_Close(void) {}
+
+static void Stamp(StratusPttEvent *ev) {
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  ev->monotonic_ns = (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000u +
+                     (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000u /
+                         (uint64_t)freq.QuadPart;
+  ev->unix_ns = (int64_t)time(NULL) * 1000000000;
+}
+
+#else
+
+static int g_fd = -1;
+static struct sockaddr_un g_addr;
+
+int StratusPtt_Open(const char *socket_path) {
+  if (g_fd >= 0)
+    return 1;
+  if (strlen(socket_path) >= sizeof(g_addr.sun_path))
+    return 0;
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd < 0)
+    return 0;
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+    close(fd);
+    return 0;
+  }
+
+  memset(&g_addr, 0, sizeof(g_addr));
+  g_addr.sun_family = AF_UNIX;
+  strcpy(g_addr.sun_path, socket_path);
+  g_fd = fd;
+  return 1;
+}
+
+void StratusPtt_Close(void) {
+  if (g_fd >= 0) {
+    close(g_fd);
+    g_fd = -1;
+  }
+}
+
+static void Stamp(StratusPttEvent *ev) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  ev->monotonic_ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ev->unix_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif
+
+int StratusPtt_Send(int active, StratusPttEvent *ev) {
+  memset(ev, 0, sizeof(*ev));
+  Stamp(ev);
+  ev->magic = STRATUS_PTT_MAGIC;
+  ev->version = STRATUS_PTT_VERSION;
+  ev->active = active ? 1 : 0;
+  ev->seq = ++g_seq;
+
+#if IBM
+  return 0;
+#else
+  if (g_fd < 0)
+    return 0;
+  /* Fails fast with ENOENT/ECONNREFUSED when nobody is listening */
+  return sendto(g_fd, ev, sizeof(*ev), 0, (const struct sockaddr *)&g_addr,
+                sizeof(g_addr)) == (ssize_t)sizeof(*ev);
+#endif
+}
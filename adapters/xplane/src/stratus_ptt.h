@@ -0,0 +1,49 @@
+/*
+ * Stratus ATC - Push-to-Talk Signal Socket
+ *
+ * PTT transitions are pushed to the voice process as a single datagram on a
+ * Unix domain socket, sent straight from the command handler. The voice
+ * process binds the socket and blocks in recv(), so it wakes as soon as the
+ * key goes down instead of noticing a rewritten file on its next poll.
+ *
+ * Sending is non-blocking and fire-and-forget: with no listener bound the
+ * datagram is simply dropped, and stratus_ptt.json (still written on the I/O
+ * thread) remains the fallback.
+ *
+ * Datagram layout (little-endian, mirrored in stratus-voice/src/ptt_hook.rs):
+ *   StratusPttEvent, 32 bytes
+ */
+
+#ifndef STRATUS_PTT_H
+#define STRATUS_PTT_H
+
+#include <stdint.h>
+
+#define STRATUS_PTT_SOCKET "stratus_ptt.sock"
+#define STRATUS_PTT_MAGIC 0x54505453u /* "STPT" */
+#define STRATUS_PTT_VERSION 1
+
+typedef struct StratusPttEvent {
+  uint32_t magic;   /* STRATUS_PTT_MAGIC */
+  uint16_t version; /* STRATUS_PTT_VERSION */
+  uint8_t active;   /* 1 = pressed, 0 = released */
+  uint8_t _pad0;
+  uint32_t seq; /* Transitions since plugin start, from 1 */
+  uint32_t _pad1;
+  uint64_t monotonic_ns; /* CLOCK_MONOTONIC at the key event */
+  int64_t unix_ns;       /* CLOCK_REALTIME at the key event */
+} StratusPttEvent;
+
+_Static_assert(sizeof(StratusPttEvent) == 32, "StratusPttEvent layout changed");
+
+/* Create the sending socket aimed at `socket_path`. Returns 1 on success. */
+int StratusPtt_Open(const char *socket_path);
+
+/* Close the sending socket. */
+void StratusPtt_Close(void);
+
+/* Stamp a transition into `ev` and send it. Returns 1 if a listener took the
+ * datagram; `ev` is filled in either way. Safe to call from the sim thread. */
+int StratusPtt_Send(int active, StratusPttEvent *ev);
+
+#endif /* STRATUS_PTT_H */
@@ -0,0 +1,324 @@
+/*
+ * Stratus ATC - Flight Data Recorder
+ *
+ * See stratus_recorder.h. The sim thread owns the encoder state and the
+ * write position; the I/O thread only reads the write position and
+ * publishes how far the file has been allocated.
+ */
+
+#include "stratus_recorder.h"
+#include "stratus_thread.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if !IBM
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FRAME_WORDS (sizeof(StratusFrame) / sizeof(uint32_t))
+#define MASK_WORDS ((FRAME_WORDS + 63) / 64)
+#define KEYFRAME_SIZE (1 + 8 + sizeof(StratusFrame))
+#define DELTA_HEADER_SIZE (1 + 4 + 8 * MASK_WORDS)
+#define MAX_RECORD 384
+#define RESERVE_BYTES (4ull << 30) /* Mapped up front; ~1000 h of cruise */
+
+_Static_assert(DELTA_HEADER_SIZE + (FRAME_WORDS + 3) / 4 +
+                       sizeof(StratusFrame) <= MAX_RECORD &&
+                   KEYFRAME_SIZE <= MAX_RECORD,
+               "MAX_RECORD too small");
+
+static char g_path[1024] = {0};
+
+#if IBM
+
+/* Windows: no recorder (no mmap-backed file growth here) */
+int StratusRecorder_Open(const char *data_dir) {
+  (void)data_dir;
+  return 0;
+}
+
+const char *StratusRecorder_Path(void) { return g_path; }
+
+void StratusRecorder_Append(const StratusFrame *frame, uint64_t monotonic_ns) {
+  (void)frame;
+  (void)monotonic_ns;
+}
+
+void StratusRecorder_Service(void) {}
+
+uint64_t StratusRecorder_Close(void) { return 0; }
+
+#else
+
+static int g_fd = -1;
+static uint8_t *g_base = NULL;
+static StratusRecHeader *g_hdr = NULL;
+static _Atomic uint64_t g_allocated = 0; /* File size, grown by Service */
+static _Atomic uint64_t g_write_pos = 0; /* End of the last record */
+static _Atomic uint64_t g_dropped = 0;
+
+/* Encoder state, sim thread only */
+static uint32_t g_prev[FRAME_WORDS];
+static uint64_t g_prev_ns = 0;
+static uint64_t g_key_ns = 0;
+static int g_need_key = 1;
+
+static int PopCount(uint64_t v) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(v);
+#else
+  int n = 0;
+  for (; v; v &= v - 1)
+    n++;
+  return n;
+#endif
+}
+
+/* Make the file `size` bytes long, with its blocks allocated where the
+ * filesystem supports it so later page faults do not wait on the disk */
+static int Grow(uint64_t size) {
+#if LIN
+  return posix_fallocate(g_fd, 0, (off_t)size) == 0;
+#else
+  return ftruncate(g_fd, (off_t)size) == 0;
+#endif
+}
+
+int StratusRecorder_Open(const char *data_dir) {
+  if (g_base)
+    return 1;
+
+  char dir[1024];
+  snprintf(dir, sizeof(dir), "%s/" STRATUS_REC_DIR, data_dir);
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    return 0;
+
+  time_t now = time(NULL);
+  struct tm tm_info;
+  localtime_r(&now, &tm_info);
+  char name[64];
+  strftime(name, sizeof(name), "stratus_%Y%m%d_%H%M%S.strec", &tm_info);
+  if (snprintf(g_path, sizeof(g_path), "%s/%s", dir, name) >=
+      (int)sizeof(g_path)) {
+    g_path[0] = '\0';
+    return 0;
+  }
+
+  g_fd = open(g_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (g_fd < 0)
+    goto fail;
+  if (!Grow(STRATUS_REC_CHUNK))
+    goto fail;
+  void *base = mmap(NULL, RESERVE_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    g_fd, 0);
+  if (base == MAP_FAILED)
+    goto fail;
+  g_base = base;
+  g_hdr = base;
+
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  memset(g_hdr, 0, sizeof(*g_hdr));
+  g_hdr->magic = STRATUS_REC_MAGIC;
+  g_hdr->version = STRATUS_REC_VERSION;
+  g_hdr->header_size = sizeof(StratusRecHeader);
+  g_hdr->frame_size = sizeof(StratusFrame);
+  g_hdr->frame_version = STRATUS_FRAME_VERSION;
+  g_hdr->start_unix_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  g_hdr->start_monotonic_ns = StratusMonotonicNs();
+  g_hdr->data_end = sizeof(StratusRecHeader);
+
+  atomic_store(&g_allocated, STRATUS_REC_CHUNK);
+  atomic_store(&g_write_pos, sizeof(StratusRecHeader));
+  atomic_store(&g_dropped, 0);
+  g_need_key = 1;
+  return 1;
+
+fail:
+  if (g_fd >= 0) {
+    close(g_fd);
+    g_fd = -1;
+    unlink(g_path);
+  }
+  g_path[0] = '\0';
+  return 0;
+}
+
+const char *StratusRecorder_Path(void) { return g_path; }
+
+static size_t WriteKeyframe(uint8_t *p, const StratusFrame *frame,
+                            uint64_t monotonic_ns) {
+  p[0] = STRATUS_REC_KEYFRAME;
+  memcpy(p + 1, &monotonic_ns, sizeof(monotonic_ns));
+  memcpy(p + 9, frame, sizeof(*frame));
+  return KEYFRAME_SIZE;
+}
+
+static int Changed(const uint64_t *mask, size_t i) {
+  return (mask[i / 64] >> (i % 64)) & 1u;
+}
+
+static size_t WriteDelta(uint8_t *p, const uint32_t *cur, uint32_t dt_us) {
+  uint64_t mask[MASK_WORDS] = {0};
+  int changed = 0;
+  for (size_t i = 0; i < FRAME_WORDS; i++) {
+    if (cur[i] != g_prev[i]) {
+      mask[i / 64] |= 1ull << (i % 64);
+      changed++;
+    }
+  }
+
+  size_t code_len = ((size_t)changed + 3) / 4;
+  uint8_t *codes = p + DELTA_HEADER_SIZE;
+  memset(codes, 0, code_len);
+  uint8_t *out = codes + code_len;
+  int j = 0;
+  for (size_t i = 0; i < FRAME_WORDS; i++) {
+    if (!Changed(mask, i))
+      continue;
+    uint32_t x = cur[i] ^ g_prev[i];
+    int n = (x >> 24) ? 4 : (x >> 16) ? 3 : (x >> 8) ? 2 : 1;
+    codes[j / 4] |= (uint8_t)((n - 1) << (2 * (j % 4)));
+    for (int b = 0; b < n; b++)
+      *out++ = (uint8_t)(x >> (8 * b));
+    j++;
+  }
+
+  p[0] = STRATUS_REC_DELTA;
+  memcpy(p + 1, &dt_us, sizeof(dt_us));
+  memcpy(p + 5, mask, sizeof(mask));
+  return (size_t)(out - p);
+}
+
+void StratusRecorder_Append(const StratusFrame *frame, uint64_t monotonic_ns) {
+  if (!g_base)
+    return;
+
+  uint64_t pos = atomic_load_explicit(&g_write_pos, memory_order_relaxed);
+  if (pos + MAX_RECORD >
+      atomic_load_explicit(&g_allocated, memory_order_acquire)) {
+    /* The file did not grow in time; resume with a keyframe */
+    atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+    g_need_key = 1;
+    return;
+  }
+
+  uint32_t cur[FRAME_WORDS];
+  memcpy(cur, frame, sizeof(cur));
+  uint64_t dt_us = (monotonic_ns - g_prev_ns) / 1000u;
+
+  uint8_t *p = g_base + pos;
+  size_t len;
+  if (g_need_key || monotonic_ns - g_key_ns >= STRATUS_REC_KEYFRAME_NS ||
+      dt_us > UINT32_MAX) {
+    len = WriteKeyframe(p, frame, monotonic_ns);
+    g_key_ns = monotonic_ns;
+    g_need_key = 0;
+  } else {
+    len = WriteDelta(p, cur, (uint32_t)dt_us);
+  }
+  memcpy(g_prev, cur, sizeof(cur));
+  g_prev_ns = monotonic_ns;
+
+  /* The record is complete before data_end covers it */
+  atomic_thread_fence(memory_order_release);
+  g_hdr->frame_count++;
+  g_hdr->data_end = pos + len;
+  atomic_store_explicit(&g_write_pos, pos + len, memory_order_release);
+}
+
+void StratusRecorder_Service(void) {
+  if (!g_base)
+    return;
+  uint64_t allocated = atomic_load_explicit(&g_allocated, memory_order_relaxed);
+  uint64_t pos = atomic_load_explicit(&g_write_pos, memory_order_acquire);
+  if (allocated - pos >= STRATUS_REC_CHUNK / 2 ||
+      allocated + STRATUS_REC_CHUNK > RESERVE_BYTES)
+    return;
+  if (Grow(allocated + STRATUS_REC_CHUNK))
+    atomic_store_explicit(&g_allocated, allocated + STRATUS_REC_CHUNK,
+                          memory_order_release);
+}
+
+/* Size of the record at `p`, 0 if it is not one */
+static size_t RecordSize(const uint8_t *p) {
+  if (p[0] == STRATUS_REC_KEYFRAME)
+    return KEYFRAME_SIZE;
+  if (p[0] != STRATUS_REC_DELTA)
+    return 0;
+  uint64_t mask[MASK_WORDS];
+  memcpy(mask, p + 5, sizeof(mask));
+  int changed = 0;
+  for (size_t i = 0; i < MASK_WORDS; i++)
+    changed += PopCount(mask[i]);
+  size_t code_len = ((size_t)changed + 3) / 4;
+  size_t size = DELTA_HEADER_SIZE + code_len;
+  const uint8_t *codes = p + DELTA_HEADER_SIZE;
+  for (int j = 0; j < changed; j++)
+    size += (size_t)((codes[j / 4] >> (2 * (j % 4))) & 3) + 1;
+  return size;
+}
+
+/* Walk the records up to `end`; with `out`, also write one index entry
+ * per keyframe there. Returns the number of keyframes. */
+static uint64_t ScanKeyframes(uint64_t end, uint8_t *out) {
+  uint64_t count = 0;
+  uint64_t frames = 0;
+  for (uint64_t off = sizeof(StratusRecHeader); off < end; frames++) {
+    const uint8_t *p = g_base + off;
+    size_t size = RecordSize(p);
+    if (!size)
+      break;
+    if (p[0] == STRATUS_REC_KEYFRAME) {
+      if (out) {
+        StratusRecIndexEntry e = {.offset = off, .frame_number = frames};
+        memcpy(&e.monotonic_ns, p + 1, sizeof(e.monotonic_ns));
+        memcpy(&e.timestamp, p + 9 + offsetof(StratusFrame, timestamp),
+               sizeof(e.timestamp));
+        memcpy(out + count * sizeof(e), &e, sizeof(e));
+      }
+      count++;
+    }
+    off += size;
+  }
+  return count;
+}
+
+uint64_t StratusRecorder_Close(void) {
+  if (!g_base)
+    return 0;
+
+  /* Seal: the index goes after the last record, 8-byte aligned */
+  uint64_t index_offset = (g_hdr->data_end + 7) & ~(uint64_t)7;
+  uint64_t count = ScanKeyframes(g_hdr->data_end, NULL);
+  uint64_t size = index_offset + count * sizeof(StratusRecIndexEntry);
+  int room = size <= atomic_load(&g_allocated) ||
+             (size <= RESERVE_BYTES && Grow(size));
+  if (room) {
+    ScanKeyframes(g_hdr->data_end, g_base + index_offset);
+    g_hdr->index_offset = index_offset;
+    g_hdr->index_count = count;
+    g_hdr->flags |= STRATUS_REC_SEALED;
+  } else {
+    size = g_hdr->data_end; /* Unsealed, but readable up to data_end */
+  }
+
+  munmap(g_base, RESERVE_BYTES);
+  g_base = NULL;
+  g_hdr = NULL;
+  /* Drop the preallocated tail; a failure only wastes disk space */
+  int truncated = ftruncate(g_fd, (off_t)size) == 0;
+  (void)truncated;
+  close(g_fd);
+  g_fd = -1;
+  return atomic_exchange(&g_dropped, 0);
+}
+
+#endif
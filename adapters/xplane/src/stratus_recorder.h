@@ -0,0 +1,105 @@
+/*
+ * Stratus ATC - Flight Data Recorder
+ *
+ * Records every captured StratusFrame of a session into one append-only
+ * file, `recordings/stratus_<YYYYMMDD_HHMMSS>.strec` in the data directory,
+ * for debriefs and replay.
+ *
+ * The file is memory-mapped once over a large reserved range and grown
+ * ahead of the writer, in STRATUS_REC_CHUNK steps, by
+ * StratusRecorder_Service() on the I/O thread. Appending a frame is an
+ * encode into the mapping with no syscalls; if the file has not grown in
+ * time the frame is dropped (and counted), never waited for.
+ *
+ * Records are byte-aligned and self-delimiting. A keyframe carries a whole
+ * StratusFrame; a delta carries only the 32-bit words of the frame that
+ * changed since the previous record, XORed with their previous value and
+ * trimmed of leading zero bytes. Cruise at 20 Hz costs ~4 MB per hour.
+ *
+ *   'K'  u64 monotonic_ns, StratusFrame              (keyframe, every 10 s)
+ *   'D'  u32 dt_us, changed-word mask,               (delta)
+ *        2-bit byte counts (n - 1) per changed word, 4 per byte,
+ *        then n low bytes of (word ^ previous word) per changed word
+ *
+ * The mask has one bit per 32-bit frame word, in as many u64s as that
+ * takes for the header's frame_size: one up to frame v3, two from v4.
+ *
+ * The header's data_end is updated after every record, so a session that
+ * never reached XPluginStop is still readable up to its last frame. Closing
+ * the recorder seals it: an index of the keyframes is appended, the header
+ * is flagged STRATUS_REC_SEALED and the unused tail is truncated.
+ *
+ * Layout (little-endian):
+ *   [StratusRecHeader, 64 bytes][records ...]
+ *   [StratusRecIndexEntry x index_count]
+ *   (the index starts at index_offset, 8-byte aligned)
+ *
+ * Not available on Windows.
+ */
+
+#ifndef STRATUS_RECORDER_H
+#define STRATUS_RECORDER_H
+
+#include "stratus_frame.h"
+
+#include <stdint.h>
+
+#define STRATUS_REC_DIR "recordings"
+#define STRATUS_REC_MAGIC 0x43525453u /* "STRC" */
+#define STRATUS_REC_VERSION 1
+#define STRATUS_REC_SEALED 0x1
+
+#define STRATUS_REC_KEYFRAME 'K'
+#define STRATUS_REC_DELTA 'D'
+
+#define STRATUS_REC_CHUNK (8u * 1024u * 1024u)
+#define STRATUS_REC_KEYFRAME_NS (10ull * 1000000000ull)
+
+typedef struct StratusRecHeader {
+  uint32_t magic;       /* STRATUS_REC_MAGIC */
+  uint16_t version;     /* STRATUS_REC_VERSION */
+  uint16_t header_size; /* sizeof(StratusRecHeader) */
+  uint32_t frame_size;  /* sizeof(StratusFrame) */
+  uint16_t frame_version; /* STRATUS_FRAME_VERSION */
+  uint16_t flags;         /* STRATUS_REC_SEALED once the index is written */
+  int64_t start_unix_ns;
+  uint64_t start_monotonic_ns;
+  uint64_t data_end;    /* Offset just past the last complete record */
+  uint64_t frame_count; /* Records written */
+  uint64_t index_offset; /* 0 until sealed */
+  uint64_t index_count;
+} StratusRecHeader;
+
+/* One per keyframe, in file order */
+typedef struct StratusRecIndexEntry {
+  uint64_t offset;       /* Of the 'K' record */
+  uint64_t monotonic_ns; /* Capture time of the keyframe */
+  int64_t timestamp;     /* Its frame's Unix time, seconds */
+  uint64_t frame_number; /* Records before it */
+} StratusRecIndexEntry;
+
+_Static_assert(sizeof(StratusRecHeader) == 64,
+               "StratusRecHeader layout changed");
+_Static_assert(sizeof(StratusRecIndexEntry) == 32,
+               "StratusRecIndexEntry layout changed");
+
+/* Start a session file under `data_dir`/recordings (created if missing).
+ * Sim thread, from the plugin's deferred init (first flight-loop tick).
+ * Returns 1 on success. */
+int StratusRecorder_Open(const char *data_dir);
+
+/* Path of the open session file ("" if none) */
+const char *StratusRecorder_Path(void);
+
+/* Append `frame`, captured at `monotonic_ns`. Sim thread; no syscalls. */
+void StratusRecorder_Append(const StratusFrame *frame, uint64_t monotonic_ns);
+
+/* Grow the file ahead of the writer. Call every poll interval from the I/O
+ * thread (or the sim thread while it is not running). */
+void StratusRecorder_Service(void);
+
+/* Seal and close the session. Call once the I/O thread has stopped.
+ * Returns the number of frames dropped because the file could not grow. */
+uint64_t StratusRecorder_Close(void);
+
+#endif /* STRATUS_RECORDER_H */
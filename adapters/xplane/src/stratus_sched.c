@@ -0,0 +1,106 @@
+/*
+ * Stratus ATC - Flight-Loop Task Scheduler
+ *
+ * See stratus_sched.h.
+ */
+
+#include "stratus_sched.h"
+#include "stratus_thread.h"
+
+#include <string.h>
+
+#define IDLE_INTERVAL_S 1.0f /* Nothing enabled: check back once a second */
+
+void StratusSched_Init(StratusSched *s, uint64_t frame_budget_ns) {
+  memset(s, 0, sizeof(*s));
+  s->frame_budget_ns = frame_budget_ns;
+}
+
+int StratusSched_Add(StratusSched *s, const char *name, void (*run)(void),
+                     float period_s, float phase_s, uint64_t budget_ns) {
+  if (s->count >= STRATUS_SCHED_MAX_TASKS)
+    return -1;
+  StratusSchedTask *t = &s->tasks[s->count];
+  memset(t, 0, sizeof(*t));
+  t->name = name;
+  t->run = run;
+  t->period_s = period_s > 0.0f ? period_s : 0.0f;
+  t->phase_s = phase_s > 0.0f ? phase_s : 0.0f;
+  t->budget_ns = budget_ns;
+  t->next_s = s->now_s + t->phase_s;
+  t->last_s = s->now_s;
+  return s->count++;
+}
+
+void StratusSched_SetPeriod(StratusSched *s, int id, float period_s) {
+  if (id < 0 || id >= s->count)
+    return;
+  StratusSchedTask *t = &s->tasks[id];
+  if (period_s < 0.0f)
+    period_s = 0.0f;
+  if (period_s == t->period_s)
+    return;
+  t->period_s = period_s;
+  t->next_s = t->last_s + period_s;
+}
+
+void StratusSched_Kick(StratusSched *s, int id) {
+  if (id >= 0 && id < s->count)
+    s->tasks[id].next_s = s->now_s;
+}
+
+/* A task with a budget may wait for a quieter frame, but not past a period */
+static int MustWait(const StratusSched *s, const StratusSchedTask *t,
+                    uint64_t used_ns) {
+  if (!t->budget_ns || s->now_s - t->next_s >= t->period_s)
+    return 0;
+  return used_ns + t->budget_ns > s->frame_budget_ns;
+}
+
+float StratusSched_Run(StratusSched *s, float elapsed_s) {
+  if (elapsed_s > 0.0f)
+    s->now_s += elapsed_s;
+  uint64_t t0 = StratusMonotonicNs();
+  int waiting = 0;
+
+  for (int i = 0; i < s->count; i++) {
+    StratusSchedTask *t = &s->tasks[i];
+    if (t->period_s <= 0.0f || s->now_s < t->next_s)
+      continue;
+
+    uint64_t start = StratusMonotonicNs();
+    if (MustWait(s, t, start - t0)) {
+      t->deferrals++;
+      waiting = 1;
+      continue;
+    }
+
+    /* Stay on the phase grid; after a stall, restart it from now rather
+     * than running the missed periods back to back. Set before running so
+     * the task can change its own period (StratusSched_SetPeriod). */
+    t->last_s = s->now_s;
+    t->next_s += t->period_s;
+    if (t->next_s <= s->now_s)
+      t->next_s = s->now_s + t->period_s;
+
+    t->run();
+    t->runs++;
+    if (t->budget_ns && StratusMonotonicNs() - start > t->budget_ns)
+      t->overruns++;
+  }
+
+  if (waiting)
+    return -1.0f;
+
+  double next = -1.0;
+  for (int i = 0; i < s->count; i++) {
+    const StratusSchedTask *t = &s->tasks[i];
+    if (t->period_s > 0.0f && (next < 0.0 || t->next_s < next))
+      next = t->next_s;
+  }
+  if (next < 0.0)
+    return IDLE_INTERVAL_S;
+  if (next <= s->now_s)
+    return -1.0f; /* Kicked while running */
+  return (float)(next - s->now_s);
+}
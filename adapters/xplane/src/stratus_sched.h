@@ -0,0 +1,73 @@
+/*
+ * Stratus ATC - Flight-Loop Task Scheduler
+ *
+ * The plugin's sim-thread work is split into tasks, each with its own rate:
+ * telemetry capture at the adaptive telemetry rate, radios and other
+ * slow-moving fields at a few Hz, traffic at about 1 Hz, command apply at
+ * tens of Hz. One flight-loop callback runs whichever tasks are due and
+ * sleeps until the next one is, so nothing runs more often than it needs to.
+ *
+ * A task's phase offsets its first run within its period. Tasks with
+ * different phases land on different frames instead of all piling onto the
+ * frame where their periods line up.
+ *
+ * A task's budget is the time it needs. A task that comes due when less
+ * than its budget is left of the frame's waits for a later frame, so an
+ * expensive task does not stack onto a frame that is already full; it never
+ * waits longer than one period. Tasks with no budget always run when due.
+ *
+ * Time is the sum of the flight-loop intervals X-Plane reports, as passed to
+ * StratusSched_Run, so it stands still when the sim does not call back.
+ * Budgets are measured on the monotonic clock. Sim thread only; no SDK
+ * calls, no allocation.
+ */
+
+#ifndef STRATUS_SCHED_H
+#define STRATUS_SCHED_H
+
+#include <stdint.h>
+
+#define STRATUS_SCHED_MAX_TASKS 8
+
+typedef struct StratusSchedTask {
+  const char *name;
+  void (*run)(void);
+  float period_s;     /* 0 = disabled */
+  float phase_s;      /* First run this far into the schedule */
+  uint64_t budget_ns; /* Time the task needs; 0 = never deferred */
+
+  double next_s; /* Schedule time of the next run */
+  double last_s; /* ... and of the last one */
+  uint64_t runs;
+  uint64_t deferrals; /* Frames it waited for budget */
+  uint64_t overruns;  /* Runs that took longer than budget_ns */
+} StratusSchedTask;
+
+typedef struct StratusSched {
+  StratusSchedTask tasks[STRATUS_SCHED_MAX_TASKS];
+  int count;
+  double now_s;
+  uint64_t frame_budget_ns; /* Shared by the tasks of one callback */
+} StratusSched;
+
+/* Reset `s` with no tasks; `frame_budget_ns` is one callback's allowance */
+void StratusSched_Init(StratusSched *s, uint64_t frame_budget_ns);
+
+/* Add a task; tasks due on the same frame run in the order added. Returns
+ * its id, or -1 when the table is full. */
+int StratusSched_Add(StratusSched *s, const char *name, void (*run)(void),
+                     float period_s, float phase_s, uint64_t budget_ns);
+
+/* Change a task's period (0 disables it). The next run moves to one new
+ * period after the last one, so a faster rate takes effect at once. */
+void StratusSched_SetPeriod(StratusSched *s, int id, float period_s);
+
+/* Make a task due on the next StratusSched_Run */
+void StratusSched_Kick(StratusSched *s, int id);
+
+/* Advance the clock by `elapsed_s` and run every due task. Returns the
+ * flight-loop interval until the next one is due: seconds, or -1 (next
+ * frame) when a task is waiting for budget. */
+float StratusSched_Run(StratusSched *s, float elapsed_s);
+
+#endif /* STRATUS_SCHED_H */
@@ -0,0 +1,403 @@
+/*
+ * Stratus ATC - Local Telemetry Server
+ *
+ * See stratus_server.h.
+ */
+
+#include "stratus_server.h"
+#include "stratus_datarefs.h"
+#include "stratus_delta.h"
+#include "stratus_json.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if IBM
+
+/* Windows: no Unix sockets; the telemetry file is the only channel */
+int StratusServer_Open(const char *socket_path) {
+  (void)socket_path;
+  return 0;
+}
+
+void StratusServer_Close(void) {}
+
+int StratusServer_IsOpen(void) { return 0; }
+
+void StratusServer_Service(void) {}
+
+void StratusServer_Publish(const StratusFrame *frame, uint64_t now_ns) {
+  (void)frame;
+  (void)now_ns;
+}
+
+int StratusServer_Subscribers(void) { return 0; }
+
+uint64_t StratusServer_Dropped(void) { return 0; }
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 /* macOS: SO_NOSIGPIPE is set per socket instead */
+#endif
+
+#define FORMAT_JSON 0
+#define FORMAT_BINARY 1
+
+/* Largest serialized record; a full JSON record is ~1.5 KB */
+#define PAYLOAD_MAX 8192
+
+typedef struct Profile {
+  int format;
+  uint64_t fields;    /* Bit i = g_stratus_fields[i] (JSON only) */
+  uint64_t period_ns; /* 0 = every frame */
+  uint64_t next_ns;
+  int subscribers; /* 0 = free slot */
+} Profile;
+
+typedef struct Client {
+  int fd;      /* -1 = free slot */
+  int profile; /* Index into g_profiles, -1 until the subscribe line */
+  size_t line_len;
+  char line[STRATUS_SERVER_LINE_MAX];
+} Client;
+
+static int g_listen_fd = -1;
+static char g_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static Client g_clients[STRATUS_SERVER_MAX_CLIENTS];
+static Profile g_profiles[STRATUS_SERVER_MAX_CLIENTS];
+static uint64_t g_dropped = 0;
+
+/* One message at a time: length prefix, then the payload */
+static uint8_t g_msg[4 + PAYLOAD_MAX];
+
+static int SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void SetNoSigPipe(int fd) {
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+  (void)fd;
+#endif
+}
+
+int StratusServer_Open(const char *socket_path) {
+  if (g_listen_fd >= 0)
+    return 1;
+
+  struct sockaddr_un addr;
+  if (strlen(socket_path) >= sizeof(addr.sun_path))
+    return 0;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socket_path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return 0;
+  /* A socket file left by a session that crashed */
+  unlink(socket_path);
+  if (!SetNonBlocking(fd) ||
+      bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return 0;
+  }
+  chmod(socket_path, 0600);
+  if (listen(fd, STRATUS_SERVER_MAX_CLIENTS) != 0) {
+    close(fd);
+    unlink(socket_path);
+    return 0;
+  }
+
+  for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS; i++) {
+    g_clients[i].fd = -1;
+    g_clients[i].profile = -1;
+  }
+  memset(g_profiles, 0, sizeof(g_profiles));
+  g_dropped = 0;
+  strcpy(g_path, socket_path);
+  g_listen_fd = fd;
+  return 1;
+}
+
+static void DropClient(Client *c) {
+  if (c->profile >= 0)
+    g_profiles[c->profile].subscribers--;
+  close(c->fd);
+  c->fd = -1;
+  c->profile = -1;
+}
+
+void StratusServer_Close(void) {
+  if (g_listen_fd < 0)
+    return;
+  for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS; i++) {
+    if (g_clients[i].fd >= 0)
+      DropClient(&g_clients[i]);
+  }
+  close(g_listen_fd);
+  g_listen_fd = -1;
+  unlink(g_path);
+}
+
+int StratusServer_IsOpen(void) { return g_listen_fd >= 0; }
+
+/* ============================================================================
+ * Subscriptions
+ * ============================================================================
+ */
+
+/* Select every field `name` refers to: a section, a top-level key or one
+ * "section.key". Returns 0 if it matches none. */
+static int SelectFields(const char *name, size_t len, uint64_t *fields) {
+  int matched = 0;
+  for (size_t i = 0; i < g_stratus_field_count && i < 64; i++) {
+    const StratusField *f = &g_stratus_fields[i];
+    const char *group = f->section ? f->section : f->key;
+    size_t group_len = strlen(group);
+    int match = len == group_len && memcmp(name, group, len) == 0;
+    if (!match && f->section && len > group_len + 1 && name[group_len] == '.')
+      match = memcmp(name, group, group_len) == 0 &&
+              strlen(f->key) == len - group_len - 1 &&
+              memcmp(name + group_len + 1, f->key, len - group_len - 1) == 0;
+    if (match) {
+      *fields |= 1ull << i;
+      matched = 1;
+    }
+  }
+  return matched;
+}
+
+/* Parse a subscribe line (NUL-terminated, no newline) into `p`. Returns 1 on
+ * success. */
+static int ParseSubscription(char *line, Profile *p) {
+  memset(p, 0, sizeof(*p));
+  p->format = FORMAT_JSON;
+  p->fields = UINT64_MAX;
+
+  char *save = NULL;
+  for (char *tok = strtok_r(line, " \t\r", &save); tok;
+       tok = strtok_r(NULL, " \t\r", &save)) {
+    char *value = strchr(tok, '=');
+    if (!value)
+      return 0;
+    *value++ = '\0';
+
+    if (strcmp(tok, "format") == 0) {
+      if (strcmp(value, "json") == 0)
+        p->format = FORMAT_JSON;
+      else if (strcmp(value, "binary") == 0)
+        p->format = FORMAT_BINARY;
+      else
+        return 0;
+    } else if (strcmp(tok, "rate") == 0) {
+      double hz;
+      if (!StratusJson_ParseDouble(value, &hz) || !(hz >= 0.0))
+        return 0;
+      p->period_ns = hz > 0.0 ? (uint64_t)(1e9 / hz) : 0;
+    } else if (strcmp(tok, "fields") == 0) {
+      p->fields = 0;
+      for (const char *name = value; *name;) {
+        size_t len = strcspn(name, ",");
+        if (len == 0 || !SelectFields(name, len, &p->fields))
+          return 0;
+        name += len;
+        if (*name == ',')
+          name++;
+      }
+    } else {
+      return 0;
+    }
+  }
+
+  /* Binary frames are always whole */
+  if (p->format == FORMAT_BINARY)
+    p->fields = UINT64_MAX;
+  return 1;
+}
+
+/* Profile matching `want`, sharing an existing one when possible. Returns -1
+ * if every slot is taken. */
+static int Subscribe(const Profile *want) {
+  int free_slot = -1;
+  for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS; i++) {
+    Profile *p = &g_profiles[i];
+    if (!p->subscribers) {
+      if (free_slot < 0)
+        free_slot = i;
+    } else if (p->format == want->format && p->fields == want->fields &&
+               p->period_ns == want->period_ns) {
+      p->subscribers++;
+      return i;
+    }
+  }
+  if (free_slot >= 0) {
+    g_profiles[free_slot] = *want;
+    g_profiles[free_slot].subscribers = 1;
+  }
+  return free_slot;
+}
+
+static int WouldBlock(void) {
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+static void ReadSubscription(Client *c) {
+  ssize_t n =
+      recv(c->fd, c->line + c->line_len, sizeof(c->line) - 1 - c->line_len, 0);
+  if (n == 0 || (n < 0 && !WouldBlock())) {
+    DropClient(c);
+    return;
+  }
+  if (n < 0)
+    return;
+  c->line_len += (size_t)n;
+  c->line[c->line_len] = '\0';
+
+  char *newline = strchr(c->line, '\n');
+  if (!newline) {
+    if (c->line_len >= sizeof(c->line) - 1)
+      DropClient(c); /* Too long to be a subscribe line */
+    return;
+  }
+  *newline = '\0';
+
+  Profile want;
+  if (!ParseSubscription(c->line, &want) || (c->profile = Subscribe(&want)) < 0)
+    DropClient(c);
+}
+
+/* Subscribers never send after the subscribe line; reading only notices
+ * when they hang up (and discards anything else) */
+static void CheckHangUp(Client *c) {
+  char buf[64];
+  ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+  if (n == 0 || (n < 0 && !WouldBlock()))
+    DropClient(c);
+}
+
+void StratusServer_Service(void) {
+  if (g_listen_fd < 0)
+    return;
+
+  for (;;) {
+    int fd = accept(g_listen_fd, NULL, NULL);
+    if (fd < 0)
+      break;
+    Client *c = NULL;
+    for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS && !c; i++) {
+      if (g_clients[i].fd < 0)
+        c = &g_clients[i];
+    }
+    if (!c || !SetNonBlocking(fd)) {
+      close(fd);
+      continue;
+    }
+    SetNoSigPipe(fd);
+    c->fd = fd;
+    c->profile = -1;
+    c->line_len = 0;
+  }
+
+  for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS; i++) {
+    Client *c = &g_clients[i];
+    if (c->fd < 0)
+      continue;
+    if (c->profile < 0)
+      ReadSubscription(c);
+    else
+      CheckHangUp(c);
+  }
+}
+
+/* ============================================================================
+ * Publishing
+ * ============================================================================
+ */
+
+/* A frame up to a tenth of a period early still counts, so a 5 Hz
+ * subscriber of a 10 Hz stream is not pushed to every third frame by
+ * scheduling jitter */
+static int Due(Profile *p, uint64_t now_ns) {
+  if (!p->period_ns)
+    return 1;
+  if (now_ns + p->period_ns / 10 < p->next_ns)
+    return 0;
+  if (p->next_ns + p->period_ns > now_ns)
+    p->next_ns += p->period_ns;
+  else
+    p->next_ns = now_ns + p->period_ns; /* Fell behind; do not burst */
+  return 1;
+}
+
+/* Serialize `frame` for `p` into g_msg. Returns the message length, prefix
+ * included, or 0 if it did not fit. */
+static size_t Serialize(const Profile *p, const StratusFrame *frame) {
+  size_t len;
+  if (p->format == FORMAT_BINARY) {
+    len = StratusFrame_Encode(frame, g_msg + 4, PAYLOAD_MAX);
+  } else {
+    len = StratusDelta_WriteJSONFields((char *)g_msg + 4, PAYLOAD_MAX, frame,
+                                       p->fields);
+  }
+  if (!len)
+    return 0;
+  g_msg[0] = (uint8_t)len;
+  g_msg[1] = (uint8_t)(len >> 8);
+  g_msg[2] = (uint8_t)(len >> 16);
+  g_msg[3] = (uint8_t)(len >> 24);
+  return 4 + len;
+}
+
+static void Send(Client *c, size_t len) {
+  ssize_t n = send(c->fd, g_msg, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+  if (n == (ssize_t)len)
+    return;
+  if (n < 0 && WouldBlock())
+    g_dropped++;
+  else
+    DropClient(c); /* Gone, or half a message: the stream is out of sync */
+}
+
+void StratusServer_Publish(const StratusFrame *frame, uint64_t now_ns) {
+  if (g_listen_fd < 0)
+    return;
+
+  for (int p = 0; p < STRATUS_SERVER_MAX_CLIENTS; p++) {
+    Profile *profile = &g_profiles[p];
+    /* Events go to everyone at once, whatever their rate */
+    if (!profile->subscribers || (!frame->events && !Due(profile, now_ns)))
+      continue;
+    size_t len = Serialize(profile, frame);
+    if (!len)
+      continue;
+    for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS; i++) {
+      if (g_clients[i].fd >= 0 && g_clients[i].profile == p)
+        Send(&g_clients[i], len);
+    }
+  }
+}
+
+int StratusServer_Subscribers(void) {
+  int n = 0;
+  for (int i = 0; i < STRATUS_SERVER_MAX_CLIENTS; i++) {
+    if (g_clients[i].fd >= 0 && g_clients[i].profile >= 0)
+      n++;
+  }
+  return n;
+}
+
+uint64_t StratusServer_Dropped(void) { return g_dropped; }
+
+#endif
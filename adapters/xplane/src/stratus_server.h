@@ -0,0 +1,72 @@
+/*
+ * Stratus ATC - Local Telemetry Server
+ *
+ * Optional publish/subscribe endpoint (`server = on`) for tools on the same
+ * machine, so N consumers do not each watch and parse the telemetry file.
+ * The plugin listens on a Unix stream socket, stratus_telemetry.sock in the
+ * data directory. A subscriber connects and sends one line:
+ *
+ *   format=json|binary rate=<hz> fields=<name>[,<name>...]\n
+ *
+ * Every key is optional: format defaults to json, rate to every frame the
+ * plugin captures (the plugin's own rate is the ceiling), fields to all.
+ * Frames with events (stratus_events.h) go to every subscriber, due or not.
+ * A field name is a JSON section ("position", "radios", ...), a top-level
+ * key ("aircraft") or one "section.key" ("radios.com1_hz"). Binary frames
+ * always carry the whole StratusFrame. A line the server cannot parse closes
+ * the connection.
+ *
+ * Subscribers asking for the same format, rate and fields share a profile:
+ * each frame is serialized once per profile and the same bytes are sent to
+ * every subscriber in it. Each message on the stream is
+ *
+ *   u32 length (little-endian), then `length` bytes of payload
+ *
+ * where the payload is one JSON record (the full-record format of
+ * stratus_telemetry.json, restricted to the chosen fields) or a
+ * StratusFrameHeader + StratusFrame, as in stratus_telemetry.bin.
+ *
+ * Sends never block. A subscriber whose socket buffer is full misses that
+ * frame (counted in StratusServer_Dropped); one that would receive half a
+ * message is disconnected, since the stream could not be resynchronised.
+ *
+ * All calls are made from one thread: the I/O thread, or the sim thread
+ * when it is not running. Not available on Windows.
+ */
+
+#ifndef STRATUS_SERVER_H
+#define STRATUS_SERVER_H
+
+#include "stratus_frame.h"
+
+#include <stdint.h>
+
+#define STRATUS_SERVER_SOCKET "stratus_telemetry.sock"
+#define STRATUS_SERVER_MAX_CLIENTS 16
+#define STRATUS_SERVER_LINE_MAX 256
+
+/* Listen on `socket_path`, replacing a stale socket file. Returns 1 on
+ * success. */
+int StratusServer_Open(const char *socket_path);
+
+/* Disconnect every subscriber and remove the socket. */
+void StratusServer_Close(void);
+
+/* 1 while listening */
+int StratusServer_IsOpen(void);
+
+/* Accept new subscribers, read subscribe lines and notice hang-ups. Call at
+ * least once per poll interval. */
+void StratusServer_Service(void);
+
+/* Send `frame` to every subscriber whose rate makes it due at `now_ns`
+ * (CLOCK_MONOTONIC), or to all of them if it has events. */
+void StratusServer_Publish(const StratusFrame *frame, uint64_t now_ns);
+
+/* Subscribers currently receiving frames */
+int StratusServer_Subscribers(void);
+
+/* Frames not sent to a subscriber because its socket was full */
+uint64_t StratusServer_Dropped(void);
+
+#endif /* STRATUS_SERVER_H */
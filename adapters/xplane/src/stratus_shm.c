@@ -0,0 +1,104 @@
+/*
+ * Stratus ATC - Shared-Memory Telemetry Ring
+ *
+ * See stratus_shm.h for the layout and the reader protocol.
+ */
+
+#include "stratus_shm.h"
+
+#include <string.h>
+
+#if !IBM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define SHM_SIZE                                                               \
+  (sizeof(StratusShmHeader) + STRATUS_SHM_SLOTS * sizeof(StratusShmSlot))
+
+static StratusShmHeader *g_shm = NULL;
+static StratusShmSlot *g_slots = NULL;
+
+#if IBM
+
+/* Windows: no POSIX shm; callers fall back to the JSON file transport */
+int StratusShm_Open(void) { return 0; }
+void StratusShm_Close(void) {}
+
+#else
+
+int StratusShm_Open(void) {
+  if (g_shm)
+    return 1;
+
+  /* Start from a fresh segment so stale readers see a new mapping */
+  shm_unlink(STRATUS_SHM_NAME);
+
+  int fd = shm_open(STRATUS_SHM_NAME, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return 0;
+
+  if (ftruncate(fd, (off_t)SHM_SIZE) != 0) {
+    close(fd);
+    shm_unlink(STRATUS_SHM_NAME);
+    return 0;
+  }
+
+  void *base =
+      mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); /* The mapping keeps the segment alive */
+  if (base == MAP_FAILED) {
+    shm_unlink(STRATUS_SHM_NAME);
+    return 0;
+  }
+
+  memset(base, 0, SHM_SIZE);
+  g_shm = (StratusShmHeader *)base;
+  g_slots = (StratusShmSlot *)((char *)base + sizeof(StratusShmHeader));
+
+  g_shm->version = STRATUS_FRAME_VERSION;
+  g_shm->slot_count = STRATUS_SHM_SLOTS;
+  g_shm->slot_size = (uint32_t)sizeof(StratusShmSlot);
+  g_shm->frame_size = (uint32_t)sizeof(StratusFrame);
+  atomic_store_explicit(&g_shm->generation, 0, memory_order_relaxed);
+
+  /* Magic last: readers only trust the header once it is set */
+  atomic_thread_fence(memory_order_release);
+  g_shm->magic = STRATUS_SHM_MAGIC;
+  return 1;
+}
+
+void StratusShm_Close(void) {
+  if (!g_shm)
+    return;
+
+  /* Tell attached readers to drop the mapping and re-open later */
+  g_shm->magic = 0;
+  atomic_thread_fence(memory_order_release);
+
+  munmap(g_shm, SHM_SIZE);
+  shm_unlink(STRATUS_SHM_NAME);
+  g_shm = NULL;
+  g_slots = NULL;
+}
+
+#endif
+
+void StratusShm_Publish(const StratusFrame *frame) {
+  if (!g_shm)
+    return;
+
+  uint64_t gen = atomic_load_explicit(&g_shm->generation, memory_order_relaxed);
+  StratusShmSlot *slot = &g_slots[gen % STRATUS_SHM_SLOTS];
+
+  /* Seqlock write: odd sequence, payload, even sequence */
+  uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+  atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  memcpy(&slot->frame, frame, sizeof(StratusFrame));
+
+  atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+  atomic_store_explicit(&g_shm->generation, gen + 1, memory_order_release);
+}
@@ -0,0 +1,59 @@
+/*
+ * Stratus ATC - Shared-Memory Telemetry Ring
+ *
+ * A POSIX shared-memory segment holding a small ring of StratusFrame slots.
+ * Each slot is guarded by a seqlock-style counter (odd = write in progress),
+ * and the header carries a generation counter equal to the number of frames
+ * published so far. Readers pick slot (generation - 1) % slot_count and retry
+ * if the slot sequence changed underneath them.
+ *
+ * The segment is created once at startup; publishing a frame is a handful of
+ * stores and a memcpy, with no syscalls.
+ *
+ * Layout (little-endian, mirrored in stratus-core/src/shm.rs):
+ *   [StratusShmHeader, 64 bytes][StratusShmSlot x slot_count]
+ */
+
+#ifndef STRATUS_SHM_H
+#define STRATUS_SHM_H
+
+#include "stratus_frame.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define STRATUS_SHM_NAME "/stratus_telemetry"
+#define STRATUS_SHM_MAGIC 0x48535453u /* "STSH" */
+#define STRATUS_SHM_SLOTS 8
+
+typedef struct StratusShmHeader {
+  uint32_t magic;     /* STRATUS_SHM_MAGIC while the writer is alive */
+  uint16_t version;   /* STRATUS_FRAME_VERSION */
+  uint16_t slot_count;
+  uint32_t slot_size;  /* sizeof(StratusShmSlot) */
+  uint32_t frame_size; /* sizeof(StratusFrame) */
+  _Atomic uint64_t generation; /* Frames published so far */
+  uint8_t _reserved[40];
+} StratusShmHeader;
+
+typedef struct StratusShmSlot {
+  _Atomic uint32_t seq; /* Odd while the slot is being written */
+  uint32_t _pad0;
+  StratusFrame frame;
+} StratusShmSlot;
+
+_Static_assert(sizeof(StratusShmHeader) == 64,
+               "StratusShmHeader layout changed");
+_Static_assert(sizeof(StratusShmSlot) == 320, "StratusShmSlot layout changed");
+
+/* Create (or re-create) and map the telemetry segment. Returns 1 on success. */
+int StratusShm_Open(void);
+
+/* Mark the segment as closed for readers, unmap and unlink it. */
+void StratusShm_Close(void);
+
+/* Publish one frame into the next ring slot. No-op if the segment is not
+ * open. */
+void StratusShm_Publish(const StratusFrame *frame);
+
+#endif /* STRATUS_SHM_H */
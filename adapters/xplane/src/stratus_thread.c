@@ -0,0 +1,121 @@
+/*
+ * Stratus ATC - Thread and Wakeup Primitives
+ *
+ * See stratus_thread.h.
+ */
+
+#include "stratus_thread.h"
+
+#include <time.h>
+
+#if !IBM && !APL
+#include <errno.h>
+#endif
+
+#if IBM
+
+static DWORD WINAPI ThreadTrampoline(LPVOID p) {
+  StratusThread *t = (StratusThread *)p;
+  t->main(t->arg);
+  return 0;
+}
+
+int StratusThread_Start(StratusThread *t, void (*main)(void *arg), void *arg) {
+  t->main = main;
+  t->arg = arg;
+  t->handle = CreateThread(NULL, 0, ThreadTrampoline, t, 0, NULL);
+  return t->handle != NULL;
+}
+
+void StratusThread_Join(StratusThread *t) {
+  WaitForSingleObject(t->handle, INFINITE);
+  CloseHandle(t->handle);
+  t->handle = NULL;
+}
+
+int StratusWake_Init(StratusWake *w) {
+  w->sem = CreateSemaphoreA(NULL, 0, LONG_MAX, NULL);
+  return w->sem != NULL;
+}
+void StratusWake_Destroy(StratusWake *w) {
+  CloseHandle(w->sem);
+  w->sem = NULL;
+}
+void StratusWake_Post(StratusWake *w) { ReleaseSemaphore(w->sem, 1, NULL); }
+void StratusWake_Wait(StratusWake *w, unsigned ms) {
+  WaitForSingleObject(w->sem, ms);
+}
+
+uint64_t StratusMonotonicMs(void) { return (uint64_t)GetTickCount64(); }
+
+uint64_t StratusMonotonicNs(void) {
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER count;
+  if (!freq.QuadPart)
+    QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  uint64_t f = (uint64_t)freq.QuadPart, c = (uint64_t)count.QuadPart;
+  return c / f * 1000000000u + c % f * 1000000000u / f;
+}
+
+#else
+
+static void *ThreadTrampoline(void *p) {
+  StratusThread *t = (StratusThread *)p;
+  t->main(t->arg);
+  return NULL;
+}
+
+int StratusThread_Start(StratusThread *t, void (*main)(void *arg), void *arg) {
+  t->main = main;
+  t->arg = arg;
+  return pthread_create(&t->handle, NULL, ThreadTrampoline, t) == 0;
+}
+
+void StratusThread_Join(StratusThread *t) { pthread_join(t->handle, NULL); }
+
+#if APL
+int StratusWake_Init(StratusWake *w) {
+  w->sem = dispatch_semaphore_create(0);
+  return w->sem != NULL;
+}
+void StratusWake_Destroy(StratusWake *w) {
+  dispatch_release(w->sem);
+  w->sem = NULL;
+}
+void StratusWake_Post(StratusWake *w) { dispatch_semaphore_signal(w->sem); }
+void StratusWake_Wait(StratusWake *w, unsigned ms) {
+  dispatch_semaphore_wait(
+      w->sem, dispatch_time(DISPATCH_TIME_NOW, (int64_t)ms * NSEC_PER_MSEC));
+}
+#else
+int StratusWake_Init(StratusWake *w) { return sem_init(&w->sem, 0, 0) == 0; }
+void StratusWake_Destroy(StratusWake *w) { sem_destroy(&w->sem); }
+void StratusWake_Post(StratusWake *w) { sem_post(&w->sem); }
+void StratusWake_Wait(StratusWake *w, unsigned ms) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += ms / 1000;
+  ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+  if (ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+  }
+  while (sem_timedwait(&w->sem, &ts) != 0 && errno == EINTR) {
+  }
+}
+#endif
+
+uint64_t StratusMonotonicMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+uint64_t StratusMonotonicNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif
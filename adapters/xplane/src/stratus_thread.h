@@ -0,0 +1,65 @@
+/*
+ * Stratus ATC - Thread and Wakeup Primitives
+ *
+ * The small amount of platform threading the background workers need: a
+ * thread that can be joined, a counting semaphore with a timed wait, and
+ * a monotonic clock. Shared by the I/O thread (stratus_io.h)
+ * and the log writer (stratus_log.h).
+ */
+
+#ifndef STRATUS_THREAD_H
+#define STRATUS_THREAD_H
+
+#include <stdint.h>
+
+#if IBM
+#include <windows.h>
+#elif APL
+#include <dispatch/dispatch.h>
+#include <pthread.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+typedef struct StratusThread {
+#if IBM
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif
+  void (*main)(void *arg);
+  void *arg;
+} StratusThread;
+
+typedef struct StratusWake {
+#if IBM
+  HANDLE sem;
+#elif APL
+  dispatch_semaphore_t sem;
+#else
+  sem_t sem;
+#endif
+} StratusWake;
+
+/* Run `main(arg)` on a new thread. Returns 1 on success. */
+int StratusThread_Start(StratusThread *t, void (*main)(void *arg), void *arg);
+
+/* Wait for the thread to return. */
+void StratusThread_Join(StratusThread *t);
+
+/* Returns 1 on success. */
+int StratusWake_Init(StratusWake *w);
+void StratusWake_Destroy(StratusWake *w);
+
+/* Wake one waiter (or the next one to wait). Never blocks. */
+void StratusWake_Post(StratusWake *w);
+
+/* Block until posted or `ms` elapse. */
+void StratusWake_Wait(StratusWake *w, unsigned ms);
+
+/* Milliseconds / nanoseconds on a clock that never jumps */
+uint64_t StratusMonotonicMs(void);
+uint64_t StratusMonotonicNs(void);
+
+#endif /* STRATUS_THREAD_H */
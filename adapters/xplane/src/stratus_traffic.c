@@ -0,0 +1,278 @@
+/*
+ * Stratus ATC - Traffic Snapshot
+ *
+ * See stratus_traffic.h.
+ */
+
+#include "stratus_traffic.h"
+#include "stratus_json.h"
+
+#include "XPLMDataAccess.h"
+#include "XPLMPlanes.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define MPS_TO_FPM 196.850394
+#define TCAS_SLOTS (STRATUS_TRAFFIC_MAX + 1) /* Slot 0 is the user */
+#define TCAS_NAME_LEN 8                      /* Bytes per slot in name arrays */
+#define MULTIPLAYER_MAX 19
+
+static StratusTrafficSource g_source = STRATUS_TRAFFIC_NONE;
+static uint64_t g_seq = 0;
+
+/* ============================================================================
+ * X-Plane 12 TCAS targets
+ * ============================================================================
+ */
+
+enum {
+  TCAS_LAT,
+  TCAS_LON,
+  TCAS_ELE,
+  TCAS_PSI,
+  TCAS_VX,
+  TCAS_VY,
+  TCAS_VZ,
+  TCAS_FLOAT_COUNT
+};
+
+static const char *const kTcasFloats[TCAS_FLOAT_COUNT] = {
+    "sim/cockpit2/tcas/targets/position/lat",
+    "sim/cockpit2/tcas/targets/position/lon",
+    "sim/cockpit2/tcas/targets/position/ele",
+    "sim/cockpit2/tcas/targets/position/psi",
+    "sim/cockpit2/tcas/targets/position/vx",
+    "sim/cockpit2/tcas/targets/position/vy",
+    "sim/cockpit2/tcas/targets/position/vz"};
+
+static XPLMDataRef g_tcas_count;
+static XPLMDataRef g_tcas_float[TCAS_FLOAT_COUNT];
+static XPLMDataRef g_tcas_mode_s;
+static XPLMDataRef g_tcas_on_ground;
+static XPLMDataRef g_tcas_flight_id;
+static XPLMDataRef g_tcas_icao_type;
+
+static int InitTcas(void) {
+  g_tcas_count = XPLMFindDataRef("sim/cockpit2/tcas/indicators/tcas_num_acf");
+  for (int i = 0; i < TCAS_FLOAT_COUNT; i++) {
+    g_tcas_float[i] = XPLMFindDataRef(kTcasFloats[i]);
+    if (!g_tcas_float[i] ||
+        !(XPLMGetDataRefTypes(g_tcas_float[i]) & xplmType_FloatArray))
+      return 0;
+  }
+  if (!g_tcas_count)
+    return 0;
+  g_tcas_mode_s = XPLMFindDataRef("sim/cockpit2/tcas/targets/modeS_id");
+  g_tcas_on_ground =
+      XPLMFindDataRef("sim/cockpit2/tcas/targets/position/weight_on_wheels");
+  g_tcas_flight_id = XPLMFindDataRef("sim/cockpit2/tcas/targets/flight_id");
+  g_tcas_icao_type = XPLMFindDataRef("sim/cockpit2/tcas/targets/icao_type");
+  return 1;
+}
+
+/* Slot i's fixed-width name out of a byte array of all slots */
+static void CopyName(char *out, const char *names, int i) {
+  memcpy(out, names + (size_t)i * TCAS_NAME_LEN, TCAS_NAME_LEN);
+  out[TCAS_NAME_LEN] = '\0';
+}
+
+static void CaptureTcas(StratusTraffic *t) {
+  int slots = XPLMGetDatai(g_tcas_count);
+  if (slots > TCAS_SLOTS)
+    slots = TCAS_SLOTS;
+  int n = slots - 1;
+  if (n <= 0)
+    return;
+
+  /* One range read per attribute, from slot 1 (slot 0 is the user) */
+  static float values[TCAS_FLOAT_COUNT][STRATUS_TRAFFIC_MAX];
+  static int mode_s[STRATUS_TRAFFIC_MAX];
+  static int on_ground[STRATUS_TRAFFIC_MAX];
+  static char flight_id[STRATUS_TRAFFIC_MAX * TCAS_NAME_LEN];
+  static char icao_type[STRATUS_TRAFFIC_MAX * TCAS_NAME_LEN];
+  for (int a = 0; a < TCAS_FLOAT_COUNT; a++)
+    XPLMGetDatavf(g_tcas_float[a], values[a], 1, n);
+  memset(mode_s, 0, sizeof(mode_s));
+  memset(on_ground, 0, sizeof(on_ground));
+  memset(flight_id, 0, sizeof(flight_id));
+  memset(icao_type, 0, sizeof(icao_type));
+  if (g_tcas_mode_s)
+    XPLMGetDatavi(g_tcas_mode_s, mode_s, 1, n);
+  if (g_tcas_on_ground)
+    XPLMGetDatavi(g_tcas_on_ground, on_ground, 1, n);
+  if (g_tcas_flight_id)
+    XPLMGetDatab(g_tcas_flight_id, flight_id, TCAS_NAME_LEN,
+                 n * TCAS_NAME_LEN);
+  if (g_tcas_icao_type)
+    XPLMGetDatab(g_tcas_icao_type, icao_type, TCAS_NAME_LEN,
+                 n * TCAS_NAME_LEN);
+
+  for (int i = 0; i < n; i++) {
+    /* Empty slots read as all zeros */
+    if (values[TCAS_LAT][i] == 0.0f && values[TCAS_LON][i] == 0.0f)
+      continue;
+    StratusTrafficTarget *tg = &t->targets[t->count++];
+    tg->id = (uint16_t)(i + 1);
+    tg->latitude = values[TCAS_LAT][i];
+    tg->longitude = values[TCAS_LON][i];
+    tg->altitude_msl_m = values[TCAS_ELE][i];
+    tg->heading_true = values[TCAS_PSI][i];
+    tg->ground_speed_mps = hypotf(values[TCAS_VX][i], values[TCAS_VZ][i]);
+    tg->vertical_speed_fpm = (float)(values[TCAS_VY][i] * MPS_TO_FPM);
+    tg->mode_s = (uint32_t)mode_s[i] & 0xFFFFFFu;
+    tg->on_ground = on_ground[i] != 0;
+    CopyName(tg->callsign, flight_id, i);
+    CopyName(tg->icao_type, icao_type, i);
+  }
+}
+
+/* ============================================================================
+ * X-Plane 11 multiplayer planes
+ * ============================================================================
+ */
+
+typedef struct MultiplayerRefs {
+  XPLMDataRef lat, lon, el, psi, vx, vy, vz;
+} MultiplayerRefs;
+
+static MultiplayerRefs g_mp[MULTIPLAYER_MAX];
+
+static XPLMDataRef FindPlaneRef(int plane, const char *attr) {
+  char name[64];
+  snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_%s", plane,
+           attr);
+  return XPLMFindDataRef(name);
+}
+
+static int InitMultiplayer(void) {
+  for (int i = 0; i < MULTIPLAYER_MAX; i++) {
+    MultiplayerRefs *r = &g_mp[i];
+    r->lat = FindPlaneRef(i + 1, "lat");
+    r->lon = FindPlaneRef(i + 1, "lon");
+    r->el = FindPlaneRef(i + 1, "el");
+    r->psi = FindPlaneRef(i + 1, "psi");
+    r->vx = FindPlaneRef(i + 1, "v_x");
+    r->vy = FindPlaneRef(i + 1, "v_y");
+    r->vz = FindPlaneRef(i + 1, "v_z");
+    if (!r->lat || !r->lon || !r->el || !r->psi || !r->vx || !r->vy || !r->vz)
+      return 0;
+  }
+  return 1;
+}
+
+static void CaptureMultiplayer(StratusTraffic *t) {
+  int total = 0, active = 0;
+  XPLMPluginID controller;
+  XPLMCountAircraft(&total, &active, &controller);
+  int n = active - 1; /* Aircraft 0 is the user */
+  if (n > MULTIPLAYER_MAX)
+    n = MULTIPLAYER_MAX;
+
+  for (int i = 0; i < n; i++) {
+    const MultiplayerRefs *r = &g_mp[i];
+    StratusTrafficTarget *tg = &t->targets[t->count++];
+    tg->id = (uint16_t)(i + 1);
+    tg->latitude = XPLMGetDatad(r->lat);
+    tg->longitude = XPLMGetDatad(r->lon);
+    tg->altitude_msl_m = (float)XPLMGetDatad(r->el);
+    tg->heading_true = XPLMGetDataf(r->psi);
+    float vx = XPLMGetDataf(r->vx);
+    float vz = XPLMGetDataf(r->vz);
+    tg->ground_speed_mps = hypotf(vx, vz);
+    tg->vertical_speed_fpm = (float)(XPLMGetDataf(r->vy) * MPS_TO_FPM);
+  }
+}
+
+/* ============================================================================
+ * Snapshot
+ * ============================================================================
+ */
+
+StratusTrafficSource StratusTraffic_Init(void) {
+  if (InitTcas())
+    g_source = STRATUS_TRAFFIC_TCAS;
+  else if (InitMultiplayer())
+    g_source = STRATUS_TRAFFIC_MULTIPLAYER;
+  else
+    g_source = STRATUS_TRAFFIC_NONE;
+  return g_source;
+}
+
+void StratusTraffic_Capture(StratusTraffic *t, uint64_t now_ns) {
+  t->seq = ++g_seq;
+  t->timestamp = (int64_t)time(NULL);
+  t->monotonic_ns = now_ns;
+  t->source = g_source;
+  t->count = 0;
+
+  switch (g_source) {
+  case STRATUS_TRAFFIC_TCAS:
+    CaptureTcas(t);
+    break;
+  case STRATUS_TRAFFIC_MULTIPLAYER:
+    CaptureMultiplayer(t);
+    break;
+  case STRATUS_TRAFFIC_NONE:
+    break;
+  }
+}
+
+static const char *SourceName(StratusTrafficSource source) {
+  switch (source) {
+  case STRATUS_TRAFFIC_TCAS:
+    return "tcas";
+  case STRATUS_TRAFFIC_MULTIPLAYER:
+    return "multiplayer";
+  case STRATUS_TRAFFIC_NONE:
+    break;
+  }
+  return "none";
+}
+
+size_t StratusTraffic_WriteJSON(char *out, size_t cap,
+                                const StratusTraffic *t) {
+  StratusJsonBuf b;
+  StratusJson_Init(&b, out, cap);
+  StratusJson_Raw(&b, "{\n  \"seq\": ");
+  StratusJson_Uint(&b, t->seq);
+  StratusJson_Raw(&b, ",\n  \"timestamp\": ");
+  StratusJson_Int(&b, t->timestamp);
+  StratusJson_Raw(&b, ",\n  \"monotonic_ns\": ");
+  StratusJson_Uint(&b, t->monotonic_ns);
+  StratusJson_Raw(&b, ",\n  \"source\": ");
+  StratusJson_String(&b, SourceName(t->source));
+  StratusJson_Raw(&b, ",\n  \"targets\": [");
+
+  /* One line per target keeps a 63-aircraft snapshot readable */
+  for (int i = 0; i < t->count; i++) {
+    const StratusTrafficTarget *tg = &t->targets[i];
+    StratusJson_Raw(&b, i ? ",\n    {\"id\": " : "\n    {\"id\": ");
+    StratusJson_Uint(&b, tg->id);
+    StratusJson_Raw(&b, ", \"mode_s\": ");
+    StratusJson_Uint(&b, tg->mode_s);
+    StratusJson_Raw(&b, ", \"callsign\": ");
+    StratusJson_String(&b, tg->callsign);
+    StratusJson_Raw(&b, ", \"icao_type\": ");
+    StratusJson_String(&b, tg->icao_type);
+    StratusJson_Raw(&b, ", \"latitude\": ");
+    StratusJson_Fixed(&b, tg->latitude, 6);
+    StratusJson_Raw(&b, ", \"longitude\": ");
+    StratusJson_Fixed(&b, tg->longitude, 6);
+    StratusJson_Raw(&b, ", \"altitude_msl_m\": ");
+    StratusJson_Fixed(&b, tg->altitude_msl_m, 1);
+    StratusJson_Raw(&b, ", \"heading_true\": ");
+    StratusJson_Fixed(&b, tg->heading_true, 1);
+    StratusJson_Raw(&b, ", \"ground_speed_mps\": ");
+    StratusJson_Fixed(&b, tg->ground_speed_mps, 1);
+    StratusJson_Raw(&b, ", \"vertical_speed_fpm\": ");
+    StratusJson_Fixed(&b, tg->vertical_speed_fpm, 0);
+    StratusJson_Raw(&b, ", \"on_ground\": ");
+    StratusJson_Bool(&b, tg->on_ground);
+    StratusJson_Char(&b, '}');
+  }
+  StratusJson_Raw(&b, t->count ? "\n  ]\n}\n" : "]\n}\n");
+  return StratusJson_Finish(&b);
+}
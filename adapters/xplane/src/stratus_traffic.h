@@ -0,0 +1,74 @@
+/*
+ * Stratus ATC - Traffic Snapshot
+ *
+ * Positions of the other aircraft in the sim (AI, multiplayer, plugin
+ * traffic such as online networks), captured at a low rate and written to
+ * `stratus_traffic.json` for the client's traffic index.
+ *
+ * Two sources, chosen once at init:
+ *   - X-Plane 12 TCAS target arrays (sim/cockpit2/tcas/targets/...): up to
+ *     63 targets besides the user, each attribute read for all targets in
+ *     one XPLMGetDatavf/XPLMGetDatavi/XPLMGetDatab range call.
+ *   - X-Plane 11 per-plane DataRefs (sim/multiplayer/position/planeN_*),
+ *     up to 19 targets, no callsign, type or Mode S address.
+ *
+ * A target's `id` is its slot in the source, stable while that aircraft
+ * stays loaded.
+ */
+
+#ifndef STRATUS_TRAFFIC_H
+#define STRATUS_TRAFFIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STRATUS_TRAFFIC_MAX 63 /* TCAS slots besides the user's */
+#define STRATUS_TRAFFIC_NAME_LEN 12
+
+typedef enum {
+  STRATUS_TRAFFIC_NONE,
+  STRATUS_TRAFFIC_TCAS,
+  STRATUS_TRAFFIC_MULTIPLAYER
+} StratusTrafficSource;
+
+typedef struct StratusTrafficTarget {
+  double latitude;
+  double longitude;
+  float altitude_msl_m;
+  float heading_true;
+  float ground_speed_mps;
+  float vertical_speed_fpm;
+  uint32_t mode_s;   /* 24-bit ICAO address, 0 if unknown */
+  uint16_t id;       /* Slot in the source, 1-based */
+  uint8_t on_ground; /* TCAS source only; 0 otherwise */
+  uint8_t _pad0;
+  char callsign[STRATUS_TRAFFIC_NAME_LEN];  /* NUL-terminated, may be empty */
+  char icao_type[STRATUS_TRAFFIC_NAME_LEN]; /* NUL-terminated, may be empty */
+} StratusTrafficTarget;
+
+typedef struct StratusTraffic {
+  uint64_t seq;          /* Snapshots captured since plugin start */
+  int64_t timestamp;     /* Unix time, seconds */
+  uint64_t monotonic_ns; /* Same clock as StratusFrame.monotonic_ns */
+  StratusTrafficSource source;
+  int count;
+  StratusTrafficTarget targets[STRATUS_TRAFFIC_MAX];
+} StratusTraffic;
+
+/* Pick the traffic source and resolve its DataRefs. Call from the plugin's
+ * deferred init (first flight-loop tick). Returns the source in use. */
+StratusTrafficSource StratusTraffic_Init(void);
+
+/* Fill `t` with the current traffic. Sim thread only (SDK calls); meant for
+ * a low-rate schedule, not every tick. */
+void StratusTraffic_Capture(StratusTraffic *t, uint64_t now_ns);
+
+/* Room for a full snapshot with every string fully escaped */
+#define STRATUS_TRAFFIC_JSON_MAX 24576
+
+/* Write `t` as a JSON object into `out`. Returns the length, or 0 if `cap`
+ * is too small. Any thread. */
+size_t StratusTraffic_WriteJSON(char *out, size_t cap,
+                                const StratusTraffic *t);
+
+#endif /* STRATUS_TRAFFIC_H */
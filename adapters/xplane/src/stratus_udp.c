@@ -0,0 +1,189 @@
+/*
+ * Stratus ATC - UDP Telemetry Stream
+ *
+ * See stratus_udp.h.
+ */
+
+#include "stratus_udp.h"
+
+#include <string.h>
+
+#if IBM
+
+/* Windows: no UDP stream yet; files and shared memory only */
+int StratusUdp_Open(const char *target) {
+  (void)target;
+  return 0;
+}
+
+void StratusUdp_Close(void) {}
+
+int StratusUdp_IsOpen(void) { return 0; }
+
+void StratusUdp_Publish(const StratusFrame *frame, uint64_t now_ns) {
+  (void)frame;
+  (void)now_ns;
+}
+
+size_t StratusUdp_Receive(char *buf, size_t cap) {
+  (void)buf;
+  (void)cap;
+  return 0;
+}
+
+uint64_t StratusUdp_Sent(void) { return 0; }
+
+uint64_t StratusUdp_Dropped(void) { return 0; }
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int g_fd = -1;
+static uint64_t g_seq = 0;
+static uint64_t g_sent = 0;
+static uint64_t g_dropped = 0;
+
+/* Outgoing and incoming datagram; one of each at a time */
+static uint8_t g_tx[sizeof(StratusUdpHeader) + STRATUS_FRAME_ENCODED_SIZE];
+static uint8_t g_rx[STRATUS_UDP_DATAGRAM_MAX];
+
+_Static_assert(sizeof(g_tx) <= STRATUS_UDP_DATAGRAM_MAX,
+               "frame datagram exceeds STRATUS_UDP_DATAGRAM_MAX");
+
+/* Split "host:port" / "[v6addr]:port" in place. Returns 0 if malformed. */
+static int SplitTarget(char *target, char **host, char **port) {
+  char *colon = strrchr(target, ':');
+  if (!colon || colon == target || colon[1] == '\0')
+    return 0;
+  *colon = '\0';
+  *port = colon + 1;
+  *host = target;
+  if (target[0] == '[') {
+    size_t len = strlen(target);
+    if (len < 3 || target[len - 1] != ']')
+      return 0;
+    target[len - 1] = '\0';
+    *host = target + 1;
+  }
+  return 1;
+}
+
+int StratusUdp_Open(const char *target) {
+  if (g_fd >= 0)
+    return 1;
+
+  char copy[256];
+  char *host, *port;
+  if (strlen(target) >= sizeof(copy))
+    return 0;
+  strcpy(copy, target);
+  if (!SplitTarget(copy, &host, &port))
+    return 0;
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_flags = AI_NUMERICSERV;
+  struct addrinfo *res = NULL;
+  if (getaddrinfo(host, port, &hints, &res) != 0)
+    return 0;
+
+  int fd = -1;
+  for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0)
+      continue;
+    /* Connecting fixes the destination and filters what recv() returns */
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 &&
+        connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+      break;
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0)
+    return 0;
+
+  g_seq = 0;
+  g_sent = 0;
+  g_dropped = 0;
+  g_fd = fd;
+  return 1;
+}
+
+void StratusUdp_Close(void) {
+  if (g_fd >= 0) {
+    close(g_fd);
+    g_fd = -1;
+  }
+}
+
+int StratusUdp_IsOpen(void) { return g_fd >= 0; }
+
+void StratusUdp_Publish(const StratusFrame *frame, uint64_t now_ns) {
+  if (g_fd < 0)
+    return;
+
+  size_t payload = StratusFrame_Encode(frame, g_tx + sizeof(StratusUdpHeader),
+                                       sizeof(g_tx) - sizeof(StratusUdpHeader));
+  StratusUdpHeader hdr;
+  hdr.magic = STRATUS_UDP_MAGIC;
+  hdr.version = STRATUS_UDP_VERSION;
+  hdr.kind = STRATUS_UDP_FRAME;
+  hdr.seq = ++g_seq;
+  hdr.sent_ns = now_ns;
+  hdr.payload_size = (uint32_t)payload;
+  hdr.flags = 0;
+  memcpy(g_tx, &hdr, sizeof(hdr));
+
+  /* A receiver that is down shows up as ECONNREFUSED on a later send; the
+   * frame is simply lost, like any other */
+  size_t len = sizeof(hdr) + payload;
+  if (send(g_fd, g_tx, len, MSG_DONTWAIT) == (ssize_t)len)
+    g_sent++;
+  else
+    g_dropped++;
+}
+
+size_t StratusUdp_Receive(char *buf, size_t cap) {
+  if (g_fd < 0 || cap == 0)
+    return 0;
+
+  for (;;) {
+    ssize_t n = recv(g_fd, g_rx, sizeof(g_rx), MSG_DONTWAIT);
+    if (n < 0) {
+      /* Pending ICMP errors from earlier sends surface here; skip them */
+      if (errno == ECONNREFUSED || errno == EINTR)
+        continue;
+      return 0;
+    }
+
+    StratusUdpHeader hdr;
+    if ((size_t)n < sizeof(hdr))
+      continue;
+    memcpy(&hdr, g_rx, sizeof(hdr));
+    if (hdr.magic != STRATUS_UDP_MAGIC || hdr.version != STRATUS_UDP_VERSION ||
+        hdr.kind != STRATUS_UDP_COMMANDS ||
+        hdr.payload_size != (size_t)n - sizeof(hdr) ||
+        hdr.payload_size >= cap)
+      continue;
+
+    memcpy(buf, g_rx + sizeof(hdr), hdr.payload_size);
+    buf[hdr.payload_size] = '\0';
+    if (hdr.payload_size > 0)
+      return hdr.payload_size;
+  }
+}
+
+uint64_t StratusUdp_Sent(void) { return g_sent; }
+
+uint64_t StratusUdp_Dropped(void) { return g_dropped; }
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Stratus ATC - UDP Telemetry Stream
+ *
+ * Optional network link (`udp = <host>:<port>`) for an ATC stack running on
+ * another machine. Every captured frame is sent as one datagram to the
+ * configured receiver; the receiver may send command datagrams back to the
+ * address the frames come from. Nothing is retransmitted and nothing is
+ * acknowledged at this level: each datagram is self-contained, carries a
+ * sequence number, and the receiver decides what to do about gaps and
+ * reordering (stratus-core/src/udp.rs keeps the newest frame).
+ *
+ * Each datagram is a StratusUdpHeader followed by `payload_size` bytes:
+ *
+ *   STRATUS_UDP_FRAME     plugin -> receiver, StratusFrameHeader +
+ *                         StratusFrame, exactly as in stratus_telemetry.bin
+ *   STRATUS_UDP_COMMANDS  receiver -> plugin, command lines in the
+ *                         stratus_commands.jsonl format (optional "id")
+ *
+ * The socket is connected to the receiver, so the kernel drops datagrams
+ * from any other address. All multi-byte values are little-endian.
+ *
+ * The target is resolved once, in StratusUdp_Open. All other calls are made
+ * from one thread: the I/O thread, or the sim thread when it is not running.
+ * Not available on Windows.
+ */
+
+#ifndef STRATUS_UDP_H
+#define STRATUS_UDP_H
+
+#include "stratus_frame.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STRATUS_UDP_MAGIC 0x55525453u /* "STRU" little-endian */
+#define STRATUS_UDP_VERSION 1
+
+/* Below the path MTU of any sane link, so nothing is ever fragmented */
+#define STRATUS_UDP_DATAGRAM_MAX 1400
+
+#define STRATUS_UDP_FRAME 1
+#define STRATUS_UDP_COMMANDS 2
+
+typedef struct StratusUdpHeader {
+  uint32_t magic;        /* STRATUS_UDP_MAGIC */
+  uint16_t version;      /* STRATUS_UDP_VERSION */
+  uint16_t kind;         /* STRATUS_UDP_FRAME / STRATUS_UDP_COMMANDS */
+  uint64_t seq;          /* Per sender and kind, from 1; gaps mean loss */
+  uint64_t sent_ns;      /* Sender's CLOCK_MONOTONIC at send */
+  uint32_t payload_size; /* Bytes after the header */
+  uint32_t flags;        /* Reserved, 0 */
+} StratusUdpHeader;
+
+_Static_assert(sizeof(StratusUdpHeader) == 32,
+               "StratusUdpHeader layout changed");
+
+/* Resolve `target` ("host:port", "[v6addr]:port") and open a socket
+ * connected to it. Returns 1 on success. */
+int StratusUdp_Open(const char *target);
+
+void StratusUdp_Close(void);
+
+/* 1 while streaming */
+int StratusUdp_IsOpen(void);
+
+/* Send `frame` as the next STRATUS_UDP_FRAME datagram */
+void StratusUdp_Publish(const StratusFrame *frame, uint64_t now_ns);
+
+/* Copy the payload of the next valid command datagram into `buf` and
+ * NUL-terminate it. Returns its length, or 0 when none is waiting. A
+ * `cap` of STRATUS_UDP_DATAGRAM_MAX fits any payload; longer ones are
+ * skipped. */
+size_t StratusUdp_Receive(char *buf, size_t cap);
+
+/* Frame datagrams sent */
+uint64_t StratusUdp_Sent(void);
+
+/* Frame datagrams send() refused (socket buffer full, no route, or an
+ * unreachable receiver reported by ICMP) */
+uint64_t StratusUdp_Dropped(void);
+
+#endif /* STRATUS_UDP_H */
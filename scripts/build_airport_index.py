@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Stratus ATC - Airport index builder
+
+Builds stratus_airports.bin, the airport and runway index the X-Plane plugin
+uses for its derived state (adapters/xplane/src/stratus_airports.h), from the
+OurAirports airports.csv and runways.csv.
+
+Usage:
+    scripts/build_airport_index.py [--airports CSV] [--runways CSV] [-o FILE]
+
+The inputs default to the copies under .legacy_client/src/core/resources, the
+output to stratus_airports.bin in the plugin's data directory. The plugin
+reads the index when it starts; rerun this after updating the CSVs.
+"""
+
+import argparse
+import csv
+import math
+import os
+import struct
+import sys
+
+MAGIC = 0x50415453  # "STAP"
+VERSION = 1
+TILE_ROWS = 180
+TILE_COLS = 360
+AIRPORT_ID_LEN = 8
+RUNWAY_ID_LEN = 4
+
+HEADER = struct.Struct("<IHHHHII12x")
+AIRPORT = struct.Struct("<ii8shBBI")
+RUNWAY = struct.Struct("<iiii4s4sHH")
+
+# StratusAirportType; heliports, balloon ports and closed airports are left out
+TYPES = {
+    "small_airport": 0,
+    "medium_airport": 1,
+    "large_airport": 2,
+    "seaplane_base": 3,
+}
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+RESOURCES = os.path.join(ROOT, ".legacy_client", "src", "core", "resources")
+
+
+def default_output():
+    """stratus_airports.bin in the plugin's data directory"""
+    if sys.platform == "win32":
+        base = os.environ.get("APPDATA", "C:\\")
+    elif sys.platform == "darwin":
+        base = os.path.expanduser("~/Library/Application Support")
+    else:
+        base = os.path.expanduser("~/.local/share")
+    return os.path.join(base, "StratusATC", "stratus_airports.bin")
+
+
+def e7(deg):
+    return int(round(float(deg) * 1e7))
+
+
+def tile_of(lat, lon):
+    row = min(max(int(math.floor(lat + 90.0)), 0), TILE_ROWS - 1)
+    col = int(math.floor((lon + 180.0) % 360.0)) % TILE_COLS
+    return row * TILE_COLS + col
+
+
+def clamp(value, low, high):
+    return min(max(value, low), high)
+
+
+def read_runways(path):
+    """Open runways with both thresholds, by airport ident"""
+    runways = {}
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.DictReader(f):
+            if row["closed"] == "1":
+                continue
+            le, he = row["le_ident"], row["he_ident"]
+            if not le or not he or len(le) >= RUNWAY_ID_LEN or len(he) >= RUNWAY_ID_LEN:
+                continue
+            try:
+                ends = [
+                    e7(row[k])
+                    for k in (
+                        "le_latitude_deg",
+                        "le_longitude_deg",
+                        "he_latitude_deg",
+                        "he_longitude_deg",
+                    )
+                ]
+            except ValueError:
+                continue
+            length = clamp(int(float(row["length_ft"] or 0)), 0, 0xFFFF)
+            width = clamp(int(float(row["width_ft"] or 0)), 0, 0xFFFF)
+            runways.setdefault(row["airport_ident"], []).append(
+                (*ends, le.encode(), he.encode(), length, width)
+            )
+    return runways
+
+
+def read_airports(path):
+    airports = []
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.DictReader(f):
+            kind = TYPES.get(row["type"])
+            ident = row["ident"]
+            if kind is None or not ident or len(ident) >= AIRPORT_ID_LEN:
+                continue
+            try:
+                lat = float(row["latitude_deg"])
+                lon = float(row["longitude_deg"])
+            except ValueError:
+                continue
+            elevation = clamp(int(float(row["elevation_ft"] or 0)), -32768, 32767)
+            airports.append((tile_of(lat, lon), ident, e7(lat), e7(lon), elevation, kind))
+    airports.sort()
+    return airports
+
+
+def build(airports, runways):
+    tiles = [0] * (TILE_ROWS * TILE_COLS + 1)
+    for tile, *_ in airports:
+        tiles[tile + 1] += 1
+    for i in range(1, len(tiles)):
+        tiles[i] += tiles[i - 1]
+
+    airport_rows = []
+    runway_rows = []
+    for _, ident, lat, lon, elevation, kind in airports:
+        own = runways.get(ident, [])[:255]
+        airport_rows.append(
+            AIRPORT.pack(lat, lon, ident.encode(), elevation, kind, len(own), len(runway_rows))
+        )
+        runway_rows.extend(RUNWAY.pack(*r) for r in own)
+
+    header = HEADER.pack(
+        MAGIC,
+        VERSION,
+        HEADER.size,
+        AIRPORT.size,
+        RUNWAY.size,
+        len(airport_rows),
+        len(runway_rows),
+    )
+    tile_table = struct.pack("<%dI" % len(tiles), *tiles)
+    return header + tile_table + b"".join(airport_rows) + b"".join(runway_rows), len(
+        runway_rows
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[2])
+    parser.add_argument("--airports", default=os.path.join(RESOURCES, "airports.csv"))
+    parser.add_argument("--runways", default=os.path.join(RESOURCES, "runways.csv"))
+    parser.add_argument("-o", "--output", default=default_output())
+    args = parser.parse_args()
+
+    airports = read_airports(args.airports)
+    data, runway_count = build(airports, read_runways(args.runways))
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    tmp = args.output + ".tmp"
+    with open(tmp, "wb") as f:
+        f.write(data)
+    os.replace(tmp, args.output)
+    print(
+        "Wrote %s: %d airports, %d runways, %.1f MB"
+        % (args.output, len(airports), runway_count, len(data) / 1e6)
+    )
+
+
+if __name__ == "__main__":
+    main()
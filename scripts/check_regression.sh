@@ -50,5 +50,52 @@ if [ -d "stratus-rs" ]; then
 fi
 echo -e "${GREEN}OK${NC}"
 
+# 4. Plugin benchmark (only if stratus_bench has been built)
+# Per-tick allocations and syscalls must not grow; time and bytes may grow
+# within STRATUS_BENCH_MAX_SLOWDOWN / 10%.
+BENCH_BIN="${STRATUS_BENCH_BIN:-adapters/xplane/build/stratus_bench}"
+BENCH_BASELINE="${STRATUS_BENCH_BASELINE:-adapters/xplane/build/bench_baseline.txt}"
+BENCH_MAX_SLOWDOWN="${STRATUS_BENCH_MAX_SLOWDOWN:-1.5}"
+echo -n "  Checking plugin benchmark... "
+if [ ! -x "$BENCH_BIN" ]; then
+    echo "SKIPPED (build stratus_bench with -DSTRATUS_BUILD_BENCH=ON)"
+else
+    BENCH_OUT=$(mktemp)
+    BENCH_REPORT=$(mktemp)
+    trap 'rm -f "$BENCH_OUT" "$BENCH_REPORT"' EXIT
+    if ! "$BENCH_BIN" > "$BENCH_OUT"; then
+        echo -e "${RED}FAILED${NC}"
+        echo "  $BENCH_BIN did not run"
+        exit 1
+    fi
+    if [ ! -f "$BENCH_BASELINE" ] || [ -n "$STRATUS_BENCH_UPDATE" ]; then
+        cp "$BENCH_OUT" "$BENCH_BASELINE"
+        echo -e "${GREEN}OK${NC} (baseline recorded in $BENCH_BASELINE)"
+    elif ! awk -v slowdown="$BENCH_MAX_SLOWDOWN" '
+        # Columns: mode ns/tick p99_us allocs/tick syscalls/tick bytes/tick
+        /^#/ { next }
+        NR == FNR { ns[$1] = $2; allocs[$1] = $4; sys[$1] = $5; bytes[$1] = $6; next }
+        !($1 in ns) { next }
+        {
+            if ($2 > ns[$1] * slowdown)
+                bad = bad sprintf("    %s: %.0f ns/tick (baseline %.0f)\n", $1, $2, ns[$1])
+            if ($4 > allocs[$1] + 0.05)
+                bad = bad sprintf("    %s: %.2f allocs/tick (baseline %.2f)\n", $1, $4, allocs[$1])
+            if ($5 != "-" && sys[$1] != "-" && $5 > sys[$1] + 0.05)
+                bad = bad sprintf("    %s: %.2f syscalls/tick (baseline %.2f)\n", $1, $5, sys[$1])
+            if ($6 > bytes[$1] * 1.1 + 1)
+                bad = bad sprintf("    %s: %.1f bytes/tick (baseline %.1f)\n", $1, $6, bytes[$1])
+        }
+        END { if (bad != "") { printf "%s", bad; exit 1 } }
+        ' "$BENCH_BASELINE" "$BENCH_OUT" > "$BENCH_REPORT"; then
+        echo -e "${RED}FAILED${NC}"
+        echo "  Plugin benchmark regressed against $BENCH_BASELINE:"
+        cat "$BENCH_REPORT"
+        exit 1
+    else
+        echo -e "${GREEN}OK${NC}"
+    fi
+fi
+
 echo ""
 echo -e "${GREEN}✅ All regression checks passed${NC}"
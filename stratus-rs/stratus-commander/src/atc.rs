@@ -0,0 +1,121 @@
+//! ATC state published to the sim.
+//!
+//! Clients send what ATC has assigned with `SET_ATC`; the commander keeps it,
+//! together with the outcome of the last command it applied, in one
+//! fixed-layout [`AtcState`]. The plugin copies it out on the sim thread
+//! whenever `seq` moves (`stratus_commander_atc_state`) and serves it as
+//! read-only `stratus/atc/*` DataRefs, so other plugins and cockpit hardware
+//! read it at sim speed with no file I/O.
+//!
+//! The plugin's `stratus/atc/*` commands act on the same state through
+//! `stratus_commander_comply`, writing the assignment with the commander's
+//! DataRef handles. Each one is acked on the command ring like any other
+//! command, with `ACK_ID_NONE`, so clients see what the pilot did.
+//!
+//! Must match `StratusAtcState` in `adapters/xplane/src/stratus_commander.h`.
+
+use crate::ring::ACK_APPLIED;
+use std::mem::size_of;
+
+/// Bytes of clearance text kept, NUL terminator included
+pub const ATC_CLEARANCE_LEN: usize = 256;
+/// Integer fields' value when nothing is assigned
+pub const ATC_NONE: i32 = -1;
+/// Float fields' value when nothing is assigned
+pub const ATC_NONE_F: f32 = -1.0;
+
+/// `stratus_commander_comply` actions
+pub const COMPLY_SQUAWK: u32 = 1;
+pub const COMPLY_FREQUENCY: u32 = 2;
+pub const COMPLY_ALTITUDE: u32 = 3;
+pub const COMPLY_HEADING: u32 = 4;
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct AtcState {
+    /// Bumped on every change below; starts at 1
+    pub seq: u64,
+    /// Assigned transponder code
+    pub squawk: i32,
+    /// Next frequency to contact, in `SET_RADIO` units
+    pub frequency: i32,
+    pub altitude_ft: f32,
+    /// Magnetic, as ATC assigns it
+    pub heading_deg: f32,
+    /// Bumped whenever the clearance text changes
+    pub clearance_seq: u32,
+    /// `OP_*` and `ACK_*` of the last command applied, from any source
+    pub last_op: u32,
+    pub last_result: i32,
+    /// Commands applied since the plugin started
+    pub commands_applied: u32,
+    /// NUL-terminated UTF-8, cut at a character boundary
+    pub clearance: [u8; ATC_CLEARANCE_LEN],
+}
+
+const _: () = assert!(size_of::<AtcState>() == 296);
+
+impl Default for AtcState {
+    fn default() -> Self {
+        Self {
+            seq: 1,
+            squawk: ATC_NONE,
+            frequency: ATC_NONE,
+            altitude_ft: ATC_NONE_F,
+            heading_deg: ATC_NONE_F,
+            clearance_seq: 0,
+            last_op: 0,
+            last_result: ACK_APPLIED,
+            commands_applied: 0,
+            clearance: [0; ATC_CLEARANCE_LEN],
+        }
+    }
+}
+
+impl AtcState {
+    /// Replace the assignments with a `SET_ATC` command's
+    pub(crate) fn assign(
+        &mut self,
+        squawk: Option<i32>,
+        frequency: Option<i32>,
+        altitude_ft: Option<f32>,
+        heading_deg: Option<f32>,
+        clearance: Option<&str>,
+    ) {
+        self.squawk = squawk.unwrap_or(ATC_NONE);
+        self.frequency = frequency.unwrap_or(ATC_NONE);
+        self.altitude_ft = altitude_ft.unwrap_or(ATC_NONE_F);
+        self.heading_deg = heading_deg.unwrap_or(ATC_NONE_F);
+
+        let mut text = [0u8; ATC_CLEARANCE_LEN];
+        let clearance = clearance.unwrap_or("");
+        let mut len = clearance.len().min(ATC_CLEARANCE_LEN - 1);
+        while !clearance.is_char_boundary(len) {
+            len -= 1;
+        }
+        text[..len].copy_from_slice(&clearance.as_bytes()[..len]);
+        if text != self.clearance {
+            self.clearance = text;
+            self.clearance_seq = self.clearance_seq.wrapping_add(1);
+        }
+        self.seq += 1;
+    }
+
+    /// Record the outcome of one applied command
+    pub(crate) fn note(&mut self, op: u32, result: i32) {
+        self.last_op = op;
+        self.last_result = result;
+        self.commands_applied = self.commands_applied.wrapping_add(1);
+        self.seq += 1;
+    }
+
+    /// The clearance text
+    pub fn clearance(&self) -> &str {
+        let len = self
+            .clearance
+            .iter()
+            .position(|&b| b == 0)
+            .unwrap_or(ATC_CLEARANCE_LEN);
+        std::str::from_utf8(&self.clearance[..len]).unwrap_or("")
+    }
+}
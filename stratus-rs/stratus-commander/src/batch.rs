@@ -0,0 +1,143 @@
+//! Per-tick command batch: coalesced by target, applied by priority.
+//!
+//! A client often sends a burst after one clearance: a frequency, a squawk
+//! and an altitude, sometimes with a correction right behind. Every command
+//! `apply` picks up goes into one slot per target first. A later command for
+//! the same target replaces the earlier one, which is acked
+//! `ACK_SUPERSEDED` without being written, so other plugins watching the
+//! DataRefs see one change per target. Slots are applied in priority order:
+//! squawk and COM radios before navigation, autopilot and settings. When the
+//! command apply budget runs out, the rest wait in their slots for the next
+//! tick, where newer commands can still replace them.
+//!
+//! The batch is a fixed array, so batching neither allocates nor grows with
+//! the burst: it never holds more than one command per target.
+
+use crate::ring::{ACK_SUPERSEDED, OP_SET_ATC};
+use crate::{ApMode, Op, Radio};
+
+// Slots in priority order
+const XPDR: usize = 0;
+const COM1: usize = 1;
+const COM2: usize = 2;
+const COM1_STANDBY: usize = 3;
+const COM2_STANDBY: usize = 4;
+const NAV1: usize = 5;
+const NAV2: usize = 6;
+const AP_ALT: usize = 7;
+const AP_HDG: usize = 8;
+const AP_VS: usize = 9;
+const RATE: usize = 10;
+const ATC: usize = 11;
+const SLOT_COUNT: usize = 12;
+
+/// What a batched command does
+#[derive(Debug)]
+pub(crate) enum Action {
+    Op(Op),
+    /// `SET_ATC`, which replaces the ATC state as a whole
+    Atc {
+        squawk: Option<i32>,
+        frequency: Option<i32>,
+        altitude_ft: Option<f32>,
+        heading_deg: Option<f32>,
+        clearance: Option<String>,
+    },
+}
+
+/// A command waiting in the batch, with the ID its ack carries
+#[derive(Debug)]
+pub(crate) struct Pending {
+    pub id: u64,
+    pub action: Action,
+}
+
+impl Pending {
+    /// `OP_*` code for the command's ack
+    pub(crate) fn code(&self) -> u32 {
+        match &self.action {
+            Action::Op(op) => op.code(),
+            Action::Atc { .. } => OP_SET_ATC,
+        }
+    }
+
+    fn slot(&self) -> usize {
+        match &self.action {
+            Action::Op(Op::Xpdr { .. }) => XPDR,
+            Action::Op(Op::Radio(radio, _)) => match radio {
+                Radio::Com1 => COM1,
+                Radio::Com2 => COM2,
+                Radio::Com1Standby => COM1_STANDBY,
+                Radio::Com2Standby => COM2_STANDBY,
+                Radio::Nav1 => NAV1,
+                Radio::Nav2 => NAV2,
+            },
+            Action::Op(Op::Ap(mode, _)) => match mode {
+                ApMode::Alt => AP_ALT,
+                ApMode::Hdg => AP_HDG,
+                ApMode::Vs => AP_VS,
+            },
+            Action::Op(Op::Rate(_)) => RATE,
+            Action::Atc { .. } => ATC,
+        }
+    }
+}
+
+#[derive(Debug, Default)]
+pub(crate) struct Batch {
+    slots: [Option<Pending>; SLOT_COUNT],
+}
+
+impl Batch {
+    /// Queue `command`. Returns the ID and ack (`ACK_SUPERSEDED`) of the
+    /// command it replaced, if any, which is dropped unwritten.
+    pub(crate) fn push(&mut self, mut command: Pending) -> Option<(u64, (u32, i32))> {
+        let slot = &mut self.slots[command.slot()];
+        // A squawk without a mode keeps the mode a replaced one asked for
+        if let (
+            Action::Op(Op::Xpdr {
+                mode: mode @ None, ..
+            }),
+            Some(Pending {
+                action: Action::Op(Op::Xpdr { mode: Some(m), .. }),
+                ..
+            }),
+        ) = (&mut command.action, slot.as_ref())
+        {
+            *mode = Some(*m);
+        }
+        slot.replace(command)
+            .map(|old| (old.id, (old.code(), ACK_SUPERSEDED)))
+    }
+
+    /// Run waiting commands, most urgent first, until the batch is empty or
+    /// `spent()` says the budget is gone. At least one command runs per call;
+    /// the rest stay queued for the next. Returns how many ran.
+    pub(crate) fn drain(
+        &mut self,
+        mut spent: impl FnMut() -> bool,
+        mut run: impl FnMut(Pending),
+    ) -> usize {
+        let mut ran = 0;
+        while !self.is_empty() {
+            if ran > 0 && spent() {
+                break;
+            }
+            let Some(command) = self.pop() else {
+                break;
+            };
+            run(command);
+            ran += 1;
+        }
+        ran
+    }
+
+    /// Highest-priority command waiting, removed from the batch
+    fn pop(&mut self) -> Option<Pending> {
+        self.slots.iter_mut().find_map(Option::take)
+    }
+
+    pub(crate) fn is_empty(&self) -> bool {
+        self.slots.iter().all(Option::is_none)
+    }
+}
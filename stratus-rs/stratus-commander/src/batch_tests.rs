@@ -0,0 +1,187 @@
+//! Unit tests for the per-tick command batch
+
+use crate::batch::{Action, Batch, Pending};
+use crate::ring::{ACK_SUPERSEDED, OP_SET_AP, OP_SET_ATC, OP_SET_RADIO, OP_SET_XPDR};
+use crate::{ApMode, Op, Radio};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn op(id: u64, op: Op) -> Pending {
+        Pending {
+            id,
+            action: Action::Op(op),
+        }
+    }
+
+    fn atc(id: u64) -> Pending {
+        Pending {
+            id,
+            action: Action::Atc {
+                squawk: Some(4521),
+                frequency: None,
+                altitude_ft: Some(5000.0),
+                heading_deg: None,
+                clearance: None,
+            },
+        }
+    }
+
+    /// Everything `drain` runs, in order, with no budget
+    fn drain_all(batch: &mut Batch) -> Vec<Pending> {
+        let mut ran = Vec::new();
+        batch.drain(|| false, |command| ran.push(command));
+        ran
+    }
+
+    fn ids(commands: &[Pending]) -> Vec<u64> {
+        commands.iter().map(|c| c.id).collect()
+    }
+
+    #[test]
+    fn test_later_command_supersedes_earlier_one() {
+        let mut batch = Batch::default();
+        assert!(batch.push(op(1, Op::Radio(Radio::Com1, 118_700))).is_none());
+        assert!(batch.push(op(2, Op::Radio(Radio::Com2, 121_500))).is_none());
+
+        let replaced = batch.push(op(3, Op::Radio(Radio::Com1, 124_350)));
+        assert_eq!(replaced, Some((1, (OP_SET_RADIO, ACK_SUPERSEDED))));
+        assert!(batch.push(atc(4)).is_none());
+        let replaced = batch.push(atc(5));
+        assert_eq!(replaced, Some((4, (OP_SET_ATC, ACK_SUPERSEDED))));
+
+        // The replaced commands are never run; the latest value is
+        let ran = drain_all(&mut batch);
+        assert_eq!(ids(&ran), [3, 2, 5]);
+        assert!(matches!(
+            ran[0].action,
+            Action::Op(Op::Radio(Radio::Com1, 124_350))
+        ));
+        assert!(batch.is_empty());
+    }
+
+    #[test]
+    fn test_runs_in_priority_order() {
+        let mut batch = Batch::default();
+        batch.push(atc(1));
+        batch.push(op(2, Op::Rate(5.0)));
+        batch.push(op(3, Op::Ap(ApMode::Vs, -500.0)));
+        batch.push(op(4, Op::Ap(ApMode::Alt, 5000.0)));
+        batch.push(op(5, Op::Radio(Radio::Nav1, 110_500)));
+        batch.push(op(6, Op::Radio(Radio::Com1Standby, 121_500)));
+        batch.push(op(7, Op::Radio(Radio::Com2, 119_100)));
+        batch.push(op(8, Op::Radio(Radio::Com1, 118_700)));
+        batch.push(op(
+            9,
+            Op::Xpdr {
+                code: 4521,
+                mode: None,
+            },
+        ));
+
+        // Squawk, COM radios, navigation, autopilot, settings, ATC state
+        assert_eq!(ids(&drain_all(&mut batch)), [9, 8, 7, 6, 5, 4, 3, 2, 1]);
+    }
+
+    #[test]
+    fn test_budget_stops_drain_and_rest_carries_over() {
+        let mut batch = Batch::default();
+        batch.push(op(1, Op::Radio(Radio::Com1, 118_700)));
+        batch.push(op(2, Op::Radio(Radio::Nav1, 110_500)));
+        batch.push(op(3, Op::Ap(ApMode::Hdg, 270.0)));
+        batch.push(op(4, Op::Rate(5.0)));
+
+        // Budget spent from the start: one command still runs
+        let mut ran = Vec::new();
+        assert_eq!(batch.drain(|| true, |c| ran.push(c.id)), 1);
+        assert_eq!(ran, [1]);
+        assert!(!batch.is_empty());
+
+        // A command arriving before the next tick can still replace a
+        // waiting one, and the waiting ones keep their priority
+        let replaced = batch.push(op(5, Op::Ap(ApMode::Hdg, 280.0)));
+        assert_eq!(replaced, Some((3, (OP_SET_AP, ACK_SUPERSEDED))));
+
+        // Budget checked before each command after the first; spent at the
+        // second check
+        let mut checks = 0;
+        let mut ran = Vec::new();
+        let count = batch.drain(
+            || {
+                checks += 1;
+                checks >= 2
+            },
+            |c| ran.push(c.id),
+        );
+        assert_eq!((count, ran), (2, vec![2, 5]));
+
+        assert_eq!(ids(&drain_all(&mut batch)), [4]);
+        assert!(batch.is_empty());
+        assert_eq!(batch.drain(|| true, |_| panic!("nothing to run")), 0);
+    }
+
+    #[test]
+    fn test_squawk_inherits_replaced_mode() {
+        let mut batch = Batch::default();
+        batch.push(op(
+            1,
+            Op::Xpdr {
+                code: 1200,
+                mode: Some(2),
+            },
+        ));
+        let replaced = batch.push(op(
+            2,
+            Op::Xpdr {
+                code: 4521,
+                mode: None,
+            },
+        ));
+        assert_eq!(replaced, Some((1, (OP_SET_XPDR, ACK_SUPERSEDED))));
+
+        let ran = drain_all(&mut batch);
+        assert!(matches!(
+            ran[0].action,
+            Action::Op(Op::Xpdr {
+                code: 4521,
+                mode: Some(2)
+            })
+        ));
+
+        // An explicit mode wins, and nothing is inherited from an empty slot
+        batch.push(op(
+            3,
+            Op::Xpdr {
+                code: 7000,
+                mode: Some(1),
+            },
+        ));
+        batch.push(op(
+            4,
+            Op::Xpdr {
+                code: 7000,
+                mode: Some(3),
+            },
+        ));
+        batch.push(op(5, Op::Radio(Radio::Com1, 118_700)));
+        let ran = drain_all(&mut batch);
+        assert!(matches!(
+            ran[0].action,
+            Action::Op(Op::Xpdr { mode: Some(3), .. })
+        ));
+
+        batch.push(op(
+            6,
+            Op::Xpdr {
+                code: 2000,
+                mode: None,
+            },
+        ));
+        let ran = drain_all(&mut batch);
+        assert!(matches!(
+            ran[0].action,
+            Action::Op(Op::Xpdr { mode: None, .. })
+        ));
+    }
+}
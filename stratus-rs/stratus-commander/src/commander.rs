@@ -0,0 +1,464 @@
+//! Persistent command engine owned by the X-Plane plugin.
+//!
+//! A [`Commander`] is created once by the plugin's deferred init, on the
+//! first flight-loop tick, and lives until `XPluginStop`. The plugin's I/O
+//! thread calls [`Commander::poll`] to pick up new lines from the command
+//! file; the sim thread calls [`Commander::apply`] to write them into X-Plane
+//! through DataRef handles resolved at creation (or when an aircraft profile
+//! remaps them, see `targets.rs`).
+//!
+//! Polling an empty command file costs one `fstat` on an already-open
+//! descriptor: no path allocation, no lock, no read.
+//!
+//! Clients that find the shared-memory command ring (see `ring.rs`) skip the
+//! file altogether: `apply` drains the ring directly on the sim thread.
+//! Every command `apply` runs, from either source, is acknowledged in the
+//! ring's ack slots with its result and apply time.
+//!
+//! Commands are not applied in arrival order: each `apply` coalesces them per
+//! target and writes the most urgent first, within an optional time budget
+//! (see `batch.rs`).
+//!
+//! `SET_ATC` commands and the outcome of every command land in an
+//! [`AtcState`] the plugin publishes as DataRefs (see `atc.rs`).
+
+use crate::atc::{
+    AtcState, ATC_NONE, COMPLY_ALTITUDE, COMPLY_FREQUENCY, COMPLY_HEADING, COMPLY_SQUAWK,
+};
+use crate::batch::{Action, Batch, Pending};
+use crate::ring::{
+    AckRecord, CommandRing, ACK_APPLIED, ACK_ID_NONE, ACK_UNAVAILABLE, ACK_UNSUPPORTED, OP_SET_AP,
+    OP_SET_ATC, OP_SET_RADIO, OP_SET_XPDR,
+};
+use crate::targets::{MapResult, Targets};
+use crate::{parse_command_lines, ApMode, Command, CommandLine, Op, Radio};
+use nix::fcntl::{Flock, FlockArg};
+use nix::time::{clock_gettime, ClockId};
+use std::cell::{Cell, RefCell};
+use std::fs::{File, OpenOptions};
+use std::io::{Read, Seek, SeekFrom};
+use std::os::unix::fs::MetadataExt;
+use std::path::PathBuf;
+use std::sync::Mutex;
+
+/// Re-check that the path still points at our open file every N polls
+/// (the client may delete and recreate it)
+const IDENTITY_CHECK_POLLS: u32 = 10;
+
+/// `CLOCK_MONOTONIC` in nanoseconds, the clock the plugin stamps frames with
+fn monotonic_ns() -> u64 {
+    clock_gettime(ClockId::CLOCK_MONOTONIC)
+        .map(|t| t.tv_sec() as u64 * 1_000_000_000 + t.tv_nsec() as u64)
+        .unwrap_or(0)
+}
+
+/// The command file, kept open between polls
+struct CommandFile {
+    path: PathBuf,
+    file: Option<File>,
+    identity: (u64, u64),
+    polls_since_check: u32,
+    buf: String,
+    parsed: Vec<CommandLine>,
+}
+
+impl CommandFile {
+    fn new(path: PathBuf) -> Self {
+        Self {
+            path,
+            file: None,
+            identity: (0, 0),
+            polls_since_check: 0,
+            buf: String::new(),
+            parsed: Vec::new(),
+        }
+    }
+
+    /// (Re)open the file if it appeared or was replaced since the last check
+    fn refresh(&mut self) {
+        self.polls_since_check = 0;
+
+        let meta = match std::fs::metadata(&self.path) {
+            Ok(meta) => meta,
+            Err(_) => {
+                self.file = None;
+                return;
+            }
+        };
+        let identity = (meta.dev(), meta.ino());
+        if self.file.is_some() && identity == self.identity {
+            return;
+        }
+
+        self.file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .open(&self.path)
+            .ok();
+        self.identity = identity;
+    }
+
+    /// Parse any commands in the file into `self.parsed` and truncate it.
+    /// Returns the number of commands read.
+    fn poll(&mut self) -> anyhow::Result<usize> {
+        if self.file.is_none() || self.polls_since_check >= IDENTITY_CHECK_POLLS {
+            self.refresh();
+        } else {
+            self.polls_since_check += 1;
+        }
+
+        let Some(file) = self.file.as_ref() else {
+            return Ok(0);
+        };
+
+        // Cheap skip: nothing appended since the last truncate
+        if file.metadata()?.len() == 0 {
+            return Ok(0);
+        }
+
+        let file = self.file.take().unwrap();
+        let mut locked = match Flock::lock(file, FlockArg::LockExclusive) {
+            Ok(locked) => locked,
+            Err((file, e)) => {
+                self.file = Some(file);
+                return Err(e.into());
+            }
+        };
+        let result = (|| -> anyhow::Result<usize> {
+            self.buf.clear();
+            locked.seek(SeekFrom::Start(0))?;
+            locked.read_to_string(&mut self.buf)?;
+            locked.set_len(0)?;
+            locked.seek(SeekFrom::Start(0))?;
+            Ok(parse_command_lines(&self.buf, &mut self.parsed))
+        })();
+        // On failure the lock is released when `locked` drops, and the file
+        // is reopened on the next poll
+        self.file = locked.unlock().ok();
+
+        result
+    }
+}
+
+/// Long-lived command state shared by the plugin's I/O and sim threads.
+///
+/// `poll` may run on any thread; `apply` and `comply` (and therefore every
+/// DataRef write) must run on the sim thread. The DataRef cache, the command
+/// ring, the batch, the ATC state and plugin settings are only ever touched
+/// by those and the sim-thread accessors, so the `RefCell`s and `Cell`s are
+/// never contended.
+pub struct Commander {
+    pub status_path: PathBuf,
+    source: Mutex<CommandFile>,
+    pending: Mutex<Vec<CommandLine>>,
+    batch: RefCell<Batch>,
+    apply_budget_ns: Cell<u64>,
+    datarefs: RefCell<Targets>,
+    ring: RefCell<Option<CommandRing>>,
+    rate_hz: Cell<f32>,
+    atc: RefCell<AtcState>,
+}
+
+impl Commander {
+    /// Resolve DataRefs, create the command ring and remember the command
+    /// file. Sim thread only, once the sim has loaded (the plugin's deferred
+    /// init).
+    pub fn new(command_path: PathBuf, status_path: PathBuf) -> Self {
+        let ring = match CommandRing::create() {
+            Ok(ring) => Some(ring),
+            Err(e) => {
+                log::warn!("Command ring unavailable, commands via file only: {}", e);
+                None
+            }
+        };
+        Self::with_ring(command_path, status_path, ring)
+    }
+
+    /// Like `new`, but file only: leaves any plugin's command ring alone.
+    /// For one-shot callers.
+    pub fn without_ring(command_path: PathBuf, status_path: PathBuf) -> Self {
+        Self::with_ring(command_path, status_path, None)
+    }
+
+    fn with_ring(command_path: PathBuf, status_path: PathBuf, ring: Option<CommandRing>) -> Self {
+        Self {
+            status_path,
+            source: Mutex::new(CommandFile::new(command_path)),
+            pending: Mutex::new(Vec::new()),
+            batch: RefCell::new(Batch::default()),
+            apply_budget_ns: Cell::new(0),
+            datarefs: RefCell::new(Targets::resolve()),
+            ring: RefCell::new(ring),
+            rate_hz: Cell::new(0.0),
+            atc: RefCell::new(AtcState::default()),
+        }
+    }
+
+    /// Telemetry rate last requested by a client via `SET_RATE`, or 0 when
+    /// the plugin should choose. Sim thread only.
+    pub fn requested_rate_hz(&self) -> f32 {
+        self.rate_hz.get()
+    }
+
+    /// Copy the ATC state into `out` unless `out.seq` is already current.
+    /// Returns true if it copied. Sim thread only.
+    pub fn atc_state(&self, out: &mut AtcState) -> bool {
+        let atc = self.atc.borrow();
+        if out.seq == atc.seq {
+            return false;
+        }
+        *out = *atc;
+        true
+    }
+
+    /// Carry out an ATC assignment (`COMPLY_*`): write the assigned squawk,
+    /// the next frequency (into COM1 standby) or the assigned altitude or
+    /// heading (into the autopilot) as the matching command would, and ack
+    /// it on the ring. Sim thread only. Returns the `ACK_*` result.
+    pub fn comply(&self, action: u32) -> i32 {
+        let (code, op) = {
+            let atc = self.atc.borrow();
+            match action {
+                COMPLY_SQUAWK => (
+                    OP_SET_XPDR,
+                    (atc.squawk != ATC_NONE).then_some(Op::Xpdr {
+                        code: atc.squawk,
+                        mode: None,
+                    }),
+                ),
+                COMPLY_FREQUENCY => (
+                    OP_SET_RADIO,
+                    (atc.frequency != ATC_NONE)
+                        .then_some(Op::Radio(Radio::Com1Standby, atc.frequency)),
+                ),
+                COMPLY_ALTITUDE => (
+                    OP_SET_AP,
+                    (atc.altitude_ft >= 0.0).then_some(Op::Ap(ApMode::Alt, atc.altitude_ft)),
+                ),
+                COMPLY_HEADING => (
+                    OP_SET_AP,
+                    (atc.heading_deg >= 0.0).then_some(Op::Ap(ApMode::Hdg, atc.heading_deg)),
+                ),
+                _ => (0, None),
+            }
+        };
+        let mut datarefs = self.datarefs.borrow_mut();
+        let ack = match op {
+            Some(op) => self.run(&mut datarefs, op),
+            None if code == 0 => (0, ACK_UNSUPPORTED),
+            None => (code, ACK_UNAVAILABLE), // Nothing assigned
+        };
+        self.atc.borrow_mut().note(ack.0, ack.1);
+        if let Some(ring) = self.ring.borrow_mut().as_mut() {
+            ring.ack(&ack_record(ACK_ID_NONE, ack, datarefs.sim_time()));
+        }
+        ack.1
+    }
+
+    /// Write `field` (`radios.com1_standby_hz`, ...) to `dataref` instead of
+    /// its stock DataRef (`None`: back to the stock one), dividing values by
+    /// `scale` (0 = 1) and firing `command` after each write. For aircraft
+    /// profiles; sim thread only.
+    pub fn map_target(
+        &self,
+        field: &str,
+        dataref: Option<&str>,
+        scale: f32,
+        command: Option<&str>,
+    ) -> MapResult {
+        self.datarefs
+            .borrow_mut()
+            .map(field, dataref, scale, command)
+    }
+
+    /// Undo every `map_target`. Sim thread only.
+    pub fn reset_targets(&self) {
+        self.datarefs.borrow_mut().reset();
+    }
+
+    /// Pick up newly written commands and queue them for `apply`.
+    /// Returns the number of commands queued.
+    pub fn poll(&self) -> anyhow::Result<usize> {
+        let mut source = self
+            .source
+            .lock()
+            .map_err(|_| anyhow::anyhow!("command file lock poisoned"))?;
+
+        // File I/O happens outside the pending-queue lock so `apply` is
+        // never kept waiting by a slow disk
+        let count = source.poll()?;
+        if count > 0 {
+            self.pending
+                .lock()
+                .map_err(|_| anyhow::anyhow!("pending queue lock poisoned"))?
+                .append(&mut source.parsed);
+        }
+        Ok(count)
+    }
+
+    /// Queue command lines that arrived outside the command file (the UDP
+    /// stream), in the same format. Returns the number of commands queued.
+    pub fn submit(&self, text: &str) -> anyhow::Result<usize> {
+        let mut parsed = Vec::new();
+        let count = parse_command_lines(text, &mut parsed);
+        if count > 0 {
+            self.pending
+                .lock()
+                .map_err(|_| anyhow::anyhow!("pending queue lock poisoned"))?
+                .append(&mut parsed);
+        }
+        Ok(count)
+    }
+
+    /// Apply commands pushed to the ring since the last tick and those queued
+    /// from the file, acking each on the ring. Commands are coalesced per
+    /// target and applied by priority (see `batch.rs`); with an apply budget
+    /// set, what does not fit waits for the next call. Sim thread only; never
+    /// blocks on the I/O thread (if it holds the queue, file commands wait
+    /// for the next tick). Returns the number of commands applied.
+    pub fn apply(&self) -> usize {
+        let mut datarefs = self.datarefs.borrow_mut();
+        let mut ring = self.ring.borrow_mut();
+        let mut atc = self.atc.borrow_mut();
+        let mut batch = self.batch.borrow_mut();
+        let mut acks = Acks {
+            ring: ring.as_mut(),
+            sim_time: None,
+        };
+
+        // Bounded by the ring size, so a flood cannot stall the frame
+        for _ in 0..crate::ring::RING_SLOTS {
+            let Some((seq, record)) = acks.ring.as_mut().and_then(|r| r.pop()) else {
+                break;
+            };
+            match Op::from_record(&record) {
+                Some(op) => {
+                    let command = Pending {
+                        id: seq,
+                        action: Action::Op(op),
+                    };
+                    if let Some((id, ack)) = batch.push(command) {
+                        acks.send(&datarefs, id, ack);
+                    }
+                }
+                None => {
+                    log::error!("Unknown ring command #{}: {:?}", seq, record);
+                    atc.note(record.op, ACK_UNSUPPORTED);
+                    acks.send(&datarefs, seq, (record.op, ACK_UNSUPPORTED));
+                }
+            }
+        }
+
+        if let Ok(mut pending) = self.pending.try_lock() {
+            for line in pending.drain(..) {
+                let id = line.id.unwrap_or(ACK_ID_NONE);
+                let action = match line.command {
+                    Command::SetAtc {
+                        squawk,
+                        frequency,
+                        altitude_ft,
+                        heading_deg,
+                        clearance,
+                    } => Action::Atc {
+                        squawk,
+                        frequency,
+                        altitude_ft,
+                        heading_deg,
+                        clearance,
+                    },
+                    command => match Op::try_from(&command) {
+                        Ok(op) => Action::Op(op),
+                        Err(e) => {
+                            log::error!("Failed to execute command: {:?}", e);
+                            atc.note(0, ACK_UNSUPPORTED);
+                            acks.send(&datarefs, id, (0, ACK_UNSUPPORTED));
+                            continue;
+                        }
+                    },
+                };
+                if let Some((id, ack)) = batch.push(Pending { id, action }) {
+                    acks.send(&datarefs, id, ack);
+                }
+            }
+        }
+
+        // At least one command per call, however small the budget
+        let budget_ns = self.apply_budget_ns.get();
+        let start = if budget_ns > 0 { monotonic_ns() } else { 0 };
+        let spent = || budget_ns > 0 && monotonic_ns() - start >= budget_ns;
+        let applied = batch.drain(spent, |command| {
+            let ack = match command.action {
+                Action::Op(op) => self.run(&mut datarefs, op),
+                Action::Atc {
+                    squawk,
+                    frequency,
+                    altitude_ft,
+                    heading_deg,
+                    clearance,
+                } => {
+                    atc.assign(
+                        squawk,
+                        frequency,
+                        altitude_ft,
+                        heading_deg,
+                        clearance.as_deref(),
+                    );
+                    (OP_SET_ATC, ACK_APPLIED)
+                }
+            };
+            atc.note(ack.0, ack.1);
+            acks.send(&datarefs, command.id, ack);
+        });
+        if !batch.is_empty() {
+            log::debug!("Command apply budget spent, rest waits for the next tick");
+        }
+        applied
+    }
+
+    /// Cap the time one `apply` call spends writing commands (0: no cap).
+    /// Sim thread only.
+    pub fn set_apply_budget_ns(&self, budget_ns: u64) {
+        self.apply_budget_ns.set(budget_ns);
+    }
+
+    /// Run one command; returns its `OP_*` code and `ACK_*` result
+    fn run(&self, datarefs: &mut Targets, op: Op) -> (u32, i32) {
+        if let Op::Rate(hz) = op {
+            log::info!("Client requested telemetry rate {} Hz", hz);
+            self.rate_hz.set(hz.max(0.0));
+            return (op.code(), ACK_APPLIED);
+        }
+        let result = if datarefs.execute(op) {
+            ACK_APPLIED
+        } else {
+            ACK_UNAVAILABLE
+        };
+        (op.code(), result)
+    }
+}
+
+/// Acks on the command ring, if there is one, stamped with one sim time per
+/// `apply` call
+struct Acks<'a> {
+    ring: Option<&'a mut CommandRing>,
+    sim_time: Option<f64>,
+}
+
+impl Acks<'_> {
+    fn send(&mut self, datarefs: &Targets, id: u64, ack: (u32, i32)) {
+        if let Some(ring) = self.ring.as_mut() {
+            let sim_time = *self.sim_time.get_or_insert_with(|| datarefs.sim_time());
+            ring.ack(&ack_record(id, ack, sim_time));
+        }
+    }
+}
+
+fn ack_record(id: u64, (op, result): (u32, i32), sim_time: f64) -> AckRecord {
+    AckRecord {
+        id,
+        applied_ns: monotonic_ns(),
+        sim_time,
+        op,
+        result,
+    }
+}
@@ -0,0 +1,115 @@
+//! Telemetry frame as the plugin captures it, for in-process consumers.
+//!
+//! Byte-compatible with `StratusFrame` in `adapters/xplane/src/stratus_frame.h`
+//! (and `TelemetryFrame` in `stratus-core/src/frame.rs`, which decodes the
+//! same layout from the files and rings). The plugin passes a pointer to its
+//! own frame to `stratus_push_telemetry`, so the layout must match exactly.
+
+use std::mem::size_of;
+
+/// Engine slots in a frame (`STRATUS_MAX_ENGINES`)
+pub const MAX_ENGINES: usize = 8;
+/// Aircraft name bytes in a frame (`STRATUS_AIRCRAFT_NAME_LEN`)
+pub const AIRCRAFT_NAME_LEN: usize = 64;
+/// Airport ident bytes in a frame (`STRATUS_AIRPORT_ID_LEN`)
+pub const AIRPORT_ID_LEN: usize = 8;
+/// Runway ident bytes in a frame (`STRATUS_RUNWAY_ID_LEN`)
+pub const RUNWAY_ID_LEN: usize = 4;
+
+/// One telemetry frame; see `stratus_frame.h` for units
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct Frame {
+    pub timestamp: i64,
+
+    pub latitude: f64,
+    pub longitude: f64,
+    pub altitude_msl_m: f64,
+    pub altitude_agl_m: f64,
+
+    pub heading_mag: f32,
+    pub heading_true: f32,
+    pub pitch: f32,
+    pub roll: f32,
+
+    pub ground_speed_mps: f32,
+    pub ias_kts: f32,
+    pub tas_mps: f32,
+    pub vertical_speed_fpm: f32,
+
+    pub com1_hz: i32,
+    pub com1_standby_hz: i32,
+    pub com2_hz: i32,
+    pub com2_standby_hz: i32,
+    pub nav1_hz: i32,
+    pub nav2_hz: i32,
+
+    pub xpdr_code: i32,
+    pub xpdr_mode: i32,
+
+    pub ap_altitude_ft: f32,
+    pub ap_heading: f32,
+    pub ap_vs_fpm: f32,
+
+    pub on_ground: u8,
+    pub paused: u8,
+    pub _pad0: [u8; 2],
+
+    pub aircraft: [u8; AIRCRAFT_NAME_LEN],
+
+    pub engine_count: i32,
+    pub engine_running: [i32; MAX_ENGINES],
+    pub _pad1: [u8; 4],
+
+    pub frame_seq: u64,
+    pub monotonic_ns: u64,
+    pub sim_time_s: f64,
+
+    /// Derived state (`stratus_derived.h`): `StratusPhase`
+    pub phase: i32,
+    pub ground_speed_kts: f32,
+    pub tas_kts: f32,
+    pub altitude_msl_ft: f32,
+    pub altitude_agl_ft: f32,
+    pub airport: [u8; AIRPORT_ID_LEN],
+    pub airport_dist_nm: f32,
+    pub airport_bearing_deg: f32,
+    pub airport_elevation_ft: f32,
+    pub runway: [u8; RUNWAY_ID_LEN],
+    pub runway_dist_ft: f32,
+    pub runway_length_ft: i32,
+    pub on_runway: u8,
+    pub _pad2: [u8; 3],
+
+    /// `STRATUS_EVENT_*` bits (`stratus_events.h`) this frame was published
+    /// for, and the count of such frames since plugin start
+    pub events: u32,
+    pub event_seq: u32,
+}
+
+// Layout of STRATUS_FRAME_VERSION 5
+const _: () = assert!(size_of::<Frame>() == 312);
+
+impl Frame {
+    /// All zeroes, as before the first capture
+    pub const ZERO: Frame = {
+        // SAFETY: plain integers, floats and byte arrays; zero is valid
+        unsafe { std::mem::zeroed() }
+    };
+
+    /// Aircraft file name up to the first NUL
+    pub fn aircraft_name(&self) -> String {
+        c_string(&self.aircraft)
+    }
+
+    /// Nearest airport ident, "" if none
+    pub fn airport_ident(&self) -> String {
+        c_string(&self.airport)
+    }
+}
+
+/// A NUL-padded frame string
+fn c_string(bytes: &[u8]) -> String {
+    let end = bytes.iter().position(|&b| b == 0).unwrap_or(bytes.len());
+    String::from_utf8_lossy(&bytes[..end]).into_owned()
+}
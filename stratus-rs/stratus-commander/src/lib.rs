@@ -1,11 +1,25 @@
-use nix::fcntl::{flock, FlockArg};
 use serde::{Deserialize, Serialize};
-use std::fs::OpenOptions;
-use std::io::{BufRead, BufReader, Seek, SeekFrom};
-use std::os::unix::io::AsRawFd;
+use std::ffi::CStr;
 use std::path::PathBuf;
-use xplm::data::borrowed::DataRef;
-use xplm::data::DataReadWrite;
+
+pub mod atc;
+mod batch;
+pub mod commander;
+pub mod frame;
+pub mod ring;
+pub mod snapshot;
+mod targets;
+
+#[cfg(test)]
+mod batch_tests;
+#[cfg(test)]
+mod snapshot_tests;
+
+pub use atc::AtcState;
+pub use commander::Commander;
+pub use frame::Frame;
+pub use snapshot::{TelemetrySnapshot, TELEMETRY};
+pub use targets::MapResult;
 
 #[derive(Debug, Serialize, Deserialize)]
 #[serde(tag = "op")]
@@ -24,8 +38,129 @@ pub enum Command {
     },
     #[serde(rename = "SET_AP")]
     SetAp { mode: String, value: f32 },
+    /// Request a telemetry rate from the plugin; `hz` of 0 returns control
+    /// to the plugin's adaptive rate
+    #[serde(rename = "SET_RATE")]
+    SetRate { hz: f32 },
+    /// What ATC has assigned, published to other plugins and cockpit tools
+    /// as `stratus/atc/*` DataRefs. Each one replaces the last: a field left
+    /// out means nothing is assigned.
+    #[serde(rename = "SET_ATC")]
+    SetAtc {
+        #[serde(default)]
+        squawk: Option<i32>,
+        /// Next frequency to contact, in `SET_RADIO` units
+        #[serde(default)]
+        frequency: Option<i32>,
+        #[serde(default)]
+        altitude_ft: Option<f32>,
+        #[serde(default)]
+        heading_deg: Option<f32>,
+        /// Text of the last clearance issued
+        #[serde(default)]
+        clearance: Option<String>,
+    },
+}
+
+/// One line of the command file. Clients may tag a command with an `"id"`
+/// to match the plugin's ack for it.
+#[derive(Debug, Deserialize)]
+pub(crate) struct CommandLine {
+    #[serde(default)]
+    pub id: Option<u64>,
+    #[serde(flatten)]
+    pub command: Command,
+}
+
+/// Radio a `SET_RADIO` command tunes
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub(crate) enum Radio {
+    Com1,
+    Com1Standby,
+    Com2,
+    Com2Standby,
+    Nav1,
+    Nav2,
+}
+
+/// Autopilot target a `SET_AP` command sets
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub(crate) enum ApMode {
+    Alt,
+    Hdg,
+    Vs,
 }
 
+/// A command resolved to what it writes. Built from a parsed JSON [`Command`]
+/// or from a shared-memory ring record, so applying never allocates.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub(crate) enum Op {
+    Radio(Radio, i32),
+    Xpdr { code: i32, mode: Option<i32> },
+    Ap(ApMode, f32),
+    Rate(f32),
+}
+
+impl TryFrom<&Command> for Op {
+    type Error = anyhow::Error;
+
+    fn try_from(cmd: &Command) -> anyhow::Result<Self> {
+        Ok(match cmd {
+            Command::SetRadio {
+                target,
+                param,
+                value,
+            } => {
+                let radio = match (target.as_str(), param.as_str()) {
+                    ("COM1", "FREQUENCY") => Radio::Com1,
+                    ("COM1", "STANDBY") => Radio::Com1Standby,
+                    ("COM2", "FREQUENCY") => Radio::Com2,
+                    ("COM2", "STANDBY") => Radio::Com2Standby,
+                    ("NAV1", "FREQUENCY") => Radio::Nav1,
+                    ("NAV2", "FREQUENCY") => Radio::Nav2,
+                    _ => anyhow::bail!("Unsupported radio target/param: {}/{}", target, param),
+                };
+                Op::Radio(radio, *value)
+            }
+            Command::SetXpdr { code, mode } => Op::Xpdr {
+                code: *code,
+                mode: *mode,
+            },
+            Command::SetAp { mode, value } => {
+                let ap = match mode.as_str() {
+                    "ALT" => ApMode::Alt,
+                    "HDG" => ApMode::Hdg,
+                    "VS" => ApMode::Vs,
+                    _ => anyhow::bail!("Unsupported AP mode: {}", mode),
+                };
+                Op::Ap(ap, *value)
+            }
+            Command::SetRate { hz } => Op::Rate(*hz),
+            Command::SetAtc { .. } => anyhow::bail!("SET_ATC is state, not a DataRef write"),
+        })
+    }
+}
+
+/// Parse JSONL command text, appending valid commands to `out`.
+/// Returns the number of commands parsed.
+pub(crate) fn parse_command_lines(text: &str, out: &mut Vec<CommandLine>) -> usize {
+    let before = out.len();
+    for line in text.lines() {
+        if line.trim().is_empty() {
+            continue;
+        }
+        match serde_json::from_str::<CommandLine>(line) {
+            Ok(cmd) => out.push(cmd),
+            Err(e) => log::error!("Failed to parse command: {} (line: {})", e, line),
+        }
+    }
+    out.len() - before
+}
+
+/// One-shot command processing: read, apply and forget.
+///
+/// Kept for callers of `process_stratus_commands`; the plugin itself holds a
+/// long-lived [`Commander`] instead so DataRefs and the file stay resolved.
 pub struct CommandParser {
     command_path: PathBuf,
     pub status_path: PathBuf,
@@ -39,136 +174,268 @@ impl CommandParser {
         }
     }
 
+    /// Read and immediately apply all pending commands. Sim thread only.
     pub fn process_commands(&self) -> anyhow::Result<()> {
-        if !self.command_path.exists() {
-            return Ok(());
-        }
-
-        let mut file = OpenOptions::new()
-            .read(true)
-            .write(true)
-            .open(&self.command_path)?;
-
-        flock(file.as_raw_fd(), FlockArg::LockExclusive)?;
-
-        let mut commands = Vec::new();
-        {
-            let reader = BufReader::new(&file);
-            for line in reader.lines() {
-                let line = line?;
-                if line.trim().is_empty() {
-                    continue;
-                }
-                match serde_json::from_str::<Command>(&line) {
-                    Ok(cmd) => commands.push(cmd),
-                    Err(e) => log::error!("Failed to parse command: {} (line: {})", e, line),
-                }
-            }
-        }
+        let commander =
+            Commander::without_ring(self.command_path.clone(), self.status_path.clone());
+        commander.poll()?;
+        commander.apply();
+        Ok(())
+    }
+}
 
-        for cmd in commands {
-            if let Err(e) = self.execute_command(&cmd) {
-                log::error!("Failed to execute command: {:?}", e);
-            }
-        }
+unsafe fn path_from_c(path: *const i8) -> PathBuf {
+    PathBuf::from(CStr::from_ptr(path).to_string_lossy().into_owned())
+}
 
-        file.set_len(0)?;
-        file.seek(SeekFrom::Start(0))?;
+/// C FFI: process commands file.
+///
+/// # Safety
+/// Caller must pass valid, non-null pointers to NUL-terminated C strings that outlive the call.
+#[no_mangle]
+pub unsafe extern "C" fn process_stratus_commands(
+    command_path: *const i8,
+    status_path: *const i8,
+) -> i32 {
+    if command_path.is_null() || status_path.is_null() {
+        return -1;
+    }
 
-        flock(file.as_raw_fd(), FlockArg::Unlock)?;
+    let parser = CommandParser::new(path_from_c(command_path), path_from_c(status_path));
+    match parser.process_commands() {
+        Ok(_) => 0,
+        Err(_) => -1,
+    }
+}
 
-        Ok(())
+/// C FFI: create the long-lived command engine. Call once from the plugin's
+/// deferred init on the first flight-loop tick (sim thread); DataRefs are
+/// resolved here.
+///
+/// Returns NULL on invalid arguments.
+///
+/// # Safety
+/// Caller must pass valid, non-null pointers to NUL-terminated C strings.
+/// The paths are copied; they need not outlive the call.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_create(
+    command_path: *const i8,
+    status_path: *const i8,
+) -> *mut Commander {
+    if command_path.is_null() || status_path.is_null() {
+        return std::ptr::null_mut();
     }
 
-    fn execute_command(&self, cmd: &Command) -> anyhow::Result<()> {
-        match cmd {
-            Command::SetRadio {
-                target,
-                param,
-                value,
-            } => self.handle_set_radio(target, param, *value),
-            Command::SetXpdr { code, mode } => self.handle_set_xpdr(*code, *mode),
-            Command::SetAp { mode, value } => self.handle_set_ap(mode, *value),
+    let commander = Commander::new(path_from_c(command_path), path_from_c(status_path));
+    Box::into_raw(Box::new(commander))
+}
+
+/// C FFI: pick up new commands from the command file. Blocking file I/O;
+/// intended for the plugin's I/O thread.
+///
+/// Returns the number of commands queued, or -1 on error.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_poll(handle: *mut Commander) -> i32 {
+    let Some(commander) = handle.as_ref() else {
+        return -1;
+    };
+    match commander.poll() {
+        Ok(count) => count as i32,
+        Err(e) => {
+            log::error!("Failed to read commands: {:?}", e);
+            -1
         }
     }
+}
 
-    fn handle_set_radio(&self, target: &str, param: &str, value: i32) -> anyhow::Result<()> {
-        let dataref_path = match (target, param) {
-            ("COM1", "FREQUENCY") => "sim/cockpit2/radios/actuators/com1_frequency_hz_833",
-            ("COM1", "STANDBY") => "sim/cockpit2/radios/actuators/com1_standby_frequency_hz_833",
-            ("COM2", "FREQUENCY") => "sim/cockpit2/radios/actuators/com2_frequency_hz_833",
-            ("COM2", "STANDBY") => "sim/cockpit2/radios/actuators/com2_standby_frequency_hz_833",
-            ("NAV1", "FREQUENCY") => "sim/cockpit2/radios/actuators/nav1_frequency_hz",
-            ("NAV2", "FREQUENCY") => "sim/cockpit2/radios/actuators/nav2_frequency_hz",
-            _ => anyhow::bail!("Unsupported radio target/param: {}/{}", target, param),
-        };
-
-        if let Ok(dr) = DataRef::<i32>::find(dataref_path) {
-            if let Ok(mut drw) = dr.writeable() {
-                log::info!("Setting {} to {}", dataref_path, value);
-                drw.set(value);
-            }
+/// C FFI: queue `len` bytes of command-file lines received some other way
+/// (the plugin's UDP stream). Intended for the plugin's I/O thread.
+///
+/// Returns the number of commands queued, or -1 on error.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed;
+/// `text` must point to `len` readable bytes.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_submit(
+    handle: *mut Commander,
+    text: *const i8,
+    len: usize,
+) -> i32 {
+    let Some(commander) = handle.as_ref() else {
+        return -1;
+    };
+    if text.is_null() {
+        return -1;
+    }
+    let bytes = std::slice::from_raw_parts(text as *const u8, len);
+    let Ok(text) = std::str::from_utf8(bytes) else {
+        log::error!("Dropping command datagram: not UTF-8");
+        return -1;
+    };
+    match commander.submit(text) {
+        Ok(count) => count as i32,
+        Err(e) => {
+            log::error!("Failed to queue commands: {:?}", e);
+            -1
         }
-        Ok(())
     }
+}
 
-    fn handle_set_xpdr(&self, code: i32, mode: Option<i32>) -> anyhow::Result<()> {
-        if let Ok(dr_code) = DataRef::<i32>::find("sim/cockpit/radios/transponder_code") {
-            if let Ok(mut drw) = dr_code.writeable() {
-                drw.set(code);
-            }
-        }
-        if let Some(m) = mode {
-            if let Ok(dr_mode) = DataRef::<i32>::find("sim/cockpit/radios/transponder_mode") {
-                if let Ok(mut drw) = dr_mode.writeable() {
-                    drw.set(m);
-                }
-            }
-        }
-        Ok(())
+/// C FFI: apply queued commands, coalesced per target and most urgent
+/// first. Sim thread (flight loop) only.
+///
+/// Returns the number of commands applied, or -1 on invalid handle.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_apply(handle: *mut Commander) -> i32 {
+    match handle.as_ref() {
+        Some(commander) => commander.apply() as i32,
+        None => -1,
     }
+}
 
-    fn handle_set_ap(&self, mode: &str, value: f32) -> anyhow::Result<()> {
-        let dataref_path = match mode {
-            "ALT" => "sim/cockpit/autopilot/altitude",
-            "HDG" => "sim/cockpit/autopilot/heading_mag",
-            "VS" => "sim/cockpit/autopilot/vertical_velocity",
-            _ => anyhow::bail!("Unsupported AP mode: {}", mode),
-        };
+/// C FFI: cap the time one `stratus_commander_apply` spends writing
+/// commands, in microseconds (0: no cap). Commands that do not fit wait for
+/// the next call, most urgent first. Sim thread only.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_set_budget_us(handle: *mut Commander, budget_us: u32) {
+    if let Some(commander) = handle.as_ref() {
+        commander.set_apply_budget_ns(budget_us as u64 * 1000);
+    }
+}
 
-        if let Ok(dr) = DataRef::<f32>::find(dataref_path) {
-            if let Ok(mut drw) = dr.writeable() {
-                drw.set(value);
-            }
-        }
-        Ok(())
+/// C FFI: telemetry rate requested by a client (`SET_RATE`), or 0 if the
+/// plugin should use its own adaptive rate. Sim thread only.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_rate_hz(handle: *mut Commander) -> f32 {
+    match handle.as_ref() {
+        Some(commander) => commander.requested_rate_hz(),
+        None => 0.0,
     }
 }
 
-/// C FFI: process commands file.
+/// C FFI: copy the ATC state (see `atc.rs`) into `out` if it changed since
+/// `out` was last filled, going by `out.seq`; a zeroed `out` is always
+/// filled. Sim thread only.
+///
+/// Returns 1 if copied, 0 if unchanged, -1 on invalid arguments.
 ///
 /// # Safety
-/// Caller must pass valid, non-null pointers to NUL-terminated C strings that outlive the call.
+/// `handle` must come from `stratus_commander_create` and not be destroyed;
+/// `out` must point to a writable `AtcState`.
 #[no_mangle]
-pub unsafe extern "C" fn process_stratus_commands(
-    command_path: *const i8,
-    status_path: *const i8,
+pub unsafe extern "C" fn stratus_commander_atc_state(
+    handle: *mut Commander,
+    out: *mut AtcState,
 ) -> i32 {
-    use std::ffi::CStr;
+    match (handle.as_ref(), out.as_mut()) {
+        (Some(commander), Some(out)) => commander.atc_state(out) as i32,
+        _ => -1,
+    }
+}
 
-    if command_path.is_null() || status_path.is_null() {
+/// C FFI: carry out an ATC assignment (`atc::COMPLY_*`), for the plugin's
+/// `stratus/atc/*` commands. Sim thread only.
+///
+/// Returns the `ACK_*` result, or -1 on invalid handle.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_comply(handle: *mut Commander, action: u32) -> i32 {
+    match handle.as_ref() {
+        Some(commander) => commander.comply(action),
+        None => -1,
+    }
+}
+
+/// C FFI: write `field` (`radios.com1_standby_hz`, ...) to `dataref`
+/// (NULL: its stock DataRef), dividing by `scale` (0 = 1) and firing
+/// `command` (may be NULL) after each write. For aircraft profiles; sim
+/// thread only.
+///
+/// Returns 1 if mapped, 0 if the commander never writes `field`, -1 if the
+/// DataRef or command was not found (writes then fail) or on invalid
+/// arguments.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed;
+/// `field` must be a NUL-terminated string, `dataref` and `command` one or
+/// NULL.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_map(
+    handle: *mut Commander,
+    field: *const i8,
+    dataref: *const i8,
+    scale: f32,
+    command: *const i8,
+) -> i32 {
+    let Some(commander) = handle.as_ref() else {
         return -1;
+    };
+    let optional = |s: *const i8| -> Result<Option<&str>, ()> {
+        if s.is_null() {
+            return Ok(None);
+        }
+        CStr::from_ptr(s).to_str().map(Some).map_err(|_| ())
+    };
+    let (Ok(Some(field)), Ok(dataref), Ok(command)) =
+        (optional(field), optional(dataref), optional(command))
+    else {
+        return -1;
+    };
+    match commander.map_target(field, dataref, scale, command) {
+        MapResult::Mapped => 1,
+        MapResult::UnknownField => 0,
+        MapResult::NotFound => -1,
     }
+}
 
-    let c_cmd_path = CStr::from_ptr(command_path);
-    let c_stat_path = CStr::from_ptr(status_path);
+/// C FFI: undo every `stratus_commander_map`, before loading another
+/// aircraft's profile. Sim thread only.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` and not be destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_reset_map(handle: *mut Commander) {
+    if let Some(commander) = handle.as_ref() {
+        commander.reset_targets();
+    }
+}
 
-    let cmd_path = PathBuf::from(c_cmd_path.to_string_lossy().into_owned());
-    let stat_path = PathBuf::from(c_stat_path.to_string_lossy().into_owned());
+/// C FFI: publish a captured frame to in-process consumers (see
+/// `snapshot.rs`). Sim thread only; copies the frame, never blocks.
+///
+/// # Safety
+/// `frame` must point to a `StratusFrame` (or be NULL, which is ignored).
+#[no_mangle]
+pub unsafe extern "C" fn stratus_push_telemetry(frame: *const Frame) {
+    if let Some(frame) = frame.as_ref() {
+        TELEMETRY.publish(frame);
+    }
+}
 
-    let parser = CommandParser::new(cmd_path, stat_path);
-    match parser.process_commands() {
-        Ok(_) => 0,
-        Err(_) => -1,
+/// C FFI: destroy the command engine. Call from `XPluginStop` once the I/O
+/// thread has stopped.
+///
+/// # Safety
+/// `handle` must come from `stratus_commander_create` (or be NULL) and must
+/// not be used afterwards.
+#[no_mangle]
+pub unsafe extern "C" fn stratus_commander_destroy(handle: *mut Commander) {
+    if !handle.is_null() {
+        drop(Box::from_raw(handle));
     }
 }
@@ -0,0 +1,356 @@
+//! Shared-memory command ring (consumer side).
+//!
+//! The plugin creates the `/stratus_commands` POSIX shared-memory segment at
+//! start-up; clients map it and push fixed-size command records. Any number
+//! of client processes may push concurrently (multi-producer); the sim thread
+//! is the only consumer and drains the ring in [`Commander::apply`], so a
+//! command is applied on the first flight-loop tick after it was pushed.
+//! No locks, no syscalls and no allocation on either side once mapped.
+//!
+//! Every applied command is acknowledged in the same segment: the plugin
+//! appends an [`AckRecord`] with the command's ID, its result and when it was
+//! applied, and clients read the acks from their own cursor.
+//!
+//! ```text
+//! [RingHeader, 64 bytes][RingSlot x slot_count][AckSlot x ack_slot_count]
+//!
+//! RingHeader: u32 magic "STCM", u16 version, u16 slot_count,
+//!             u32 slot_size, u32 reserved,
+//!             u64 write_pos (next ticket, producers compare-and-swap it),
+//!             u64 read_pos  (next ticket to apply, consumer only),
+//!             u64 ack_pos   (acks written so far, plugin only),
+//!             u16 ack_slot_count, u16 ack_slot_size, reserved
+//! RingSlot:   u64 turn, CommandRecord (24 bytes)
+//! AckSlot:    u64 stamp, AckRecord (32 bytes)
+//! ```
+//!
+//! Slot `t % slot_count` belongs to ticket `t`. Its `turn` is `t` while the
+//! slot is free for that ticket, `t + 1` once the record is written and
+//! `t + slot_count` after the plugin has consumed it. A producer claims a
+//! ticket by compare-and-swap on `write_pos`; the ring is full when the slot
+//! for the next ticket has not been consumed yet. The ticket doubles as the
+//! command's sequence number.
+//!
+//! Ack `n` lives in slot `n % ack_slot_count`; its `stamp` is 0 while the
+//! plugin writes it and `n + 1` once complete, so a reader copies the record
+//! and re-checks the stamp (seqlock). Acks are overwritten a ring later; a
+//! reader that falls further behind skips ahead to the oldest one left.
+//!
+//! A client that dies between claiming a ticket and publishing its record
+//! stalls the ring until the plugin restarts; the file path keeps working.
+//!
+//! The client side lives in `stratus-core/src/command_ring.rs`; both must
+//! match this layout exactly.
+//!
+//! [`Commander::apply`]: crate::Commander::apply
+
+use crate::{ApMode, Op, Radio};
+use nix::fcntl::OFlag;
+use nix::sys::mman::{mmap, munmap, shm_open, shm_unlink, MapFlags, ProtFlags};
+use nix::sys::stat::Mode;
+use nix::unistd::ftruncate;
+use std::ffi::c_void;
+use std::mem::size_of;
+use std::num::NonZeroUsize;
+use std::ptr::NonNull;
+use std::sync::atomic::{fence, AtomicU32, AtomicU64, Ordering};
+
+/// Name of the segment created by the plugin
+pub const RING_NAME: &str = "/stratus_commands";
+/// Header magic ("STCM"); cleared by the plugin on shutdown
+pub const RING_MAGIC: u32 = 0x4D43_5453;
+/// Layout version
+pub const RING_VERSION: u16 = 3;
+/// Slots in the ring; also the most commands applied per tick
+pub const RING_SLOTS: usize = 64;
+/// Acks kept for readers
+pub const ACK_SLOTS: usize = 64;
+
+/// `CommandRecord::op` values
+pub const OP_SET_RADIO: u32 = 1;
+pub const OP_SET_XPDR: u32 = 2;
+pub const OP_SET_AP: u32 = 3;
+pub const OP_SET_RATE: u32 = 4;
+/// `SET_ATC` carries text, so it only arrives as a command line (file or
+/// UDP); the code is used in its acks
+pub const OP_SET_ATC: u32 = 5;
+
+/// `CommandRecord::target` values for `OP_SET_RADIO`
+pub const RADIO_COM1: u32 = 1;
+pub const RADIO_COM1_STANDBY: u32 = 2;
+pub const RADIO_COM2: u32 = 3;
+pub const RADIO_COM2_STANDBY: u32 = 4;
+pub const RADIO_NAV1: u32 = 5;
+pub const RADIO_NAV2: u32 = 6;
+
+/// `CommandRecord::target` values for `OP_SET_AP`
+pub const AP_ALT: u32 = 1;
+pub const AP_HDG: u32 = 2;
+pub const AP_VS: u32 = 3;
+
+/// `CommandRecord::mode` for `OP_SET_XPDR` when the mode should not change
+pub const XPDR_MODE_UNCHANGED: i32 = -1;
+
+/// `AckRecord::result` values
+pub const ACK_APPLIED: i32 = 0;
+/// Unknown op or target; nothing was written
+pub const ACK_UNSUPPORTED: i32 = 1;
+/// The target DataRef is missing or read-only in this aircraft
+pub const ACK_UNAVAILABLE: i32 = 2;
+/// A later command for the same target arrived before this one was applied;
+/// only the later one was written (see `batch.rs`)
+pub const ACK_SUPERSEDED: i32 = 3;
+
+/// `AckRecord::id` of a file command that carried no `"id"`
+pub const ACK_ID_NONE: u64 = u64::MAX;
+
+/// One typed command, as pushed by a client
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct CommandRecord {
+    pub op: u32,
+    /// `RADIO_*` or `AP_*`
+    pub target: u32,
+    /// Radio frequency (Hz) or transponder code
+    pub value_i: i32,
+    /// Transponder mode, `XPDR_MODE_UNCHANGED` to leave it
+    pub mode: i32,
+    /// Autopilot value or telemetry rate (Hz)
+    pub value_f: f32,
+    pub _reserved: u32,
+}
+
+/// The plugin's acknowledgement of one applied command
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AckRecord {
+    /// Ring sequence number, the file command's `"id"`, or `ACK_ID_NONE`
+    pub id: u64,
+    /// Plugin `CLOCK_MONOTONIC` when the command was applied, nanoseconds
+    pub applied_ns: u64,
+    /// `sim/time/total_flight_time_sec` when the command was applied, the
+    /// clock of the frame's `sim_time_s`
+    pub sim_time: f64,
+    /// `OP_*` of the command, 0 if unknown
+    pub op: u32,
+    /// `ACK_*`
+    pub result: i32,
+}
+
+#[repr(C)]
+struct RingHeader {
+    magic: AtomicU32,
+    version: u16,
+    slot_count: u16,
+    slot_size: u32,
+    _reserved0: u32,
+    write_pos: AtomicU64,
+    read_pos: AtomicU64,
+    ack_pos: AtomicU64,
+    ack_slot_count: u16,
+    ack_slot_size: u16,
+    _reserved1: [u8; 20],
+}
+
+#[repr(C)]
+struct RingSlot {
+    turn: AtomicU64,
+    record: CommandRecord,
+}
+
+#[repr(C)]
+struct AckSlot {
+    stamp: AtomicU64,
+    record: AckRecord,
+}
+
+const _: () = assert!(size_of::<CommandRecord>() == 24);
+const _: () = assert!(size_of::<AckRecord>() == 32);
+const _: () = assert!(size_of::<RingHeader>() == 64);
+const _: () = assert!(size_of::<RingSlot>() == 32);
+const _: () = assert!(size_of::<AckSlot>() == 40);
+
+const ACKS_OFFSET: usize = size_of::<RingHeader>() + RING_SLOTS * size_of::<RingSlot>();
+const RING_SIZE: usize = ACKS_OFFSET + ACK_SLOTS * size_of::<AckSlot>();
+
+impl Op {
+    /// Decode a ring record; `None` for unknown ops or targets
+    pub(crate) fn from_record(r: &CommandRecord) -> Option<Self> {
+        Some(match r.op {
+            OP_SET_RADIO => {
+                let radio = match r.target {
+                    RADIO_COM1 => Radio::Com1,
+                    RADIO_COM1_STANDBY => Radio::Com1Standby,
+                    RADIO_COM2 => Radio::Com2,
+                    RADIO_COM2_STANDBY => Radio::Com2Standby,
+                    RADIO_NAV1 => Radio::Nav1,
+                    RADIO_NAV2 => Radio::Nav2,
+                    _ => return None,
+                };
+                Op::Radio(radio, r.value_i)
+            }
+            OP_SET_XPDR => Op::Xpdr {
+                code: r.value_i,
+                mode: (r.mode != XPDR_MODE_UNCHANGED).then_some(r.mode),
+            },
+            OP_SET_AP => {
+                let mode = match r.target {
+                    AP_ALT => ApMode::Alt,
+                    AP_HDG => ApMode::Hdg,
+                    AP_VS => ApMode::Vs,
+                    _ => return None,
+                };
+                Op::Ap(mode, r.value_f)
+            }
+            OP_SET_RATE => Op::Rate(r.value_f),
+            _ => return None,
+        })
+    }
+
+    /// `OP_*` code, for acks
+    pub(crate) fn code(&self) -> u32 {
+        match self {
+            Op::Radio(..) => OP_SET_RADIO,
+            Op::Xpdr { .. } => OP_SET_XPDR,
+            Op::Ap(..) => OP_SET_AP,
+            Op::Rate(_) => OP_SET_RATE,
+        }
+    }
+}
+
+/// The plugin's end of the ring: creates the segment and consumes it
+pub struct CommandRing {
+    name: String,
+    base: NonNull<c_void>,
+    read_pos: u64,
+    ack_pos: u64,
+}
+
+// Only the sim thread consumes; producers synchronise through `turn`
+unsafe impl Send for CommandRing {}
+
+impl CommandRing {
+    /// Create the plugin's segment
+    pub fn create() -> anyhow::Result<Self> {
+        Self::create_named(RING_NAME)
+    }
+
+    /// Create (or re-create) a segment by name (tests use private names)
+    pub fn create_named(name: &str) -> anyhow::Result<Self> {
+        // Start from a fresh segment so stale clients see a new mapping
+        let _ = shm_unlink(name);
+        let fd = shm_open(
+            name,
+            OFlag::O_CREAT | OFlag::O_RDWR,
+            Mode::from_bits_truncate(0o600),
+        )?;
+        let mapped = ftruncate(&fd, RING_SIZE as i64).and_then(|_| {
+            // SAFETY: fresh shared mapping of a descriptor we just sized
+            unsafe {
+                mmap(
+                    None,
+                    NonZeroUsize::new(RING_SIZE).unwrap(),
+                    ProtFlags::PROT_READ | ProtFlags::PROT_WRITE,
+                    MapFlags::MAP_SHARED,
+                    &fd,
+                    0,
+                )
+            }
+        });
+        let base = match mapped {
+            Ok(base) => base,
+            Err(e) => {
+                let _ = shm_unlink(name);
+                return Err(e.into());
+            }
+        };
+
+        let ring = Self {
+            name: name.to_string(),
+            base,
+            read_pos: 0,
+            ack_pos: 0,
+        };
+        // SAFETY: the mapping is zero-filled and RING_SIZE bytes long; no
+        // client trusts the header until the magic is set below.
+        unsafe {
+            let header = base.as_ptr() as *mut RingHeader;
+            std::ptr::addr_of_mut!((*header).version).write(RING_VERSION);
+            std::ptr::addr_of_mut!((*header).slot_count).write(RING_SLOTS as u16);
+            std::ptr::addr_of_mut!((*header).slot_size).write(size_of::<RingSlot>() as u32);
+            std::ptr::addr_of_mut!((*header).ack_slot_count).write(ACK_SLOTS as u16);
+            std::ptr::addr_of_mut!((*header).ack_slot_size).write(size_of::<AckSlot>() as u16);
+        }
+        for t in 0..RING_SLOTS as u64 {
+            ring.slot(t).turn.store(t, Ordering::Relaxed);
+        }
+        // Magic last: clients only push once it is set
+        ring.header().magic.store(RING_MAGIC, Ordering::Release);
+        Ok(ring)
+    }
+
+    fn header(&self) -> &RingHeader {
+        // SAFETY: the mapping is RING_SIZE bytes long
+        unsafe { &*(self.base.as_ptr() as *const RingHeader) }
+    }
+
+    fn slot(&self, ticket: u64) -> &RingSlot {
+        let offset =
+            size_of::<RingHeader>() + (ticket % RING_SLOTS as u64) as usize * size_of::<RingSlot>();
+        // SAFETY: offset is within the mapping
+        unsafe { &*((self.base.as_ptr() as *const u8).add(offset) as *const RingSlot) }
+    }
+
+    fn ack_slot(&self, index: u64) -> *mut AckSlot {
+        let offset = ACKS_OFFSET + (index % ACK_SLOTS as u64) as usize * size_of::<AckSlot>();
+        // SAFETY: offset is within the mapping
+        unsafe { (self.base.as_ptr() as *mut u8).add(offset) as *mut AckSlot }
+    }
+
+    /// Take the next published record with its sequence number, if any.
+    /// Sim thread only.
+    pub fn pop(&mut self) -> Option<(u64, CommandRecord)> {
+        let ticket = self.read_pos;
+        let slot = self.slot(ticket);
+        if slot.turn.load(Ordering::Acquire) != ticket + 1 {
+            return None;
+        }
+        // SAFETY: the producer finished writing before its Release store of
+        // `turn`, and will not touch the slot again until we hand it back
+        let record = unsafe { std::ptr::read_volatile(&slot.record) };
+        slot.turn
+            .store(ticket + RING_SLOTS as u64, Ordering::Release);
+        self.read_pos = ticket + 1;
+        self.header()
+            .read_pos
+            .store(self.read_pos, Ordering::Release);
+        Some((ticket, record))
+    }
+
+    /// Publish an ack for readers. Sim thread only.
+    pub fn ack(&mut self, record: &AckRecord) {
+        let index = self.ack_pos;
+        let slot = self.ack_slot(index);
+        // SAFETY: in-bounds slot; only this thread writes acks, and readers
+        // discard any copy whose stamp changed while they read it
+        unsafe {
+            let stamp = &(*slot).stamp;
+            stamp.store(0, Ordering::Relaxed);
+            fence(Ordering::Release);
+            std::ptr::addr_of_mut!((*slot).record).write_volatile(*record);
+            stamp.store(index + 1, Ordering::Release);
+        }
+        self.ack_pos = index + 1;
+        self.header().ack_pos.store(self.ack_pos, Ordering::Release);
+    }
+}
+
+impl Drop for CommandRing {
+    fn drop(&mut self) {
+        // Tell clients to stop pushing and fall back until we are back
+        self.header().magic.store(0, Ordering::Release);
+        // SAFETY: base came from our own successful mmap of RING_SIZE bytes
+        let _ = unsafe { munmap(self.base, RING_SIZE) };
+        let _ = shm_unlink(self.name.as_str());
+    }
+}
@@ -0,0 +1,105 @@
+//! Latest telemetry frame for consumers inside the plugin's process.
+//!
+//! With `in_process = on` the plugin hands every captured frame to
+//! `stratus_push_telemetry` on the sim thread, which publishes it in
+//! [`TELEMETRY`]. Worker threads in the same process (anything linked into
+//! the `.xpl` alongside this library) read it from there: no serialization,
+//! no IPC, no syscalls.
+//!
+//! Two buffers alternate: frame `n` goes into buffer `n % 2`, so the writer
+//! never touches the buffer holding the frame readers were just pointed at.
+//! Each buffer's `stamp` is 0 while it is written and `n` once complete; a
+//! reader copies the buffer `published` points at and re-checks the stamp
+//! (seqlock), retrying in the rare case the writer lapped it. Neither side
+//! locks, and the writer never waits for readers.
+
+use crate::frame::Frame;
+use std::cell::UnsafeCell;
+use std::sync::atomic::{fence, AtomicU64, Ordering};
+
+struct Buffer {
+    stamp: AtomicU64,
+    frame: UnsafeCell<Frame>,
+}
+
+impl Buffer {
+    const fn empty() -> Self {
+        Self {
+            stamp: AtomicU64::new(0),
+            frame: UnsafeCell::new(Frame::ZERO),
+        }
+    }
+}
+
+/// Double-buffered latest frame: one writer, any number of readers
+pub struct TelemetrySnapshot {
+    /// Frames published so far; the latest is in `buffers[published % 2]`
+    published: AtomicU64,
+    buffers: [Buffer; 2],
+}
+
+// SAFETY: frames are only written through `publish` (one writer, see
+// there) and readers discard copies whose stamp changed while they read
+unsafe impl Sync for TelemetrySnapshot {}
+
+/// The plugin's telemetry, fed by `stratus_push_telemetry`
+pub static TELEMETRY: TelemetrySnapshot = TelemetrySnapshot::new();
+
+impl TelemetrySnapshot {
+    pub const fn new() -> Self {
+        Self {
+            published: AtomicU64::new(0),
+            buffers: [Buffer::empty(), Buffer::empty()],
+        }
+    }
+
+    /// Publish `frame` as the latest. One writer at a time: the plugin calls
+    /// this from the sim thread only.
+    pub fn publish(&self, frame: &Frame) {
+        let n = self.published.load(Ordering::Relaxed) + 1;
+        let buffer = &self.buffers[(n % 2) as usize];
+        buffer.stamp.store(0, Ordering::Relaxed);
+        fence(Ordering::Release);
+        // SAFETY: only this writer stores frames; readers check the stamp
+        unsafe { buffer.frame.get().write_volatile(*frame) };
+        buffer.stamp.store(n, Ordering::Release);
+        self.published.store(n, Ordering::Release);
+    }
+
+    /// Frames published so far; 0 before the first
+    pub fn published(&self) -> u64 {
+        self.published.load(Ordering::Acquire)
+    }
+
+    /// Latest frame, or `None` before the first
+    pub fn latest(&self) -> Option<Frame> {
+        self.newer_than(0).map(|(_, frame)| frame)
+    }
+
+    /// Latest frame with its publish count, if one was published after
+    /// `seen` (a count returned earlier, or 0). For workers that poll.
+    pub fn newer_than(&self, seen: u64) -> Option<(u64, Frame)> {
+        loop {
+            let n = self.published.load(Ordering::Acquire);
+            if n <= seen {
+                return None;
+            }
+            let buffer = &self.buffers[(n % 2) as usize];
+            if buffer.stamp.load(Ordering::Acquire) != n {
+                continue; // Lapped: already being rewritten, look again
+            }
+            // SAFETY: a torn copy is possible, and discarded below
+            let frame = unsafe { buffer.frame.get().read_volatile() };
+            fence(Ordering::Acquire);
+            if buffer.stamp.load(Ordering::Relaxed) == n {
+                return Some((n, frame));
+            }
+        }
+    }
+}
+
+impl Default for TelemetrySnapshot {
+    fn default() -> Self {
+        Self::new()
+    }
+}
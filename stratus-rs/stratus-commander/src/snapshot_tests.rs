@@ -0,0 +1,120 @@
+//! Unit tests for the in-process telemetry snapshot
+
+use crate::frame::Frame;
+use crate::snapshot::TelemetrySnapshot;
+use std::sync::atomic::{AtomicBool, Ordering};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const ENGINES: usize = crate::frame::MAX_ENGINES;
+
+    /// Frame `seq`, with every other field it sets derived from `seq`
+    fn frame(seq: u64) -> Frame {
+        let mut f = Frame::ZERO;
+        f.frame_seq = seq;
+        f.monotonic_ns = seq * 7;
+        f.latitude = seq as f64 * 0.5;
+        f.com1_hz = seq as i32;
+        for (k, running) in f.engine_running.iter_mut().enumerate() {
+            *running = seq as i32 + k as i32;
+        }
+        f.event_seq = !(seq as u32);
+        f
+    }
+
+    /// True if `f` is `frame(f.frame_seq)` throughout, not a mix of two
+    fn whole(f: &Frame) -> bool {
+        let seq = f.frame_seq;
+        f.monotonic_ns == seq * 7
+            && f.latitude == seq as f64 * 0.5
+            && f.com1_hz == seq as i32
+            && (0..ENGINES).all(|k| f.engine_running[k] == seq as i32 + k as i32)
+            && f.event_seq == !(seq as u32)
+    }
+
+    #[test]
+    fn test_nothing_published() {
+        let snapshot = TelemetrySnapshot::new();
+        assert_eq!(snapshot.published(), 0);
+        assert!(snapshot.latest().is_none());
+        assert!(snapshot.newer_than(0).is_none());
+    }
+
+    #[test]
+    fn test_publish_and_latest() {
+        let snapshot = TelemetrySnapshot::new();
+        snapshot.publish(&frame(10));
+        assert_eq!(snapshot.published(), 1);
+        assert_eq!(snapshot.latest().unwrap().frame_seq, 10);
+
+        snapshot.publish(&frame(11));
+        snapshot.publish(&frame(12));
+        assert_eq!(snapshot.published(), 3);
+        let latest = snapshot.latest().unwrap();
+        assert_eq!(latest.frame_seq, 12);
+        assert!(whole(&latest));
+    }
+
+    #[test]
+    fn test_newer_than() {
+        let snapshot = TelemetrySnapshot::new();
+        snapshot.publish(&frame(1));
+
+        let (seen, f) = snapshot.newer_than(0).unwrap();
+        assert_eq!((seen, f.frame_seq), (1, 1));
+        assert!(snapshot.newer_than(seen).is_none());
+
+        // Frames published in between are skipped, not queued
+        snapshot.publish(&frame(2));
+        snapshot.publish(&frame(3));
+        let (seen, f) = snapshot.newer_than(seen).unwrap();
+        assert_eq!((seen, f.frame_seq), (3, 3));
+        assert!(snapshot.newer_than(seen).is_none());
+        assert!(snapshot.newer_than(seen + 5).is_none());
+    }
+
+    #[test]
+    fn test_readers_never_see_torn_frames() {
+        const FRAMES: u64 = 1_000_000;
+        let snapshot = TelemetrySnapshot::new();
+        let done = AtomicBool::new(false);
+
+        std::thread::scope(|s| {
+            // Readers that copy back to back, so the writer laps them mid-copy
+            for _ in 0..2 {
+                s.spawn(|| {
+                    let mut last_seq = 0;
+                    while !done.load(Ordering::Relaxed) {
+                        let Some(f) = snapshot.latest() else {
+                            continue;
+                        };
+                        assert!(whole(&f), "torn frame {}", f.frame_seq);
+                        assert!(f.frame_seq >= last_seq, "went back");
+                        last_seq = f.frame_seq;
+                    }
+                });
+            }
+            // A poller: publish n carries frame n, and counts only go up
+            s.spawn(|| {
+                let mut seen = 0;
+                while seen < FRAMES {
+                    if let Some((n, f)) = snapshot.newer_than(seen) {
+                        assert!(whole(&f), "torn frame {}", f.frame_seq);
+                        assert!(n > seen);
+                        assert_eq!(f.frame_seq, n);
+                        seen = n;
+                    }
+                }
+            });
+            s.spawn(|| {
+                for seq in 1..=FRAMES {
+                    snapshot.publish(&frame(seq));
+                }
+                done.store(true, Ordering::Relaxed);
+            });
+        });
+        assert_eq!(snapshot.latest().unwrap().frame_seq, FRAMES);
+    }
+}
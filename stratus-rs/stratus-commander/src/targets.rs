@@ -0,0 +1,261 @@
+//! Write targets: the DataRefs commands write into.
+//!
+//! Every field a command can set has one slot in a flat table, named
+//! `<section>.<key>` as in the telemetry (`radios.com1_standby_hz`,
+//! `autopilot.altitude_ft`, ...) and resolved from its stock DataRef when the
+//! commander is created. An aircraft profile (see the plugin's
+//! `stratus_profile.h`) remaps slots to the aircraft's own DataRefs, with a
+//! scale and optionally a command fired after each write. Names are only
+//! matched then; applying a command indexes the table.
+
+use crate::{ApMode, Op, Radio};
+use std::ffi::{c_char, c_void, CString};
+use xplm::data::borrowed::DataRef;
+use xplm::data::{DataRead, DataReadWrite, ReadOnly, ReadWrite};
+
+// Commands are not wrapped by the `xplm` crate version in use
+extern "C" {
+    fn XPLMFindCommand(name: *const c_char) -> *mut c_void;
+    fn XPLMCommandOnce(command: *mut c_void);
+}
+
+const COM1: usize = 0;
+const COM1_STANDBY: usize = 1;
+const COM2: usize = 2;
+const COM2_STANDBY: usize = 3;
+const NAV1: usize = 4;
+const NAV2: usize = 5;
+const XPDR_CODE: usize = 6;
+const XPDR_MODE: usize = 7;
+const AP_ALTITUDE: usize = 8;
+const AP_HEADING: usize = 9;
+const AP_VS: usize = 10;
+const TARGET_COUNT: usize = 11;
+
+/// Field name and stock DataRef of each slot
+const FIELDS: [(&str, &str); TARGET_COUNT] = [
+    (
+        "radios.com1_hz",
+        "sim/cockpit2/radios/actuators/com1_frequency_hz_833",
+    ),
+    (
+        "radios.com1_standby_hz",
+        "sim/cockpit2/radios/actuators/com1_standby_frequency_hz_833",
+    ),
+    (
+        "radios.com2_hz",
+        "sim/cockpit2/radios/actuators/com2_frequency_hz_833",
+    ),
+    (
+        "radios.com2_standby_hz",
+        "sim/cockpit2/radios/actuators/com2_standby_frequency_hz_833",
+    ),
+    (
+        "radios.nav1_hz",
+        "sim/cockpit2/radios/actuators/nav1_frequency_hz",
+    ),
+    (
+        "radios.nav2_hz",
+        "sim/cockpit2/radios/actuators/nav2_frequency_hz",
+    ),
+    ("transponder.code", "sim/cockpit/radios/transponder_code"),
+    ("transponder.mode", "sim/cockpit/radios/transponder_mode"),
+    ("autopilot.altitude_ft", "sim/cockpit/autopilot/altitude"),
+    ("autopilot.heading", "sim/cockpit/autopilot/heading_mag"),
+    (
+        "autopilot.vs_fpm",
+        "sim/cockpit/autopilot/vertical_velocity",
+    ),
+];
+
+/// A writable DataRef in whichever type it was published with
+enum Handle {
+    Int(DataRef<i32, ReadWrite>),
+    Float(DataRef<f32, ReadWrite>),
+    Double(DataRef<f64, ReadWrite>),
+}
+
+impl Handle {
+    fn find(name: &str) -> Option<Self> {
+        if let Some(dr) = DataRef::<i32>::find(name)
+            .ok()
+            .and_then(|d| d.writeable().ok())
+        {
+            return Some(Handle::Int(dr));
+        }
+        if let Some(dr) = DataRef::<f32>::find(name)
+            .ok()
+            .and_then(|d| d.writeable().ok())
+        {
+            return Some(Handle::Float(dr));
+        }
+        let dr = DataRef::<f64>::find(name)
+            .ok()
+            .and_then(|d| d.writeable().ok());
+        if dr.is_none() {
+            log::warn!("DataRef not found or not writable: {}", name);
+        }
+        dr.map(Handle::Double)
+    }
+
+    fn set(&mut self, value: f64) {
+        match self {
+            Handle::Int(dr) => dr.set(value.round() as i32),
+            Handle::Float(dr) => dr.set(value as f32),
+            Handle::Double(dr) => dr.set(value),
+        }
+    }
+}
+
+/// A command fired after writes to a remapped slot
+struct CommandHook(*mut c_void);
+
+impl CommandHook {
+    fn find(name: &str) -> Option<Self> {
+        let c_name = CString::new(name).ok()?;
+        // SAFETY: NUL-terminated name; sim thread, like every caller here
+        let command = unsafe { XPLMFindCommand(c_name.as_ptr()) };
+        if command.is_null() {
+            log::warn!("Command not found: {}", name);
+            return None;
+        }
+        Some(CommandHook(command))
+    }
+
+    fn fire(&self) {
+        // SAFETY: a command ref from XPLMFindCommand stays valid for the session
+        unsafe { XPLMCommandOnce(self.0) }
+    }
+}
+
+struct Slot {
+    handle: Option<Handle>,
+    /// Telemetry value = DataRef value * scale, so writes divide by it
+    scale: f64,
+    command: Option<CommandHook>,
+    /// Set by a profile
+    remapped: bool,
+}
+
+impl Slot {
+    fn stock(index: usize) -> Self {
+        Slot {
+            handle: Handle::find(FIELDS[index].1),
+            scale: 1.0,
+            command: None,
+            remapped: false,
+        }
+    }
+
+    fn write(&mut self, value: f64) -> bool {
+        let Some(handle) = &mut self.handle else {
+            return false;
+        };
+        handle.set(value / self.scale);
+        if let Some(command) = &self.command {
+            command.fire();
+        }
+        true
+    }
+}
+
+/// Outcome of [`Targets::map`]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum MapResult {
+    Mapped,
+    UnknownField,
+    /// The DataRef or command does not exist (or is read-only); writes to
+    /// the field report `ACK_UNAVAILABLE` rather than go to the stock one
+    NotFound,
+}
+
+/// Writable DataRefs used by command handlers, indexed by slot
+pub(crate) struct Targets {
+    slots: [Slot; TARGET_COUNT],
+    sim_time: Option<DataRef<f32, ReadOnly>>,
+}
+
+impl Targets {
+    /// Resolve every slot to its stock DataRef
+    pub(crate) fn resolve() -> Self {
+        Self {
+            slots: std::array::from_fn(Slot::stock),
+            sim_time: DataRef::find("sim/time/total_flight_time_sec").ok(),
+        }
+    }
+
+    /// The sim clock frames are stamped with (`StratusFrame::sim_time_s`),
+    /// widened the same way so an ack and a frame compare exactly
+    pub(crate) fn sim_time(&self) -> f64 {
+        self.sim_time.as_ref().map_or(0.0, |dr| dr.get() as f64)
+    }
+
+    /// Point `field` at `dataref` (`None`: its stock DataRef), scaled as in
+    /// the profile (0 = 1), with `command` fired after each write
+    pub(crate) fn map(
+        &mut self,
+        field: &str,
+        dataref: Option<&str>,
+        scale: f32,
+        command: Option<&str>,
+    ) -> MapResult {
+        let Some(index) = FIELDS.iter().position(|(name, _)| *name == field) else {
+            return MapResult::UnknownField;
+        };
+        let slot = &mut self.slots[index];
+        slot.handle = Handle::find(dataref.unwrap_or(FIELDS[index].1));
+        slot.scale = if scale != 0.0 { scale as f64 } else { 1.0 };
+        slot.command = command.and_then(CommandHook::find);
+        slot.remapped = true;
+        if slot.handle.is_none() || (command.is_some() && slot.command.is_none()) {
+            return MapResult::NotFound;
+        }
+        MapResult::Mapped
+    }
+
+    /// Back to the stock DataRefs, for an aircraft without a profile
+    pub(crate) fn reset(&mut self) {
+        for (index, slot) in self.slots.iter_mut().enumerate() {
+            if slot.remapped {
+                *slot = Slot::stock(index);
+            }
+        }
+    }
+
+    /// Write `op` to its slots. False if a DataRef it needs is missing.
+    pub(crate) fn execute(&mut self, op: Op) -> bool {
+        match op {
+            Op::Radio(radio, value) => {
+                let index = match radio {
+                    Radio::Com1 => COM1,
+                    Radio::Com1Standby => COM1_STANDBY,
+                    Radio::Com2 => COM2,
+                    Radio::Com2Standby => COM2_STANDBY,
+                    Radio::Nav1 => NAV1,
+                    Radio::Nav2 => NAV2,
+                };
+                log::info!("Setting {:?} to {}", radio, value);
+                self.slots[index].write(value as f64)
+            }
+            Op::Xpdr { code, mode } => {
+                if !self.slots[XPDR_CODE].write(code as f64) {
+                    return false;
+                }
+                match mode {
+                    Some(m) => self.slots[XPDR_MODE].write(m as f64),
+                    None => true,
+                }
+            }
+            Op::Ap(mode, value) => {
+                let index = match mode {
+                    ApMode::Alt => AP_ALTITUDE,
+                    ApMode::Hdg => AP_HEADING,
+                    ApMode::Vs => AP_VS,
+                };
+                self.slots[index].write(value as f64)
+            }
+            // Plugin settings, not DataRefs; handled by Commander::run
+            Op::Rate(_) => true,
+        }
+    }
+}
@@ -4,7 +4,7 @@
 
 use crate::commands::Command;
 use crate::ollama::OllamaClient;
-use crate::telemetry::Telemetry;
+use crate::telemetry::{Derived, Telemetry};
 use serde::{Deserialize, Serialize};
 use stratus_bitnet::BitNetClient;
 
@@ -30,6 +30,28 @@ fn parse_frequency(s: &str) -> i32 {
     s.parse::<i32>().unwrap_or(0)
 }
 
+/// Where the aircraft is relative to the nearest airport, from the plugin's
+/// derived state; `None` without one
+pub(crate) fn location_summary(derived: &Derived) -> Option<String> {
+    if derived.airport.is_empty() {
+        return None;
+    }
+    let mut out = format!(
+        "{:.1} nm from {}, bearing {:03.0}° true",
+        derived.airport_dist_nm, derived.airport, derived.airport_bearing_deg
+    );
+    if derived.on_runway {
+        out.push_str(&format!(", on runway {}", derived.runway));
+    } else if !derived.runway.is_empty() && derived.runway_dist_ft < 1000.0 {
+        out.push_str(&format!(
+            ", {:.0} ft from runway {}",
+            derived.runway_dist_ft, derived.runway
+        ));
+    }
+    out.push_str(&format!(", phase {}", derived.phase().as_str()));
+    Some(out)
+}
+
 /// ATC Engine - manages the conversation and prompt construction
 #[derive(Debug, Clone)]
 pub struct AtcEngine {
@@ -38,6 +60,17 @@ pub struct AtcEngine {
     callsign: String,
     aircraft_type: String,
     state: VfrState,
+    assigned: Assignments,
+}
+
+/// What ATC has told the pilot so far, for the plugin's `stratus/atc/*`
+/// DataRefs (see `atc_state_command`)
+#[derive(Debug, Clone, Default)]
+struct Assignments {
+    squawk: Option<i32>,
+    altitude_ft: Option<f32>,
+    heading_deg: Option<f32>,
+    clearance: Option<String>,
 }
 
 #[derive(Debug, Clone)]
@@ -129,6 +162,7 @@ impl AtcEngine {
             callsign: config.aircraft.callsign.clone(),
             aircraft_type: config.aircraft.aircraft_type.clone(),
             state: VfrState::Parked,
+            assigned: Assignments::default(),
         }
     }
 
@@ -161,6 +195,7 @@ impl AtcEngine {
 
 AIRCRAFT: {callsign} ({aircraft_type})
 POSITION: {state} at {altitude_ft} ft MSL, heading {heading}°, {ground_speed_kts} kts
+LOCATION: {location}
 SQUAWK: {squawk:04}
 
 RULES:
@@ -181,6 +216,8 @@ Supported commands:
             altitude_ft = altitude_ft,
             heading = heading,
             ground_speed_kts = ground_speed_kts,
+            location = location_summary(&telemetry.derived)
+                .unwrap_or_else(|| "no airport nearby".to_string()),
             squawk = telemetry.transponder.code,
         )
     }
@@ -300,6 +337,7 @@ Supported commands:
                 .map_err(|e| e.to_string())?,
         };
         let (speech_text, commands) = self.parse_response(&raw_response);
+        self.note_assignments(&speech_text, &commands);
 
         // Add ATC response to history
         self.conversation_history.push(ConversationEntry {
@@ -398,6 +436,38 @@ Supported commands:
     pub fn clear_history(&mut self) {
         self.conversation_history.clear();
     }
+
+    /// Remember the squawk, altitude and heading a response assigned, and
+    /// its text as the latest clearance
+    fn note_assignments(&mut self, speech_text: &str, commands: &[Command]) {
+        for command in commands {
+            match command {
+                Command::SetXpdr { code, .. } => self.assigned.squawk = Some(*code),
+                Command::SetAp { mode, value } if mode == "ALT" => {
+                    self.assigned.altitude_ft = Some(*value)
+                }
+                Command::SetAp { mode, value } if mode == "HDG" => {
+                    self.assigned.heading_deg = Some(*value)
+                }
+                _ => {}
+            }
+        }
+        if !speech_text.is_empty() {
+            self.assigned.clearance = Some(speech_text.to_string());
+        }
+    }
+
+    /// A `SET_ATC` command carrying everything assigned so far and the
+    /// frequency expected for the current phase, for the plugin to publish
+    pub fn atc_state_command(&self) -> Command {
+        Command::SetAtc {
+            squawk: self.assigned.squawk,
+            frequency: Some(self.expected_frequency()),
+            altitude_ft: self.assigned.altitude_ft,
+            heading_deg: self.assigned.heading_deg,
+            clearance: self.assigned.clearance.clone(),
+        }
+    }
 }
 
 #[cfg(test)]
@@ -1,7 +1,8 @@
 //! Unit tests for AtcEngine command parsing
 
-use crate::atc::AtcEngine;
+use crate::atc::{location_summary, AtcEngine};
 use crate::commands::Command;
+use crate::telemetry::Derived;
 
 #[cfg(test)]
 mod tests {
@@ -126,4 +127,48 @@ mod tests {
         assert_eq!(commands.len(), 1);
         assert_eq!(speech, "and some text");
     }
+
+    #[test]
+    fn test_atc_state_before_any_clearance() {
+        let engine = make_engine();
+        match engine.atc_state_command() {
+            Command::SetAtc {
+                squawk,
+                frequency,
+                clearance,
+                ..
+            } => {
+                assert_eq!(squawk, None);
+                assert_eq!(frequency, Some(engine.expected_frequency()));
+                assert_eq!(clearance, None);
+            }
+            _ => panic!("Expected SetAtc command"),
+        }
+    }
+
+    #[test]
+    fn test_location_summary() {
+        assert_eq!(location_summary(&Derived::default()), None);
+
+        let mut derived = Derived {
+            phase: 2,
+            airport: "KPAO".to_string(),
+            airport_dist_nm: 0.4,
+            airport_bearing_deg: 95.0,
+            runway: "31".to_string(),
+            runway_dist_ft: 250.0,
+            ..Default::default()
+        };
+        assert_eq!(
+            location_summary(&derived).unwrap(),
+            "0.4 nm from KPAO, bearing 095° true, 250 ft from runway 31, phase TAXI_OUT"
+        );
+
+        derived.on_runway = true;
+        derived.phase = 3;
+        assert_eq!(
+            location_summary(&derived).unwrap(),
+            "0.4 nm from KPAO, bearing 095° true, on runway 31, phase TAKEOFF"
+        );
+    }
 }
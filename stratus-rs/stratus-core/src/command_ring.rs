@@ -0,0 +1,512 @@
+//! Shared-memory command ring (client side)
+//!
+//! Pushes typed, fixed-size command records into the `/stratus_commands`
+//! segment the plugin creates (`stratus-commander/src/ring.rs`, which also
+//! documents the layout; the header, slot and record layouts here must match
+//! it exactly). The plugin applies pushed commands on its next flight-loop
+//! tick. Pushing never locks and never blocks: a full ring is an error the
+//! caller can fall back from.
+//!
+//! The plugin acknowledges every command it applies in the same segment;
+//! [`AckReader`] follows those acks and times each tracked command from push
+//! to apply.
+
+use crate::commands::Command;
+use anyhow::{anyhow, bail, Result};
+use nix::fcntl::OFlag;
+use nix::sys::mman::{mmap, munmap, shm_open, MapFlags, ProtFlags};
+use nix::sys::stat::{fstat, Mode};
+use nix::time::{clock_gettime, ClockId};
+use std::collections::HashMap;
+use std::ffi::c_void;
+use std::mem::size_of;
+use std::num::NonZeroUsize;
+use std::ptr::NonNull;
+use std::sync::atomic::{fence, AtomicU32, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+/// Name of the segment created by the plugin
+pub const COMMAND_RING_NAME: &str = "/stratus_commands";
+/// Header magic ("STCM"); cleared by the plugin on shutdown
+pub const COMMAND_RING_MAGIC: u32 = 0x4D43_5453;
+/// Layout version
+pub const COMMAND_RING_VERSION: u16 = 3;
+
+const OP_SET_RADIO: u32 = 1;
+const OP_SET_XPDR: u32 = 2;
+const OP_SET_AP: u32 = 3;
+const OP_SET_RATE: u32 = 4;
+
+const RADIO_COM1: u32 = 1;
+const RADIO_COM1_STANDBY: u32 = 2;
+const RADIO_COM2: u32 = 3;
+const RADIO_COM2_STANDBY: u32 = 4;
+const RADIO_NAV1: u32 = 5;
+const RADIO_NAV2: u32 = 6;
+
+const AP_ALT: u32 = 1;
+const AP_HDG: u32 = 2;
+const AP_VS: u32 = 3;
+
+const XPDR_MODE_UNCHANGED: i32 = -1;
+
+/// `CommandAck::id` of a file command sent without an ID
+pub const ACK_ID_NONE: u64 = u64::MAX;
+
+/// How often `AckReader` retries attaching while the plugin is away
+pub(crate) const ATTACH_RETRY_INTERVAL: Duration = Duration::from_secs(1);
+/// Tracked commands with no ack after this long are forgotten
+const ACK_TIMEOUT: Duration = Duration::from_secs(10);
+
+/// `CLOCK_MONOTONIC` in nanoseconds, the clock the plugin stamps acks with
+pub fn monotonic_ns() -> u64 {
+    clock_gettime(ClockId::CLOCK_MONOTONIC)
+        .map(|t| t.tv_sec() as u64 * 1_000_000_000 + t.tv_nsec() as u64)
+        .unwrap_or(0)
+}
+
+/// One typed command (`CommandRecord` in the commander)
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct CommandRecord {
+    pub op: u32,
+    pub target: u32,
+    pub value_i: i32,
+    pub mode: i32,
+    pub value_f: f32,
+    pub _reserved: u32,
+}
+
+/// The plugin's ack of one applied command (`AckRecord` in the commander)
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+struct AckRecord {
+    id: u64,
+    applied_ns: u64,
+    sim_time: f64,
+    op: u32,
+    result: i32,
+}
+
+#[repr(C)]
+struct RingHeader {
+    magic: AtomicU32,
+    version: u16,
+    slot_count: u16,
+    slot_size: u32,
+    _reserved0: u32,
+    write_pos: AtomicU64,
+    read_pos: AtomicU64,
+    ack_pos: AtomicU64,
+    ack_slot_count: u16,
+    ack_slot_size: u16,
+    _reserved1: [u8; 20],
+}
+
+#[repr(C)]
+struct RingSlot {
+    turn: AtomicU64,
+    record: CommandRecord,
+}
+
+#[repr(C)]
+struct AckSlot {
+    stamp: AtomicU64,
+    record: AckRecord,
+}
+
+const _: () = assert!(size_of::<CommandRecord>() == 24);
+const _: () = assert!(size_of::<AckRecord>() == 32);
+const _: () = assert!(size_of::<RingHeader>() == 64);
+const _: () = assert!(size_of::<RingSlot>() == 32);
+const _: () = assert!(size_of::<AckSlot>() == 40);
+
+/// What became of an applied command
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AckResult {
+    Applied,
+    /// The plugin does not know the op or target
+    Unsupported,
+    /// The DataRef it writes is missing or read-only in this aircraft
+    Unavailable,
+    /// Replaced by a later command for the same target before it was
+    /// applied; only the later one was written
+    Superseded,
+    /// A result code from a newer plugin
+    Other(i32),
+}
+
+impl From<i32> for AckResult {
+    fn from(code: i32) -> Self {
+        match code {
+            0 => AckResult::Applied,
+            1 => AckResult::Unsupported,
+            2 => AckResult::Unavailable,
+            3 => AckResult::Superseded,
+            other => AckResult::Other(other),
+        }
+    }
+}
+
+/// A command the plugin has applied
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct CommandAck {
+    /// Ring sequence number, the file command's ID, or `ACK_ID_NONE`
+    pub id: u64,
+    pub result: AckResult,
+    /// Plugin `CLOCK_MONOTONIC` at apply, nanoseconds (see `monotonic_ns`)
+    pub applied_monotonic_ns: u64,
+    /// Sim time at apply (`sim/time/total_flight_time_sec`), the same clock
+    /// as `Telemetry::sim_time_s`: the first frame with `sim_time_s` at or
+    /// past it shows the command's effect
+    pub sim_time: f64,
+    /// Push to apply, for commands handed to `AckReader::track`
+    pub latency: Option<Duration>,
+}
+
+/// A command handed to the plugin, for matching its ack
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SentCommand {
+    pub id: u64,
+    /// `monotonic_ns()` just before the command was sent
+    pub sent_monotonic_ns: u64,
+}
+
+impl TryFrom<&Command> for CommandRecord {
+    type Error = anyhow::Error;
+
+    fn try_from(cmd: &Command) -> Result<Self> {
+        let mut r = CommandRecord::default();
+        match cmd {
+            Command::SetRadio {
+                target,
+                param,
+                value,
+            } => {
+                r.op = OP_SET_RADIO;
+                r.target = match (target.as_str(), param.as_str()) {
+                    ("COM1", "FREQUENCY") => RADIO_COM1,
+                    ("COM1", "STANDBY") => RADIO_COM1_STANDBY,
+                    ("COM2", "FREQUENCY") => RADIO_COM2,
+                    ("COM2", "STANDBY") => RADIO_COM2_STANDBY,
+                    ("NAV1", "FREQUENCY") => RADIO_NAV1,
+                    ("NAV2", "FREQUENCY") => RADIO_NAV2,
+                    _ => bail!("Unsupported radio target/param: {}/{}", target, param),
+                };
+                r.value_i = *value;
+            }
+            Command::SetXpdr { code, mode } => {
+                r.op = OP_SET_XPDR;
+                r.value_i = *code;
+                r.mode = mode.unwrap_or(XPDR_MODE_UNCHANGED);
+            }
+            Command::SetAp { mode, value } => {
+                r.op = OP_SET_AP;
+                r.target = match mode.as_str() {
+                    "ALT" => AP_ALT,
+                    "HDG" => AP_HDG,
+                    "VS" => AP_VS,
+                    _ => bail!("Unsupported AP mode: {}", mode),
+                };
+                r.value_f = *value;
+            }
+            Command::SetRate { hz } => {
+                r.op = OP_SET_RATE;
+                r.value_f = *hz;
+            }
+            Command::SetAtc { .. } => bail!("SET_ATC carries text; command file only"),
+        }
+        Ok(r)
+    }
+}
+
+/// A client's mapping of the plugin's command ring
+pub struct CommandRingWriter {
+    base: NonNull<c_void>,
+    len: usize,
+    slot_count: u64,
+    ack_slot_count: u64,
+}
+
+// Producers synchronise through `write_pos` and the slot turns
+unsafe impl Send for CommandRingWriter {}
+
+impl CommandRingWriter {
+    /// Attach to the plugin's ring
+    pub fn open() -> Result<Self> {
+        Self::open_named(COMMAND_RING_NAME)
+    }
+
+    /// Attach to a ring by name (tests use private names)
+    pub fn open_named(name: &str) -> Result<Self> {
+        let shm_err = |e: nix::Error| anyhow!("{}: {}", name, e);
+
+        let fd = shm_open(name, OFlag::O_RDWR, Mode::empty()).map_err(shm_err)?;
+        let len = fstat(&fd).map_err(shm_err)?.st_size as usize;
+        if len < size_of::<RingHeader>() {
+            bail!("{}: segment too small ({} bytes)", name, len);
+        }
+        // SAFETY: fresh shared mapping of a valid descriptor
+        let base = unsafe {
+            mmap(
+                None,
+                NonZeroUsize::new(len).unwrap(),
+                ProtFlags::PROT_READ | ProtFlags::PROT_WRITE,
+                MapFlags::MAP_SHARED,
+                &fd,
+                0,
+            )
+        }
+        .map_err(shm_err)?;
+
+        let mut writer = Self {
+            base,
+            len,
+            slot_count: 0,
+            ack_slot_count: 0,
+        };
+        let header = writer.header();
+        if header.magic.load(Ordering::Acquire) != COMMAND_RING_MAGIC {
+            bail!("{}: plugin not ready", name);
+        }
+        let slot_count = header.slot_count as usize;
+        let ack_slot_count = header.ack_slot_count as usize;
+        if header.version != COMMAND_RING_VERSION
+            || header.slot_size as usize != size_of::<RingSlot>()
+            || header.ack_slot_size as usize != size_of::<AckSlot>()
+            || slot_count == 0
+            || ack_slot_count == 0
+            || len
+                < size_of::<RingHeader>()
+                    + slot_count * size_of::<RingSlot>()
+                    + ack_slot_count * size_of::<AckSlot>()
+        {
+            bail!(
+                "{}: incompatible layout (version {}, {} slots)",
+                name,
+                header.version,
+                slot_count
+            );
+        }
+        writer.slot_count = slot_count as u64;
+        writer.ack_slot_count = ack_slot_count as u64;
+        Ok(writer)
+    }
+
+    fn header(&self) -> &RingHeader {
+        // SAFETY: the mapping is at least one header long (checked in open)
+        unsafe { &*(self.base.as_ptr() as *const RingHeader) }
+    }
+
+    fn slot(&self, ticket: u64) -> *mut RingSlot {
+        let offset =
+            size_of::<RingHeader>() + (ticket % self.slot_count) as usize * size_of::<RingSlot>();
+        // SAFETY: offset is within the mapping (slot_count validated in open)
+        unsafe { (self.base.as_ptr() as *mut u8).add(offset) as *mut RingSlot }
+    }
+
+    fn ack_slot(&self, index: u64) -> *mut AckSlot {
+        let offset = size_of::<RingHeader>()
+            + self.slot_count as usize * size_of::<RingSlot>()
+            + (index % self.ack_slot_count) as usize * size_of::<AckSlot>();
+        // SAFETY: offset is within the mapping (ack_slot_count validated in open)
+        unsafe { (self.base.as_ptr() as *mut u8).add(offset) as *mut AckSlot }
+    }
+
+    /// False once the plugin has shut down; re-open to reach its next ring
+    pub fn is_alive(&self) -> bool {
+        self.header().magic.load(Ordering::Acquire) == COMMAND_RING_MAGIC
+    }
+
+    /// Commands pushed but not yet applied by the plugin
+    pub fn backlog(&self) -> u64 {
+        let header = self.header();
+        let write = header.write_pos.load(Ordering::Acquire);
+        write.saturating_sub(header.read_pos.load(Ordering::Acquire))
+    }
+
+    /// Push one command. Returns its sequence number, or an error if the
+    /// plugin is gone or the ring is full.
+    pub fn push(&self, cmd: &Command) -> Result<u64> {
+        let record = CommandRecord::try_from(cmd)?;
+        self.push_record(&record)
+    }
+
+    /// Push one raw record
+    pub fn push_record(&self, record: &CommandRecord) -> Result<u64> {
+        if !self.is_alive() {
+            bail!("command ring closed");
+        }
+        let header = self.header();
+        let mut ticket = header.write_pos.load(Ordering::Relaxed);
+        loop {
+            let slot = self.slot(ticket);
+            // SAFETY: in-bounds slot; `turn` is only accessed atomically
+            let turn = unsafe { &(*slot).turn };
+            let current_turn = turn.load(Ordering::Acquire);
+            if current_turn == ticket {
+                // Free for this ticket; claim it
+                match header.write_pos.compare_exchange_weak(
+                    ticket,
+                    ticket + 1,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: the ticket gives us the slot exclusively
+                        // until we publish it by advancing `turn`
+                        unsafe { std::ptr::addr_of_mut!((*slot).record).write_volatile(*record) };
+                        turn.store(ticket + 1, Ordering::Release);
+                        return Ok(ticket);
+                    }
+                    Err(current) => ticket = current,
+                }
+            } else if current_turn < ticket {
+                // Still holds the record from one lap ago
+                bail!("command ring full");
+            } else {
+                // Another producer claimed this ticket first
+                ticket = header.write_pos.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Acks the plugin has written so far; the cursor to start reading at
+    /// to see only acks from now on
+    pub fn ack_head(&self) -> u64 {
+        self.header().ack_pos.load(Ordering::Acquire)
+    }
+
+    /// Read the ack at `*cursor` and advance past it. Returns `None` when
+    /// caught up. A cursor more than a ring behind skips to the oldest ack
+    /// still held.
+    pub fn read_ack(&self, cursor: &mut u64) -> Option<CommandAck> {
+        loop {
+            let head = self.ack_head();
+            if *cursor >= head {
+                return None;
+            }
+            if head - *cursor > self.ack_slot_count {
+                *cursor = head - self.ack_slot_count;
+            }
+            let index = *cursor;
+            let slot = self.ack_slot(index);
+            // SAFETY: in-bounds slot; the stamp check discards torn copies
+            let (before, record, after) = unsafe {
+                let stamp = &(*slot).stamp;
+                let before = stamp.load(Ordering::Acquire);
+                let record = std::ptr::addr_of!((*slot).record).read_volatile();
+                fence(Ordering::Acquire);
+                (before, record, stamp.load(Ordering::Relaxed))
+            };
+            if before != index + 1 || after != before {
+                // Overwritten (or being overwritten) under us; re-check the head
+                continue;
+            }
+            *cursor = index + 1;
+            return Some(CommandAck {
+                id: record.id,
+                result: record.result.into(),
+                applied_monotonic_ns: record.applied_ns,
+                sim_time: record.sim_time,
+                latency: None,
+            });
+        }
+    }
+}
+
+/// Follows the plugin's acks and measures push-to-apply latency for the
+/// commands it is told about. Reattaches on its own when the plugin restarts.
+pub struct AckReader {
+    name: String,
+    ring: Option<CommandRingWriter>,
+    cursor: u64,
+    last_attach: Option<Instant>,
+    /// Sent time by command ID, until acked or timed out
+    pending: HashMap<u64, u64>,
+}
+
+impl AckReader {
+    pub fn new() -> Self {
+        Self::with_name(COMMAND_RING_NAME)
+    }
+
+    /// Follow the ring segment `name` (tests use private names)
+    pub fn with_name(name: &str) -> Self {
+        Self {
+            name: name.to_string(),
+            ring: None,
+            cursor: 0,
+            last_attach: None,
+            pending: HashMap::new(),
+        }
+    }
+
+    /// Expect acks for `sent`, timing each from its send time
+    pub fn track(&mut self, sent: &[SentCommand]) {
+        for cmd in sent.iter().filter(|c| c.id != ACK_ID_NONE) {
+            self.pending.insert(cmd.id, cmd.sent_monotonic_ns);
+        }
+    }
+
+    /// Tracked commands not acked yet
+    pub fn pending(&self) -> usize {
+        self.pending.len()
+    }
+
+    fn attach(&mut self) {
+        if !self.ring.as_ref().is_some_and(CommandRingWriter::is_alive) {
+            if self.ring.take().is_some() {
+                // The plugin went away; what it had not applied is lost
+                self.pending.clear();
+            }
+            let due = self
+                .last_attach
+                .is_none_or(|t| t.elapsed() >= ATTACH_RETRY_INTERVAL);
+            if due {
+                self.last_attach = Some(Instant::now());
+                // A new plugin session numbers its acks from zero
+                self.ring = CommandRingWriter::open_named(&self.name).ok();
+                self.cursor = 0;
+            }
+        }
+    }
+
+    /// Acks written since the last call, oldest first
+    pub fn poll(&mut self) -> Vec<CommandAck> {
+        // Attach first: a reattach restarts the cursor for the new session
+        self.attach();
+        let mut acks = Vec::new();
+        if let Some(ring) = &self.ring {
+            while let Some(ack) = ring.read_ack(&mut self.cursor) {
+                acks.push(ack);
+            }
+        }
+
+        for ack in &mut acks {
+            if let Some(sent) = self.pending.remove(&ack.id) {
+                ack.latency = Some(Duration::from_nanos(
+                    ack.applied_monotonic_ns.saturating_sub(sent),
+                ));
+            }
+        }
+        let now = monotonic_ns();
+        let timeout = ACK_TIMEOUT.as_nanos() as u64;
+        self.pending
+            .retain(|_, sent| now.saturating_sub(*sent) < timeout);
+        acks
+    }
+}
+
+impl Default for AckReader {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for CommandRingWriter {
+    fn drop(&mut self) {
+        // SAFETY: base/len came from our own successful mmap
+        let _ = unsafe { munmap(self.base, self.len) };
+    }
+}
@@ -0,0 +1,402 @@
+//! Unit tests for the shared-memory command ring (client side)
+
+use crate::command_ring::{
+    monotonic_ns, AckReader, AckResult, CommandRecord, CommandRingWriter, ATTACH_RETRY_INTERVAL,
+    COMMAND_RING_MAGIC, COMMAND_RING_VERSION,
+};
+use crate::commands::{Command, CommandWriter};
+use nix::fcntl::OFlag;
+use nix::sys::mman::{mmap, munmap, shm_open, shm_unlink, MapFlags, ProtFlags};
+use nix::sys::stat::Mode;
+use nix::unistd::ftruncate;
+use std::collections::HashSet;
+use std::ffi::c_void;
+use std::num::NonZeroUsize;
+use std::ptr::NonNull;
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use std::time::Duration;
+use tempfile::tempdir;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const HEADER_SIZE: usize = 64;
+    const SLOT_SIZE: usize = 32;
+    const SLOTS: usize = 8;
+    const ACK_SLOT_SIZE: usize = 40;
+    const ACK_SLOTS: usize = 4;
+    const ACKS_OFFSET: usize = HEADER_SIZE + SLOTS * SLOT_SIZE;
+    const SEGMENT_SIZE: usize = ACKS_OFFSET + ACK_SLOTS * ACK_SLOT_SIZE;
+
+    /// Minimal Rust stand-in for the commander's `CommandRing` consumer
+    struct TestRing {
+        name: String,
+        base: NonNull<c_void>,
+        read_pos: u64,
+        ack_pos: u64,
+    }
+
+    impl TestRing {
+        fn create(tag: &str) -> Self {
+            let name = format!("/stratus_test_cmd_{}_{}", tag, std::process::id());
+            let _ = shm_unlink(name.as_str());
+            let fd = shm_open(
+                name.as_str(),
+                OFlag::O_CREAT | OFlag::O_RDWR,
+                Mode::from_bits_truncate(0o600),
+            )
+            .unwrap();
+            ftruncate(&fd, SEGMENT_SIZE as i64).unwrap();
+            let base = unsafe {
+                mmap(
+                    None,
+                    NonZeroUsize::new(SEGMENT_SIZE).unwrap(),
+                    ProtFlags::PROT_READ | ProtFlags::PROT_WRITE,
+                    MapFlags::MAP_SHARED,
+                    &fd,
+                    0,
+                )
+            }
+            .unwrap();
+
+            let ring = Self {
+                name,
+                base,
+                read_pos: 0,
+                ack_pos: 0,
+            };
+            unsafe {
+                let p = ring.base.as_ptr() as *mut u8;
+                (p.add(4) as *mut u16).write(COMMAND_RING_VERSION);
+                (p.add(6) as *mut u16).write(SLOTS as u16);
+                (p.add(8) as *mut u32).write(SLOT_SIZE as u32);
+                (p.add(40) as *mut u16).write(ACK_SLOTS as u16);
+                (p.add(42) as *mut u16).write(ACK_SLOT_SIZE as u16);
+            }
+            for t in 0..SLOTS as u64 {
+                ring.turn(t).store(t, Ordering::Relaxed);
+            }
+            ring.magic().store(COMMAND_RING_MAGIC, Ordering::Release);
+            ring
+        }
+
+        fn magic(&self) -> &AtomicU32 {
+            unsafe { &*(self.base.as_ptr() as *const AtomicU32) }
+        }
+
+        fn slot(&self, ticket: u64) -> *mut u8 {
+            unsafe {
+                (self.base.as_ptr() as *mut u8)
+                    .add(HEADER_SIZE + (ticket as usize % SLOTS) * SLOT_SIZE)
+            }
+        }
+
+        fn turn(&self, ticket: u64) -> &AtomicU64 {
+            unsafe { &*(self.slot(ticket) as *const AtomicU64) }
+        }
+
+        fn pop(&mut self) -> Option<(u64, CommandRecord)> {
+            let ticket = self.read_pos;
+            if self.turn(ticket).load(Ordering::Acquire) != ticket + 1 {
+                return None;
+            }
+            let record = unsafe {
+                std::ptr::read_volatile(self.slot(ticket).add(8) as *const CommandRecord)
+            };
+            self.turn(ticket)
+                .store(ticket + SLOTS as u64, Ordering::Release);
+            self.read_pos += 1;
+            let read_pos =
+                unsafe { &*((self.base.as_ptr() as *const u8).add(24) as *const AtomicU64) };
+            read_pos.store(self.read_pos, Ordering::Release);
+            Some((ticket, record))
+        }
+
+        /// Ack the way the commander does: id, applied_ns, sim_time, op, result
+        fn ack(&mut self, id: u64, applied_ns: u64, result: i32) {
+            let slot = unsafe {
+                (self.base.as_ptr() as *mut u8)
+                    .add(ACKS_OFFSET + (self.ack_pos as usize % ACK_SLOTS) * ACK_SLOT_SIZE)
+            };
+            let stamp = unsafe { &*(slot as *const AtomicU64) };
+            stamp.store(0, Ordering::Release);
+            unsafe {
+                (slot.add(8) as *mut u64).write(id);
+                (slot.add(16) as *mut u64).write(applied_ns);
+                (slot.add(24) as *mut f64).write(12.5);
+                (slot.add(32) as *mut u32).write(2);
+                (slot.add(36) as *mut i32).write(result);
+            }
+            self.ack_pos += 1;
+            stamp.store(self.ack_pos, Ordering::Release);
+            let ack_pos =
+                unsafe { &*((self.base.as_ptr() as *const u8).add(32) as *const AtomicU64) };
+            ack_pos.store(self.ack_pos, Ordering::Release);
+        }
+    }
+
+    impl Drop for TestRing {
+        fn drop(&mut self) {
+            self.magic().store(0, Ordering::Release);
+            unsafe {
+                let _ = munmap(self.base, SEGMENT_SIZE);
+            }
+            let _ = shm_unlink(self.name.as_str());
+        }
+    }
+
+    fn xpdr(code: i32) -> Command {
+        Command::SetXpdr { code, mode: None }
+    }
+
+    #[test]
+    fn test_records_match_commander_layout() {
+        let radio = CommandRecord::try_from(&Command::SetRadio {
+            target: "COM2".to_string(),
+            param: "STANDBY".to_string(),
+            value: 121_800,
+        })
+        .unwrap();
+        assert_eq!((radio.op, radio.target, radio.value_i), (1, 4, 121_800));
+
+        let code = CommandRecord::try_from(&Command::SetXpdr {
+            code: 7000,
+            mode: Some(2),
+        })
+        .unwrap();
+        assert_eq!((code.op, code.value_i, code.mode), (2, 7000, 2));
+        assert_eq!(CommandRecord::try_from(&xpdr(1200)).unwrap().mode, -1);
+
+        let ap = CommandRecord::try_from(&Command::SetAp {
+            mode: "HDG".to_string(),
+            value: 270.0,
+        })
+        .unwrap();
+        assert_eq!((ap.op, ap.target, ap.value_f), (3, 2, 270.0));
+
+        assert!(CommandRecord::try_from(&Command::SetAp {
+            mode: "SPD".to_string(),
+            value: 250.0,
+        })
+        .is_err());
+    }
+
+    #[test]
+    fn test_push_assigns_sequence_numbers() {
+        let mut ring = TestRing::create("seq");
+        let writer = CommandRingWriter::open_named(&ring.name).unwrap();
+
+        assert_eq!(writer.push(&xpdr(1200)).unwrap(), 0);
+        assert_eq!(writer.push(&xpdr(4521)).unwrap(), 1);
+        assert_eq!(writer.backlog(), 2);
+
+        let (seq, record) = ring.pop().unwrap();
+        assert_eq!((seq, record.value_i), (0, 1200));
+        let (seq, record) = ring.pop().unwrap();
+        assert_eq!((seq, record.value_i), (1, 4521));
+        assert!(ring.pop().is_none());
+        assert_eq!(writer.backlog(), 0);
+    }
+
+    #[test]
+    fn test_full_ring_rejects_until_drained() {
+        let mut ring = TestRing::create("full");
+        let writer = CommandRingWriter::open_named(&ring.name).unwrap();
+
+        for i in 0..SLOTS as i32 {
+            writer.push(&xpdr(i)).unwrap();
+        }
+        assert!(writer.push(&xpdr(99)).is_err());
+
+        ring.pop().unwrap();
+        assert_eq!(writer.push(&xpdr(99)).unwrap(), SLOTS as u64);
+        // Wrapped into slot 0 without disturbing the rest
+        let rest: Vec<i32> = std::iter::from_fn(|| ring.pop().map(|(_, r)| r.value_i)).collect();
+        assert_eq!(rest, vec![1, 2, 3, 4, 5, 6, 7, 99]);
+    }
+
+    #[test]
+    fn test_concurrent_producers_lose_nothing() {
+        let mut ring = TestRing::create("mpsc");
+        let name = ring.name.clone();
+        const PER_THREAD: i32 = 2_000;
+
+        let producers: Vec<_> = (0..4)
+            .map(|t| {
+                let name = name.clone();
+                std::thread::spawn(move || {
+                    let writer = CommandRingWriter::open_named(&name).unwrap();
+                    for i in 0..PER_THREAD {
+                        while writer.push(&xpdr(t * PER_THREAD + i)).is_err() {
+                            std::thread::yield_now();
+                        }
+                    }
+                })
+            })
+            .collect();
+
+        let mut seen = HashSet::new();
+        let mut next_seq = 0;
+        while seen.len() < 4 * PER_THREAD as usize {
+            match ring.pop() {
+                Some((seq, record)) => {
+                    assert_eq!(seq, next_seq);
+                    next_seq += 1;
+                    assert!(seen.insert(record.value_i), "duplicate {}", record.value_i);
+                }
+                None => std::thread::yield_now(),
+            }
+        }
+        for p in producers {
+            p.join().unwrap();
+        }
+        assert!(ring.pop().is_none());
+    }
+
+    #[test]
+    fn test_closed_ring_is_refused() {
+        let ring = TestRing::create("closed");
+        let writer = CommandRingWriter::open_named(&ring.name).unwrap();
+        ring.magic().store(0, Ordering::Release);
+
+        assert!(!writer.is_alive());
+        assert!(writer.push(&xpdr(1200)).is_err());
+        assert!(CommandRingWriter::open_named(&ring.name).is_err());
+        assert!(CommandRingWriter::open_named("/stratus_test_cmd_missing").is_err());
+    }
+
+    #[test]
+    fn test_command_writer_prefers_ring_and_falls_back_to_file() {
+        let dir = tempdir().unwrap();
+        let path = dir.path().join("commands.jsonl");
+        let mut ring = TestRing::create("writer");
+        let writer = CommandWriter::new(&path).with_ring(Some(&ring.name));
+
+        writer.write(&[xpdr(1200), xpdr(4521)]).unwrap();
+        assert!(!path.exists());
+        assert_eq!(ring.pop().unwrap().1.value_i, 1200);
+        assert_eq!(ring.pop().unwrap().1.value_i, 4521);
+
+        // Overflow keeps the order: the ring takes what fits, the file the rest
+        let commands: Vec<Command> = (0..SLOTS as i32 + 2).map(xpdr).collect();
+        writer.write(&commands).unwrap();
+        let lines: Vec<String> = std::fs::read_to_string(&path)
+            .unwrap()
+            .lines()
+            .map(str::to_string)
+            .collect();
+        assert_eq!(lines.len(), 2);
+        assert!(lines[0].contains(&format!("\"code\":{}", SLOTS)));
+
+        // No plugin: everything goes to the file
+        drop(ring);
+        writer.write(&[xpdr(7000)]).unwrap();
+        let content = std::fs::read_to_string(&path).unwrap();
+        assert_eq!(content.lines().count(), 3);
+    }
+
+    #[test]
+    fn test_reads_acks_in_order() {
+        let mut ring = TestRing::create("acks");
+        let writer = CommandRingWriter::open_named(&ring.name).unwrap();
+        let mut cursor = 0;
+        assert!(writer.read_ack(&mut cursor).is_none());
+
+        ring.ack(0, 1_000, 0);
+        ring.ack(1, 2_000, 2);
+        ring.ack(2, 2_500, 3);
+        ring.ack(7, 3_000, 9);
+
+        let ack = writer.read_ack(&mut cursor).unwrap();
+        assert_eq!((ack.id, ack.result), (0, AckResult::Applied));
+        assert_eq!((ack.applied_monotonic_ns, ack.sim_time), (1_000, 12.5));
+        assert_eq!(
+            writer.read_ack(&mut cursor).unwrap().result,
+            AckResult::Unavailable
+        );
+        assert_eq!(
+            writer.read_ack(&mut cursor).unwrap().result,
+            AckResult::Superseded
+        );
+        assert_eq!(
+            writer.read_ack(&mut cursor).unwrap().result,
+            AckResult::Other(9)
+        );
+        assert!(writer.read_ack(&mut cursor).is_none());
+        assert_eq!(cursor, writer.ack_head());
+    }
+
+    #[test]
+    fn test_lagging_reader_skips_overwritten_acks() {
+        let mut ring = TestRing::create("lag");
+        let writer = CommandRingWriter::open_named(&ring.name).unwrap();
+        for id in 0..ACK_SLOTS as u64 + 3 {
+            ring.ack(id, id, 0);
+        }
+
+        let mut cursor = 0;
+        let ids: Vec<u64> =
+            std::iter::from_fn(|| writer.read_ack(&mut cursor).map(|a| a.id)).collect();
+        assert_eq!(ids, vec![3, 4, 5, 6]);
+    }
+
+    #[test]
+    fn test_ack_reader_times_tracked_commands() {
+        let dir = tempdir().unwrap();
+        let mut ring = TestRing::create("latency");
+        let writer =
+            CommandWriter::new(dir.path().join("commands.jsonl")).with_ring(Some(&ring.name));
+        let mut acks = AckReader::with_name(&ring.name);
+
+        let sent = writer.write(&[xpdr(1200), xpdr(4521)]).unwrap();
+        assert_eq!(sent.iter().map(|s| s.id).collect::<Vec<_>>(), vec![0, 1]);
+        acks.track(&sent);
+        assert_eq!(acks.pending(), 2);
+
+        let (seq, _) = ring.pop().unwrap();
+        ring.ack(seq, sent[0].sent_monotonic_ns + 5_000_000, 0);
+
+        let received = acks.poll();
+        assert_eq!(received.len(), 1);
+        assert_eq!(received[0].latency, Some(Duration::from_millis(5)));
+        assert_eq!(acks.pending(), 1);
+        assert!(acks.poll().is_empty());
+
+        // A restarted plugin starts over; what it never applied is dropped
+        drop(ring);
+        let _ring = TestRing::create("latency");
+        assert!(acks.poll().is_empty());
+        assert_eq!(acks.pending(), 0);
+    }
+
+    #[test]
+    fn test_ack_reader_restarts_cursor_on_reattach() {
+        let mut ring = TestRing::create("reattach");
+        let mut acks = AckReader::with_name(&ring.name);
+        ring.ack(0, 1_000, 0);
+        ring.ack(1, 2_000, 0);
+        assert_eq!(acks.poll().len(), 2);
+
+        // The new session numbers its acks from zero again
+        drop(ring);
+        let mut ring = TestRing::create("reattach");
+        std::thread::sleep(ATTACH_RETRY_INTERVAL);
+        assert!(acks.poll().is_empty());
+        ring.ack(0, 3_000, 0);
+
+        let received = acks.poll();
+        assert_eq!(received.len(), 1);
+        assert_eq!(
+            (received[0].id, received[0].applied_monotonic_ns),
+            (0, 3_000)
+        );
+    }
+
+    #[test]
+    fn test_monotonic_clock_advances() {
+        let a = monotonic_ns();
+        std::thread::sleep(Duration::from_millis(1));
+        assert!(monotonic_ns() > a);
+    }
+}
@@ -1,9 +1,11 @@
+use crate::command_ring::{monotonic_ns, CommandRingWriter, SentCommand, COMMAND_RING_NAME};
 use anyhow::Result;
 use nix::fcntl::{Flock, FlockArg};
 use serde::{Deserialize, Serialize};
 use std::fs::OpenOptions;
 use std::io::Write;
 use std::path::PathBuf;
+use std::sync::atomic::{AtomicU32, Ordering};
 
 #[derive(Debug, Serialize, Deserialize, Clone)]
 #[serde(tag = "op")]
@@ -22,21 +24,112 @@ pub enum Command {
     },
     #[serde(rename = "SET_AP")]
     SetAp { mode: String, value: f32 },
+    /// Request a telemetry rate from the plugin; `hz` of 0 returns control
+    /// to the plugin's adaptive rate
+    #[serde(rename = "SET_RATE")]
+    SetRate { hz: f32 },
+    /// What ATC has assigned, published by the plugin as `stratus/atc/*`
+    /// DataRefs for other plugins and cockpit hardware. Each one replaces the
+    /// last: a field left out means nothing is assigned. Carries text, so it
+    /// always goes through the command file (or the UDP stream).
+    #[serde(rename = "SET_ATC")]
+    SetAtc {
+        #[serde(default, skip_serializing_if = "Option::is_none")]
+        squawk: Option<i32>,
+        /// Next frequency to contact, in `SET_RADIO` units
+        #[serde(default, skip_serializing_if = "Option::is_none")]
+        frequency: Option<i32>,
+        #[serde(default, skip_serializing_if = "Option::is_none")]
+        altitude_ft: Option<f32>,
+        /// Magnetic
+        #[serde(default, skip_serializing_if = "Option::is_none")]
+        heading_deg: Option<f32>,
+        /// Text of the last clearance issued (the plugin keeps 255 bytes)
+        #[serde(default, skip_serializing_if = "Option::is_none")]
+        clearance: Option<String>,
+    },
 }
 
+/// IDs for commands sent as command lines (the file, or the UDP stream) have
+/// the top bit set, so they never collide with ring sequence numbers, and
+/// carry the process ID so clients do not collide with each other
+const FILE_ID_FLAG: u64 = 1 << 63;
+static NEXT_FILE_ID: AtomicU32 = AtomicU32::new(0);
+
+pub(crate) fn next_file_id() -> u64 {
+    let pid = std::process::id() as u64 & 0x7FFF_FFFF;
+    FILE_ID_FLAG | (pid << 32) | NEXT_FILE_ID.fetch_add(1, Ordering::Relaxed) as u64
+}
+
+/// A command-file line: the command tagged with its ID
+#[derive(Serialize)]
+pub(crate) struct CommandLine<'a> {
+    pub id: u64,
+    #[serde(flatten)]
+    pub command: &'a Command,
+}
+
+/// Sends commands to the plugin: through its shared-memory command ring
+/// when the plugin is running, else appended to the command file it polls
 #[derive(Clone)]
 pub struct CommandWriter {
     command_path: PathBuf,
+    ring_name: Option<String>,
 }
 
 impl CommandWriter {
     pub fn new(command_path: impl Into<PathBuf>) -> Self {
         Self {
             command_path: command_path.into(),
+            ring_name: Some(COMMAND_RING_NAME.to_string()),
+        }
+    }
+
+    /// Use the ring segment `name`, or never use a ring with `None`
+    /// (tests, so they never reach a running sim)
+    pub fn with_ring(mut self, name: Option<&str>) -> Self {
+        self.ring_name = name.map(str::to_string);
+        self
+    }
+
+    /// Send `commands` in order. Returns the ID and send time of each, to
+    /// match the plugin's acks (see `AckReader`).
+    pub fn write(&self, commands: &[Command]) -> Result<Vec<SentCommand>> {
+        let mut sent = Vec::with_capacity(commands.len());
+        if commands.is_empty() {
+            return Ok(sent);
         }
+
+        self.push_to_ring(commands, &mut sent);
+        self.append_to_file(&commands[sent.len()..], &mut sent)?;
+        Ok(sent)
     }
 
-    pub fn write(&self, commands: &[Command]) -> Result<()> {
+    /// Push as many commands as the ring takes, in order
+    fn push_to_ring(&self, commands: &[Command], sent: &mut Vec<SentCommand>) {
+        let Some(ring) = self
+            .ring_name
+            .as_deref()
+            .and_then(|name| CommandRingWriter::open_named(name).ok())
+        else {
+            return;
+        };
+        for cmd in commands {
+            let sent_monotonic_ns = monotonic_ns();
+            match ring.push(cmd) {
+                Ok(id) => sent.push(SentCommand {
+                    id,
+                    sent_monotonic_ns,
+                }),
+                Err(e) => {
+                    log::debug!("Command ring: {}; falling back to the command file", e);
+                    return;
+                }
+            }
+        }
+    }
+
+    fn append_to_file(&self, commands: &[Command], sent: &mut Vec<SentCommand>) -> Result<()> {
         if commands.is_empty() {
             return Ok(());
         }
@@ -55,9 +148,15 @@ impl CommandWriter {
             )
         })?;
 
-        for cmd in commands {
-            let line = serde_json::to_string(cmd)?;
+        let sent_monotonic_ns = monotonic_ns();
+        for command in commands {
+            let id = next_file_id();
+            let line = serde_json::to_string(&CommandLine { id, command })?;
             writeln!(file, "{}", line)?;
+            sent.push(SentCommand {
+                id,
+                sent_monotonic_ns,
+            });
         }
 
         Ok(())
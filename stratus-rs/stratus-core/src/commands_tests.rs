@@ -12,7 +12,7 @@ mod tests {
     fn test_write_single_command() {
         let dir = tempdir().unwrap();
         let path = dir.path().join("commands.jsonl");
-        let writer = CommandWriter::new(&path);
+        let writer = CommandWriter::new(&path).with_ring(None);
 
         let commands = vec![Command::SetXpdr {
             code: 1234,
@@ -29,7 +29,7 @@ mod tests {
     fn test_write_multiple_commands() {
         let dir = tempdir().unwrap();
         let path = dir.path().join("commands.jsonl");
-        let writer = CommandWriter::new(&path);
+        let writer = CommandWriter::new(&path).with_ring(None);
 
         let commands = vec![
             Command::SetXpdr {
@@ -53,7 +53,7 @@ mod tests {
     fn test_write_empty_commands() {
         let dir = tempdir().unwrap();
         let path = dir.path().join("commands.jsonl");
-        let writer = CommandWriter::new(&path);
+        let writer = CommandWriter::new(&path).with_ring(None);
 
         // Should not create file if no commands
         writer.write(&[]).unwrap();
@@ -72,11 +72,33 @@ mod tests {
         assert!(json.contains("5000"));
     }
 
+    #[test]
+    fn test_rate_command_serialization() {
+        let json = serde_json::to_string(&Command::SetRate { hz: 30.0 }).unwrap();
+        assert_eq!(json, r#"{"op":"SET_RATE","hz":30.0}"#);
+    }
+
+    #[test]
+    fn test_atc_command_serialization() {
+        let cmd = Command::SetAtc {
+            squawk: Some(4521),
+            frequency: Some(121_900),
+            altitude_ft: None,
+            heading_deg: None,
+            clearance: Some("Cleared to land runway 34L".to_string()),
+        };
+        let json = serde_json::to_string(&cmd).unwrap();
+        assert_eq!(
+            json,
+            r#"{"op":"SET_ATC","squawk":4521,"frequency":121900,"clearance":"Cleared to land runway 34L"}"#
+        );
+    }
+
     #[test]
     fn test_append_mode() {
         let dir = tempdir().unwrap();
         let path = dir.path().join("commands.jsonl");
-        let writer = CommandWriter::new(&path);
+        let writer = CommandWriter::new(&path).with_ring(None);
 
         // First write
         writer
@@ -99,4 +121,35 @@ mod tests {
         assert!(lines[0].contains("1200"));
         assert!(lines[1].contains("4521"));
     }
+
+    #[test]
+    fn test_file_commands_carry_ids() {
+        let dir = tempdir().unwrap();
+        let path = dir.path().join("commands.jsonl");
+        let writer = CommandWriter::new(&path).with_ring(None);
+
+        let sent = writer
+            .write(&[
+                Command::SetXpdr {
+                    code: 1200,
+                    mode: None,
+                },
+                Command::SetRate { hz: 5.0 },
+            ])
+            .unwrap();
+        assert_eq!(sent.len(), 2);
+        assert!(sent.iter().all(|s| s.id >> 63 == 1));
+        assert_ne!(sent[0].id, sent[1].id);
+
+        let content = fs::read_to_string(&path).unwrap();
+        for (line, s) in content.lines().zip(&sent) {
+            let value: serde_json::Value = serde_json::from_str(line).unwrap();
+            assert_eq!(value["id"], s.id);
+        }
+        assert!(content
+            .lines()
+            .nth(1)
+            .unwrap()
+            .contains(r#""op":"SET_RATE""#));
+    }
 }
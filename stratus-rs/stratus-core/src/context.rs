@@ -0,0 +1,57 @@
+//! Context - Aircraft and location reported by the X-Plane plugin
+//!
+//! The plugin writes `stratus_context.json` once at startup and again whenever
+//! X-Plane loads a plane, an airport or scenery. Consumers use the `seq` to
+//! notice a change and drop state tied to the previous aircraft or location.
+
+use crate::telemetry::TelemetryError;
+use crate::tracker::{read_json, FileTracker, Sequenced};
+use serde::{Deserialize, Serialize};
+use std::path::Path;
+
+/// Context file name inside the telemetry directory
+pub const CONTEXT_FILE: &str = "stratus_context.json";
+
+/// Loaded aircraft and nearest airport at the time of the last load event
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+#[serde(default)]
+pub struct SimContext {
+    /// Bumped on every event; restarts at 1 with the plugin
+    pub seq: u64,
+    pub timestamp: i64,
+    /// "startup", "plane_loaded", "airport_loaded" or "scenery_loaded"
+    pub event: String,
+    pub aircraft: AircraftContext,
+    pub location: LocationContext,
+}
+
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+#[serde(default)]
+pub struct AircraftContext {
+    /// `.acf` file name
+    pub file: String,
+    pub path: String,
+    pub icao: String,
+    pub tailnum: String,
+}
+
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+#[serde(default)]
+pub struct LocationContext {
+    pub airport_id: String,
+    pub airport_name: String,
+}
+
+/// Read and parse a context file
+pub fn read_context(path: &Path) -> Result<SimContext, TelemetryError> {
+    read_json(path)
+}
+
+impl Sequenced for SimContext {
+    fn sequence(&self) -> (u64, i64) {
+        (self.seq, self.timestamp)
+    }
+}
+
+/// Remembers the last context seen so callers only act on changes
+pub type ContextTracker = FileTracker<SimContext>;
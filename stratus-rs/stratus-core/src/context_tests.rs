@@ -0,0 +1,50 @@
+//! Unit tests for the plugin context file
+
+use crate::context::{read_context, ContextTracker};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::test_util::write;
+
+    const CONTEXT: &str = r#"{
+        "seq": 2, "timestamp": 1700000000, "event": "plane_loaded",
+        "aircraft": {"file": "Cessna_172SP.acf",
+                     "path": "Aircraft/Laminar Research/Cessna 172SP/Cessna_172SP.acf",
+                     "icao": "C172", "tailnum": "N172SP"},
+        "location": {"airport_id": "KPAO", "airport_name": "Palo Alto"}
+    }"#;
+
+    #[test]
+    fn test_read_context() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("stratus_context.json");
+        write(&path, CONTEXT, 0);
+
+        let context = read_context(&path).unwrap();
+        assert_eq!(context.seq, 2);
+        assert_eq!(context.event, "plane_loaded");
+        assert_eq!(context.aircraft.icao, "C172");
+        assert_eq!(context.location.airport_id, "KPAO");
+    }
+
+    #[test]
+    fn test_tracker_reports_changes_only() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("stratus_context.json");
+        let mut tracker = ContextTracker::new();
+        assert!(tracker.poll(&path).is_none());
+
+        write(&path, CONTEXT, 20);
+        assert_eq!(tracker.poll(&path).unwrap().seq, 2);
+        assert!(tracker.poll(&path).is_none());
+
+        // Rewritten with the same record: nothing new
+        write(&path, CONTEXT, 10);
+        assert!(tracker.poll(&path).is_none());
+
+        let next = CONTEXT.replace("\"seq\": 2", "\"seq\": 3");
+        write(&path, &next, 0);
+        assert_eq!(tracker.poll(&path).unwrap().seq, 3);
+    }
+}
@@ -0,0 +1,99 @@
+//! Delta - Incremental apply for delta-published telemetry
+//!
+//! With `publish = delta` in `stratus_plugin.cfg` the plugin writes a full
+//! keyframe periodically and, in between, records holding only the fields
+//! that moved beyond their dead-band since that keyframe:
+//!
+//! ```json
+//! {"timestamp": 1736330012, "type": "delta", "seq": 42, "keyframe_seq": 40,
+//!  "orientation": {"heading_mag": 91.00}}
+//! ```
+//!
+//! Deltas are relative to the keyframe, not to each other, so a reader that
+//! skips records (the file is overwritten in place) stays correct as long as
+//! it has seen keyframe `keyframe_seq`. Records without a `type` are plain
+//! snapshots from a plugin in `full` mode and are accepted as keyframes.
+//!
+//! An `"type": "event"` record is a full frame published at once for a
+//! transition such as a touchdown, and doubles as the next keyframe. Its
+//! `events` list belongs to that record alone; the deltas after it do not
+//! repeat it.
+
+use crate::telemetry::{Telemetry, TelemetryError};
+use serde_json::Value;
+
+impl Telemetry {
+    /// Apply a delta record on top of this telemetry. Fields absent from the
+    /// delta keep their current value; bookkeeping keys are ignored.
+    pub fn apply_delta(&mut self, delta: &Value) -> Result<(), TelemetryError> {
+        let mut merged = serde_json::to_value(&*self)?;
+        merge(&mut merged, delta);
+        *self = serde_json::from_value(merged)?;
+        Ok(())
+    }
+}
+
+/// Recursively overlay `patch` onto `target` (objects merge, values replace)
+fn merge(target: &mut Value, patch: &Value) {
+    match (target, patch) {
+        (Value::Object(target), Value::Object(patch)) => {
+            for (key, value) in patch {
+                match target.get_mut(key) {
+                    Some(existing) => merge(existing, value),
+                    None => {
+                        target.insert(key.clone(), value.clone());
+                    }
+                }
+            }
+        }
+        (target, patch) => *target = patch.clone(),
+    }
+}
+
+/// Reassembles full telemetry from a stream of keyframe / delta records
+#[derive(Debug, Default)]
+pub struct TelemetryStream {
+    keyframe: Option<(u64, Telemetry)>,
+    current: Telemetry,
+}
+
+impl TelemetryStream {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Latest reassembled telemetry
+    pub fn current(&self) -> &Telemetry {
+        &self.current
+    }
+
+    /// Apply one record as read from `stratus_telemetry.json`
+    pub fn apply_json(&mut self, content: &str) -> Result<&Telemetry, TelemetryError> {
+        let record: Value = serde_json::from_str(content)?;
+        self.apply_record(&record)?;
+        Ok(&self.current)
+    }
+
+    /// Apply one parsed record
+    pub fn apply_record(&mut self, record: &Value) -> Result<(), TelemetryError> {
+        let seq = |key: &str| record.get(key).and_then(Value::as_u64);
+
+        if record.get("type").and_then(Value::as_str) != Some("delta") {
+            let telemetry: Telemetry = serde_json::from_value(record.clone())?;
+            self.keyframe = seq("seq").map(|seq| (seq, telemetry.clone()));
+            self.current = telemetry;
+            return Ok(());
+        }
+
+        // Rebase onto the keyframe the delta refers to. If we never saw it,
+        // the best we can do is the running state; the next keyframe heals it.
+        let mut next = match (&self.keyframe, seq("keyframe_seq")) {
+            (Some((key_seq, keyframe)), Some(base)) if *key_seq == base => keyframe.clone(),
+            _ => self.current.clone(),
+        };
+        next.events.clear();
+        next.apply_delta(record)?;
+        self.current = next;
+        Ok(())
+    }
+}
@@ -0,0 +1,117 @@
+//! Unit tests for delta telemetry apply
+
+use crate::delta::TelemetryStream;
+use crate::telemetry::Telemetry;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const KEYFRAME: &str = r#"{
+        "timestamp": 100, "type": "keyframe", "seq": 1, "keyframe_seq": 1,
+        "simulator": "X-Plane", "aircraft": "C172.acf",
+        "position": {"latitude": 37.5, "longitude": -122.0,
+                     "altitude_msl_m": 1000.0, "altitude_agl_m": 500.0},
+        "orientation": {"heading_mag": 90.0, "heading_true": 104.0,
+                        "pitch": 2.0, "roll": 0.0},
+        "speed": {"ground_speed_mps": 50.0, "ias_kts": 95.0,
+                  "tas_mps": 52.0, "vertical_speed_fpm": 0.0},
+        "radios": {"com1_hz": 118700000, "com1_standby_hz": 121500000,
+                   "com2_hz": 0, "com2_standby_hz": 0, "nav1_hz": 0, "nav2_hz": 0},
+        "transponder": {"code": 1200, "mode": 2},
+        "autopilot": {"altitude_ft": 0, "heading": 0, "vs_fpm": 0},
+        "state": {"on_ground": false, "paused": false}
+    }"#;
+
+    #[test]
+    fn test_apply_delta_keeps_other_fields() {
+        let mut telemetry: Telemetry = serde_json::from_str(KEYFRAME).unwrap();
+        let delta = serde_json::json!({
+            "timestamp": 101, "type": "delta", "seq": 2, "keyframe_seq": 1,
+            "orientation": {"heading_mag": 95.5}
+        });
+        telemetry.apply_delta(&delta).unwrap();
+
+        assert_eq!(telemetry.timestamp, 101);
+        assert_eq!(telemetry.orientation.heading_mag, 95.5);
+        assert_eq!(telemetry.orientation.heading_true, 104.0);
+        assert_eq!(telemetry.radios.com1_hz, 118_700_000);
+    }
+
+    #[test]
+    fn test_deltas_rebase_on_keyframe() {
+        let mut stream = TelemetryStream::new();
+        stream.apply_json(KEYFRAME).unwrap();
+
+        // Heading moved, then a later delta only carries the radio change:
+        // heading is back within its dead-band of the keyframe value
+        stream
+            .apply_json(
+                r#"{"timestamp": 101, "type": "delta", "seq": 2, "keyframe_seq": 1,
+                            "orientation": {"heading_mag": 95.5}}"#,
+            )
+            .unwrap();
+        let telemetry = stream
+            .apply_json(
+                r#"{"timestamp": 102, "type": "delta", "seq": 3, "keyframe_seq": 1,
+                            "radios": {"com1_hz": 121500000}}"#,
+            )
+            .unwrap();
+
+        assert_eq!(telemetry.orientation.heading_mag, 90.0);
+        assert_eq!(telemetry.radios.com1_hz, 121_500_000);
+        assert_eq!(telemetry.aircraft, "C172.acf");
+    }
+
+    #[test]
+    fn test_delta_without_keyframe_uses_running_state() {
+        let mut stream = TelemetryStream::new();
+        stream.apply_json(KEYFRAME).unwrap();
+
+        let telemetry = stream
+            .apply_json(
+                r#"{"timestamp": 200, "type": "delta", "seq": 9, "keyframe_seq": 7,
+                            "transponder": {"code": 7000}}"#,
+            )
+            .unwrap();
+        assert_eq!(telemetry.transponder.code, 7000);
+        assert_eq!(telemetry.position.latitude, 37.5);
+    }
+
+    #[test]
+    fn test_full_snapshot_without_type() {
+        let mut stream = TelemetryStream::new();
+        let full = KEYFRAME.replace(r#""type": "keyframe", "seq": 1, "keyframe_seq": 1,"#, "");
+        let telemetry = stream.apply_json(&full).unwrap();
+        assert_eq!(telemetry.transponder.code, 1200);
+    }
+
+    #[test]
+    fn test_event_record_is_keyframe() {
+        let mut stream = TelemetryStream::new();
+        stream.apply_json(KEYFRAME).unwrap();
+
+        let event = KEYFRAME
+            .replace(
+                r#""type": "keyframe", "seq": 1, "keyframe_seq": 1,"#,
+                r#""type": "event", "events": ["touchdown"], "event_seq": 1,
+                   "seq": 5, "keyframe_seq": 5,"#,
+            )
+            .replace(r#""on_ground": false"#, r#""on_ground": true"#);
+        let telemetry = stream.apply_json(&event).unwrap();
+        assert_eq!(telemetry.events, ["touchdown"]);
+        assert_eq!(telemetry.event_seq, 1);
+        assert!(telemetry.state.on_ground);
+
+        // The next delta rebases on the event frame, without its events
+        let telemetry = stream
+            .apply_json(
+                r#"{"timestamp": 101, "type": "delta", "seq": 6, "keyframe_seq": 5,
+                            "event_seq": 1, "speed": {"ias_kts": 60.0}}"#,
+            )
+            .unwrap();
+        assert!(telemetry.events.is_empty());
+        assert!(telemetry.state.on_ground);
+        assert_eq!(telemetry.speed.ias_kts, 60.0);
+    }
+}
@@ -0,0 +1,269 @@
+//! Extrapolate - Dead reckoning between telemetry frames
+//!
+//! The plugin publishes 1-20 frames per second, so anything that wants the
+//! aircraft's position "now" (runway and traffic checks) either needs a high
+//! telemetry rate or has to project the last frame forward. `Extrapolator`
+//! does the latter with a constant-turn, constant-speed model:
+//!
+//! - ground track from the last two positions (heading when they coincide),
+//!   so a crab angle into the wind is honoured
+//! - turn rate from the change of true heading between the last two frames
+//! - vertical speed from the frame itself
+//! - sim seconds per wall second from `sim_time_s` against `monotonic_ns`,
+//!   so pause and time acceleration carry over to the prediction
+//!
+//! Frames from a plugin without the v3 timing fields (`monotonic_ns` 0) fall
+//! back to local arrival times and real-time sim speed.
+
+use crate::telemetry::Telemetry;
+use std::time::{Duration, Instant};
+
+/// Furthest a prediction is carried past the last frame by default
+pub const DEFAULT_MAX_HORIZON: Duration = Duration::from_secs(5);
+
+/// Mean Earth radius, metres (flat-earth steps over a few seconds)
+const EARTH_RADIUS_M: f64 = 6_371_000.0;
+const FPM_TO_MPS: f64 = 0.00508;
+/// Below this distance between frames the track is taken from the heading
+const MIN_TRACK_DISTANCE_M: f64 = 1.0;
+/// Frames further apart than this are not used for rates
+const MAX_FRAME_GAP_S: f64 = 10.0;
+/// X-Plane's fastest time acceleration
+const MAX_SIM_RATE: f64 = 16.0;
+
+#[derive(Debug, Clone)]
+struct Sample {
+    telemetry: Telemetry,
+    received: Instant,
+}
+
+/// Motion derived from the last two frames
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Motion {
+    /// Direction of travel over the ground, degrees true
+    pub track_deg: f64,
+    /// Rate of change of true heading, degrees per sim second
+    pub turn_rate_dps: f64,
+    /// Sim seconds per wall-clock second (0 while paused)
+    pub sim_rate: f64,
+}
+
+/// Projects the latest telemetry frame forward in time
+#[derive(Debug, Clone)]
+pub struct Extrapolator {
+    last: Option<Sample>,
+    motion: Motion,
+    max_horizon: Duration,
+}
+
+impl Default for Extrapolator {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Extrapolator {
+    pub fn new() -> Self {
+        Self::with_max_horizon(DEFAULT_MAX_HORIZON)
+    }
+
+    /// Never project more than `max_horizon` past the last frame; beyond
+    /// that a prediction is a guess, and the last real frame is kept instead
+    pub fn with_max_horizon(max_horizon: Duration) -> Self {
+        Self {
+            last: None,
+            motion: Motion {
+                track_deg: 0.0,
+                turn_rate_dps: 0.0,
+                sim_rate: 1.0,
+            },
+            max_horizon,
+        }
+    }
+
+    /// Feed the next frame as it arrives
+    pub fn update(&mut self, telemetry: &Telemetry) {
+        self.update_at(telemetry, Instant::now());
+    }
+
+    /// Feed a frame that arrived at `received`
+    pub fn update_at(&mut self, telemetry: &Telemetry, received: Instant) {
+        if let Some(prev) = &self.last {
+            if telemetry.frame_seq != 0 && telemetry.frame_seq == prev.telemetry.frame_seq {
+                return; // The same frame read twice
+            }
+        }
+        let prev = self.last.take();
+        self.motion = match &prev {
+            Some(prev) if continues(&prev.telemetry, telemetry) => {
+                derive_motion(prev, telemetry, received)
+            }
+            _ => Motion {
+                track_deg: telemetry.orientation.heading_true as f64,
+                turn_rate_dps: 0.0,
+                sim_rate: 1.0,
+            },
+        };
+        self.last = Some(Sample {
+            telemetry: telemetry.clone(),
+            received,
+        });
+    }
+
+    /// Forget all frames (e.g. after switching telemetry source)
+    pub fn reset(&mut self) {
+        self.last = None;
+    }
+
+    /// Latest real frame, if any
+    pub fn latest(&self) -> Option<&Telemetry> {
+        self.last.as_ref().map(|s| &s.telemetry)
+    }
+
+    /// Motion estimated from the last two frames
+    pub fn motion(&self) -> Motion {
+        self.motion
+    }
+
+    /// Time since the latest frame arrived
+    pub fn age(&self) -> Option<Duration> {
+        self.last.as_ref().map(|s| s.received.elapsed())
+    }
+
+    /// The aircraft state now, projected from the latest frame. Transport
+    /// latency is not known and is not accounted for.
+    pub fn predict(&self) -> Option<Telemetry> {
+        let last = self.last.as_ref()?;
+        Some(self.project(&last.telemetry, last.received.elapsed()))
+    }
+
+    /// The aircraft state `dt` of wall-clock time after the latest frame
+    pub fn predict_after(&self, dt: Duration) -> Option<Telemetry> {
+        let last = self.last.as_ref()?;
+        Some(self.project(&last.telemetry, dt))
+    }
+
+    fn project(&self, from: &Telemetry, dt: Duration) -> Telemetry {
+        let dt = dt.min(self.max_horizon);
+        let mut out = from.clone();
+        let wall_s = dt.as_secs_f64();
+        out.monotonic_ns = from.monotonic_ns.saturating_add(dt.as_nanos() as u64);
+
+        let sim_s = if from.state.paused {
+            0.0
+        } else {
+            wall_s * self.motion.sim_rate
+        };
+        if sim_s <= 0.0 {
+            return out;
+        }
+        out.sim_time_s = from.sim_time_s + sim_s;
+
+        // Constant turn: the track sweeps `turn` degrees while covering an
+        // arc of `distance` metres; a straight line when the turn is tiny
+        let distance = from.speed.ground_speed_mps as f64 * sim_s;
+        let turn = self.motion.turn_rate_dps * sim_s;
+        let track0 = self.motion.track_deg.to_radians();
+        let (north, east) = if turn.abs() < 1e-3 {
+            (distance * track0.cos(), distance * track0.sin())
+        } else {
+            let radius = distance / turn.to_radians();
+            let track1 = track0 + turn.to_radians();
+            (
+                radius * (track1.sin() - track0.sin()),
+                radius * (track0.cos() - track1.cos()),
+            )
+        };
+        let lat = from.position.latitude.to_radians();
+        out.position.latitude += (north / EARTH_RADIUS_M).to_degrees();
+        out.position.longitude += (east / (EARTH_RADIUS_M * lat.cos())).to_degrees();
+
+        if !from.state.on_ground {
+            let climb = from.speed.vertical_speed_fpm as f64 * FPM_TO_MPS * sim_s;
+            out.position.altitude_msl_m += climb;
+            out.position.altitude_agl_m = (from.position.altitude_agl_m + climb).max(0.0);
+        }
+
+        out.orientation.heading_true =
+            wrap_degrees(from.orientation.heading_true as f64 + turn) as f32;
+        out.orientation.heading_mag =
+            wrap_degrees(from.orientation.heading_mag as f64 + turn) as f32;
+        out
+    }
+}
+
+/// True if `next` directly follows `prev` from the same plugin run and flight
+fn continues(prev: &Telemetry, next: &Telemetry) -> bool {
+    if next.frame_seq != 0 && next.frame_seq <= prev.frame_seq {
+        return false; // Plugin restarted
+    }
+    if next.sim_time_s < prev.sim_time_s {
+        return false; // New flight loaded
+    }
+    true
+}
+
+fn derive_motion(prev: &Sample, next: &Telemetry, received: Instant) -> Motion {
+    let (a, b) = (&prev.telemetry, next);
+    let wall_s = if a.monotonic_ns != 0 && b.monotonic_ns > a.monotonic_ns {
+        (b.monotonic_ns - a.monotonic_ns) as f64 * 1e-9
+    } else {
+        received
+            .saturating_duration_since(prev.received)
+            .as_secs_f64()
+    };
+    let sim_s = if b.sim_time_s > 0.0 {
+        b.sim_time_s - a.sim_time_s
+    } else {
+        wall_s
+    };
+
+    let heading = b.orientation.heading_true as f64;
+    if wall_s <= 0.0 || wall_s > MAX_FRAME_GAP_S {
+        return Motion {
+            track_deg: heading,
+            turn_rate_dps: 0.0,
+            sim_rate: 1.0,
+        };
+    }
+
+    let turned = signed_difference(a.orientation.heading_true as f64, heading);
+    let turn_rate_dps = if sim_s > 0.0 { turned / sim_s } else { 0.0 };
+
+    // In a turn the chord between the frames points half the turn behind
+    // the track at the newer one
+    let (north, east) = offset_m(a, b);
+    let track_deg = if north.hypot(east) >= MIN_TRACK_DISTANCE_M {
+        wrap_degrees(east.atan2(north).to_degrees() + turned / 2.0)
+    } else {
+        heading
+    };
+    Motion {
+        track_deg,
+        turn_rate_dps,
+        sim_rate: (sim_s / wall_s).clamp(0.0, MAX_SIM_RATE),
+    }
+}
+
+/// North/east displacement from `a` to `b`, metres
+fn offset_m(a: &Telemetry, b: &Telemetry) -> (f64, f64) {
+    let lat = a.position.latitude.to_radians();
+    let north = (b.position.latitude - a.position.latitude).to_radians() * EARTH_RADIUS_M;
+    let east =
+        (b.position.longitude - a.position.longitude).to_radians() * EARTH_RADIUS_M * lat.cos();
+    (north, east)
+}
+
+/// Shortest signed angle from `from` to `to`, degrees in (-180, 180]
+pub(crate) fn signed_difference(from: f64, to: f64) -> f64 {
+    let d = (to - from).rem_euclid(360.0);
+    if d > 180.0 {
+        d - 360.0
+    } else {
+        d
+    }
+}
+
+fn wrap_degrees(deg: f64) -> f64 {
+    deg.rem_euclid(360.0)
+}
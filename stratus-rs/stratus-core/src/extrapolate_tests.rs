@@ -0,0 +1,182 @@
+//! Unit tests for dead-reckoning extrapolation
+
+use crate::extrapolate::Extrapolator;
+use crate::telemetry::Telemetry;
+use std::time::{Duration, Instant};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const METRES_PER_DEG: f64 = 6_371_000.0 * std::f64::consts::PI / 180.0;
+
+    /// Frame `seq` of a flight at 100 m/s, captured every 100 ms
+    fn frame(seq: u64) -> Telemetry {
+        let mut t = Telemetry {
+            frame_seq: seq,
+            monotonic_ns: 1_000_000_000 + seq * 100_000_000,
+            sim_time_s: 500.0 + seq as f64 * 0.1,
+            ..Default::default()
+        };
+        t.position.latitude = 47.0;
+        t.position.longitude = 8.0;
+        t.position.altitude_msl_m = 1000.0;
+        t.position.altitude_agl_m = 600.0;
+        t.speed.ground_speed_mps = 100.0;
+        t
+    }
+
+    /// `frame(seq)` moved `metres` along `track_deg` from the base position
+    fn moved(seq: u64, track_deg: f64, metres: f64) -> Telemetry {
+        let mut t = frame(seq);
+        let track = track_deg.to_radians();
+        t.position.latitude += metres * track.cos() / METRES_PER_DEG;
+        t.position.longitude +=
+            metres * track.sin() / (METRES_PER_DEG * 47.0_f64.to_radians().cos());
+        t
+    }
+
+    fn feed(frames: &[Telemetry]) -> Extrapolator {
+        let mut x = Extrapolator::new();
+        let start = Instant::now();
+        for f in frames {
+            x.update_at(f, start);
+        }
+        x
+    }
+
+    /// North/east metres from `a` to `b`
+    fn offset(a: &Telemetry, b: &Telemetry) -> (f64, f64) {
+        let north = (b.position.latitude - a.position.latitude) * METRES_PER_DEG;
+        let east = (b.position.longitude - a.position.longitude)
+            * METRES_PER_DEG
+            * a.position.latitude.to_radians().cos();
+        (north, east)
+    }
+
+    #[test]
+    fn test_straight_and_climbing() {
+        let mut a = frame(1);
+        let mut b = moved(2, 0.0, 10.0);
+        a.speed.vertical_speed_fpm = 1000.0;
+        b.speed.vertical_speed_fpm = 1000.0;
+        let x = feed(&[a, b.clone()]);
+        assert!((x.motion().sim_rate - 1.0).abs() < 1e-6);
+
+        let p = x.predict_after(Duration::from_secs(2)).unwrap();
+        let (north, east) = offset(&b, &p);
+        assert!((north - 200.0).abs() < 0.5, "north {}", north);
+        assert!(east.abs() < 0.5, "east {}", east);
+        assert!((p.position.altitude_msl_m - (1000.0 + 2.0 * 5.08)).abs() < 1e-6);
+        assert_eq!(p.monotonic_ns, b.monotonic_ns + 2_000_000_000);
+        assert!((p.sim_time_s - (b.sim_time_s + 2.0)).abs() < 1e-9);
+        assert_eq!(p.frame_seq, b.frame_seq);
+    }
+
+    #[test]
+    fn test_track_follows_positions_not_heading() {
+        // Pointing north, drifting east: the ground track wins
+        let a = frame(1);
+        let mut b = moved(2, 90.0, 10.0);
+        b.orientation.heading_true = 0.0;
+        let x = feed(&[a, b.clone()]);
+        assert!((x.motion().track_deg - 90.0).abs() < 0.1);
+
+        let (north, east) = offset(&b, &x.predict_after(Duration::from_secs(1)).unwrap());
+        assert!(north.abs() < 0.5 && (east - 100.0).abs() < 0.5);
+    }
+
+    #[test]
+    fn test_constant_turn() {
+        // Standard-rate turn (3 deg/s) to the right through north
+        let mut a = moved(1, 0.0, 0.0);
+        a.orientation.heading_true = 359.85;
+        let mut b = moved(2, 0.0, 10.0);
+        b.orientation.heading_true = 0.15;
+        let mut x = Extrapolator::with_max_horizon(Duration::from_secs(60));
+        let now = Instant::now();
+        x.update_at(&a, now);
+        x.update_at(&b, now);
+        assert!((x.motion().turn_rate_dps - 3.0).abs() < 1e-3);
+        assert!((x.motion().track_deg - 0.15).abs() < 0.01);
+
+        // 30 s = a 90 degree turn of radius v/omega
+        let p = x.predict_after(Duration::from_secs(30)).unwrap();
+        assert!((p.orientation.heading_true - 90.15).abs() < 0.01);
+        let radius = 100.0 / 3.0_f64.to_radians();
+        let (north, east) = offset(&b, &p);
+        assert!((north.hypot(east) - radius * 2.0_f64.sqrt()).abs() < 5.0);
+        assert!(north > 0.0 && east > 0.0);
+    }
+
+    #[test]
+    fn test_pause_and_time_acceleration() {
+        // Sim clock runs at 4x the capture clock
+        let a = frame(1);
+        let mut b = moved(2, 0.0, 40.0);
+        b.sim_time_s = a.sim_time_s + 0.4;
+        let x = feed(&[a, b.clone()]);
+        assert!((x.motion().sim_rate - 4.0).abs() < 1e-6);
+        let (north, _) = offset(&b, &x.predict_after(Duration::from_secs(1)).unwrap());
+        assert!((north - 400.0).abs() < 1.0);
+
+        // Paused: the sim clock stands still, and so does the aircraft
+        let a = frame(1);
+        let mut b = frame(2);
+        b.sim_time_s = a.sim_time_s;
+        b.state.paused = true;
+        let x = feed(&[a, b.clone()]);
+        let p = x.predict_after(Duration::from_secs(3)).unwrap();
+        assert_eq!(p.position.latitude, b.position.latitude);
+        assert_eq!(p.sim_time_s, b.sim_time_s);
+    }
+
+    #[test]
+    fn test_horizon_is_capped() {
+        let x = feed(&[frame(1), moved(2, 0.0, 10.0)]);
+        let capped = x.predict_after(Duration::from_secs(5)).unwrap();
+        let far = x.predict_after(Duration::from_secs(600)).unwrap();
+        assert_eq!(capped.position.latitude, far.position.latitude);
+        assert!(Extrapolator::new().predict().is_none());
+    }
+
+    #[test]
+    fn test_restart_and_duplicates_drop_rates() {
+        let mut a = frame(1);
+        a.orientation.heading_true = 10.0;
+        let mut b = moved(2, 0.0, 10.0);
+        b.orientation.heading_true = 11.0;
+        let mut x = feed(&[a, b.clone()]);
+        assert!(x.motion().turn_rate_dps > 5.0);
+
+        // Reading the same frame again changes nothing
+        x.update_at(&b, Instant::now());
+        assert!(x.motion().turn_rate_dps > 5.0);
+
+        // Plugin restarted: sequence from 1 again, no rates from across it
+        let mut restarted = frame(1);
+        restarted.orientation.heading_true = 200.0;
+        x.update_at(&restarted, Instant::now());
+        assert_eq!(x.motion().turn_rate_dps, 0.0);
+        assert_eq!(x.motion().track_deg, 200.0);
+    }
+
+    #[test]
+    fn test_frames_without_timing_fields() {
+        // A v2 plugin: no seq or clocks, arrival times are used instead
+        let mut a = frame(0);
+        a.monotonic_ns = 0;
+        a.sim_time_s = 0.0;
+        let mut b = moved(0, 0.0, 10.0);
+        b.monotonic_ns = 0;
+        b.sim_time_s = 0.0;
+
+        let mut x = Extrapolator::new();
+        let t0 = Instant::now();
+        x.update_at(&a, t0);
+        x.update_at(&b, t0 + Duration::from_millis(100));
+        assert!((x.motion().sim_rate - 1.0).abs() < 1e-6);
+        let (north, _) = offset(&b, &x.predict_after(Duration::from_secs(1)).unwrap());
+        assert!((north - 100.0).abs() < 0.5);
+    }
+}
@@ -0,0 +1,259 @@
+//! Telemetry frame layout and binary encoding
+//!
+//! `TelemetryFrame` is the fixed-layout snapshot the X-Plane plugin captures
+//! each tick (`adapters/xplane/src/stratus_frame.h`). It travels unchanged
+//! through the shared-memory ring and, prefixed with a small versioned
+//! header, as the binary file format (`stratus_telemetry.bin`):
+//!
+//! ```text
+//! offset  size  field
+//! 0       4     magic "STRF" (0x46525453 LE)
+//! 4       2     version (FRAME_VERSION)
+//! 6       2     header_size (16; readers skip anything beyond what they know)
+//! 8       4     frame_size (size of the TelemetryFrame that follows)
+//! 12      4     flags (reserved, 0)
+//! 16      ...   TelemetryFrame, little-endian, fixed offsets
+//! ```
+
+use crate::telemetry::{
+    Autopilot, Derived, Engines, FlightState, Orientation, Position, Radios, Speed, Telemetry,
+    TelemetryError, Transponder,
+};
+use std::mem::size_of;
+
+/// Frame layout version (`STRATUS_FRAME_VERSION`)
+pub const FRAME_VERSION: u16 = 5;
+/// Engine slots in a frame (`STRATUS_MAX_ENGINES`)
+pub const MAX_ENGINES: usize = 8;
+/// `events` bit i is `EVENT_NAMES[i]` (`STRATUS_EVENT_*`)
+pub const EVENT_NAMES: [&str; 9] = [
+    "touchdown",
+    "liftoff",
+    "pause",
+    "unpause",
+    "com1",
+    "com2",
+    "squawk",
+    "xpdr_mode",
+    "phase",
+];
+/// Airport ident bytes in a frame (`STRATUS_AIRPORT_ID_LEN`)
+pub const AIRPORT_ID_LEN: usize = 8;
+/// Runway ident bytes in a frame (`STRATUS_RUNWAY_ID_LEN`)
+pub const RUNWAY_ID_LEN: usize = 4;
+/// Binary frame magic ("STRF")
+pub const FRAME_MAGIC: u32 = 0x4652_5453;
+/// Size of the binary frame header (`StratusFrameHeader`)
+pub const FRAME_HEADER_SIZE: usize = 16;
+
+/// Raw telemetry frame, byte-compatible with `StratusFrame` in `stratus_frame.h`
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct TelemetryFrame {
+    pub timestamp: i64,
+
+    pub latitude: f64,
+    pub longitude: f64,
+    pub altitude_msl_m: f64,
+    pub altitude_agl_m: f64,
+
+    pub heading_mag: f32,
+    pub heading_true: f32,
+    pub pitch: f32,
+    pub roll: f32,
+
+    pub ground_speed_mps: f32,
+    pub ias_kts: f32,
+    pub tas_mps: f32,
+    pub vertical_speed_fpm: f32,
+
+    pub com1_hz: i32,
+    pub com1_standby_hz: i32,
+    pub com2_hz: i32,
+    pub com2_standby_hz: i32,
+    pub nav1_hz: i32,
+    pub nav2_hz: i32,
+
+    pub xpdr_code: i32,
+    pub xpdr_mode: i32,
+
+    pub ap_altitude_ft: f32,
+    pub ap_heading: f32,
+    pub ap_vs_fpm: f32,
+
+    pub on_ground: u8,
+    pub paused: u8,
+    pub _pad0: [u8; 2],
+
+    pub aircraft: [u8; 64],
+
+    pub engine_count: i32,
+    pub engine_running: [i32; MAX_ENGINES],
+    pub _pad1: [u8; 4],
+
+    pub frame_seq: u64,
+    pub monotonic_ns: u64,
+    pub sim_time_s: f64,
+
+    pub phase: i32,
+    pub ground_speed_kts: f32,
+    pub tas_kts: f32,
+    pub altitude_msl_ft: f32,
+    pub altitude_agl_ft: f32,
+    pub airport: [u8; AIRPORT_ID_LEN],
+    pub airport_dist_nm: f32,
+    pub airport_bearing_deg: f32,
+    pub airport_elevation_ft: f32,
+    pub runway: [u8; RUNWAY_ID_LEN],
+    pub runway_dist_ft: f32,
+    pub runway_length_ft: i32,
+    pub on_runway: u8,
+    pub _pad2: [u8; 3],
+
+    pub events: u32,
+    pub event_seq: u32,
+}
+
+const _: () = assert!(size_of::<TelemetryFrame>() == 312);
+
+impl TelemetryFrame {
+    /// Decode a binary frame (header + payload)
+    pub fn decode(bytes: &[u8]) -> Result<Self, TelemetryError> {
+        let invalid = |msg: String| TelemetryError::FrameError(msg);
+
+        if bytes.len() < FRAME_HEADER_SIZE {
+            return Err(invalid(format!("short frame ({} bytes)", bytes.len())));
+        }
+        let u16_at = |o: usize| u16::from_le_bytes([bytes[o], bytes[o + 1]]);
+        let u32_at = |o: usize| u32::from_le_bytes(bytes[o..o + 4].try_into().unwrap());
+
+        if u32_at(0) != FRAME_MAGIC {
+            return Err(invalid("bad magic".to_string()));
+        }
+        let version = u16_at(4);
+        let header_size = u16_at(6) as usize;
+        let frame_size = u32_at(8) as usize;
+        if version != FRAME_VERSION || frame_size != size_of::<Self>() {
+            return Err(invalid(format!(
+                "unsupported frame (version {}, {} bytes)",
+                version, frame_size
+            )));
+        }
+        if header_size < FRAME_HEADER_SIZE || bytes.len() < header_size + frame_size {
+            return Err(invalid(format!("truncated frame ({} bytes)", bytes.len())));
+        }
+
+        // SAFETY: bounds checked above; every bit pattern is a valid
+        // TelemetryFrame (plain integers, floats and byte arrays).
+        Ok(unsafe { std::ptr::read_unaligned(bytes[header_size..].as_ptr() as *const Self) })
+    }
+
+    /// Encode as a binary frame (header + payload)
+    pub fn encode(&self) -> Vec<u8> {
+        let mut out = Vec::with_capacity(FRAME_HEADER_SIZE + size_of::<Self>());
+        out.extend_from_slice(&FRAME_MAGIC.to_le_bytes());
+        out.extend_from_slice(&FRAME_VERSION.to_le_bytes());
+        out.extend_from_slice(&(FRAME_HEADER_SIZE as u16).to_le_bytes());
+        out.extend_from_slice(&(size_of::<Self>() as u32).to_le_bytes());
+        out.extend_from_slice(&0u32.to_le_bytes());
+        // SAFETY: TelemetryFrame is repr(C) with explicit padding only
+        out.extend_from_slice(unsafe {
+            std::slice::from_raw_parts(self as *const Self as *const u8, size_of::<Self>())
+        });
+        out
+    }
+
+    /// Aircraft file name up to the first NUL
+    pub fn aircraft_name(&self) -> String {
+        c_string(&self.aircraft)
+    }
+
+    /// Names of the transitions set in `events`
+    pub fn event_names(&self) -> Vec<String> {
+        EVENT_NAMES
+            .iter()
+            .enumerate()
+            .filter(|(i, _)| self.events & (1 << i) != 0)
+            .map(|(_, name)| name.to_string())
+            .collect()
+    }
+}
+
+/// A NUL-padded frame string
+fn c_string(bytes: &[u8]) -> String {
+    let end = bytes.iter().position(|&b| b == 0).unwrap_or(bytes.len());
+    String::from_utf8_lossy(&bytes[..end]).into_owned()
+}
+
+impl From<&TelemetryFrame> for Telemetry {
+    fn from(f: &TelemetryFrame) -> Self {
+        Telemetry {
+            timestamp: f.timestamp,
+            frame_seq: f.frame_seq,
+            monotonic_ns: f.monotonic_ns,
+            sim_time_s: f.sim_time_s,
+            event_seq: f.event_seq,
+            events: f.event_names(),
+            simulator: "X-Plane".to_string(),
+            aircraft: f.aircraft_name(),
+            position: Position {
+                latitude: f.latitude,
+                longitude: f.longitude,
+                altitude_msl_m: f.altitude_msl_m,
+                altitude_agl_m: f.altitude_agl_m,
+            },
+            orientation: Orientation {
+                heading_mag: f.heading_mag,
+                heading_true: f.heading_true,
+                pitch: f.pitch,
+                roll: f.roll,
+            },
+            speed: Speed {
+                ground_speed_mps: f.ground_speed_mps,
+                ias_kts: f.ias_kts,
+                tas_mps: f.tas_mps,
+                vertical_speed_fpm: f.vertical_speed_fpm,
+            },
+            radios: Radios {
+                com1_hz: f.com1_hz,
+                com1_standby_hz: f.com1_standby_hz,
+                com2_hz: f.com2_hz,
+                com2_standby_hz: f.com2_standby_hz,
+                nav1_hz: f.nav1_hz,
+                nav2_hz: f.nav2_hz,
+            },
+            transponder: Transponder {
+                code: f.xpdr_code,
+                mode: f.xpdr_mode,
+            },
+            autopilot: Autopilot {
+                altitude_ft: f.ap_altitude_ft,
+                heading: f.ap_heading,
+                vs_fpm: f.ap_vs_fpm,
+            },
+            engines: Engines {
+                count: f.engine_count,
+                running: f.engine_running.to_vec(),
+            },
+            state: FlightState {
+                on_ground: f.on_ground != 0,
+                paused: f.paused != 0,
+            },
+            derived: Derived {
+                phase: f.phase,
+                ground_speed_kts: f.ground_speed_kts,
+                tas_kts: f.tas_kts,
+                altitude_msl_ft: f.altitude_msl_ft,
+                altitude_agl_ft: f.altitude_agl_ft,
+                airport: c_string(&f.airport),
+                airport_dist_nm: f.airport_dist_nm,
+                airport_bearing_deg: f.airport_bearing_deg,
+                airport_elevation_ft: f.airport_elevation_ft,
+                runway: c_string(&f.runway),
+                runway_dist_ft: f.runway_dist_ft,
+                runway_length_ft: f.runway_length_ft,
+                on_runway: f.on_runway != 0,
+            },
+        }
+    }
+}
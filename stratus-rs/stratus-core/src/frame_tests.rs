@@ -0,0 +1,126 @@
+//! Unit tests for the binary telemetry frame format
+
+use crate::frame::{TelemetryFrame, FRAME_HEADER_SIZE, FRAME_MAGIC};
+use crate::telemetry::{read_binary_telemetry, FlightPhase, Telemetry};
+use std::mem::size_of;
+use tempfile::tempdir;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sample_frame() -> TelemetryFrame {
+        let mut f: TelemetryFrame = unsafe { std::mem::zeroed() };
+        f.timestamp = 1_736_330_000;
+        f.latitude = 37.6188;
+        f.longitude = -122.375;
+        f.heading_mag = 284.5;
+        f.com1_hz = 118_700_000;
+        f.xpdr_code = 4521;
+        f.ap_altitude_ft = 5000.0;
+        f.paused = 1;
+        f.aircraft[..8].copy_from_slice(b"C172.acf");
+        f.engine_count = 1;
+        f.engine_running[0] = 1;
+        f.frame_seq = 42;
+        f.monotonic_ns = 9_876_543_210;
+        f.sim_time_s = 1234.5;
+        f.phase = 7;
+        f.airport[..4].copy_from_slice(b"KSFO");
+        f.airport_dist_nm = 3.25;
+        f.runway[..3].copy_from_slice(b"28L");
+        f.runway_length_ft = 11_870;
+        f
+    }
+
+    #[test]
+    fn test_encode_layout() {
+        let bytes = sample_frame().encode();
+        assert_eq!(bytes.len(), FRAME_HEADER_SIZE + size_of::<TelemetryFrame>());
+        assert_eq!(&bytes[0..4], &FRAME_MAGIC.to_le_bytes());
+        // Fixed offset: latitude is the second field of the payload
+        let lat = f64::from_le_bytes(
+            bytes[FRAME_HEADER_SIZE + 8..FRAME_HEADER_SIZE + 16]
+                .try_into()
+                .unwrap(),
+        );
+        assert_eq!(lat, 37.6188);
+    }
+
+    #[test]
+    fn test_roundtrip() {
+        let decoded = TelemetryFrame::decode(&sample_frame().encode()).unwrap();
+        let telemetry = Telemetry::from(&decoded);
+        assert_eq!(telemetry.timestamp, 1_736_330_000);
+        assert_eq!(telemetry.position.longitude, -122.375);
+        assert_eq!(telemetry.radios.com1_hz, 118_700_000);
+        assert_eq!(telemetry.transponder.code, 4521);
+        assert_eq!(telemetry.autopilot.altitude_ft, 5000.0);
+        assert_eq!(telemetry.aircraft, "C172.acf");
+        assert!(telemetry.state.paused);
+        assert!(!telemetry.state.on_ground);
+        assert_eq!(telemetry.engines.count, 1);
+        assert_eq!(telemetry.engines.running[..2], [1, 0]);
+        assert_eq!(telemetry.frame_seq, 42);
+        assert_eq!(telemetry.monotonic_ns, 9_876_543_210);
+        assert_eq!(telemetry.sim_time_s, 1234.5);
+    }
+
+    #[test]
+    fn test_derived_section() {
+        let telemetry = Telemetry::from(&sample_frame());
+        let derived = &telemetry.derived;
+        assert_eq!(derived.phase(), FlightPhase::Approach);
+        assert_eq!(derived.phase().as_str(), "APPROACH");
+        assert_eq!(derived.airport, "KSFO");
+        assert_eq!(derived.airport_dist_nm, 3.25);
+        assert_eq!(derived.runway, "28L");
+        assert_eq!(derived.runway_length_ft, 11_870);
+        assert!(!derived.on_runway);
+
+        // JSON from a plugin without the section still parses
+        let json = serde_json::to_value(&telemetry).unwrap();
+        let mut old = json.clone();
+        old.as_object_mut().unwrap().remove("derived");
+        let parsed: Telemetry = serde_json::from_value(old).unwrap();
+        assert_eq!(parsed.derived.phase(), FlightPhase::Unknown);
+        assert_eq!(parsed.derived.airport, "");
+    }
+
+    #[test]
+    fn test_event_names() {
+        let mut frame = sample_frame();
+        assert!(Telemetry::from(&frame).events.is_empty());
+
+        frame.events = 0x001 | 0x010; // STRATUS_EVENT_TOUCHDOWN | COM1
+        frame.event_seq = 3;
+        let telemetry = Telemetry::from(&frame);
+        assert_eq!(telemetry.events, ["touchdown", "com1"]);
+        assert_eq!(telemetry.event_seq, 3);
+    }
+
+    #[test]
+    fn test_rejects_bad_frames() {
+        let good = sample_frame().encode();
+
+        assert!(TelemetryFrame::decode(&good[..FRAME_HEADER_SIZE + 10]).is_err());
+
+        let mut bad_magic = good.clone();
+        bad_magic[0] = b'X';
+        assert!(TelemetryFrame::decode(&bad_magic).is_err());
+
+        let mut bad_version = good.clone();
+        bad_version[4] = 99;
+        assert!(TelemetryFrame::decode(&bad_version).is_err());
+    }
+
+    #[test]
+    fn test_read_binary_file() {
+        let dir = tempdir().unwrap();
+        let path = dir.path().join("stratus_telemetry.bin");
+        std::fs::write(&path, sample_frame().encode()).unwrap();
+
+        let telemetry = read_binary_telemetry(&path).unwrap();
+        assert_eq!(telemetry.orientation.heading_mag, 284.5);
+    }
+}
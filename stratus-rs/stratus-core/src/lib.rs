@@ -2,31 +2,77 @@
 //!
 //! This crate contains the core logic for Stratus ATC:
 //! - Telemetry: File-based communication with X-Plane
+//! - Command ring: Shared-memory command ring to the plugin
+//! - Context: Aircraft/location load events from the plugin
+//! - Delta: Keyframe/delta telemetry reassembly
+//! - Extrapolate: Dead reckoning between telemetry frames
+//! - Frame: Fixed-layout telemetry frame and binary encoding
+//! - Shm: Shared-memory telemetry frame ring
+//! - Traffic: Other aircraft from the plugin and a spatial index over them
+//! - Tracker: Change detection for the plugin's context and traffic files
+//! - Udp: Telemetry stream from a plugin on another machine
+//! - Recording: Flight data recorder session files
+//! - Replay: Stream a recording back through a telemetry channel
 //! - Ollama: Local LLM client
 //! - Streaming: Low-latency streaming LLM responses
 //! - Warmup: Keep model hot to eliminate cold-starts
 //! - ATC: Prompt building and response parsing
 
 pub mod atc;
+pub mod command_ring;
 pub mod commands;
 pub mod config;
+pub mod context;
+pub mod delta;
+pub mod extrapolate;
+pub mod frame;
 pub mod ollama;
+pub mod recording;
+pub mod replay;
+pub mod shm;
 #[cfg(target_os = "linux")]
 pub mod speech;
 pub mod streaming;
 pub mod telemetry;
+pub mod tracker;
+pub mod traffic;
+pub mod udp;
 pub mod voice;
 pub mod warmup;
 
 #[cfg(test)]
 mod atc_tests;
 #[cfg(test)]
+mod command_ring_tests;
+#[cfg(test)]
 mod commands_tests;
+#[cfg(test)]
+mod context_tests;
+#[cfg(test)]
+mod delta_tests;
+#[cfg(test)]
+mod extrapolate_tests;
+#[cfg(test)]
+mod frame_tests;
+#[cfg(test)]
+mod recording_tests;
+#[cfg(test)]
+mod shm_tests;
+#[cfg(test)]
+mod test_util;
+#[cfg(test)]
+mod traffic_tests;
+#[cfg(test)]
+mod udp_tests;
 
 // Re-export common types
 pub use atc::AtcEngine;
 pub use config::StratusConfig;
+pub use context::SimContext;
+pub use delta::TelemetryStream;
+pub use extrapolate::Extrapolator;
 pub use ollama::OllamaClient;
 pub use streaming::{StreamChunk, StreamingOllama};
-pub use telemetry::{Telemetry, TelemetryWatcher};
+pub use telemetry::{FlightPhase, Telemetry, TelemetryWatcher};
+pub use traffic::{TrafficIndex, TrafficSnapshot};
 pub use warmup::{WarmupConfig, WarmupService};
@@ -0,0 +1,269 @@
+//! Recording - Flight data recorder session files
+//!
+//! Reads the `.strec` files the X-Plane plugin writes with `record = on`
+//! (`adapters/xplane/src/stratus_recorder.h`) back into the `TelemetryFrame`s
+//! it captured, each with its original capture time.
+//!
+//! ```text
+//! [header, 64 bytes][records ...][keyframe index, once sealed]
+//!
+//! 'K'  u64 monotonic_ns, TelemetryFrame              (keyframe)
+//! 'D'  u32 dt_us, changed-word mask,                 (delta)
+//!      2-bit byte counts (n - 1) per changed word, 4 per byte,
+//!      then n low bytes of (word ^ previous word) per changed word
+//! ```
+//!
+//! The mask has one bit per 32-bit word of the recorded frame, in as many
+//! `u64`s as that takes (two for the v5 frame, one up to v3).
+//!
+//! Frame versions only ever append fields, so sessions recorded with an
+//! older plugin (frame v2 on) stay readable: their frames are decoded at the
+//! recorded size and the newer fields read as zero.
+//!
+//! A session that never reached a clean shutdown is unsealed but still
+//! readable up to the header's `data_end`.
+
+use crate::frame::{TelemetryFrame, FRAME_VERSION};
+use crate::telemetry::TelemetryError;
+use std::mem::size_of;
+use std::path::Path;
+
+/// Header magic ("STRC")
+pub const RECORDING_MAGIC: u32 = 0x4352_5453;
+/// Container version (`STRATUS_REC_VERSION`)
+pub const RECORDING_VERSION: u16 = 1;
+/// Header flag set once the keyframe index has been written
+pub const RECORDING_SEALED: u16 = 0x1;
+/// Size of the file header (`StratusRecHeader`)
+pub const RECORDING_HEADER_SIZE: usize = 64;
+
+const KEYFRAME: u8 = b'K';
+const DELTA: u8 = b'D';
+const FRAME_WORDS: usize = size_of::<TelemetryFrame>() / 4;
+const MASK_WORDS: usize = FRAME_WORDS.div_ceil(64);
+
+/// Frame size of each version a recording can hold (`STRATUS_FRAME_VERSION`
+/// from the first recorder on)
+const FRAME_SIZES: [(u16, usize); 4] = [
+    (2, 224),
+    (3, 248),
+    (4, 304),
+    (FRAME_VERSION, size_of::<TelemetryFrame>()),
+];
+
+/// One captured frame and when the plugin captured it
+#[derive(Debug, Clone, Copy)]
+pub struct RecordedFrame {
+    /// Plugin monotonic clock at capture, in nanoseconds
+    pub monotonic_ns: u64,
+    pub frame: TelemetryFrame,
+}
+
+/// A recorded session, loaded into memory
+#[derive(Debug)]
+pub struct Recording {
+    data: Vec<u8>,
+    data_end: usize,
+    start_unix_ns: i64,
+    start_monotonic_ns: u64,
+    frame_count: u64,
+    sealed: bool,
+    frame_words: usize,
+}
+
+impl Recording {
+    /// Load a session file
+    pub fn open(path: &Path) -> Result<Self, TelemetryError> {
+        Self::parse(std::fs::read(path)?)
+    }
+
+    /// Validate the header of an in-memory session file
+    pub fn parse(data: Vec<u8>) -> Result<Self, TelemetryError> {
+        let invalid = |msg: String| TelemetryError::RecordingError(msg);
+
+        if data.len() < RECORDING_HEADER_SIZE {
+            return Err(invalid(format!("short file ({} bytes)", data.len())));
+        }
+        let u16_at = |o: usize| u16::from_le_bytes([data[o], data[o + 1]]);
+        let u32_at = |o: usize| u32::from_le_bytes(data[o..o + 4].try_into().unwrap());
+        let u64_at = |o: usize| u64::from_le_bytes(data[o..o + 8].try_into().unwrap());
+
+        if u32_at(0) != RECORDING_MAGIC {
+            return Err(invalid("bad magic".to_string()));
+        }
+        let version = u16_at(4);
+        let header_size = u16_at(6) as usize;
+        let frame_size = u32_at(8) as usize;
+        let frame_version = u16_at(12);
+        if version != RECORDING_VERSION
+            || header_size != RECORDING_HEADER_SIZE
+            || !FRAME_SIZES.contains(&(frame_version, frame_size))
+        {
+            return Err(invalid(format!(
+                "unsupported recording (version {}, frame version {}, {} bytes)",
+                version, frame_version, frame_size
+            )));
+        }
+
+        let data_end = u64_at(32) as usize;
+        if data_end < RECORDING_HEADER_SIZE || data_end > data.len() {
+            return Err(invalid(format!(
+                "data_end {} outside the file ({} bytes)",
+                data_end,
+                data.len()
+            )));
+        }
+
+        Ok(Self {
+            start_unix_ns: u64_at(16) as i64,
+            start_monotonic_ns: u64_at(24),
+            frame_count: u64_at(40),
+            sealed: u16_at(14) & RECORDING_SEALED != 0,
+            frame_words: frame_size / 4,
+            data_end,
+            data,
+        })
+    }
+
+    /// Wall-clock time the session started, Unix nanoseconds
+    pub fn start_unix_ns(&self) -> i64 {
+        self.start_unix_ns
+    }
+
+    /// Plugin monotonic clock when the session started
+    pub fn start_monotonic_ns(&self) -> u64 {
+        self.start_monotonic_ns
+    }
+
+    /// Frames in the session, as counted by the recorder
+    pub fn frame_count(&self) -> u64 {
+        self.frame_count
+    }
+
+    /// False if the plugin never closed the session (crash, kill)
+    pub fn is_sealed(&self) -> bool {
+        self.sealed
+    }
+
+    /// Decode the frames in capture order
+    pub fn frames(&self) -> RecordingFrames<'_> {
+        RecordingFrames {
+            data: &self.data[..self.data_end],
+            offset: RECORDING_HEADER_SIZE,
+            frame_words: self.frame_words,
+            words: [0; FRAME_WORDS],
+            monotonic_ns: None,
+        }
+    }
+}
+
+/// Iterator over the frames of a `Recording`; stops at the first bad record
+pub struct RecordingFrames<'a> {
+    data: &'a [u8],
+    offset: usize,
+    /// Words per recorded frame; the rest of `words` stays zero
+    frame_words: usize,
+    words: [u32; FRAME_WORDS],
+    monotonic_ns: Option<u64>,
+}
+
+impl RecordingFrames<'_> {
+    fn next_record(&mut self) -> Result<RecordedFrame, TelemetryError> {
+        let invalid = |offset: usize, msg: &str| {
+            TelemetryError::RecordingError(format!("{} at {}", msg, offset))
+        };
+        let start = self.offset;
+        let rest = &self.data[start..];
+        let frame_words = self.frame_words;
+        let mask_words = frame_words.div_ceil(64);
+        let delta_header_size = 1 + 4 + 8 * mask_words;
+
+        match rest[0] {
+            KEYFRAME => {
+                let size = 1 + 8 + frame_words * 4;
+                if rest.len() < size {
+                    return Err(invalid(start, "truncated keyframe"));
+                }
+                self.monotonic_ns = Some(u64::from_le_bytes(rest[1..9].try_into().unwrap()));
+                for (i, word) in self.words[..frame_words].iter_mut().enumerate() {
+                    let o = 9 + i * 4;
+                    *word = u32::from_le_bytes(rest[o..o + 4].try_into().unwrap());
+                }
+                self.offset += size;
+            }
+            DELTA => {
+                let Some(prev_ns) = self.monotonic_ns else {
+                    return Err(invalid(start, "delta before the first keyframe"));
+                };
+                if rest.len() < delta_header_size {
+                    return Err(invalid(start, "truncated delta"));
+                }
+                let dt_us = u32::from_le_bytes(rest[1..5].try_into().unwrap());
+                let mut mask = [0u64; MASK_WORDS];
+                for (k, m) in mask[..mask_words].iter_mut().enumerate() {
+                    let o = 5 + k * 8;
+                    *m = u64::from_le_bytes(rest[o..o + 8].try_into().unwrap());
+                }
+                let spare = mask_words * 64 - frame_words;
+                if spare > 0 && mask[mask_words - 1] >> (64 - spare) != 0 {
+                    return Err(invalid(start, "delta mask beyond the frame"));
+                }
+                let changed: usize = mask.iter().map(|m| m.count_ones() as usize).sum();
+                let codes_end = delta_header_size + changed.div_ceil(4);
+                if rest.len() < codes_end {
+                    return Err(invalid(start, "truncated delta"));
+                }
+                let codes = &rest[delta_header_size..codes_end];
+                let mut pos = codes_end;
+                let changed_words =
+                    (0..frame_words).filter(|i| mask[i / 64] & (1u64 << (i % 64)) != 0);
+                for (j, i) in changed_words.enumerate() {
+                    let n = ((codes[j / 4] >> (2 * (j % 4))) & 3) as usize + 1;
+                    let Some(bytes) = rest.get(pos..pos + n) else {
+                        return Err(invalid(start, "truncated delta"));
+                    };
+                    let x = bytes
+                        .iter()
+                        .enumerate()
+                        .fold(0u32, |x, (b, &byte)| x | (byte as u32) << (8 * b));
+                    self.words[i] ^= x;
+                    pos += n;
+                }
+                self.monotonic_ns = Some(prev_ns + dt_us as u64 * 1000);
+                self.offset += pos;
+            }
+            kind => {
+                return Err(invalid(
+                    start,
+                    &format!("unknown record type {:#04x}", kind),
+                ))
+            }
+        }
+
+        // SAFETY: the words hold exactly size_of::<TelemetryFrame>() bytes and
+        // every bit pattern is a valid TelemetryFrame (plain integers, floats
+        // and byte arrays).
+        let frame =
+            unsafe { std::ptr::read_unaligned(self.words.as_ptr() as *const TelemetryFrame) };
+        Ok(RecordedFrame {
+            monotonic_ns: self.monotonic_ns.unwrap_or_default(),
+            frame,
+        })
+    }
+}
+
+impl Iterator for RecordingFrames<'_> {
+    type Item = Result<RecordedFrame, TelemetryError>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.offset >= self.data.len() {
+            return None;
+        }
+        let record = self.next_record();
+        if record.is_err() {
+            // Nothing after a bad record can be trusted
+            self.offset = self.data.len();
+        }
+        Some(record)
+    }
+}
@@ -0,0 +1,281 @@
+//! Unit tests for flight recordings and replay
+
+use crate::frame::{TelemetryFrame, FRAME_VERSION};
+use crate::recording::{Recording, RECORDING_HEADER_SIZE, RECORDING_MAGIC, RECORDING_SEALED};
+use crate::replay::{replay, ReplaySink, ReplaySpeed};
+use crate::telemetry::{read_binary_telemetry, TelemetryError};
+use std::mem::size_of;
+use std::time::Duration;
+use tempfile::tempdir;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn words(f: &TelemetryFrame) -> Vec<u32> {
+        // SAFETY: TelemetryFrame is repr(C) with explicit padding only
+        let bytes = unsafe {
+            std::slice::from_raw_parts(f as *const _ as *const u8, size_of::<TelemetryFrame>())
+        };
+        bytes
+            .chunks(4)
+            .map(|c| u32::from_le_bytes(c.try_into().unwrap()))
+            .collect()
+    }
+
+    /// Minimal Rust stand-in for the plugin's `StratusRecorder_*` encoder
+    struct TestRecorder {
+        out: Vec<u8>,
+        words: usize,
+        prev: Vec<u32>,
+        prev_ns: u64,
+        frames: u64,
+    }
+
+    impl TestRecorder {
+        fn new() -> Self {
+            Self::with_frame(FRAME_VERSION, size_of::<TelemetryFrame>())
+        }
+
+        /// A recorder from an older plugin: frames cut to `frame_size`
+        fn with_frame(frame_version: u16, frame_size: usize) -> Self {
+            let mut out = vec![0u8; RECORDING_HEADER_SIZE];
+            out[0..4].copy_from_slice(&RECORDING_MAGIC.to_le_bytes());
+            out[4..6].copy_from_slice(&1u16.to_le_bytes());
+            out[6..8].copy_from_slice(&(RECORDING_HEADER_SIZE as u16).to_le_bytes());
+            out[8..12].copy_from_slice(&(frame_size as u32).to_le_bytes());
+            out[12..14].copy_from_slice(&frame_version.to_le_bytes());
+            Self {
+                out,
+                words: frame_size / 4,
+                prev: vec![0; frame_size / 4],
+                prev_ns: 0,
+                frames: 0,
+            }
+        }
+
+        fn keyframe(&mut self, f: &TelemetryFrame, ns: u64) {
+            self.out.push(b'K');
+            self.out.extend_from_slice(&ns.to_le_bytes());
+            for w in &words(f)[..self.words] {
+                self.out.extend_from_slice(&w.to_le_bytes());
+            }
+            self.finish(f, ns);
+        }
+
+        fn delta(&mut self, f: &TelemetryFrame, ns: u64) {
+            let cur = words(f);
+            let changed: Vec<usize> = (0..self.words)
+                .filter(|&i| cur[i] != self.prev[i])
+                .collect();
+            let mut mask = vec![0u64; self.words.div_ceil(64)];
+            for &i in &changed {
+                mask[i / 64] |= 1 << (i % 64);
+            }
+            let mut codes = vec![0u8; changed.len().div_ceil(4)];
+            let mut payload = Vec::new();
+            for (j, &i) in changed.iter().enumerate() {
+                let x = cur[i] ^ self.prev[i];
+                let n = 4 - (x.leading_zeros() as usize / 8).min(3);
+                codes[j / 4] |= ((n - 1) << (2 * (j % 4))) as u8;
+                payload.extend_from_slice(&x.to_le_bytes()[..n]);
+            }
+            self.out.push(b'D');
+            self.out
+                .extend_from_slice(&(((ns - self.prev_ns) / 1000) as u32).to_le_bytes());
+            for m in &mask {
+                self.out.extend_from_slice(&m.to_le_bytes());
+            }
+            self.out.extend_from_slice(&codes);
+            self.out.extend_from_slice(&payload);
+            self.finish(f, ns);
+        }
+
+        fn finish(&mut self, f: &TelemetryFrame, ns: u64) {
+            self.prev = words(f)[..self.words].to_vec();
+            self.prev_ns = ns;
+            self.frames += 1;
+            let end = self.out.len() as u64;
+            self.out[32..40].copy_from_slice(&end.to_le_bytes());
+            self.out[40..48].copy_from_slice(&self.frames.to_le_bytes());
+        }
+    }
+
+    fn frame(i: u32) -> TelemetryFrame {
+        let mut f: TelemetryFrame = unsafe { std::mem::zeroed() };
+        f.timestamp = 1_736_330_000 + (i / 20) as i64;
+        f.latitude = 37.6188 + i as f64 * 1e-5;
+        f.longitude = -122.375;
+        f.altitude_msl_m = 300.0 + i as f64 * 0.5;
+        f.heading_mag = 284.5;
+        f.ground_speed_mps = 50.0;
+        f.com1_hz = 120_500;
+        f.xpdr_code = if i < 30 { 1200 } else { 4521 };
+        f.aircraft[..8].copy_from_slice(b"C172.acf");
+        // Past the first 64 frame words: the second mask word
+        f.airport_dist_nm = 4.0 - i as f32 * 0.01;
+        f
+    }
+
+    /// A 50-frame session at 20 Hz, keyframes every 20 frames
+    fn session() -> Vec<u8> {
+        record(TestRecorder::new())
+    }
+
+    fn record(mut rec: TestRecorder) -> Vec<u8> {
+        for i in 0..50 {
+            let ns = 1_000_000_000 + i as u64 * 50_000_000;
+            if i % 20 == 0 {
+                rec.keyframe(&frame(i), ns);
+            } else {
+                rec.delta(&frame(i), ns);
+            }
+        }
+        rec.out
+    }
+
+    #[test]
+    fn test_decodes_every_frame() {
+        let recording = Recording::parse(session()).unwrap();
+        assert_eq!(recording.frame_count(), 50);
+        assert!(!recording.is_sealed());
+
+        let frames: Vec<_> = recording.frames().collect::<Result<_, _>>().unwrap();
+        assert_eq!(frames.len(), 50);
+        for (i, recorded) in frames.iter().enumerate() {
+            assert_eq!(
+                words(&recorded.frame),
+                words(&frame(i as u32)),
+                "frame {}",
+                i
+            );
+            assert_eq!(recorded.monotonic_ns, 1_000_000_000 + i as u64 * 50_000_000);
+        }
+        assert_eq!(frames[49].frame.xpdr_code, 4521);
+    }
+
+    #[test]
+    fn test_decodes_older_frame_versions() {
+        // v3 frames end before the derived block, in a one-word mask
+        let recording = Recording::parse(record(TestRecorder::with_frame(3, 248))).unwrap();
+        let frames: Vec<_> = recording.frames().collect::<Result<_, _>>().unwrap();
+        assert_eq!(frames.len(), 50);
+        for (i, recorded) in frames.iter().enumerate() {
+            let expected = frame(i as u32);
+            assert_eq!(words(&recorded.frame)[..62], words(&expected)[..62]);
+            assert!(words(&recorded.frame)[62..].iter().all(|&w| w == 0));
+        }
+        assert_eq!(frames[49].frame.xpdr_code, 4521);
+        assert_eq!(frames[49].frame.airport_dist_nm, 0.0);
+
+        // A size that does not match its version is not a frame we know
+        let mut bytes = record(TestRecorder::with_frame(3, 248));
+        bytes[8..12].copy_from_slice(&(size_of::<TelemetryFrame>() as u32).to_le_bytes());
+        assert!(Recording::parse(bytes).is_err());
+    }
+
+    #[test]
+    fn test_sealed_flag_and_index_are_ignored_for_decoding() {
+        let mut bytes = session();
+        let end = bytes.len();
+        bytes[14..16].copy_from_slice(&RECORDING_SEALED.to_le_bytes());
+        bytes.resize(end.next_multiple_of(8) + 32, 0xAA);
+
+        let recording = Recording::parse(bytes).unwrap();
+        assert!(recording.is_sealed());
+        assert_eq!(recording.frames().count(), 50);
+    }
+
+    #[test]
+    fn test_rejects_bad_header() {
+        let mut bytes = session();
+        bytes[0] = b'X';
+        assert!(matches!(
+            Recording::parse(bytes),
+            Err(TelemetryError::RecordingError(_))
+        ));
+
+        let mut bytes = session();
+        bytes[12..14].copy_from_slice(&(FRAME_VERSION + 1).to_le_bytes());
+        assert!(Recording::parse(bytes).is_err());
+
+        let mut bytes = session();
+        bytes[32..40].copy_from_slice(&u64::MAX.to_le_bytes());
+        assert!(Recording::parse(bytes).is_err());
+    }
+
+    #[test]
+    fn test_stops_at_corrupt_record() {
+        let mut bytes = session();
+        // Record 1 is the first delta, right after the keyframe
+        bytes[RECORDING_HEADER_SIZE + 1 + 8 + size_of::<TelemetryFrame>()] = b'?';
+
+        let recording = Recording::parse(bytes).unwrap();
+        let results: Vec<_> = recording.frames().collect();
+        assert_eq!(results.len(), 2);
+        assert!(results[0].is_ok());
+        assert!(results[1].is_err());
+    }
+
+    #[test]
+    fn test_replay_max_speed_into_binary_file() {
+        let dir = tempdir().unwrap();
+        let recording = Recording::parse(session()).unwrap();
+        let mut sink = ReplaySink::Binary(dir.path().to_path_buf());
+
+        let mut offsets = Vec::new();
+        let stats = replay(&recording, &mut sink, ReplaySpeed::Max, |offset, _| {
+            offsets.push(offset)
+        })
+        .unwrap();
+
+        assert_eq!(stats.frames, 50);
+        assert_eq!(stats.recorded, Duration::from_millis(49 * 50));
+        assert_eq!(offsets[1], Duration::from_millis(50));
+
+        let last = read_binary_telemetry(&dir.path().join("stratus_telemetry.bin")).unwrap();
+        assert_eq!(last.transponder.code, 4521);
+        assert_eq!(last.aircraft, "C172.acf");
+    }
+
+    #[test]
+    fn test_replay_json_keeps_capture_time() {
+        let dir = tempdir().unwrap();
+        let recording = Recording::parse(session()).unwrap();
+        let mut sink = ReplaySink::Json(dir.path().to_path_buf());
+        replay(&recording, &mut sink, ReplaySpeed::Max, |_, _| {}).unwrap();
+
+        let content = std::fs::read_to_string(dir.path().join("stratus_telemetry.json")).unwrap();
+        let record: serde_json::Value = serde_json::from_str(&content).unwrap();
+        assert_eq!(
+            record["recorded_monotonic_ns"],
+            1_000_000_000u64 + 49 * 50_000_000
+        );
+        assert_eq!(record["transponder"]["code"], 4521);
+    }
+
+    #[test]
+    fn test_replay_paces_by_speed_factor() {
+        let recording = Recording::parse(session()).unwrap();
+        // 2.45 s of recording at 10x
+        let stats = replay(
+            &recording,
+            &mut ReplaySink::Discard,
+            ReplaySpeed::Factor(10.0),
+            |_, _| {},
+        )
+        .unwrap();
+        assert!(stats.elapsed >= Duration::from_millis(245));
+        assert!(stats.elapsed < Duration::from_millis(2450));
+    }
+
+    #[test]
+    fn test_parse_speed() {
+        assert_eq!("realtime".parse(), Ok(ReplaySpeed::RealTime));
+        assert_eq!("max".parse(), Ok(ReplaySpeed::Max));
+        assert_eq!("10x".parse(), Ok(ReplaySpeed::Factor(10.0)));
+        assert_eq!("0.5".parse(), Ok(ReplaySpeed::Factor(0.5)));
+        assert!("0".parse::<ReplaySpeed>().is_err());
+        assert!("fast".parse::<ReplaySpeed>().is_err());
+    }
+}
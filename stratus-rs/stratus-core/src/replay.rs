@@ -0,0 +1,148 @@
+//! Replay - Stream a recorded session back through a telemetry channel
+//!
+//! Plays the frames of a flight recording (see `recording.rs`) into one of
+//! the channels `TelemetryWatcher` reads, standing in for the plugin: the
+//! shared-memory ring, `stratus_telemetry.bin` or `stratus_telemetry.json`.
+//! Frames go out byte-for-byte as recorded, spaced by their original capture
+//! times divided by the replay speed.
+//!
+//! The JSON channel also carries each frame's capture time as
+//! `recorded_monotonic_ns`, so a consumer can recover the original
+//! inter-frame timing at any speed; the fixed-layout channels carry the
+//! frame only.
+
+use crate::frame::TelemetryFrame;
+use crate::recording::{RecordedFrame, Recording};
+use crate::shm::ShmTelemetryWriter;
+use crate::telemetry::{Telemetry, TelemetryError, BINARY_FILE, JSON_FILE};
+use std::path::{Path, PathBuf};
+use std::str::FromStr;
+use std::time::{Duration, Instant};
+
+/// How fast to replay
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ReplaySpeed {
+    /// Original timing
+    RealTime,
+    /// Original timing divided by this factor
+    Factor(f64),
+    /// No pacing at all
+    Max,
+}
+
+impl ReplaySpeed {
+    /// Wall-clock time at which a frame recorded `offset` into the session is due
+    fn scale(self, offset: Duration) -> Option<Duration> {
+        match self {
+            ReplaySpeed::RealTime => Some(offset),
+            ReplaySpeed::Factor(f) => Some(offset.div_f64(f)),
+            ReplaySpeed::Max => None,
+        }
+    }
+}
+
+impl FromStr for ReplaySpeed {
+    type Err = String;
+
+    /// `realtime`, `max`, or a factor such as `10`, `10x`, `0.5`
+    fn from_str(s: &str) -> Result<Self, Self::Err> {
+        match s {
+            "realtime" | "1" | "1x" => return Ok(ReplaySpeed::RealTime),
+            "max" => return Ok(ReplaySpeed::Max),
+            _ => {}
+        }
+        match s.trim_end_matches('x').parse::<f64>() {
+            Ok(f) if f.is_finite() && f > 0.0 => Ok(ReplaySpeed::Factor(f)),
+            _ => Err(format!("invalid replay speed '{}'", s)),
+        }
+    }
+}
+
+/// Where replayed frames go
+pub enum ReplaySink {
+    /// The shared-memory ring (`shm.rs`)
+    Shm(ShmTelemetryWriter),
+    /// `stratus_telemetry.bin` in this directory
+    Binary(PathBuf),
+    /// `stratus_telemetry.json` in this directory
+    Json(PathBuf),
+    /// Nowhere; only the per-frame callback sees the frames
+    Discard,
+}
+
+impl ReplaySink {
+    /// Publish into the plugin's shared-memory segment
+    pub fn shm() -> Result<Self, TelemetryError> {
+        Ok(ReplaySink::Shm(ShmTelemetryWriter::create()?))
+    }
+
+    fn publish(&mut self, recorded: &RecordedFrame) -> Result<(), TelemetryError> {
+        match self {
+            ReplaySink::Shm(writer) => writer.publish(&recorded.frame),
+            ReplaySink::Binary(dir) => {
+                write_atomic(&dir.join(BINARY_FILE), &recorded.frame.encode())?
+            }
+            ReplaySink::Json(dir) => {
+                let mut record = serde_json::to_value(Telemetry::from(&recorded.frame))?;
+                record["recorded_monotonic_ns"] = recorded.monotonic_ns.into();
+                write_atomic(&dir.join(JSON_FILE), &serde_json::to_vec(&record)?)?
+            }
+            ReplaySink::Discard => {}
+        }
+        Ok(())
+    }
+}
+
+/// Write via a temporary file and rename, like the plugin, so a watcher
+/// never reads a half-written frame
+fn write_atomic(path: &Path, bytes: &[u8]) -> std::io::Result<()> {
+    let tmp = path.with_extension("tmp");
+    std::fs::write(&tmp, bytes)?;
+    std::fs::rename(&tmp, path)
+}
+
+/// Outcome of one replay
+#[derive(Debug, Clone, Copy, Default)]
+pub struct ReplayStats {
+    pub frames: u64,
+    /// Capture time between the first and last frame
+    pub recorded: Duration,
+    /// Wall-clock time the replay took
+    pub elapsed: Duration,
+}
+
+/// Replay every frame of `recording` into `sink` at `speed`, handing each
+/// one to `on_frame` (with its offset into the session) after publishing it.
+/// Stops at the first undecodable record.
+pub fn replay(
+    recording: &Recording,
+    sink: &mut ReplaySink,
+    speed: ReplaySpeed,
+    mut on_frame: impl FnMut(Duration, &TelemetryFrame),
+) -> Result<ReplayStats, TelemetryError> {
+    let start = Instant::now();
+    let mut first_ns = None;
+    let mut stats = ReplayStats::default();
+
+    for recorded in recording.frames() {
+        let recorded = recorded?;
+        let first = *first_ns.get_or_insert(recorded.monotonic_ns);
+        let offset = Duration::from_nanos(recorded.monotonic_ns.saturating_sub(first));
+
+        // Pace against the start, not the previous frame, so sleep overshoot
+        // does not accumulate over a long session
+        if let Some(due) = speed.scale(offset) {
+            if let Some(wait) = due.checked_sub(start.elapsed()) {
+                std::thread::sleep(wait);
+            }
+        }
+
+        sink.publish(&recorded)?;
+        on_frame(offset, &recorded.frame);
+        stats.frames += 1;
+        stats.recorded = offset;
+    }
+
+    stats.elapsed = start.elapsed();
+    Ok(stats)
+}
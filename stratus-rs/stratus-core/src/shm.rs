@@ -0,0 +1,300 @@
+//! Shared-memory telemetry transport
+//!
+//! Maps the `/stratus_telemetry` POSIX shared-memory segment published by the
+//! X-Plane plugin (`adapters/xplane/src/stratus_shm.h`) and reads the newest
+//! frame without touching the filesystem. The segment is a 64-byte header
+//! followed by a ring of seqlock-guarded slots; see the C header for the
+//! writer side. The header and slot layouts here must match
+//! `stratus_shm.h` exactly; the frame itself lives in `frame.rs`.
+//!
+//! `ShmTelemetryWriter` is the same writer in Rust, for tools that stand in
+//! for the plugin (flight replay).
+
+use crate::frame::{TelemetryFrame, FRAME_VERSION};
+use crate::telemetry::{Telemetry, TelemetryError};
+use nix::fcntl::OFlag;
+use nix::sys::mman::{mmap, munmap, shm_open, shm_unlink, MapFlags, ProtFlags};
+use nix::sys::stat::{fstat, Mode};
+use nix::unistd::ftruncate;
+use std::ffi::c_void;
+use std::mem::size_of;
+use std::num::NonZeroUsize;
+use std::ptr::NonNull;
+use std::sync::atomic::{fence, AtomicU32, AtomicU64, Ordering};
+
+/// Name of the segment created by the plugin
+pub const SHM_NAME: &str = "/stratus_telemetry";
+/// Header magic ("STSH"); cleared by the plugin on shutdown
+pub const SHM_MAGIC: u32 = 0x4853_5453;
+
+/// Ring slots created by `ShmTelemetryWriter` (`STRATUS_SHM_SLOTS`)
+pub const SHM_SLOTS: usize = 8;
+
+/// Give up on a slot after this many torn reads (writer lapping the reader)
+const MAX_READ_RETRIES: usize = 64;
+
+#[repr(C)]
+struct ShmHeader {
+    magic: AtomicU32,
+    version: u16,
+    slot_count: u16,
+    slot_size: u32,
+    frame_size: u32,
+    generation: AtomicU64,
+    _reserved: [u8; 40],
+}
+
+#[repr(C)]
+struct ShmSlot {
+    seq: AtomicU32,
+    _pad0: u32,
+    frame: TelemetryFrame,
+}
+
+const _: () = assert!(size_of::<ShmHeader>() == 64);
+const _: () = assert!(size_of::<ShmSlot>() == 320);
+
+/// Read-only mapping of the plugin's telemetry ring
+pub struct ShmTelemetryReader {
+    base: NonNull<c_void>,
+    len: usize,
+    slot_count: u64,
+}
+
+// The mapping is plain shared memory; all access goes through atomics or
+// seqlock-validated copies.
+unsafe impl Send for ShmTelemetryReader {}
+
+impl ShmTelemetryReader {
+    /// Attach to the plugin's segment
+    pub fn open() -> Result<Self, TelemetryError> {
+        Self::open_named(SHM_NAME)
+    }
+
+    /// Attach to a segment by name (tests use private names)
+    pub fn open_named(name: &str) -> Result<Self, TelemetryError> {
+        let shm_err = |e: nix::Error| TelemetryError::ShmError(format!("{}: {}", name, e));
+
+        let fd = shm_open(name, OFlag::O_RDONLY, Mode::empty()).map_err(shm_err)?;
+        let len = fstat(&fd).map_err(shm_err)?.st_size as usize;
+        if len < size_of::<ShmHeader>() {
+            return Err(TelemetryError::ShmError(format!(
+                "{}: segment too small ({} bytes)",
+                name, len
+            )));
+        }
+
+        // SAFETY: fresh read-only shared mapping of a valid descriptor; the
+        // fd may be closed once mapped.
+        let base = unsafe {
+            mmap(
+                None,
+                NonZeroUsize::new(len).unwrap(),
+                ProtFlags::PROT_READ,
+                MapFlags::MAP_SHARED,
+                &fd,
+                0,
+            )
+        }
+        .map_err(shm_err)?;
+
+        let mut reader = Self {
+            base,
+            len,
+            slot_count: 0,
+        };
+
+        let header = reader.header();
+        if header.magic.load(Ordering::Acquire) != SHM_MAGIC {
+            return Err(TelemetryError::ShmError(format!(
+                "{}: writer not ready",
+                name
+            )));
+        }
+        let slot_count = header.slot_count as usize;
+        if header.version != FRAME_VERSION
+            || header.frame_size as usize != size_of::<TelemetryFrame>()
+            || header.slot_size as usize != size_of::<ShmSlot>()
+            || slot_count == 0
+            || len < size_of::<ShmHeader>() + slot_count * size_of::<ShmSlot>()
+        {
+            return Err(TelemetryError::ShmError(format!(
+                "{}: incompatible layout (version {}, frame {} bytes)",
+                name, header.version, header.frame_size
+            )));
+        }
+        reader.slot_count = slot_count as u64;
+
+        Ok(reader)
+    }
+
+    fn header(&self) -> &ShmHeader {
+        // SAFETY: the mapping is at least one header long (checked in open)
+        unsafe { &*(self.base.as_ptr() as *const ShmHeader) }
+    }
+
+    fn slot(&self, index: u64) -> &ShmSlot {
+        let offset =
+            size_of::<ShmHeader>() + (index % self.slot_count) as usize * size_of::<ShmSlot>();
+        // SAFETY: offset is within the mapping (slot_count validated in open)
+        unsafe { &*((self.base.as_ptr() as *const u8).add(offset) as *const ShmSlot) }
+    }
+
+    /// False once the plugin has shut down; the caller should re-open later
+    pub fn is_alive(&self) -> bool {
+        self.header().magic.load(Ordering::Acquire) == SHM_MAGIC
+    }
+
+    /// Number of frames published so far
+    pub fn generation(&self) -> u64 {
+        self.header().generation.load(Ordering::Acquire)
+    }
+
+    /// Copy out the newest frame together with its generation.
+    ///
+    /// Returns `None` if nothing has been published yet or the writer kept
+    /// overwriting the slot while we were reading it.
+    pub fn read_frame(&self) -> Option<(u64, TelemetryFrame)> {
+        for _ in 0..MAX_READ_RETRIES {
+            let generation = self.generation();
+            if generation == 0 {
+                return None;
+            }
+
+            let slot = self.slot(generation - 1);
+            let seq_before = slot.seq.load(Ordering::Acquire);
+            if seq_before & 1 != 0 {
+                std::hint::spin_loop();
+                continue;
+            }
+
+            // SAFETY: in-bounds, aligned read of a Copy struct; a torn copy is
+            // detected by the sequence check below and discarded.
+            let frame = unsafe { std::ptr::read_volatile(&slot.frame) };
+            fence(Ordering::Acquire);
+
+            if slot.seq.load(Ordering::Relaxed) == seq_before {
+                return Some((generation, frame));
+            }
+        }
+        None
+    }
+
+    /// Newest frame converted to the client `Telemetry` model
+    pub fn read_telemetry(&self) -> Option<Telemetry> {
+        self.read_frame().map(|(_, frame)| Telemetry::from(&frame))
+    }
+}
+
+impl Drop for ShmTelemetryReader {
+    fn drop(&mut self) {
+        // SAFETY: base/len came from our own successful mmap
+        let _ = unsafe { munmap(self.base, self.len) };
+    }
+}
+
+/// Writable mapping of a telemetry ring, laid out exactly as the plugin's
+pub struct ShmTelemetryWriter {
+    name: String,
+    base: NonNull<c_void>,
+    len: usize,
+}
+
+// Single writer; readers synchronise through the seqlock
+unsafe impl Send for ShmTelemetryWriter {}
+
+impl ShmTelemetryWriter {
+    /// Create the plugin's segment. Don't run this next to a live sim: the
+    /// plugin would replace it on its next start.
+    pub fn create() -> Result<Self, TelemetryError> {
+        Self::create_named(SHM_NAME)
+    }
+
+    /// Create (or re-create) a segment by name (tests use private names)
+    pub fn create_named(name: &str) -> Result<Self, TelemetryError> {
+        let shm_err = |e: nix::Error| TelemetryError::ShmError(format!("{}: {}", name, e));
+        let len = size_of::<ShmHeader>() + SHM_SLOTS * size_of::<ShmSlot>();
+
+        // Start from a fresh segment so stale readers see a new mapping
+        let _ = shm_unlink(name);
+        let fd = shm_open(
+            name,
+            OFlag::O_CREAT | OFlag::O_RDWR,
+            Mode::from_bits_truncate(0o644),
+        )
+        .map_err(shm_err)?;
+        let mapped = ftruncate(&fd, len as i64).and_then(|_| {
+            // SAFETY: fresh shared mapping of a descriptor we just sized
+            unsafe {
+                mmap(
+                    None,
+                    NonZeroUsize::new(len).unwrap(),
+                    ProtFlags::PROT_READ | ProtFlags::PROT_WRITE,
+                    MapFlags::MAP_SHARED,
+                    &fd,
+                    0,
+                )
+            }
+        });
+        let base = match mapped {
+            Ok(base) => base,
+            Err(e) => {
+                let _ = shm_unlink(name);
+                return Err(shm_err(e));
+            }
+        };
+
+        let writer = Self {
+            name: name.to_string(),
+            base,
+            len,
+        };
+        // SAFETY: the mapping is zero-filled and `len` bytes long; nothing
+        // reads the header until the magic is set below.
+        unsafe {
+            let header = base.as_ptr() as *mut ShmHeader;
+            std::ptr::addr_of_mut!((*header).version).write(FRAME_VERSION);
+            std::ptr::addr_of_mut!((*header).slot_count).write(SHM_SLOTS as u16);
+            std::ptr::addr_of_mut!((*header).slot_size).write(size_of::<ShmSlot>() as u32);
+            std::ptr::addr_of_mut!((*header).frame_size).write(size_of::<TelemetryFrame>() as u32);
+        }
+        // Magic last: readers only trust the header once it is set
+        writer.header().magic.store(SHM_MAGIC, Ordering::Release);
+        Ok(writer)
+    }
+
+    fn header(&self) -> &ShmHeader {
+        // SAFETY: the mapping is at least one header long
+        unsafe { &*(self.base.as_ptr() as *const ShmHeader) }
+    }
+
+    /// Publish one frame into the next ring slot
+    pub fn publish(&mut self, frame: &TelemetryFrame) {
+        let header = self.header();
+        let generation = header.generation.load(Ordering::Relaxed);
+        let offset =
+            size_of::<ShmHeader>() + (generation as usize % SHM_SLOTS) * size_of::<ShmSlot>();
+        // SAFETY: offset is within the mapping; we are the only writer
+        let slot = unsafe { (self.base.as_ptr() as *mut u8).add(offset) as *mut ShmSlot };
+
+        // Seqlock write: odd sequence, payload, even sequence
+        let seq = unsafe { &(*slot).seq };
+        let s = seq.load(Ordering::Relaxed);
+        seq.store(s + 1, Ordering::Relaxed);
+        fence(Ordering::Release);
+        // SAFETY: see above; readers discard torn copies
+        unsafe { std::ptr::addr_of_mut!((*slot).frame).write_volatile(*frame) };
+        seq.store(s + 2, Ordering::Release);
+        header.generation.store(generation + 1, Ordering::Release);
+    }
+}
+
+impl Drop for ShmTelemetryWriter {
+    fn drop(&mut self) {
+        // Tell attached readers to drop the mapping and re-open later
+        self.header().magic.store(0, Ordering::Release);
+        // SAFETY: base/len came from our own successful mmap
+        let _ = unsafe { munmap(self.base, self.len) };
+        let _ = shm_unlink(self.name.as_str());
+    }
+}
@@ -0,0 +1,161 @@
+//! Unit tests for the shared-memory telemetry reader
+
+use crate::frame::{TelemetryFrame, FRAME_VERSION};
+use crate::shm::{ShmTelemetryReader, ShmTelemetryWriter, SHM_MAGIC};
+use nix::fcntl::OFlag;
+use nix::sys::mman::{mmap, munmap, shm_open, shm_unlink, MapFlags, ProtFlags};
+use nix::sys::stat::Mode;
+use nix::unistd::ftruncate;
+use std::ffi::c_void;
+use std::num::NonZeroUsize;
+use std::ptr::NonNull;
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const HEADER_SIZE: usize = 64;
+    const SLOT_SIZE: usize = 320;
+    const SLOTS: usize = 4;
+    const SEGMENT_SIZE: usize = HEADER_SIZE + SLOTS * SLOT_SIZE;
+
+    /// Minimal Rust stand-in for the plugin's `StratusShm_*` writer
+    struct TestWriter {
+        name: String,
+        base: NonNull<c_void>,
+    }
+
+    impl TestWriter {
+        fn create(tag: &str) -> Self {
+            let name = format!("/stratus_test_{}_{}", tag, std::process::id());
+            let _ = shm_unlink(name.as_str());
+            let fd = shm_open(
+                name.as_str(),
+                OFlag::O_CREAT | OFlag::O_RDWR,
+                Mode::from_bits_truncate(0o600),
+            )
+            .unwrap();
+            ftruncate(&fd, SEGMENT_SIZE as i64).unwrap();
+            let base = unsafe {
+                mmap(
+                    None,
+                    NonZeroUsize::new(SEGMENT_SIZE).unwrap(),
+                    ProtFlags::PROT_READ | ProtFlags::PROT_WRITE,
+                    MapFlags::MAP_SHARED,
+                    &fd,
+                    0,
+                )
+            }
+            .unwrap();
+
+            let writer = Self { name, base };
+            unsafe {
+                let p = writer.base.as_ptr() as *mut u8;
+                (p.add(4) as *mut u16).write(FRAME_VERSION);
+                (p.add(6) as *mut u16).write(SLOTS as u16);
+                (p.add(8) as *mut u32).write(SLOT_SIZE as u32);
+                (p.add(12) as *mut u32).write(std::mem::size_of::<TelemetryFrame>() as u32);
+            }
+            writer.magic().store(SHM_MAGIC, Ordering::Release);
+            writer
+        }
+
+        fn magic(&self) -> &AtomicU32 {
+            unsafe { &*(self.base.as_ptr() as *const AtomicU32) }
+        }
+
+        fn generation(&self) -> &AtomicU64 {
+            unsafe { &*((self.base.as_ptr() as *const u8).add(16) as *const AtomicU64) }
+        }
+
+        fn publish(&self, frame: &TelemetryFrame) {
+            let gen = self.generation().load(Ordering::Relaxed);
+            let slot = unsafe {
+                (self.base.as_ptr() as *mut u8)
+                    .add(HEADER_SIZE + (gen as usize % SLOTS) * SLOT_SIZE)
+            };
+            let seq = unsafe { &*(slot as *const AtomicU32) };
+            let s = seq.load(Ordering::Relaxed);
+            seq.store(s + 1, Ordering::Release);
+            unsafe { (slot.add(8) as *mut TelemetryFrame).write(*frame) };
+            seq.store(s + 2, Ordering::Release);
+            self.generation().store(gen + 1, Ordering::Release);
+        }
+    }
+
+    impl Drop for TestWriter {
+        fn drop(&mut self) {
+            let _ = unsafe { munmap(self.base, SEGMENT_SIZE) };
+            let _ = shm_unlink(self.name.as_str());
+        }
+    }
+
+    fn frame(lat: f64, squawk: i32) -> TelemetryFrame {
+        let mut f: TelemetryFrame = unsafe { std::mem::zeroed() };
+        f.latitude = lat;
+        f.xpdr_code = squawk;
+        f.on_ground = 1;
+        f.aircraft[..10].copy_from_slice(b"Cessna.acf");
+        f
+    }
+
+    #[test]
+    fn test_empty_ring_has_no_frame() {
+        let writer = TestWriter::create("empty");
+        let reader = ShmTelemetryReader::open_named(&writer.name).unwrap();
+        assert!(reader.is_alive());
+        assert!(reader.read_frame().is_none());
+    }
+
+    #[test]
+    fn test_reads_newest_frame() {
+        let writer = TestWriter::create("newest");
+        let reader = ShmTelemetryReader::open_named(&writer.name).unwrap();
+
+        // Wrap the ring more than once
+        for i in 0..10 {
+            writer.publish(&frame(47.0 + i as f64, 1200 + i));
+        }
+
+        let (generation, latest) = reader.read_frame().unwrap();
+        assert_eq!(generation, 10);
+        assert_eq!(latest.xpdr_code, 1209);
+
+        let telemetry = reader.read_telemetry().unwrap();
+        assert_eq!(telemetry.position.latitude, 56.0);
+        assert_eq!(telemetry.aircraft, "Cessna.acf");
+        assert!(telemetry.state.on_ground);
+    }
+
+    #[test]
+    fn test_rejects_closed_segment() {
+        let writer = TestWriter::create("closed");
+        let reader = ShmTelemetryReader::open_named(&writer.name).unwrap();
+
+        writer.magic().store(0, Ordering::Release);
+        assert!(!reader.is_alive());
+        assert!(ShmTelemetryReader::open_named(&writer.name).is_err());
+    }
+
+    #[test]
+    fn test_rust_writer_round_trip() {
+        let name = format!("/stratus_test_writer_{}", std::process::id());
+        let mut writer = ShmTelemetryWriter::create_named(&name).unwrap();
+        let reader = ShmTelemetryReader::open_named(&name).unwrap();
+        assert!(reader.read_frame().is_none());
+
+        for i in 0..10 {
+            writer.publish(&frame(47.0 + i as f64, 1200 + i));
+        }
+        let (generation, latest) = reader.read_frame().unwrap();
+        assert_eq!(generation, 10);
+        assert_eq!(latest.xpdr_code, 1209);
+        assert_eq!(latest.latitude, 56.0);
+
+        // Dropping the writer closes and unlinks the segment
+        drop(writer);
+        assert!(!reader.is_alive());
+        assert!(ShmTelemetryReader::open_named(&name).is_err());
+    }
+}
@@ -1,14 +1,35 @@
 //! Telemetry - File-based communication with X-Plane
 //!
 //! Watches `~/.local/share/StratusATC/stratus_telemetry.json` for telemetry updates
-//! and writes commands to `stratus_commands.jsonl`.
+//! and writes commands to `stratus_commands.jsonl`. When the plugin publishes the
+//! shared-memory frame ring (see `shm.rs`), frames are read from there instead,
+//! and when it writes the packed binary format (`stratus_telemetry.bin`, see
+//! `frame.rs`) that file is preferred over the JSON one. Delta-published JSON
+//! (see `delta.rs`) is reassembled transparently. When the sim runs on another
+//! machine, `STRATUS_TELEMETRY_UDP=<addr>:<port>` makes the plugin's UDP
+//! stream (see `udp.rs`) the only source instead.
 
+use crate::context::{ContextTracker, SimContext, CONTEXT_FILE};
+use crate::delta::TelemetryStream;
+use crate::frame::TelemetryFrame;
+use crate::shm::ShmTelemetryReader;
+use crate::traffic::{TrafficSnapshot, TrafficTracker, TRAFFIC_FILE};
+use crate::udp::{UdpTelemetryReceiver, UDP_BIND_ENV};
 use notify::{Event, RecommendedWatcher, RecursiveMode, Watcher};
 use serde::{Deserialize, Serialize};
-use std::path::PathBuf;
+use std::cell::{Cell, RefCell, RefMut};
+use std::path::{Path, PathBuf};
 use std::sync::mpsc;
+use std::time::{Duration, Instant, SystemTime};
 use thiserror::Error;
 
+/// How often to retry attaching to the shared-memory ring when it is absent
+const SHM_RETRY_INTERVAL: Duration = Duration::from_secs(1);
+
+/// Telemetry files written by the plugin, by output format
+pub const JSON_FILE: &str = "stratus_telemetry.json";
+pub const BINARY_FILE: &str = "stratus_telemetry.bin";
+
 #[derive(Error, Debug)]
 pub enum TelemetryError {
     #[error("Failed to read telemetry file: {0}")]
@@ -17,12 +38,39 @@ pub enum TelemetryError {
     ParseError(#[from] serde_json::Error),
     #[error("File watcher error: {0}")]
     WatchError(#[from] notify::Error),
+    #[error("Shared-memory telemetry unavailable: {0}")]
+    ShmError(String),
+    #[error("Invalid binary telemetry frame: {0}")]
+    FrameError(String),
+    #[error("Invalid flight recording: {0}")]
+    RecordingError(String),
+    #[error("UDP telemetry unavailable: {0}")]
+    UdpError(String),
 }
 
 /// Aircraft telemetry from X-Plane
 #[derive(Debug, Clone, Serialize, Deserialize, Default)]
 pub struct Telemetry {
     pub timestamp: i64,
+    /// Capture sequence number, 1 for the first frame after the plugin
+    /// starts; a gap means frames were dropped or skipped
+    #[serde(default)]
+    pub frame_seq: u64,
+    /// Plugin monotonic clock at capture, nanoseconds (unrelated to
+    /// `timestamp`; only differences between frames are meaningful)
+    #[serde(default)]
+    pub monotonic_ns: u64,
+    /// Sim clock at capture (`sim/time/total_flight_time_sec`), seconds
+    #[serde(default)]
+    pub sim_time_s: f64,
+    /// Event frames since the plugin started (frame v5); a jump means an
+    /// event record was missed
+    #[serde(default)]
+    pub event_seq: u32,
+    /// Transitions this record was published for, e.g. `"touchdown"`
+    /// (`frame::EVENT_NAMES`); empty for ordinary frames
+    #[serde(default, skip_serializing_if = "Vec::is_empty")]
+    pub events: Vec<String>,
     pub simulator: String,
     pub aircraft: String,
     pub position: Position,
@@ -30,7 +78,14 @@ pub struct Telemetry {
     pub speed: Speed,
     pub radios: Radios,
     pub transponder: Transponder,
+    #[serde(default)]
+    pub autopilot: Autopilot,
     pub state: FlightState,
+    #[serde(default)]
+    pub engines: Engines,
+    /// Computed by the plugin from the fields above (frame v4)
+    #[serde(default)]
+    pub derived: Derived,
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize, Default)]
@@ -73,22 +128,138 @@ pub struct Transponder {
     pub mode: i32,
 }
 
+#[derive(Debug, Clone, Serialize, Deserialize, Default)]
+pub struct Autopilot {
+    pub altitude_ft: f32,
+    pub heading: f32,
+    pub vs_fpm: f32,
+}
+
+#[derive(Debug, Clone, Serialize, Deserialize, Default)]
+pub struct Engines {
+    pub count: i32,
+    /// Running flag (0/1) per engine slot; only the first `count` are real
+    pub running: Vec<i32>,
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize, Default)]
 pub struct FlightState {
     pub on_ground: bool,
     pub paused: bool,
 }
 
+/// State the plugin derives from the raw fields (`stratus_derived.h`)
+#[derive(Debug, Clone, Serialize, Deserialize, Default)]
+#[serde(default)]
+pub struct Derived {
+    /// `FlightPhase` discriminant; see `phase()`
+    pub phase: i32,
+    pub ground_speed_kts: f32,
+    pub tas_kts: f32,
+    pub altitude_msl_ft: f32,
+    pub altitude_agl_ft: f32,
+    /// Nearest airport within the plugin's search radius, "" if none
+    pub airport: String,
+    pub airport_dist_nm: f32,
+    /// True bearing from the aircraft
+    pub airport_bearing_deg: f32,
+    pub airport_elevation_ft: f32,
+    /// The airport's nearest runway, named by the end the aircraft heads for
+    pub runway: String,
+    /// Distance from that runway's centerline
+    pub runway_dist_ft: f32,
+    pub runway_length_ft: i32,
+    pub on_runway: bool,
+}
+
+impl Derived {
+    pub fn phase(&self) -> FlightPhase {
+        FlightPhase::from_i32(self.phase)
+    }
+}
+
+/// Flight phase as the plugin publishes it (`StratusPhase`)
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum FlightPhase {
+    #[default]
+    Unknown,
+    Parked,
+    TaxiOut,
+    Takeoff,
+    Departure,
+    Cruise,
+    Descent,
+    Approach,
+    Landing,
+    TaxiIn,
+}
+
+impl FlightPhase {
+    pub fn from_i32(value: i32) -> Self {
+        match value {
+            1 => Self::Parked,
+            2 => Self::TaxiOut,
+            3 => Self::Takeoff,
+            4 => Self::Departure,
+            5 => Self::Cruise,
+            6 => Self::Descent,
+            7 => Self::Approach,
+            8 => Self::Landing,
+            9 => Self::TaxiIn,
+            _ => Self::Unknown,
+        }
+    }
+
+    /// Same names as the plugin log ("TAXI_OUT", ...)
+    pub fn as_str(self) -> &'static str {
+        match self {
+            Self::Unknown => "UNKNOWN",
+            Self::Parked => "PARKED",
+            Self::TaxiOut => "TAXI_OUT",
+            Self::Takeoff => "TAKEOFF",
+            Self::Departure => "DEPARTURE",
+            Self::Cruise => "CRUISE",
+            Self::Descent => "DESCENT",
+            Self::Approach => "APPROACH",
+            Self::Landing => "LANDING",
+            Self::TaxiIn => "TAXI_IN",
+        }
+    }
+}
+
 /// Watches the Telemetry input file for changes
 pub struct TelemetryWatcher {
     data_dir: PathBuf,
     _watcher: RecommendedWatcher,
     receiver: mpsc::Receiver<Result<Event, notify::Error>>,
+    shm: RefCell<Option<ShmTelemetryReader>>,
+    shm_last_attempt: Cell<Option<Instant>>,
+    shm_last_generation: Cell<u64>,
+    json_stream: RefCell<TelemetryStream>,
+    context: RefCell<ContextTracker>,
+    traffic: RefCell<TrafficTracker>,
+    udp: Option<RefCell<UdpTelemetryReceiver>>,
 }
 
 impl TelemetryWatcher {
-    /// Create a new watcher for the Telemetry directory
+    /// Create a new watcher for the Telemetry directory, or for the UDP
+    /// stream if `STRATUS_TELEMETRY_UDP` names an address to listen on
     pub fn new() -> Result<Self, TelemetryError> {
+        match std::env::var(UDP_BIND_ENV) {
+            Ok(addr) if !addr.is_empty() => Self::with_udp(&addr),
+            _ => Self::watch(None),
+        }
+    }
+
+    /// Receive telemetry only from the plugin's UDP stream, listening on
+    /// `bind` (e.g. `"0.0.0.0:49300"`)
+    pub fn with_udp(bind: &str) -> Result<Self, TelemetryError> {
+        let receiver = UdpTelemetryReceiver::bind(bind)
+            .map_err(|e| TelemetryError::UdpError(format!("{}: {}", bind, e)))?;
+        Self::watch(Some(receiver))
+    }
+
+    fn watch(udp: Option<UdpTelemetryReceiver>) -> Result<Self, TelemetryError> {
         let data_dir = Self::get_data_dir();
 
         // Create directory if it doesn't exist
@@ -109,11 +280,18 @@ impl TelemetryWatcher {
             data_dir,
             _watcher: watcher,
             receiver: rx,
+            shm: RefCell::new(None),
+            shm_last_attempt: Cell::new(None),
+            shm_last_generation: Cell::new(0),
+            json_stream: RefCell::new(TelemetryStream::new()),
+            context: RefCell::new(ContextTracker::new()),
+            traffic: RefCell::new(TrafficTracker::new()),
+            udp: udp.map(RefCell::new),
         })
     }
 
-    /// Get the platform-specific data directory
-    fn get_data_dir() -> PathBuf {
+    /// Get the platform-specific data directory (where the plugin writes)
+    pub fn get_data_dir() -> PathBuf {
         #[cfg(target_os = "linux")]
         {
             dirs::data_local_dir()
@@ -134,16 +312,107 @@ impl TelemetryWatcher {
         }
     }
 
-    /// Read the current telemetry from the input file
+    /// Read the current telemetry, from shared memory if the plugin publishes
+    /// it, otherwise from the input file
     pub fn read_telemetry(&self) -> Result<Telemetry, TelemetryError> {
-        let path = self.data_dir.join("stratus_telemetry.json");
-        let content = std::fs::read_to_string(&path)?;
-        let telemetry: Telemetry = serde_json::from_str(&content)?;
-        Ok(telemetry)
+        if let Some(udp) = &self.udp {
+            let mut udp = udp.borrow_mut();
+            udp.poll();
+            return udp
+                .latest()
+                .map(|f| Telemetry::from(&f.frame))
+                .ok_or_else(|| TelemetryError::UdpError("no frame received yet".to_string()));
+        }
+
+        if self.attach_shm() {
+            if let Some(telemetry) = self.shm.borrow().as_ref().and_then(|r| r.read_telemetry()) {
+                return Ok(telemetry);
+            }
+        }
+
+        // Prefer whichever format the plugin wrote most recently
+        let json_path = self.data_dir.join(JSON_FILE);
+        let binary_path = self.data_dir.join(BINARY_FILE);
+        if let Some(binary_mtime) = modified(&binary_path) {
+            if modified(&json_path).is_none_or(|json_mtime| binary_mtime >= json_mtime) {
+                return read_binary_telemetry(&binary_path);
+            }
+        }
+
+        let content = std::fs::read_to_string(&json_path)?;
+        let mut stream = self.json_stream.borrow_mut();
+        Ok(stream.apply_json(&content)?.clone())
+    }
+
+    /// Return the aircraft/location context if the plugin published a new one
+    /// since the last call (non-blocking)
+    pub fn poll_context(&self) -> Option<SimContext> {
+        self.context
+            .borrow_mut()
+            .poll(&self.data_dir.join(CONTEXT_FILE))
+    }
+
+    /// Return the other aircraft if the plugin published a new snapshot
+    /// since the last call (non-blocking); index it with `TrafficIndex`
+    pub fn poll_traffic(&self) -> Option<TrafficSnapshot> {
+        self.traffic
+            .borrow_mut()
+            .poll(&self.data_dir.join(TRAFFIC_FILE))
+    }
+
+    /// The UDP receiver, when telemetry comes over the network; use it to
+    /// send commands back and to read its loss counters
+    pub fn udp(&self) -> Option<RefMut<'_, UdpTelemetryReceiver>> {
+        self.udp.as_ref().map(RefCell::borrow_mut)
+    }
+
+    /// True if frames are coming from the shared-memory ring
+    pub fn is_shm(&self) -> bool {
+        self.shm.borrow().is_some()
     }
 
-    /// Check for file changes (non-blocking)
+    /// Make sure we hold a live shared-memory mapping, re-attaching at most
+    /// once per `SHM_RETRY_INTERVAL`. Returns true if one is attached.
+    fn attach_shm(&self) -> bool {
+        let mut shm = self.shm.borrow_mut();
+        if shm.as_ref().is_some_and(|r| !r.is_alive()) {
+            *shm = None;
+        }
+        if shm.is_none() {
+            let due = self
+                .shm_last_attempt
+                .get()
+                .is_none_or(|t| t.elapsed() >= SHM_RETRY_INTERVAL);
+            if !due {
+                return false;
+            }
+            self.shm_last_attempt.set(Some(Instant::now()));
+            *shm = ShmTelemetryReader::open().ok();
+            self.shm_last_generation.set(0);
+        }
+        shm.is_some()
+    }
+
+    /// Check for new telemetry (non-blocking)
     pub fn poll(&self) -> Option<Result<Telemetry, TelemetryError>> {
+        if let Some(udp) = &self.udp {
+            while self.receiver.try_recv().is_ok() {}
+            let frame = udp.borrow_mut().poll()?;
+            return Some(Ok(Telemetry::from(&frame.frame)));
+        }
+
+        if self.attach_shm() {
+            // File events are redundant while the ring is live
+            while self.receiver.try_recv().is_ok() {}
+
+            let (generation, frame) = self.shm.borrow().as_ref()?.read_frame()?;
+            if generation == self.shm_last_generation.get() {
+                return None;
+            }
+            self.shm_last_generation.set(generation);
+            return Some(Ok(Telemetry::from(&frame)));
+        }
+
         match self.receiver.try_recv() {
             Ok(Ok(_event)) => Some(self.read_telemetry()),
             Ok(Err(e)) => Some(Err(TelemetryError::WatchError(e))),
@@ -152,6 +421,17 @@ impl TelemetryWatcher {
     }
 }
 
+fn modified(path: &Path) -> Option<SystemTime> {
+    std::fs::metadata(path).and_then(|m| m.modified()).ok()
+}
+
+/// Read a packed binary telemetry file (`stratus_telemetry.bin`)
+pub fn read_binary_telemetry(path: &Path) -> Result<Telemetry, TelemetryError> {
+    let bytes = std::fs::read(path)?;
+    let frame = TelemetryFrame::decode(&bytes)?;
+    Ok(Telemetry::from(&frame))
+}
+
 impl Default for TelemetryWatcher {
     fn default() -> Self {
         Self::new().expect("Failed to create Telemetry watcher")
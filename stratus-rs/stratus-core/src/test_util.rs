@@ -0,0 +1,16 @@
+//! Helpers shared by the unit tests
+
+use std::path::Path;
+use std::time::{Duration, SystemTime};
+
+/// Write `content` to `path` with an mtime `age_s` seconds in the past
+pub(crate) fn write(path: &Path, content: &str, age_s: u64) {
+    std::fs::write(path, content).unwrap();
+    let mtime = SystemTime::now() - Duration::from_secs(age_s);
+    std::fs::File::options()
+        .write(true)
+        .open(path)
+        .unwrap()
+        .set_modified(mtime)
+        .unwrap();
+}
@@ -0,0 +1,67 @@
+//! Tracker - Change detection for files the plugin rewrites in place
+//!
+//! The plugin overwrites `stratus_context.json` and `stratus_traffic.json`
+//! whole, each record carrying a `seq` that is bumped on every write and
+//! restarts at 1 with the plugin. `FileTracker` re-reads such a file only
+//! when its mtime moves and hands back a record only when it is a new one.
+
+use crate::telemetry::TelemetryError;
+use serde::de::DeserializeOwned;
+use std::marker::PhantomData;
+use std::path::Path;
+use std::time::SystemTime;
+
+/// A record the plugin numbers as it writes it
+pub trait Sequenced: DeserializeOwned {
+    /// The record's `seq` and `timestamp`
+    fn sequence(&self) -> (u64, i64);
+}
+
+/// Remembers the last record seen so callers only act on changes
+#[derive(Debug)]
+pub struct FileTracker<T> {
+    last_modified: Option<SystemTime>,
+    last: Option<(u64, i64)>,
+    _record: PhantomData<fn() -> T>,
+}
+
+impl<T> Default for FileTracker<T> {
+    fn default() -> Self {
+        Self {
+            last_modified: None,
+            last: None,
+            _record: PhantomData,
+        }
+    }
+}
+
+impl<T: Sequenced> FileTracker<T> {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Return the record at `path` if it changed since the previous call.
+    /// The file is only re-read when its mtime moves.
+    pub fn poll(&mut self, path: &Path) -> Option<T> {
+        let modified = std::fs::metadata(path).and_then(|m| m.modified()).ok()?;
+        if self.last_modified == Some(modified) {
+            return None;
+        }
+        let record: T = read_json(path).ok()?;
+        self.last_modified = Some(modified);
+
+        // A restarted plugin counts from 1 again, so compare the timestamp too
+        let key = record.sequence();
+        if self.last == Some(key) {
+            return None;
+        }
+        self.last = Some(key);
+        Some(record)
+    }
+}
+
+/// Read and parse one of the plugin's JSON files
+pub(crate) fn read_json<T: DeserializeOwned>(path: &Path) -> Result<T, TelemetryError> {
+    let content = std::fs::read_to_string(path)?;
+    Ok(serde_json::from_str(&content)?)
+}
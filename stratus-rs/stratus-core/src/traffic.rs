@@ -0,0 +1,367 @@
+//! Traffic - Other aircraft reported by the X-Plane plugin
+//!
+//! The plugin writes `stratus_traffic.json` at `traffic_rate_hz` (1 Hz by
+//! default) with every AI, multiplayer or plugin-injected aircraft it can see.
+//! `TrafficIndex` buckets a snapshot into a latitude/longitude grid so the
+//! questions ATC asks on every transmission ("traffic within 10 nm", "who is
+//! on final") only look at the few cells around the point of interest.
+//!
+//! Grid rows are `CELL_NM` tall. Each row is split into as many columns as
+//! fit `CELL_NM` wide at that row's latitude, so cells stay roughly square
+//! from the equator to the poles, and column indices wrap at the antimeridian.
+
+use crate::extrapolate::signed_difference;
+use crate::telemetry::TelemetryError;
+use crate::tracker::{read_json, FileTracker, Sequenced};
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::path::Path;
+
+/// Traffic file name inside the telemetry directory
+pub const TRAFFIC_FILE: &str = "stratus_traffic.json";
+
+/// Grid cell size, nautical miles. Around the radius of a typical query, so
+/// a 10 nm lookup touches a 3x3 block.
+pub const CELL_NM: f64 = 10.0;
+
+const CELL_DEG: f64 = CELL_NM / 60.0;
+const ROWS: i32 = (180.0 / CELL_DEG) as i32;
+/// Mean Earth radius, nautical miles
+const EARTH_RADIUS_NM: f64 = 3440.065;
+const METERS_TO_FEET: f64 = 3.28084;
+
+/// All traffic the plugin saw at one moment
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+#[serde(default)]
+pub struct TrafficSnapshot {
+    /// Bumped on every snapshot; restarts at 1 with the plugin
+    pub seq: u64,
+    pub timestamp: i64,
+    /// Same clock as `Telemetry::monotonic_ns`
+    pub monotonic_ns: u64,
+    /// "tcas" (X-Plane 12), "multiplayer" (X-Plane 11) or "none"
+    pub source: String,
+    pub targets: Vec<TrafficTarget>,
+}
+
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+#[serde(default)]
+pub struct TrafficTarget {
+    /// Slot in the plugin's source, stable while the aircraft stays loaded
+    pub id: u16,
+    /// 24-bit ICAO address, 0 if unknown
+    pub mode_s: u32,
+    /// Empty when the source does not provide one
+    pub callsign: String,
+    pub icao_type: String,
+    pub latitude: f64,
+    pub longitude: f64,
+    pub altitude_msl_m: f64,
+    pub heading_true: f32,
+    pub ground_speed_mps: f32,
+    pub vertical_speed_fpm: f32,
+    pub on_ground: bool,
+}
+
+/// Read and parse a traffic file
+pub fn read_traffic(path: &Path) -> Result<TrafficSnapshot, TelemetryError> {
+    read_json(path)
+}
+
+impl Sequenced for TrafficSnapshot {
+    fn sequence(&self) -> (u64, i64) {
+        (self.seq, self.timestamp)
+    }
+}
+
+/// Remembers the last snapshot seen so callers only act on new ones
+pub type TrafficTracker = FileTracker<TrafficSnapshot>;
+
+/// A target found by a range query
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct NearbyTraffic<'a> {
+    pub target: &'a TrafficTarget,
+    pub distance_nm: f64,
+    /// From the query point to the target, degrees true
+    pub bearing_deg: f64,
+}
+
+/// A final approach corridor, measured back from the runway threshold
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct FinalApproach {
+    pub threshold_lat: f64,
+    pub threshold_lon: f64,
+    pub threshold_elevation_m: f64,
+    /// Direction aircraft fly on final (the runway heading), degrees true
+    pub course_deg: f64,
+    /// How far out the corridor extends
+    pub length_nm: f64,
+    /// Distance either side of the extended centreline
+    pub half_width_nm: f64,
+    /// How far a target's heading may differ from the course
+    pub max_heading_error_deg: f64,
+    /// Highest a target may be above the threshold
+    pub max_height_ft: f64,
+}
+
+impl FinalApproach {
+    /// A 10 nm final, 1 nm either side, up to 4000 ft above the threshold
+    pub fn new(threshold_lat: f64, threshold_lon: f64, elevation_m: f64, course_deg: f64) -> Self {
+        Self {
+            threshold_lat,
+            threshold_lon,
+            threshold_elevation_m: elevation_m,
+            course_deg,
+            length_nm: 10.0,
+            half_width_nm: 1.0,
+            max_heading_error_deg: 30.0,
+            max_height_ft: 4000.0,
+        }
+    }
+}
+
+/// A target established on a final approach corridor
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct TrafficOnFinal<'a> {
+    pub target: &'a TrafficTarget,
+    /// Distance from the threshold along the extended centreline
+    pub distance_nm: f64,
+    /// Signed offset from the centreline, positive right of course
+    pub offset_nm: f64,
+    pub height_ft: f64,
+}
+
+/// Grid index over one traffic snapshot
+#[derive(Debug, Clone, Default)]
+pub struct TrafficIndex {
+    targets: Vec<TrafficTarget>,
+    cells: HashMap<(i32, i32), Vec<u32>>,
+}
+
+impl TrafficIndex {
+    pub fn new(targets: Vec<TrafficTarget>) -> Self {
+        let mut cells: HashMap<(i32, i32), Vec<u32>> = HashMap::with_capacity(targets.len());
+        for (i, t) in targets.iter().enumerate() {
+            cells
+                .entry(cell_of(t.latitude, t.longitude))
+                .or_default()
+                .push(i as u32);
+        }
+        Self { targets, cells }
+    }
+
+    pub fn from_snapshot(snapshot: &TrafficSnapshot) -> Self {
+        Self::new(snapshot.targets.clone())
+    }
+
+    pub fn len(&self) -> usize {
+        self.targets.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.targets.is_empty()
+    }
+
+    pub fn targets(&self) -> &[TrafficTarget] {
+        &self.targets
+    }
+
+    /// Targets within `radius_nm` of a point, nearest first
+    pub fn within(&self, lat: f64, lon: f64, radius_nm: f64) -> Vec<NearbyTraffic<'_>> {
+        let mut found = Vec::new();
+        self.for_each_candidate(lat, lon, radius_nm, |target| {
+            let distance_nm = distance_nm(lat, lon, target.latitude, target.longitude);
+            if distance_nm <= radius_nm {
+                found.push(NearbyTraffic {
+                    target,
+                    distance_nm,
+                    bearing_deg: bearing_deg(lat, lon, target.latitude, target.longitude),
+                });
+            }
+        });
+        found.sort_by(|a, b| a.distance_nm.total_cmp(&b.distance_nm));
+        found
+    }
+
+    /// Up to `count` closest targets within `max_radius_nm`, nearest first
+    pub fn nearest(
+        &self,
+        lat: f64,
+        lon: f64,
+        count: usize,
+        max_radius_nm: f64,
+    ) -> Vec<NearbyTraffic<'_>> {
+        let mut found = self.within(lat, lon, max_radius_nm);
+        found.truncate(count);
+        found
+    }
+
+    /// Airborne targets on the final approach corridor, closest to the
+    /// threshold first (the landing sequence)
+    pub fn on_final(&self, approach: &FinalApproach) -> Vec<TrafficOnFinal<'_>> {
+        // The corridor fits in a circle around its midpoint
+        let outbound = approach.course_deg + 180.0;
+        let half = approach.length_nm / 2.0;
+        let (mid_lat, mid_lon) = destination(
+            approach.threshold_lat,
+            approach.threshold_lon,
+            outbound,
+            half,
+        );
+        let radius = half.hypot(approach.half_width_nm);
+
+        let mut found = Vec::new();
+        self.for_each_candidate(mid_lat, mid_lon, radius, |target| {
+            if target.on_ground {
+                return;
+            }
+            let heading_error = signed_difference(approach.course_deg, target.heading_true as f64);
+            if heading_error.abs() > approach.max_heading_error_deg {
+                return;
+            }
+            let height_ft =
+                (target.altitude_msl_m - approach.threshold_elevation_m) * METERS_TO_FEET;
+            if height_ft > approach.max_height_ft {
+                return;
+            }
+
+            // Along- and cross-track from the threshold, back along final
+            let d = distance_nm(
+                approach.threshold_lat,
+                approach.threshold_lon,
+                target.latitude,
+                target.longitude,
+            );
+            let b = bearing_deg(
+                approach.threshold_lat,
+                approach.threshold_lon,
+                target.latitude,
+                target.longitude,
+            );
+            let angle = signed_difference(outbound, b).to_radians();
+            let along = d * angle.cos();
+            // Left of the outbound line is right of the inbound course
+            let offset = -d * angle.sin();
+            if along < 0.0 || along > approach.length_nm || offset.abs() > approach.half_width_nm {
+                return;
+            }
+            found.push(TrafficOnFinal {
+                target,
+                distance_nm: along,
+                offset_nm: offset,
+                height_ft,
+            });
+        });
+        found.sort_by(|a, b| a.distance_nm.total_cmp(&b.distance_nm));
+        found
+    }
+
+    /// Call `f` for every target in a cell that overlaps the circle
+    fn for_each_candidate<'a>(
+        &'a self,
+        lat: f64,
+        lon: f64,
+        radius_nm: f64,
+        mut f: impl FnMut(&'a TrafficTarget),
+    ) {
+        if self.targets.is_empty() {
+            return;
+        }
+        let radius_deg = radius_nm / 60.0;
+        let row_lo = row_of(lat - radius_deg);
+        let row_hi = row_of(lat + radius_deg);
+        for row in row_lo..=row_hi {
+            let cols = columns_in_row(row);
+            let (lo, hi) = row_bounds(row);
+            // Longitude span of the circle at the row edge nearest the pole
+            // (or across the whole row once the pole is within reach)
+            let edge = (lat.clamp(lo, hi).abs() + radius_deg).min(90.0);
+            let col_span = if edge >= 89.0 {
+                cols
+            } else {
+                let lon_deg = radius_deg / edge.to_radians().cos();
+                (lon_deg / 360.0 * cols as f64).ceil() as i32 + 1
+            };
+            if 2 * col_span + 1 >= cols {
+                for col in 0..cols {
+                    self.visit(row, col, &mut f);
+                }
+            } else {
+                let center = column_of(lon, cols);
+                for d in -col_span..=col_span {
+                    self.visit(row, (center + d).rem_euclid(cols), &mut f);
+                }
+            }
+        }
+    }
+
+    fn visit<'a>(&'a self, row: i32, col: i32, f: &mut impl FnMut(&'a TrafficTarget)) {
+        if let Some(ids) = self.cells.get(&(row, col)) {
+            for &i in ids {
+                f(&self.targets[i as usize]);
+            }
+        }
+    }
+}
+
+fn row_of(lat: f64) -> i32 {
+    (((lat + 90.0) / CELL_DEG).floor() as i32).clamp(0, ROWS - 1)
+}
+
+fn row_bounds(row: i32) -> (f64, f64) {
+    let lo = row as f64 * CELL_DEG - 90.0;
+    (lo, lo + CELL_DEG)
+}
+
+/// Columns in a row: as many `CELL_NM`-wide cells as fit at its
+/// equator-side edge, so no cell is narrower than `CELL_NM`
+fn columns_in_row(row: i32) -> i32 {
+    let (lo, hi) = row_bounds(row);
+    let lat = if lo <= 0.0 && hi >= 0.0 {
+        0.0
+    } else {
+        lo.abs().min(hi.abs())
+    };
+    ((360.0 * lat.to_radians().cos() / CELL_DEG).floor() as i32).max(1)
+}
+
+fn column_of(lon: f64, cols: i32) -> i32 {
+    let x = (lon + 180.0).rem_euclid(360.0) / 360.0;
+    ((x * cols as f64).floor() as i32).min(cols - 1)
+}
+
+fn cell_of(lat: f64, lon: f64) -> (i32, i32) {
+    let row = row_of(lat);
+    (row, column_of(lon, columns_in_row(row)))
+}
+
+/// Great-circle distance, nautical miles
+pub fn distance_nm(lat1: f64, lon1: f64, lat2: f64, lon2: f64) -> f64 {
+    let (p1, p2) = (lat1.to_radians(), lat2.to_radians());
+    let dp = p2 - p1;
+    let dl = (lon2 - lon1).to_radians();
+    let a = (dp / 2.0).sin().powi(2) + p1.cos() * p2.cos() * (dl / 2.0).sin().powi(2);
+    2.0 * EARTH_RADIUS_NM * a.sqrt().min(1.0).asin()
+}
+
+/// Initial great-circle bearing from point 1 to point 2, degrees true
+pub fn bearing_deg(lat1: f64, lon1: f64, lat2: f64, lon2: f64) -> f64 {
+    let (p1, p2) = (lat1.to_radians(), lat2.to_radians());
+    let dl = (lon2 - lon1).to_radians();
+    let y = dl.sin() * p2.cos();
+    let x = p1.cos() * p2.sin() - p1.sin() * p2.cos() * dl.cos();
+    y.atan2(x).to_degrees().rem_euclid(360.0)
+}
+
+/// The point `distance` nm from a start along `bearing` degrees true
+fn destination(lat: f64, lon: f64, bearing: f64, distance: f64) -> (f64, f64) {
+    let (p1, l1) = (lat.to_radians(), lon.to_radians());
+    let d = distance / EARTH_RADIUS_NM;
+    let b = bearing.to_radians();
+    let p2 = (p1.sin() * d.cos() + p1.cos() * d.sin() * b.cos()).asin();
+    let l2 = l1 + (b.sin() * d.sin() * p1.cos()).atan2(d.cos() - p1.sin() * p2.sin());
+    (
+        p2.to_degrees(),
+        (l2.to_degrees() + 180.0).rem_euclid(360.0) - 180.0,
+    )
+}
@@ -0,0 +1,199 @@
+//! Unit tests for the traffic snapshot and spatial index
+
+use crate::traffic::{
+    distance_nm, read_traffic, FinalApproach, TrafficIndex, TrafficTarget, TrafficTracker,
+};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::test_util::write;
+
+    const SNAPSHOT: &str = r#"{
+  "seq": 4,
+  "timestamp": 1700000000,
+  "monotonic_ns": 123456789,
+  "source": "tcas",
+  "targets": [
+    {"id": 1, "mode_s": 11160567, "callsign": "UAL123", "icao_type": "B738", "latitude": 47.500000, "longitude": -122.300000, "altitude_msl_m": 900.0, "heading_true": 10.0, "ground_speed_mps": 70.7, "vertical_speed_fpm": -591, "on_ground": false},
+    {"id": 2, "mode_s": 0, "callsign": "", "icao_type": "", "latitude": 47.450000, "longitude": -122.310000, "altitude_msl_m": 130.0, "heading_true": 160.0, "ground_speed_mps": 0.0, "vertical_speed_fpm": 0, "on_ground": true}
+  ]
+}
+"#;
+
+    fn target(id: u16, latitude: f64, longitude: f64) -> TrafficTarget {
+        TrafficTarget {
+            id,
+            latitude,
+            longitude,
+            altitude_msl_m: 1000.0,
+            ..Default::default()
+        }
+    }
+
+    /// Deterministic pseudo-random numbers in [0, 1)
+    struct Lcg(u64);
+
+    impl Lcg {
+        fn next(&mut self) -> f64 {
+            self.0 = self
+                .0
+                .wrapping_mul(6364136223846793005)
+                .wrapping_add(1442695040888963407);
+            (self.0 >> 11) as f64 / (1u64 << 53) as f64
+        }
+    }
+
+    #[test]
+    fn test_read_traffic() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("stratus_traffic.json");
+        write(&path, SNAPSHOT, 0);
+
+        let snapshot = read_traffic(&path).unwrap();
+        assert_eq!(snapshot.seq, 4);
+        assert_eq!(snapshot.source, "tcas");
+        assert_eq!(snapshot.targets.len(), 2);
+        assert_eq!(snapshot.targets[0].callsign, "UAL123");
+        assert_eq!(snapshot.targets[0].mode_s, 11160567);
+        assert!(snapshot.targets[1].on_ground);
+    }
+
+    #[test]
+    fn test_tracker_reports_changes_only() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("stratus_traffic.json");
+        let mut tracker = TrafficTracker::new();
+        assert!(tracker.poll(&path).is_none());
+
+        write(&path, SNAPSHOT, 20);
+        assert_eq!(tracker.poll(&path).unwrap().seq, 4);
+        assert!(tracker.poll(&path).is_none());
+
+        write(&path, SNAPSHOT, 10);
+        assert!(tracker.poll(&path).is_none());
+
+        let next = SNAPSHOT.replace("\"seq\": 4", "\"seq\": 5");
+        write(&path, &next, 0);
+        assert_eq!(tracker.poll(&path).unwrap().seq, 5);
+    }
+
+    #[test]
+    fn test_within_matches_brute_force() {
+        // Clusters at mid latitude, high latitude, and across the antimeridian
+        let centers = [(47.45, -122.3), (78.2, 15.5), (-17.7, 179.9), (0.0, 0.0)];
+        let mut rng = Lcg(7);
+        let mut targets = Vec::new();
+        for (i, &(lat, lon)) in centers.iter().enumerate() {
+            for j in 0..150 {
+                let lon = lon + (rng.next() - 0.5) * 3.0;
+                targets.push(target(
+                    (i * 150 + j) as u16,
+                    lat + (rng.next() - 0.5) * 1.0,
+                    (lon + 180.0).rem_euclid(360.0) - 180.0,
+                ));
+            }
+        }
+        let index = TrafficIndex::new(targets.clone());
+        assert_eq!(index.len(), 600);
+
+        for &(lat, lon) in &centers {
+            for radius in [2.0, 10.0, 25.0, 60.0] {
+                let found = index.within(lat, lon, radius);
+                let mut ids: Vec<u16> = found.iter().map(|n| n.target.id).collect();
+                ids.sort_unstable();
+                let mut expected: Vec<u16> = targets
+                    .iter()
+                    .filter(|t| distance_nm(lat, lon, t.latitude, t.longitude) <= radius)
+                    .map(|t| t.id)
+                    .collect();
+                expected.sort_unstable();
+                assert_eq!(ids, expected, "within {} nm of {},{}", radius, lat, lon);
+                assert!(found
+                    .windows(2)
+                    .all(|w| w[0].distance_nm <= w[1].distance_nm));
+            }
+        }
+    }
+
+    #[test]
+    fn test_within_across_antimeridian() {
+        let index = TrafficIndex::new(vec![
+            target(1, -17.7, 179.95),
+            target(2, -17.7, -179.95),
+            target(3, -17.7, 178.0),
+        ]);
+        let found = index.within(-17.7, 179.99, 10.0);
+        let ids: Vec<u16> = found.iter().map(|n| n.target.id).collect();
+        assert_eq!(ids, vec![1, 2]);
+        // Target 2 is east of the query point, across the date line
+        assert!((found[1].bearing_deg - 90.0).abs() < 1.0);
+    }
+
+    #[test]
+    fn test_nearest_is_limited_and_ordered() {
+        let index = TrafficIndex::new(vec![
+            target(1, 47.60, -122.3),
+            target(2, 47.51, -122.3),
+            target(3, 47.55, -122.3),
+            target(4, 49.00, -122.3),
+        ]);
+        let ids: Vec<u16> = index
+            .nearest(47.5, -122.3, 2, 20.0)
+            .iter()
+            .map(|n| n.target.id)
+            .collect();
+        assert_eq!(ids, vec![2, 3]);
+        assert_eq!(index.nearest(47.5, -122.3, 10, 20.0).len(), 3);
+    }
+
+    #[test]
+    fn test_on_final_sequences_established_traffic() {
+        // Runway 34 at about KSEA: final lies to the south of the threshold
+        let (lat, lon) = (47.4638, -122.3079);
+        let approach = FinalApproach::new(lat, lon, 130.0, 340.0);
+        let south = |nm: f64| lat - nm / 60.0 * 340f64.to_radians().cos();
+        let east = |nm: f64| lon - nm / 60.0 * 340f64.to_radians().sin() / lat.to_radians().cos();
+
+        let on_final = |id, nm: f64, heading| TrafficTarget {
+            heading_true: heading,
+            altitude_msl_m: 130.0 + nm * 300.0 / 3.28084,
+            ..target(id, south(nm), east(nm))
+        };
+        let mut targets = vec![
+            on_final(1, 6.0, 338.0),
+            on_final(2, 2.5, 342.0),
+            // Opposite direction on the same line
+            on_final(3, 4.0, 160.0),
+            // Beyond the corridor
+            on_final(4, 14.0, 340.0),
+        ];
+        // Gear on the runway at the threshold
+        targets.push(TrafficTarget {
+            on_ground: true,
+            ..on_final(5, 0.1, 340.0)
+        });
+        // Abeam final, 3 nm to the side
+        let mut abeam = on_final(6, 4.0, 340.0);
+        abeam.longitude += 3.0 / 60.0 / lat.to_radians().cos();
+        targets.push(abeam);
+
+        let index = TrafficIndex::new(targets);
+        let sequence = index.on_final(&approach);
+        let ids: Vec<u16> = sequence.iter().map(|f| f.target.id).collect();
+        assert_eq!(ids, vec![2, 1]);
+        assert!((sequence[0].distance_nm - 2.5).abs() < 0.05);
+        assert!(sequence[0].offset_nm.abs() < 0.05);
+        assert!((sequence[1].height_ft - 1800.0).abs() < 1.0);
+    }
+
+    #[test]
+    fn test_empty_index() {
+        let index = TrafficIndex::default();
+        assert!(index.is_empty());
+        assert!(index.within(0.0, 0.0, 10.0).is_empty());
+        assert!(index
+            .on_final(&FinalApproach::new(0.0, 0.0, 0.0, 90.0))
+            .is_empty());
+    }
+}
@@ -0,0 +1,263 @@
+//! UDP telemetry stream - receiver for a plugin on another machine
+//!
+//! With `udp = <host>:<port>` in `stratus_plugin.cfg` the plugin sends every
+//! captured frame as one datagram to that address
+//! (`adapters/xplane/src/stratus_udp.h`), and accepts command datagrams sent
+//! back from it. Each datagram is a 32-byte header and a payload:
+//!
+//! ```text
+//! offset  size  field
+//! 0       4     magic "STRU" (0x55525453 LE)
+//! 4       2     version (UDP_VERSION)
+//! 6       2     kind (KIND_FRAME = 1, KIND_COMMANDS = 2)
+//! 8       8     seq (per sender and kind, from 1)
+//! 16      8     sent_ns (sender's CLOCK_MONOTONIC)
+//! 24      4     payload_size
+//! 28      4     flags (reserved, 0)
+//! 32      ...   KIND_FRAME: binary frame as in stratus_telemetry.bin
+//!               KIND_COMMANDS: command-file JSON lines
+//! ```
+//!
+//! Nothing is retransmitted. Every frame datagram is complete on its own, so
+//! the receiver only has to order them: it keeps the newest by sequence
+//! number, and counts gaps and late arrivals in [`UdpStats`].
+
+use crate::command_ring::{monotonic_ns, SentCommand};
+use crate::commands::{next_file_id, Command, CommandLine};
+use crate::frame::TelemetryFrame;
+use anyhow::Result;
+use std::io::ErrorKind;
+use std::net::{SocketAddr, ToSocketAddrs, UdpSocket};
+
+/// Datagram magic ("STRU")
+pub const UDP_MAGIC: u32 = 0x5552_5453;
+/// Datagram layout version (`STRATUS_UDP_VERSION`)
+pub const UDP_VERSION: u16 = 1;
+/// Size of the datagram header (`StratusUdpHeader`)
+pub const UDP_HEADER_SIZE: usize = 32;
+/// Largest datagram either side sends (`STRATUS_UDP_DATAGRAM_MAX`)
+pub const UDP_DATAGRAM_MAX: usize = 1400;
+
+/// Datagram kinds
+pub const KIND_FRAME: u16 = 1;
+pub const KIND_COMMANDS: u16 = 2;
+
+/// Environment variable naming the address `TelemetryWatcher` listens on
+pub const UDP_BIND_ENV: &str = "STRATUS_TELEMETRY_UDP";
+
+/// Decoded datagram header
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct UdpHeader {
+    pub kind: u16,
+    pub seq: u64,
+    pub sent_ns: u64,
+    pub payload_size: u32,
+}
+
+impl UdpHeader {
+    /// Parse the header of `datagram`; `None` unless it is a well-formed
+    /// datagram of this version whose payload is exactly the rest
+    pub fn decode(datagram: &[u8]) -> Option<Self> {
+        if datagram.len() < UDP_HEADER_SIZE {
+            return None;
+        }
+        let u16_at = |o: usize| u16::from_le_bytes([datagram[o], datagram[o + 1]]);
+        let u32_at = |o: usize| u32::from_le_bytes(datagram[o..o + 4].try_into().unwrap());
+        let u64_at = |o: usize| u64::from_le_bytes(datagram[o..o + 8].try_into().unwrap());
+
+        if u32_at(0) != UDP_MAGIC || u16_at(4) != UDP_VERSION {
+            return None;
+        }
+        let header = Self {
+            kind: u16_at(6),
+            seq: u64_at(8),
+            sent_ns: u64_at(16),
+            payload_size: u32_at(24),
+        };
+        (header.payload_size as usize == datagram.len() - UDP_HEADER_SIZE).then_some(header)
+    }
+
+    /// Append the encoded header to `out`
+    pub fn encode(&self, out: &mut Vec<u8>) {
+        out.extend_from_slice(&UDP_MAGIC.to_le_bytes());
+        out.extend_from_slice(&UDP_VERSION.to_le_bytes());
+        out.extend_from_slice(&self.kind.to_le_bytes());
+        out.extend_from_slice(&self.seq.to_le_bytes());
+        out.extend_from_slice(&self.sent_ns.to_le_bytes());
+        out.extend_from_slice(&self.payload_size.to_le_bytes());
+        out.extend_from_slice(&0u32.to_le_bytes());
+    }
+}
+
+/// A frame received over UDP
+#[derive(Debug, Clone, Copy)]
+pub struct UdpFrame {
+    pub seq: u64,
+    /// When the plugin sent it, on the sim machine's monotonic clock
+    pub sent_ns: u64,
+    pub frame: TelemetryFrame,
+}
+
+/// Receiver counters since bind
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct UdpStats {
+    /// Frame datagrams accepted
+    pub received: u64,
+    /// Sequence numbers skipped and not (yet) seen
+    pub lost: u64,
+    /// Frames that arrived after a newer one, and were discarded
+    pub late: u64,
+    /// Datagrams that were not valid frames
+    pub invalid: u64,
+    /// Times the sender restarted its sequence (plugin reload)
+    pub restarts: u64,
+}
+
+/// Receives the plugin's frame datagrams and sends commands back
+pub struct UdpTelemetryReceiver {
+    socket: UdpSocket,
+    peer: Option<SocketAddr>,
+    last_seq: u64,
+    latest: Option<UdpFrame>,
+    fresh: bool,
+    stats: UdpStats,
+    command_seq: u64,
+    buf: Box<[u8; UDP_DATAGRAM_MAX]>,
+}
+
+impl UdpTelemetryReceiver {
+    /// Listen on `addr`, e.g. `"0.0.0.0:49300"`
+    pub fn bind(addr: impl ToSocketAddrs) -> std::io::Result<Self> {
+        let socket = UdpSocket::bind(addr)?;
+        socket.set_nonblocking(true)?;
+        Ok(Self {
+            socket,
+            peer: None,
+            last_seq: 0,
+            latest: None,
+            fresh: false,
+            stats: UdpStats::default(),
+            command_seq: 0,
+            buf: Box::new([0; UDP_DATAGRAM_MAX]),
+        })
+    }
+
+    pub fn local_addr(&self) -> std::io::Result<SocketAddr> {
+        self.socket.local_addr()
+    }
+
+    /// Address the frames come from, once one has arrived
+    pub fn peer(&self) -> Option<SocketAddr> {
+        self.peer
+    }
+
+    pub fn stats(&self) -> UdpStats {
+        self.stats
+    }
+
+    /// Newest frame received so far
+    pub fn latest(&self) -> Option<&UdpFrame> {
+        self.latest.as_ref()
+    }
+
+    /// Drain every waiting datagram and return the newest frame, if one
+    /// arrived since the last call (non-blocking)
+    pub fn poll(&mut self) -> Option<UdpFrame> {
+        loop {
+            match self.socket.recv_from(&mut self.buf[..]) {
+                Ok((len, from)) => self.accept(len, from),
+                Err(e) if e.kind() == ErrorKind::Interrupted => continue,
+                // WouldBlock, or an ICMP error from an earlier command send
+                Err(_) => break,
+            }
+        }
+        if !std::mem::take(&mut self.fresh) {
+            return None;
+        }
+        self.latest
+    }
+
+    fn accept(&mut self, len: usize, from: SocketAddr) {
+        let datagram = &self.buf[..len];
+        let Some(header) = UdpHeader::decode(datagram).filter(|h| h.kind == KIND_FRAME) else {
+            self.stats.invalid += 1;
+            return;
+        };
+        let Ok(frame) = TelemetryFrame::decode(&datagram[UDP_HEADER_SIZE..]) else {
+            self.stats.invalid += 1;
+            return;
+        };
+
+        // A new sender, or the plugin starting over from 1: follow it
+        if self.peer != Some(from) || (header.seq < self.last_seq && header.seq == 1) {
+            if self.peer.is_some() {
+                self.stats.restarts += 1;
+            }
+            self.peer = Some(from);
+            self.last_seq = 0;
+        }
+
+        if header.seq <= self.last_seq {
+            self.stats.late += 1;
+            self.stats.lost = self.stats.lost.saturating_sub(1);
+            return;
+        }
+        self.stats.lost += header.seq - self.last_seq - 1;
+        self.stats.received += 1;
+        self.last_seq = header.seq;
+        self.latest = Some(UdpFrame {
+            seq: header.seq,
+            sent_ns: header.sent_ns,
+            frame,
+        });
+        self.fresh = true;
+    }
+
+    /// Send `commands` to the plugin the frames come from, packing as many
+    /// lines per datagram as fit. Returns the ID and send time of each; acks
+    /// stay on the sim machine's command ring. Fails until the first frame
+    /// has arrived, since there is nowhere to send to.
+    pub fn send_commands(&mut self, commands: &[Command]) -> Result<Vec<SentCommand>> {
+        let peer = self
+            .peer
+            .ok_or_else(|| anyhow::anyhow!("no frames from the plugin yet"))?;
+        let mut sent = Vec::with_capacity(commands.len());
+        let mut payload = Vec::new();
+        for command in commands {
+            let id = next_file_id();
+            let mut line = serde_json::to_vec(&CommandLine { id, command })?;
+            line.push(b'\n');
+            if UDP_HEADER_SIZE + line.len() > UDP_DATAGRAM_MAX {
+                anyhow::bail!("command too large for one datagram: {:?}", command);
+            }
+            if UDP_HEADER_SIZE + payload.len() + line.len() > UDP_DATAGRAM_MAX {
+                self.send_datagram(peer, &payload)?;
+                payload.clear();
+            }
+            payload.extend_from_slice(&line);
+            sent.push(SentCommand {
+                id,
+                sent_monotonic_ns: monotonic_ns(),
+            });
+        }
+        if !payload.is_empty() {
+            self.send_datagram(peer, &payload)?;
+        }
+        Ok(sent)
+    }
+
+    fn send_datagram(&mut self, peer: SocketAddr, payload: &[u8]) -> Result<()> {
+        self.command_seq += 1;
+        let mut datagram = Vec::with_capacity(UDP_HEADER_SIZE + payload.len());
+        UdpHeader {
+            kind: KIND_COMMANDS,
+            seq: self.command_seq,
+            sent_ns: monotonic_ns(),
+            payload_size: payload.len() as u32,
+        }
+        .encode(&mut datagram);
+        datagram.extend_from_slice(payload);
+        self.socket.send_to(&datagram, peer)?;
+        Ok(())
+    }
+}
@@ -0,0 +1,239 @@
+//! Unit tests for the UDP telemetry receiver
+
+use crate::commands::Command;
+use crate::frame::TelemetryFrame;
+use crate::udp::{
+    UdpHeader, UdpTelemetryReceiver, KIND_COMMANDS, KIND_FRAME, UDP_DATAGRAM_MAX, UDP_HEADER_SIZE,
+    UDP_MAGIC,
+};
+use std::net::UdpSocket;
+use std::time::{Duration, Instant};
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn frame(latitude: f64) -> TelemetryFrame {
+        let mut f: TelemetryFrame = unsafe { std::mem::zeroed() };
+        f.latitude = latitude;
+        f.com1_hz = 118_700_000;
+        f.aircraft[..8].copy_from_slice(b"C172.acf");
+        f
+    }
+
+    fn datagram(kind: u16, seq: u64, payload: &[u8]) -> Vec<u8> {
+        let mut out = Vec::new();
+        UdpHeader {
+            kind,
+            seq,
+            sent_ns: seq * 100_000_000,
+            payload_size: payload.len() as u32,
+        }
+        .encode(&mut out);
+        out.extend_from_slice(payload);
+        out
+    }
+
+    /// Minimal Rust stand-in for the plugin's `StratusUdp_*` sender
+    struct TestSender {
+        socket: UdpSocket,
+    }
+
+    impl TestSender {
+        fn new(receiver: &UdpTelemetryReceiver) -> Self {
+            let socket = UdpSocket::bind("127.0.0.1:0").unwrap();
+            socket.connect(receiver.local_addr().unwrap()).unwrap();
+            socket
+                .set_read_timeout(Some(Duration::from_secs(2)))
+                .unwrap();
+            Self { socket }
+        }
+
+        fn send_frame(&self, seq: u64, latitude: f64) {
+            let bytes = datagram(KIND_FRAME, seq, &frame(latitude).encode());
+            self.socket.send(&bytes).unwrap();
+        }
+
+        fn send_raw(&self, bytes: &[u8]) {
+            self.socket.send(bytes).unwrap();
+        }
+
+        fn recv(&self) -> Vec<u8> {
+            let mut buf = [0u8; UDP_DATAGRAM_MAX];
+            let len = self.socket.recv(&mut buf).unwrap();
+            buf[..len].to_vec()
+        }
+    }
+
+    fn receiver() -> UdpTelemetryReceiver {
+        UdpTelemetryReceiver::bind("127.0.0.1:0").unwrap()
+    }
+
+    /// Poll until `want` frames have been counted (loopback delivery is not
+    /// instantaneous)
+    fn poll_until(rx: &mut UdpTelemetryReceiver, want: impl Fn(&UdpTelemetryReceiver) -> bool) {
+        let deadline = Instant::now() + Duration::from_secs(2);
+        while !want(rx) && Instant::now() < deadline {
+            rx.poll();
+            std::thread::sleep(Duration::from_millis(1));
+        }
+    }
+
+    #[test]
+    fn test_header_roundtrip_and_validation() {
+        let bytes = datagram(KIND_FRAME, 7, &[1, 2, 3]);
+        assert_eq!(bytes.len(), UDP_HEADER_SIZE + 3);
+        assert_eq!(&bytes[0..4], &UDP_MAGIC.to_le_bytes());
+        let header = UdpHeader::decode(&bytes).unwrap();
+        assert_eq!(header.kind, KIND_FRAME);
+        assert_eq!(header.seq, 7);
+        assert_eq!(header.sent_ns, 700_000_000);
+        assert_eq!(header.payload_size, 3);
+
+        // Truncated payload, bad magic, short header
+        assert!(UdpHeader::decode(&bytes[..bytes.len() - 1]).is_none());
+        let mut bad = bytes.clone();
+        bad[0] ^= 0xFF;
+        assert!(UdpHeader::decode(&bad).is_none());
+        assert!(UdpHeader::decode(&bytes[..UDP_HEADER_SIZE - 1]).is_none());
+    }
+
+    #[test]
+    fn test_newest_frame_wins() {
+        let mut rx = receiver();
+        let tx = TestSender::new(&rx);
+        assert!(rx.poll().is_none());
+
+        for seq in 1..=3 {
+            tx.send_frame(seq, seq as f64);
+        }
+        poll_until(&mut rx, |rx| rx.stats().received == 3);
+        let latest = rx.latest().unwrap();
+        assert_eq!(latest.seq, 3);
+        assert_eq!(latest.frame.latitude, 3.0);
+        assert_eq!(latest.sent_ns, 300_000_000);
+        assert_eq!(rx.peer(), Some(tx.socket.local_addr().unwrap()));
+
+        // Nothing new since: poll reports no frame
+        assert!(rx.poll().is_none());
+    }
+
+    #[test]
+    fn test_gaps_and_late_frames() {
+        let mut rx = receiver();
+        let tx = TestSender::new(&rx);
+
+        tx.send_frame(1, 1.0);
+        tx.send_frame(4, 4.0); // 2 and 3 lost
+        poll_until(&mut rx, |rx| rx.stats().received == 2);
+        assert_eq!(rx.stats().lost, 2);
+
+        tx.send_frame(3, 3.0); // 3 turns up late: discarded, no longer lost
+        poll_until(&mut rx, |rx| rx.stats().late == 1);
+        let stats = rx.stats();
+        assert_eq!(stats.lost, 1);
+        assert_eq!(stats.received, 2);
+        assert_eq!(rx.latest().unwrap().frame.latitude, 4.0);
+    }
+
+    #[test]
+    fn test_invalid_datagrams_counted() {
+        let mut rx = receiver();
+        let tx = TestSender::new(&rx);
+
+        tx.send_raw(b"not a datagram");
+        tx.send_raw(&datagram(KIND_COMMANDS, 1, b"{}\n"));
+        tx.send_raw(&datagram(KIND_FRAME, 1, &[0u8; 16]));
+        poll_until(&mut rx, |rx| rx.stats().invalid == 3);
+        assert_eq!(rx.stats().received, 0);
+        assert!(rx.latest().is_none());
+        assert!(rx.peer().is_none());
+    }
+
+    #[test]
+    fn test_sender_restart() {
+        let mut rx = receiver();
+        let old = TestSender::new(&rx);
+        old.send_frame(500, 1.0);
+        poll_until(&mut rx, |rx| rx.stats().received == 1);
+
+        // Plugin reloaded: new socket, sequence from 1
+        let new = TestSender::new(&rx);
+        new.send_frame(1, 2.0);
+        poll_until(&mut rx, |rx| rx.stats().received == 2);
+        let stats = rx.stats();
+        assert_eq!(stats.restarts, 1);
+        assert_eq!(stats.late, 0);
+        assert_eq!(rx.latest().unwrap().frame.latitude, 2.0);
+        assert_eq!(rx.peer(), Some(new.socket.local_addr().unwrap()));
+    }
+
+    #[test]
+    fn test_commands_go_back_to_the_sender() {
+        let mut rx = receiver();
+        assert!(rx.send_commands(&[Command::SetRate { hz: 5.0 }]).is_err());
+
+        let tx = TestSender::new(&rx);
+        tx.send_frame(1, 1.0);
+        poll_until(&mut rx, |rx| rx.stats().received == 1);
+
+        let commands = [
+            Command::SetXpdr {
+                code: 4521,
+                mode: None,
+            },
+            Command::SetRate { hz: 5.0 },
+        ];
+        let sent = rx.send_commands(&commands).unwrap();
+        assert_eq!(sent.len(), 2);
+
+        let bytes = tx.recv();
+        let header = UdpHeader::decode(&bytes).unwrap();
+        assert_eq!(header.kind, KIND_COMMANDS);
+        assert_eq!(header.seq, 1);
+        let text = std::str::from_utf8(&bytes[UDP_HEADER_SIZE..]).unwrap();
+        let lines: Vec<serde_json::Value> = text
+            .lines()
+            .map(|l| serde_json::from_str(l).unwrap())
+            .collect();
+        assert_eq!(lines.len(), 2);
+        assert_eq!(lines[0]["op"], "SET_XPDR");
+        assert_eq!(lines[0]["id"], sent[0].id);
+        assert_eq!(lines[1]["op"], "SET_RATE");
+        assert_eq!(lines[1]["id"], sent[1].id);
+    }
+
+    #[test]
+    fn test_commands_split_across_datagrams() {
+        let mut rx = receiver();
+        let tx = TestSender::new(&rx);
+        tx.send_frame(1, 1.0);
+        poll_until(&mut rx, |rx| rx.stats().received == 1);
+
+        let commands: Vec<Command> = (0..100)
+            .map(|i| Command::SetRadio {
+                target: "COM1".to_string(),
+                param: "frequency".to_string(),
+                value: 118_000_000 + i * 25_000,
+            })
+            .collect();
+        let sent = rx.send_commands(&commands).unwrap();
+        assert_eq!(sent.len(), 100);
+
+        let mut lines = 0;
+        let mut seq = 0;
+        while lines < 100 {
+            let bytes = tx.recv();
+            assert!(bytes.len() <= UDP_DATAGRAM_MAX);
+            let header = UdpHeader::decode(&bytes).unwrap();
+            assert_eq!(header.seq, seq + 1);
+            seq = header.seq;
+            lines += std::str::from_utf8(&bytes[UDP_HEADER_SIZE..])
+                .unwrap()
+                .lines()
+                .count();
+        }
+        assert_eq!(lines, 100);
+        assert!(seq > 1);
+    }
+}
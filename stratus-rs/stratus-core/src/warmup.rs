@@ -8,7 +8,7 @@ use serde::Serialize;
 use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::Arc;
 use std::time::{Duration, Instant};
-use tokio::sync::watch;
+use tokio::sync::{watch, Notify};
 use tokio::time;
 use tracing::{debug, info, warn};
 
@@ -59,6 +59,7 @@ pub struct WarmupService {
     config: WarmupConfig,
     running: Arc<AtomicBool>,
     paused: Arc<AtomicBool>,
+    invalidated: Arc<Notify>,
     stats_tx: watch::Sender<WarmupStats>,
     stats_rx: watch::Receiver<WarmupStats>,
 }
@@ -72,6 +73,7 @@ impl WarmupService {
             config,
             running: Arc::new(AtomicBool::new(false)),
             paused: Arc::new(AtomicBool::new(false)),
+            invalidated: Arc::new(Notify::new()),
             stats_tx,
             stats_rx,
         }
@@ -89,6 +91,7 @@ impl WarmupService {
         let config = self.config.clone();
         let running = self.running.clone();
         let paused = self.paused.clone();
+        let invalidated = self.invalidated.clone();
         let stats_tx = self.stats_tx.clone();
 
         tokio::spawn(async move {
@@ -102,8 +105,11 @@ impl WarmupService {
             let mut heartbeat_count = 0u64;
 
             while running.load(Ordering::SeqCst) {
-                // Wait for interval
-                time::sleep(config.interval).await;
+                // Wait for interval, or less if the sim context changed
+                tokio::select! {
+                    _ = time::sleep(config.interval) => {}
+                    _ = invalidated.notified() => debug!("Warmup invalidated"),
+                }
 
                 // Skip if paused
                 if paused.load(Ordering::SeqCst) {
@@ -147,6 +153,12 @@ impl WarmupService {
         debug!("Warmup service resumed");
     }
 
+    /// Send the next heartbeat now instead of at the end of the interval,
+    /// e.g. after the sim loads a new aircraft or airport
+    pub fn invalidate(&self) {
+        self.invalidated.notify_one();
+    }
+
     /// Force an immediate warmup (useful before expected use)
     pub async fn force_warmup(&self) -> u64 {
         let client = Client::new();
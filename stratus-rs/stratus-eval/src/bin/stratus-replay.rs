@@ -0,0 +1,131 @@
+//! stratus-replay - Feed recorded flights back into the client
+//!
+//! Streams flight data recorder sessions (`recordings/*.strec`, written by
+//! the plugin with `record = on`) into a telemetry channel, standing in for
+//! X-Plane, and optionally runs them through the ATC phase tracker:
+//!
+//! ```text
+//! stratus-replay [--speed realtime|10x|max] [--to shm|binary|json|none]
+//!                [--dir DIR] [--phases] SESSION.strec...
+//! ```
+//!
+//! `--phases` prints every `VfrState` change with its time into the flight,
+//! so `--to none --speed max --phases` checks phase detection on a whole
+//! directory of flights in seconds.
+
+use anyhow::{anyhow, bail, Result};
+use std::path::PathBuf;
+use std::time::Duration;
+use stratus_core::atc::AtcEngine;
+use stratus_core::recording::Recording;
+use stratus_core::replay::{replay, ReplaySink, ReplaySpeed};
+use stratus_core::telemetry::{Telemetry, TelemetryWatcher};
+
+const USAGE: &str = "Usage: stratus-replay [--speed realtime|10x|max] \
+                     [--to shm|binary|json|none] [--dir DIR] [--phases] SESSION.strec...";
+
+struct Options {
+    speed: ReplaySpeed,
+    to: String,
+    dir: PathBuf,
+    phases: bool,
+    sessions: Vec<PathBuf>,
+}
+
+fn parse_args() -> Result<Options> {
+    let mut opts = Options {
+        speed: ReplaySpeed::RealTime,
+        to: "shm".to_string(),
+        dir: TelemetryWatcher::get_data_dir(),
+        phases: false,
+        sessions: Vec::new(),
+    };
+    let mut args = std::env::args().skip(1);
+    while let Some(arg) = args.next() {
+        let mut value = || args.next().ok_or_else(|| anyhow!("{} needs a value", arg));
+        match arg.as_str() {
+            "--speed" => opts.speed = value()?.parse().map_err(|e: String| anyhow!("{}", e))?,
+            "--to" => opts.to = value()?,
+            "--dir" => opts.dir = PathBuf::from(value()?),
+            "--phases" => opts.phases = true,
+            "-h" | "--help" => {
+                println!("{}", USAGE);
+                std::process::exit(0);
+            }
+            _ if arg.starts_with('-') => bail!("unknown option {}\n{}", arg, USAGE),
+            _ => opts.sessions.push(PathBuf::from(arg)),
+        }
+    }
+    if opts.sessions.is_empty() {
+        bail!("no session files\n{}", USAGE);
+    }
+    Ok(opts)
+}
+
+fn open_sink(opts: &Options) -> Result<ReplaySink> {
+    Ok(match opts.to.as_str() {
+        "shm" => ReplaySink::shm()?,
+        "binary" => ReplaySink::Binary(opts.dir.clone()),
+        "json" => ReplaySink::Json(opts.dir.clone()),
+        "none" => ReplaySink::Discard,
+        other => bail!("unknown channel '{}' (shm, binary, json or none)", other),
+    })
+}
+
+fn main() -> Result<()> {
+    let opts = parse_args()?;
+    let mut sink = open_sink(&opts)?;
+
+    // Phase tracking only needs the state machine, never a model
+    let mut config = stratus_core::StratusConfig::default();
+    config.model.backend = "Ollama".to_string();
+
+    for path in &opts.sessions {
+        let recording = Recording::open(path).map_err(|e| anyhow!("{}: {}", path.display(), e))?;
+        println!(
+            "{}: {} frames{}",
+            path.display(),
+            recording.frame_count(),
+            if recording.is_sealed() {
+                ""
+            } else {
+                " (unsealed)"
+            }
+        );
+
+        let mut engine = AtcEngine::new(&config);
+        let mut last_state = None;
+        let stats = replay(&recording, &mut sink, opts.speed, |offset, frame| {
+            if !opts.phases {
+                return;
+            }
+            engine.update_state(&Telemetry::from(frame));
+            let state = engine.state();
+            if last_state != Some(state) {
+                println!("  {:>9}  {}", format_offset(offset), state.as_str());
+                last_state = Some(state);
+            }
+        })
+        .map_err(|e| anyhow!("{}: {}", path.display(), e))?;
+
+        println!(
+            "  replayed {} frames, {} of flight in {:.2} s",
+            stats.frames,
+            format_offset(stats.recorded),
+            stats.elapsed.as_secs_f64()
+        );
+    }
+    Ok(())
+}
+
+/// `h:mm:ss.s` into the flight
+fn format_offset(offset: Duration) -> String {
+    let secs = offset.as_secs_f64();
+    let whole = secs as u64;
+    format!(
+        "{}:{:02}:{:04.1}",
+        whole / 3600,
+        whole / 60 % 60,
+        secs - (whole - whole % 60) as f64
+    )
+}
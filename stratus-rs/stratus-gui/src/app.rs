@@ -10,8 +10,8 @@ use iced::{stream, time, Element, Length, Subscription, Task, Theme};
 use std::path::PathBuf;
 use std::time::Duration;
 use stratus_core::{
-    atc::AtcEngine, commands::CommandWriter, config::StratusConfig, speech::SpeechProxy, voice,
-    Telemetry, WarmupService,
+    atc::AtcEngine, commands::CommandWriter, config::StratusConfig, context::ContextTracker,
+    speech::SpeechProxy, voice, Telemetry, TelemetryStream, WarmupService,
 };
 
 /// Main application state
@@ -22,6 +22,8 @@ pub struct StratusApp {
 
     // Core state
     telemetry: Telemetry,
+    telemetry_stream: TelemetryStream,
+    context: ContextTracker,
     connected: bool,
     last_telemetry_time: std::time::Instant,
     ollama_status: OllamaStatus,
@@ -62,7 +64,7 @@ pub enum Message {
     SendMessage,
 
     // Background events
-    TelemetryUpdated(Result<Telemetry, String>),
+    TelemetryUpdated(Result<String, String>),
     OllamaStatusChanged(bool),
     #[cfg(target_os = "linux")]
     SpeechConnected(Result<SpeechProxy<'static>, String>),
@@ -106,6 +108,8 @@ impl StratusApp {
                 message: "Stratus ATC (Rust Core) initialized.".into(),
             }],
             telemetry: Telemetry::default(),
+            telemetry_stream: TelemetryStream::new(),
+            context: ContextTracker::new(),
             connected: false,
             last_telemetry_time: std::time::Instant::now(),
             ollama_status: OllamaStatus::Unknown,
@@ -215,11 +219,12 @@ impl StratusApp {
                                 }
                             }
 
-                            // Execute Commands
-                            if !commands.is_empty() {
-                                if let Err(e) = self.cmd_writer.write(&commands) {
-                                    eprintln!("Failed to write commands: {}", e);
-                                }
+                            // Execute Commands, then publish the updated ATC state
+                            // to the plugin's stratus/atc/* DataRefs
+                            let mut commands = commands;
+                            commands.push(self.atc_engine.atc_state_command());
+                            if let Err(e) = self.cmd_writer.write(&commands) {
+                                eprintln!("Failed to write commands: {}", e);
                             }
 
                             // Speak response
@@ -255,6 +260,13 @@ impl StratusApp {
                 Task::none()
             }
             Message::TelemetryUpdated(result) => {
+                // The file may hold a keyframe or a delta (publish = delta)
+                let result = result.and_then(|content| {
+                    self.telemetry_stream
+                        .apply_json(&content)
+                        .cloned()
+                        .map_err(|e| e.to_string())
+                });
                 match result {
                     Ok(telemetry) => {
                         self.telemetry = telemetry.clone();
@@ -280,6 +292,13 @@ impl StratusApp {
                 Task::none()
             }
             Message::Tick => {
+                // A new aircraft or airport: re-warm the model before the
+                // pilot's first call (a stat() per tick, read only on change)
+                let context_path = self.data_dir.join(stratus_core::context::CONTEXT_FILE);
+                if self.context.poll(&context_path).is_some() {
+                    self.warmup.invalidate();
+                }
+
                 // Read telemetry file
                 let path = self.data_dir.join("stratus_telemetry.json");
                 Task::perform(read_telemetry_file(path), Message::TelemetryUpdated)
@@ -471,12 +490,10 @@ impl StratusApp {
 
 // Async helper functions
 
-async fn read_telemetry_file(path: PathBuf) -> Result<Telemetry, String> {
-    let content = tokio::fs::read_to_string(&path)
+async fn read_telemetry_file(path: PathBuf) -> Result<String, String> {
+    tokio::fs::read_to_string(&path)
         .await
-        .map_err(|e| e.to_string())?;
-
-    serde_json::from_str(&content).map_err(|e| e.to_string())
+        .map_err(|e| e.to_string())
 }
 
 async fn check_ollama_available() -> bool {
@@ -50,6 +50,14 @@ impl Config {
             .join("stratus_ptt.json")
     }
 
+    /// Get the PTT datagram socket path (we bind, X-Plane plugin sends)
+    pub fn ptt_socket() -> PathBuf {
+        dirs::data_local_dir()
+            .unwrap_or_else(|| PathBuf::from("/tmp"))
+            .join("StratusATC")
+            .join("stratus_ptt.sock")
+    }
+
     fn config_path() -> Result<PathBuf> {
         let config_dir = dirs::config_dir()
             .context("Could not determine config directory")?
@@ -111,21 +111,25 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
 
     info!("Service registered. Listening for calls...");
 
-    // Spawn PTT file monitor in background thread
-    // Watches stratus_ptt.json written by X-Plane plugin
+    // Spawn PTT monitor in background thread
+    // Receives PTT datagrams from the X-Plane plugin, falling back to
+    // watching the stratus_ptt.json it writes
     let ptt_file = Config::ptt_file();
+    let ptt_socket = Config::ptt_socket();
     info!("PTT file path: {:?}", ptt_file);
-    thread::spawn(move || match ptt_hook::PTTMonitor::new(&ptt_file) {
-        Ok(mut monitor) => {
-            if let Err(e) = monitor.listen() {
-                error!("PTT Monitor crashed: {}", e);
+    thread::spawn(
+        move || match ptt_hook::PTTMonitor::new(&ptt_file, &ptt_socket) {
+            Ok(mut monitor) => {
+                if let Err(e) = monitor.listen() {
+                    error!("PTT Monitor crashed: {}", e);
+                }
             }
-        }
-        Err(e) => error!(
-            "Failed to initialize PTT Monitor: {}. Is X-Plane running?",
-            e
-        ),
-    });
+            Err(e) => error!(
+                "Failed to initialize PTT Monitor: {}. Is X-Plane running?",
+                e
+            ),
+        },
+    );
 
     // Add Match for method calls
     connection.add_match("interface='org.stratus.ATC.Voice'")?;
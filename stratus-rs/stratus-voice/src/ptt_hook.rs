@@ -1,37 +1,124 @@
 use anyhow::{Context, Result};
-use dbus::blocking::Connection;
-use log::{debug, error, info};
+use dbus::blocking::{Connection, Proxy};
+use log::{debug, error, info, warn};
+use nix::time::{clock_gettime, ClockId};
 use serde::Deserialize;
 use std::fs;
-use std::path::PathBuf;
+use std::io::ErrorKind;
+use std::os::unix::net::UnixDatagram;
+use std::path::{Path, PathBuf};
 use std::thread;
 use std::time::Duration;
 
+/// Datagram sent by the X-Plane plugin on every PTT transition
+/// (adapters/xplane/src/stratus_ptt.h)
+const PTT_MAGIC: u32 = 0x5450_5453; // "STPT"
+const PTT_VERSION: u16 = 1;
+const PTT_EVENT_SIZE: usize = 32;
+
+/// How often the state file is checked when no datagram arrives
+const FILE_POLL_INTERVAL: Duration = Duration::from_millis(50);
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PttEvent {
+    pub active: bool,
+    /// Transitions since the plugin started, from 1
+    pub seq: u32,
+    /// CLOCK_MONOTONIC at the key event
+    pub monotonic_ns: u64,
+    /// Wall clock at the key event
+    pub unix_ns: i64,
+}
+
+impl PttEvent {
+    /// Decode a datagram; `None` if it is not a PTT event we understand
+    pub fn decode(buf: &[u8]) -> Option<Self> {
+        if buf.len() < PTT_EVENT_SIZE {
+            return None;
+        }
+        let u32_at = |o: usize| u32::from_le_bytes(buf[o..o + 4].try_into().unwrap());
+        let u64_at = |o: usize| u64::from_le_bytes(buf[o..o + 8].try_into().unwrap());
+        if u32_at(0) != PTT_MAGIC || u16::from_le_bytes([buf[4], buf[5]]) != PTT_VERSION {
+            return None;
+        }
+        Some(Self {
+            active: buf[6] != 0,
+            seq: u32_at(8),
+            monotonic_ns: u64_at(16),
+            unix_ns: u64_at(24) as i64,
+        })
+    }
+}
+
 #[derive(Debug, Deserialize)]
 struct PttState {
     ptt: bool,
     #[serde(default)]
     _timestamp: i64,
+    /// Absent in files written by older plugins
+    #[serde(default)]
+    monotonic_ns: u64,
+}
+
+fn monotonic_ns() -> u64 {
+    clock_gettime(ClockId::CLOCK_MONOTONIC)
+        .map(|ts| ts.tv_sec() as u64 * 1_000_000_000 + ts.tv_nsec() as u64)
+        .unwrap_or(0)
+}
+
+/// Merges PTT states from the socket and the file into transitions
+#[derive(Debug, Default)]
+struct PttTracker {
+    active: bool,
+    /// Key event time of the last state applied, to order file and socket
+    /// updates (both carry the same monotonic stamp)
+    last_event_ns: u64,
+}
+
+impl PttTracker {
+    /// Returns the new state if `active` is a transition. States older than
+    /// one already applied are ignored; states without a stamp (older
+    /// plugins) only count while nothing stamped has been seen.
+    fn update(&mut self, active: bool, event_ns: u64) -> Option<bool> {
+        if event_ns == 0 {
+            if self.last_event_ns != 0 {
+                return None;
+            }
+        } else if event_ns <= self.last_event_ns {
+            return None;
+        } else {
+            self.last_event_ns = event_ns;
+        }
+
+        if active == self.active {
+            return None;
+        }
+        self.active = active;
+        Some(active)
+    }
 }
 
 pub struct PTTMonitor {
     ptt_file: PathBuf,
+    socket: Option<UnixDatagram>,
     dbus_conn: Connection,
-    last_state: bool,
+    tracker: PttTracker,
 }
 
 impl PTTMonitor {
-    pub fn new(ptt_file: impl Into<PathBuf>) -> Result<Self> {
+    pub fn new(ptt_file: impl Into<PathBuf>, ptt_socket: &Path) -> Result<Self> {
         let conn = Connection::new_session().context("Failed to connect to Session Bus")?;
         Ok(Self {
             ptt_file: ptt_file.into(),
+            socket: bind_socket(ptt_socket),
             dbus_conn: conn,
-            last_state: false,
+            tracker: PttTracker::default(),
         })
     }
 
-    /// Monitor the PTT file for state changes.
-    /// This replaces the evdev-based PTT hook - now we watch a file written by X-Plane.
+    /// Wait for PTT transitions from X-Plane. Datagrams on the PTT socket wake
+    /// us immediately; the state file is checked in between as a fallback for
+    /// plugins that do not send them.
     pub fn listen(&mut self) -> Result<()> {
         info!("Monitoring PTT file: {:?}", self.ptt_file);
 
@@ -41,28 +128,128 @@ impl PTTMonitor {
             Duration::from_secs(5),
         );
 
+        let mut buf = [0u8; 64];
         loop {
-            // Check file state
+            if let Some(socket) = &self.socket {
+                match socket.recv(&mut buf) {
+                    Ok(n) => {
+                        if let Some(event) = PttEvent::decode(&buf[..n]) {
+                            let latency_us =
+                                monotonic_ns().saturating_sub(event.monotonic_ns) / 1000;
+                            debug!("PTT event #{} after {}us", event.seq, latency_us);
+                            if let Some(active) =
+                                self.tracker.update(event.active, event.monotonic_ns)
+                            {
+                                notify(&proxy, active);
+                            }
+                        }
+                        continue;
+                    }
+                    Err(e) if matches!(e.kind(), ErrorKind::WouldBlock | ErrorKind::TimedOut) => {}
+                    Err(e) => return Err(e).context("PTT socket receive failed"),
+                }
+            } else {
+                thread::sleep(FILE_POLL_INTERVAL);
+            }
+
             if let Ok(content) = fs::read_to_string(&self.ptt_file) {
                 if let Ok(state) = serde_json::from_str::<PttState>(&content) {
-                    // Detect state changes
-                    if state.ptt && !self.last_state {
-                        debug!("PTT DOWN (from X-Plane)");
-                        let _: std::result::Result<(), _> = proxy
-                            .method_call("org.stratus.ATC.Voice", "StartListening", ())
-                            .map_err(|e| error!("Failed to call StartListening: {}", e));
-                    } else if !state.ptt && self.last_state {
-                        debug!("PTT UP (from X-Plane)");
-                        let _: std::result::Result<(), _> = proxy
-                            .method_call("org.stratus.ATC.Voice", "StopListening", ())
-                            .map_err(|e| error!("Failed to call StopListening: {}", e));
+                    if let Some(active) = self.tracker.update(state.ptt, state.monotonic_ns) {
+                        notify(&proxy, active);
                     }
-                    self.last_state = state.ptt;
                 }
             }
+        }
+    }
+}
 
-            // Poll at 50ms for low latency
-            thread::sleep(Duration::from_millis(50));
+/// Tell the voice service to start or stop listening
+fn notify(proxy: &Proxy<'_, &Connection>, active: bool) {
+    if active {
+        debug!("PTT DOWN (from X-Plane)");
+        let _: std::result::Result<(), _> = proxy
+            .method_call("org.stratus.ATC.Voice", "StartListening", ())
+            .map_err(|e| error!("Failed to call StartListening: {}", e));
+    } else {
+        debug!("PTT UP (from X-Plane)");
+        let _: std::result::Result<(), _> = proxy
+            .method_call("org.stratus.ATC.Voice", "StopListening", ())
+            .map_err(|e| error!("Failed to call StopListening: {}", e));
+    }
+}
+
+/// Bind the PTT datagram socket, replacing a stale one left by a previous run
+fn bind_socket(path: &Path) -> Option<UnixDatagram> {
+    let _ = fs::remove_file(path);
+    let socket = UnixDatagram::bind(path)
+        .and_then(|s| s.set_read_timeout(Some(FILE_POLL_INTERVAL)).map(|_| s));
+    match socket {
+        Ok(s) => {
+            info!("Listening for PTT events on {:?}", path);
+            Some(s)
         }
+        Err(e) => {
+            warn!(
+                "PTT socket {:?} unavailable ({}), polling file only",
+                path, e
+            );
+            None
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn encode(active: bool, seq: u32, monotonic_ns: u64) -> Vec<u8> {
+        let mut buf = Vec::new();
+        buf.extend_from_slice(&PTT_MAGIC.to_le_bytes());
+        buf.extend_from_slice(&PTT_VERSION.to_le_bytes());
+        buf.push(active as u8);
+        buf.push(0);
+        buf.extend_from_slice(&seq.to_le_bytes());
+        buf.extend_from_slice(&0u32.to_le_bytes());
+        buf.extend_from_slice(&monotonic_ns.to_le_bytes());
+        buf.extend_from_slice(&1_700_000_000_000_000_000i64.to_le_bytes());
+        buf
+    }
+
+    #[test]
+    fn test_decode_event() {
+        let event = PttEvent::decode(&encode(true, 3, 42)).unwrap();
+        assert!(event.active);
+        assert_eq!(event.seq, 3);
+        assert_eq!(event.monotonic_ns, 42);
+        assert_eq!(event.unix_ns, 1_700_000_000_000_000_000);
+    }
+
+    #[test]
+    fn test_decode_rejects_foreign_datagrams() {
+        let mut buf = encode(true, 1, 1);
+        assert!(PttEvent::decode(&buf[..16]).is_none());
+        buf[0] ^= 0xff;
+        assert!(PttEvent::decode(&buf).is_none());
+    }
+
+    #[test]
+    fn test_tracker_ignores_stale_file_state() {
+        let mut tracker = PttTracker::default();
+        // Press and release arrive by socket before the file catches up
+        assert_eq!(tracker.update(true, 100), Some(true));
+        assert_eq!(tracker.update(false, 200), Some(false));
+        assert_eq!(tracker.update(true, 100), None);
+        // Unstamped (legacy) file states are ignored once stamps are seen
+        assert_eq!(tracker.update(true, 0), None);
+        assert_eq!(tracker.update(true, 300), Some(true));
+        assert_eq!(tracker.update(true, 300), None);
+    }
+
+    #[test]
+    fn test_tracker_legacy_file_only() {
+        let mut tracker = PttTracker::default();
+        assert_eq!(tracker.update(true, 0), Some(true));
+        assert_eq!(tracker.update(true, 0), None);
+        assert_eq!(tracker.update(false, 0), Some(false));
     }
 }